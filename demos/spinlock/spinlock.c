@@ -0,0 +1,184 @@
+/*
+ *  GXemul demo:  Multi-Processor spinlock stress test
+ *
+ *  All cpus repeatedly take a spinlock and do a non-atomic increment of a
+ *  shared counter while holding it, and also increment a second counter
+ *  using an atomic add. When all cpus are done, cpu 0 prints both counters.
+ *  If load-linked/store-conditional (or the architecture's equivalent) is
+ *  not emulated correctly, the counters end up lower than expected.
+ *
+ *  This file is in the Public Domain.
+ */
+
+#include "dev_cons.h"
+#include "dev_mp.h"
+
+
+#ifdef MIPS
+/*  Note: The ugly cast to a signed int (32-bit) causes the address to be
+	sign-extended correctly on MIPS when compiled in 64-bit mode  */
+#define	PHYSADDR_OFFSET		((signed int)0xa0000000)
+#else
+#define	PHYSADDR_OFFSET		0
+#endif
+
+
+#define	PUTCHAR_ADDRESS		(PHYSADDR_OFFSET +		\
+				DEV_CONS_ADDRESS + DEV_CONS_PUTGETCHAR)
+#define	HALT_ADDRESS		(PHYSADDR_OFFSET +		\
+				DEV_CONS_ADDRESS + DEV_CONS_HALT)
+
+#define	MP_ADDRESS(reg)		(PHYSADDR_OFFSET + DEV_MP_ADDRESS + (reg))
+
+
+#define	MAX_CPUS		32
+#define	STACK_SIZE		4096
+#define	N_ITERATIONS		20000
+
+
+static volatile int lock;
+static volatile unsigned int locked_counter;
+static volatile unsigned int atomic_counter;
+static volatile int n_done;
+
+static char stacks[MAX_CPUS][STACK_SIZE];
+
+
+void printchar(char ch)
+{
+	*((volatile unsigned char *) PUTCHAR_ADDRESS) = ch;
+}
+
+
+void halt(void)
+{
+	*((volatile unsigned char *) HALT_ADDRESS) = 0;
+}
+
+
+void printstr(char *s)
+{
+	while (*s)
+		printchar(*s++);
+}
+
+void printuint_internal(unsigned int u)
+{
+	int z = u / 10;
+	if (z > 0)
+		printuint_internal(z);
+	printchar('0' + (u - z*10));
+}
+
+void printuint(unsigned int u)
+{
+	if (u == 0)
+		printchar('0');
+	else
+		printuint_internal(u);
+}
+
+int mp_read(int reg)
+{
+	return *((volatile int *) MP_ADDRESS(reg));
+}
+
+void mp_write(int reg, long value)
+{
+	*((volatile long *) MP_ADDRESS(reg)) = value;
+}
+
+
+void spin_lock(volatile int *l)
+{
+	while (__sync_lock_test_and_set(l, 1))
+		while (*l)
+			;
+}
+
+void spin_unlock(volatile int *l)
+{
+	__sync_lock_release(l);
+}
+
+
+void worker(void)
+{
+	int i, whoami = mp_read(DEV_MP_WHOAMI);
+
+	for (i=0; i<N_ITERATIONS; i++) {
+		unsigned int v;
+		int delay;
+
+		spin_lock(&lock);
+
+		/*  Make the window between the read and the write larger,
+		    differently on each cpu:  */
+		v = locked_counter;
+		for (delay=0; delay<whoami+2; delay++)
+			__asm__ __volatile__ ("" ::: "memory");
+		locked_counter = v + 1;
+
+		spin_unlock(&lock);
+
+		__sync_fetch_and_add(&atomic_counter, 1);
+	}
+
+	__sync_fetch_and_add(&n_done, 1);
+}
+
+
+void secondary(void)
+{
+	worker();
+
+	for (;;)
+		;
+}
+
+
+void f(void)
+{
+	int i, ncpus = mp_read(DEV_MP_NCPUS);
+	unsigned int expected;
+
+	printstr("Multi-Processor spinlock stress test\n");
+	printstr("------------------------------------\n\n");
+
+	if (ncpus > MAX_CPUS)
+		ncpus = MAX_CPUS;
+
+	printstr("Number of CPUs: ");
+	printuint(ncpus);
+	printstr("\n");
+
+	/*  Start all other cpus, each with its own stack:  */
+	mp_write(DEV_MP_STARTUPADDR, (long) secondary);
+	for (i=1; i<ncpus; i++) {
+		mp_write(DEV_MP_STARTUPSTACK, (long) &stacks[i][STACK_SIZE - 64]);
+		mp_write(DEV_MP_STARTUPCPU, i);
+	}
+
+	worker();
+
+	while (n_done != ncpus)
+		;
+
+	expected = ncpus * N_ITERATIONS;
+
+	printstr("Locked counter: ");
+	printuint(locked_counter);
+	printstr("\nAtomic counter: ");
+	printuint(atomic_counter);
+	printstr("\nExpected:       ");
+	printuint(expected);
+	printstr("\n\n");
+
+	if (locked_counter == expected && atomic_counter == expected)
+		printstr("OK\n");
+	else
+		printstr("FAILED\n");
+
+	halt();
+}
+
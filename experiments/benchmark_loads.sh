@@ -0,0 +1,50 @@
+#!/bin/sh
+#
+#  Microbenchmark for emulated loads in the component-based MIPS emulation.
+#
+#  Usage:  ./benchmark_loads.sh [path/to/gxemul [seconds]]
+#
+#  A small raw MIPS program is run on a testmips machine. The program is an
+#  endless loop of 8 lw instructions (from RAM in kseg0) followed by a branch
+#  and a nop, i.e. 8 loads per 10 steps. The last steps/second figure printed
+#  by GXemul is used to calculate the number of emulated loads per second.
+#
+
+GXEMUL=${1:-../gxemul}
+SECONDS_TO_RUN=${2:-8}
+TMPDIR=${TMPDIR:-/tmp}
+BIN=$TMPDIR/benchmark_loads.$$.bin
+OUT=$TMPDIR/benchmark_loads.$$.out
+
+#	lui	s0,0x8001
+#  loop:
+#	lw	t8,0(s0)
+#	lw	t9,4(s0)
+#	lw	v0,8(s0)
+#	lw	v1,12(s0)
+#	lw	a0,16(s0)
+#	lw	a1,20(s0)
+#	lw	a2,24(s0)
+#	lw	a3,28(s0)
+#	b	loop
+#	nop
+printf '\074\020\200\001' > $BIN
+printf '\216\030\000\000\216\031\000\004\216\002\000\010\216\003\000\014' >> $BIN
+printf '\216\004\000\020\216\005\000\024\216\006\000\030\216\007\000\034' >> $BIN
+printf '\020\000\377\367\000\000\000\000' >> $BIN
+
+$GXEMUL -q -e testmips raw:0xffffffff80004000:$BIN > $OUT 2>&1 &
+PID=$!
+sleep $SECONDS_TO_RUN
+kill -9 $PID
+wait $PID 2>/dev/null
+
+STEPS=`grep "steps/second" $OUT | tail -1 | sed 's/.*(\([0-9]*\) steps\/second).*/\1/'`
+rm -f $BIN $OUT
+
+if [ z"$STEPS" = z ]; then
+	echo "No steps/second output from $GXEMUL?"
+	exit 1
+fi
+
+echo "$STEPS steps/second, `expr $STEPS / 10 \* 8` loads/second"
@@ -0,0 +1,285 @@
+/*
+ *  Copyright (C) 2010  Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ *
+ *
+ *  Conformance test for the fast paths in src/old_main/float_emul.cc.
+ *
+ *  A corpus of single and double precision bit patterns (zeroes, denormals,
+ *  the smallest and largest normals, infinities, NaNs, values around 1.0,
+ *  and a fixed sequence of pseudo-random patterns) is converted using both
+ *  ieee_interpret_float_value() and ieee_interpret_float_value_slow(), and
+ *  the resulting doubles are stored back using both ieee_store_float_value()
+ *  and ieee_store_float_value_slow(). Any difference is printed.
+ *
+ *  A few arithmetic operations are also done the way the CPU emulation does
+ *  them (ieee_fenv_begin(), host arithmetic, ieee_fenv_end()), and the
+ *  results and exception flags are compared with the IEEE 754 results for
+ *  each rounding mode.
+ *
+ *  Build GXemul first (float_emul.o is linked in), then run
+ *  ./float_emul_conformance [nr of random patterns]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "float_emul.h"
+
+
+static int n_tests = 0, n_failures = 0;
+
+
+/*  float_emul.o only needs fatal() from the rest of the emulator.  */
+void fatal(const char *fmt, ...)
+{
+	va_list argp;
+
+	va_start(argp, fmt);
+	vfprintf(stderr, fmt, argp);
+	va_end(argp);
+}
+
+
+static uint64_t next_random(uint64_t *state)
+{
+	/*  A plain 64-bit LCG, so that the corpus is the same every time.  */
+	*state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+	return *state;
+}
+
+
+static void test_interpret(uint64_t x, int fmt)
+{
+	struct ieee_float_value fast, slow;
+
+	n_tests ++;
+	ieee_interpret_float_value(x, &fast, fmt);
+	ieee_interpret_float_value_slow(x, &slow, fmt);
+
+	if (memcmp(&fast.f, &slow.f, sizeof(double)) != 0 ||
+	    fast.nan != slow.nan) {
+		printf("interpret %s %016llx: fast=%a (nan=%i), slow=%a "
+		    "(nan=%i)\n", fmt == IEEE_FMT_S? "S" : "D",
+		    (long long) x, fast.f, fast.nan, slow.f, slow.nan);
+		n_failures ++;
+	}
+}
+
+
+static void test_store(double f, int fmt, int nan)
+{
+	uint64_t fast, slow;
+
+	n_tests ++;
+	fast = ieee_store_float_value(f, fmt, nan);
+	slow = ieee_store_float_value_slow(f, fmt, nan);
+
+	if (fast != slow) {
+		printf("store %s %a (nan=%i): fast=%016llx, slow=%016llx\n",
+		    fmt == IEEE_FMT_S? "S" : "D", f, nan,
+		    (long long) fast, (long long) slow);
+		n_failures ++;
+	}
+}
+
+
+static void test_pattern(uint64_t x, int fmt)
+{
+	struct ieee_float_value fv;
+	double f;
+
+	if (fmt == IEEE_FMT_S)
+		x &= 0xffffffffULL;
+
+	test_interpret(x, fmt);
+
+	/*  Store the value back, in both formats:  */
+	ieee_interpret_float_value_slow(x, &fv, fmt);
+	test_store(fv.f, IEEE_FMT_S, fv.nan);
+	test_store(fv.f, IEEE_FMT_D, fv.nan);
+
+	/*  ... and the pattern itself, as a host double:  */
+	if (fmt == IEEE_FMT_D) {
+		memcpy(&f, &x, sizeof(f));
+		test_store(f, IEEE_FMT_S, 0);
+		test_store(f, IEEE_FMT_D, 0);
+	}
+}
+
+
+/*
+ *  Interprets a and b, computes "a op b" in the given rounding mode, and
+ *  compares the stored result (unless it is NO_RESULT) and the exception
+ *  flags with the expected ones.
+ */
+#define	NO_RESULT	0xffffffffffffffffULL
+static void test_op(uint64_t a, char op, uint64_t b, int fmt, int rm,
+	uint64_t expected, int expected_exc)
+{
+	struct ieee_float_value fa, fb;
+	uint64_t r;
+	double nf = 0.0;
+	float f;
+	int exc;
+
+	n_tests ++;
+	ieee_interpret_float_value(a, &fa, fmt);
+	ieee_interpret_float_value(b, &fb, fmt);
+
+	ieee_fenv_begin(rm);
+	switch (op) {
+	case '+':	nf = fa.f + fb.f; break;
+	case '-':	nf = fa.f - fb.f; break;
+	case '*':	nf = fa.f * fb.f; break;
+	case '/':	nf = fa.f / fb.f; break;
+	}
+	if (fmt == IEEE_FMT_S) {
+		f = nf;
+		nf = f;
+	}
+	exc = ieee_fenv_end(rm);
+
+	r = ieee_store_float_value(nf, fmt, 0);
+	if ((expected != NO_RESULT && r != expected) || exc != expected_exc) {
+		printf("op %s %016llx %c %016llx (rm=%i): result=%016llx "
+		    "exc=0x%02x, expected %016llx exc=0x%02x\n",
+		    fmt == IEEE_FMT_S? "S" : "D", (long long) a, op,
+		    (long long) b, rm, (long long) r, exc,
+		    (long long) expected, expected_exc);
+		n_failures ++;
+	}
+}
+
+
+static void test_ops(void)
+{
+	int rm;
+
+	/*  Zero operands are exact, in every rounding mode:  */
+	for (rm=IEEE_ROUND_NEAREST; rm<=IEEE_ROUND_DOWN; rm++) {
+		test_op(0x3f800000, '+', 0x00000000, IEEE_FMT_S, rm,
+		    0x3f800000, 0);
+		test_op(0x3f800000, '+', 0x80000000, IEEE_FMT_S, rm,
+		    0x3f800000, 0);
+		test_op(0x3f800000, '*', 0x00000000, IEEE_FMT_S, rm, 0, 0);
+		test_op(0x3ff0000000000000ULL, '+', 0x0000000000000000ULL,
+		    IEEE_FMT_D, rm, 0x3ff0000000000000ULL, 0);
+		test_op(0x3ff0000000000000ULL, '-', 0x8000000000000000ULL,
+		    IEEE_FMT_D, rm, 0x3ff0000000000000ULL, 0);
+	}
+
+	/*  Denormal operands:  */
+	test_op(0x00000001, '*', 0x4b000000, IEEE_FMT_S, IEEE_ROUND_NEAREST,
+	    0x00800000, 0);
+	test_op(0x0000000000000001ULL, '*', 0x4330000000000000ULL,
+	    IEEE_FMT_D, IEEE_ROUND_NEAREST, 0x0010000000000000ULL, 0);
+
+	/*  Rounding of inexact results:  */
+	test_op(0x3f800000, '/', 0x40400000, IEEE_FMT_S, IEEE_ROUND_NEAREST,
+	    0x3eaaaaab, IEEE_EXC_INEXACT);
+	test_op(0x3f800000, '/', 0x40400000, IEEE_FMT_S, IEEE_ROUND_ZERO,
+	    0x3eaaaaaa, IEEE_EXC_INEXACT);
+	test_op(0x3f800000, '/', 0x40400000, IEEE_FMT_S, IEEE_ROUND_UP,
+	    0x3eaaaaab, IEEE_EXC_INEXACT);
+	test_op(0x3f800000, '/', 0x40400000, IEEE_FMT_S, IEEE_ROUND_DOWN,
+	    0x3eaaaaaa, IEEE_EXC_INEXACT);
+	test_op(0x3f800000, '+', 0x30800000, IEEE_FMT_S, IEEE_ROUND_UP,
+	    0x3f800001, IEEE_EXC_INEXACT);
+	test_op(0x3f800000, '+', 0x30800000, IEEE_FMT_S, IEEE_ROUND_NEAREST,
+	    0x3f800000, IEEE_EXC_INEXACT);
+	test_op(0x3ff0000000000000ULL, '/', 0x4008000000000000ULL,
+	    IEEE_FMT_D, IEEE_ROUND_NEAREST, 0x3fd5555555555555ULL,
+	    IEEE_EXC_INEXACT);
+	test_op(0x3ff0000000000000ULL, '/', 0x4008000000000000ULL,
+	    IEEE_FMT_D, IEEE_ROUND_UP, 0x3fd5555555555556ULL,
+	    IEEE_EXC_INEXACT);
+	test_op(0xbff0000000000000ULL, '/', 0x4008000000000000ULL,
+	    IEEE_FMT_D, IEEE_ROUND_DOWN, 0xbfd5555555555556ULL,
+	    IEEE_EXC_INEXACT);
+
+	/*  Exceptions:  */
+	test_op(0x3ff0000000000000ULL, '/', 0x0000000000000000ULL,
+	    IEEE_FMT_D, IEEE_ROUND_NEAREST, NO_RESULT, IEEE_EXC_DIVBYZERO);
+	test_op(0x0000000000000000ULL, '/', 0x0000000000000000ULL,
+	    IEEE_FMT_D, IEEE_ROUND_NEAREST, NO_RESULT, IEEE_EXC_INVALID);
+	test_op(0x7fefffffffffffffULL, '*', 0x4000000000000000ULL,
+	    IEEE_FMT_D, IEEE_ROUND_NEAREST, NO_RESULT,
+	    IEEE_EXC_OVERFLOW | IEEE_EXC_INEXACT);
+	test_op(0x0010000000000001ULL, '*', 0x3fe0000000000000ULL,
+	    IEEE_FMT_D, IEEE_ROUND_NEAREST, NO_RESULT,
+	    IEEE_EXC_UNDERFLOW | IEEE_EXC_INEXACT);
+	test_op(0x7f7fffff, '*', 0x40000000, IEEE_FMT_S, IEEE_ROUND_NEAREST,
+	    NO_RESULT, IEEE_EXC_OVERFLOW | IEEE_EXC_INEXACT);
+}
+
+
+int main(int argc, char *argv[])
+{
+	static const uint32_t corpus_s[] = {
+		0x00000000, 0x80000000, 0x00000001, 0x807fffff,
+		0x00800000, 0x80800000, 0x00ffffff, 0x3f7fffff,
+		0x3f800000, 0xbf800000, 0x3f800001, 0x40000000,
+		0x3eaaaaab, 0x7f7fffff, 0xff7fffff, 0x7f800000,
+		0xff800000, 0x7f800001, 0x7fc00000, 0xffffffff };
+	static const uint64_t corpus_d[] = {
+		0x0000000000000000ULL, 0x8000000000000000ULL,
+		0x0000000000000001ULL, 0x800fffffffffffffULL,
+		0x0010000000000000ULL, 0x8010000000000000ULL,
+		0x3690000000000000ULL, 0x3810000000000000ULL,
+		0x380fffffffffffffULL, 0x47efffffe0000000ULL,
+		0x47f0000000000000ULL, 0x3fefffffffffffffULL,
+		0x3ff0000000000000ULL, 0xbff0000000000000ULL,
+		0x3ff0000000000001ULL, 0x3fd5555555555555ULL,
+		0x400921fb54442d18ULL, 0x7fefffffffffffffULL,
+		0xffefffffffffffffULL, 0x7ff0000000000000ULL,
+		0xfff0000000000000ULL, 0x7ff0000000000001ULL,
+		0x7ff8000000000000ULL, 0xffffffffffffffffULL };
+	uint64_t state = 0x2010;
+	int i, n_random = argc > 1? atoi(argv[1]) : 1000000;
+
+	for (i=0; i<(int)(sizeof(corpus_s) / sizeof(corpus_s[0])); i++)
+		test_pattern(corpus_s[i], IEEE_FMT_S);
+	for (i=0; i<(int)(sizeof(corpus_d) / sizeof(corpus_d[0])); i++)
+		test_pattern(corpus_d[i], IEEE_FMT_D);
+
+	for (i=0; i<n_random; i++) {
+		uint64_t x = next_random(&state);
+
+		test_pattern(x >> 32, IEEE_FMT_S);
+		test_pattern(x, IEEE_FMT_D);
+
+		/*  Exponents close to the single precision limits:  */
+		test_pattern((x & 0x800fffffffffffffULL) |
+		    ((uint64_t)(0x360 + (x >> 55) % 0x140) << 52), IEEE_FMT_D);
+	}
+
+	test_ops();
+
+	printf("%i tests, %i failures\n", n_tests, n_failures);
+	return n_failures? 1 : 0;
+}
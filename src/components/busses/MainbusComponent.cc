@@ -308,6 +308,37 @@ bool MainbusComponent::WriteData(const uint64_t& data, Endianness endianness)
 }
 
 
+uint8_t* MainbusComponent::LookupHostPage(uint64_t address, uint64_t pageSize,
+	bool forWriting)
+{
+	if (!MakeSureMemoryMapExists())
+		return NULL;
+
+	uint64_t pageAddr = address & ~(pageSize - 1);
+
+	for (size_t i=0; i<m_memoryMap.size(); ++i) {
+		MemoryMapEntry& mmEntry = m_memoryMap[i];
+
+		if (address < mmEntry.base ||
+		    address >= mmEntry.base + mmEntry.size)
+			continue;
+
+		// Only pages which are completely covered by the component,
+		// and which are not scaled by addrMul, can be accessed
+		// directly:
+		if (mmEntry.addrMul != 1 || pageAddr < mmEntry.base ||
+		    pageAddr + pageSize > mmEntry.base + mmEntry.size ||
+		    ((pageAddr - mmEntry.base) & (pageSize - 1)) != 0)
+			return NULL;
+
+		return mmEntry.addressDataBus->LookupHostPage(
+		    pageAddr - mmEntry.base, pageSize, forWriting);
+	}
+
+	return NULL;
+}
+
+
 /*****************************************************************************/
 
 
@@ -406,6 +437,46 @@ static void Test_MainbusComponent_Remapping()
 	UnitTest::Assert("remapping failed?", dataByte2, 123);
 }
 
+static void Test_MainbusComponent_LookupHostPage()
+{
+	refcount_ptr<Component> mainbus =
+	    ComponentFactory::CreateComponent("mainbus");
+	refcount_ptr<Component> ram0 =
+	    ComponentFactory::CreateComponent("ram");
+	refcount_ptr<Component> ram1 =
+	    ComponentFactory::CreateComponent("ram");
+
+	mainbus->AddChild(ram0);
+	mainbus->AddChild(ram1);
+	ram0->SetVariableValue("memoryMappedSize", "0x10000");
+	ram0->SetVariableValue("memoryMappedBase", "0x1000");
+	ram1->SetVariableValue("memoryMappedSize", "0x10000");
+	ram1->SetVariableValue("memoryMappedBase", "0x20800");
+
+	AddressDataBus* bus = mainbus->AsAddressDataBus();
+
+	uint32_t data = 0x11223344;
+	bus->AddressSelect(0x2010);
+	bus->WriteData(data, BigEndian);
+
+	uint8_t* page = bus->LookupHostPage(0x2018, 0x1000, false);
+	UnitTest::Assert("page in ram0 should be directly accessible",
+	    page != NULL);
+	UnitTest::Assert("wrong page?", page[0x10], 0x11);
+	UnitTest::Assert("wrong page? (2)", page[0x13], 0x44);
+
+	UnitTest::Assert("ram1 is not page aligned",
+	    bus->LookupHostPage(0x21000, 0x1000, false) == NULL);
+	UnitTest::Assert("unmapped addresses cannot be accessed directly",
+	    bus->LookupHostPage(0x40000, 0x1000, false) == NULL);
+
+	ram0->SetVariableValue("writeProtect", "true");
+	UnitTest::Assert("write protected pages cannot be written directly",
+	    bus->LookupHostPage(0x2018, 0x1000, true) == NULL);
+	UnitTest::Assert("but they may still be read directly",
+	    bus->LookupHostPage(0x2018, 0x1000, false) == page);
+}
+
 static void Test_MainbusComponent_Multiple_NonOverlapping()
 {
 	refcount_ptr<Component> mainbus =
@@ -550,6 +621,7 @@ UNITTESTS(MainbusComponent)
 	// Memory mapping, ranges, overlaps, addrmul, etc.:
 	UNITTEST(Test_MainbusComponent_Simple);
 	UNITTEST(Test_MainbusComponent_Remapping);
+	UNITTEST(Test_MainbusComponent_LookupHostPage);
 	UNITTEST(Test_MainbusComponent_Multiple_NonOverlapping);
 	UNITTEST(Test_MainbusComponent_Simple_With_AddrMul);
 
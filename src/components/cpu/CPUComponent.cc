@@ -31,6 +31,7 @@
 #include "AddressDataBus.h"
 #include "components/CPUComponent.h"
 #include "GXemul.h"
+#include "QuantumScheduler.h"
 
 
 CPUComponent::CPUComponent(const string& className, const string& cpuArchitecture)
@@ -524,6 +525,7 @@ bool CPUComponent::ReadData(uint8_t& data, Endianness endianness)
 	bool writable;
 	VirtualToPhysical(m_addressSelect, paddr, writable);
 
+	QuantumScheduler::BusLock busLock;
 	m_addressDataBus->AddressSelect(paddr);
 	return m_addressDataBus->ReadData(data, endianness);
 }
@@ -540,6 +542,7 @@ bool CPUComponent::ReadData(uint16_t& data, Endianness endianness)
 	bool writable;
 	VirtualToPhysical(m_addressSelect, paddr, writable);
 
+	QuantumScheduler::BusLock busLock;
 	m_addressDataBus->AddressSelect(paddr);
 	return m_addressDataBus->ReadData(data, endianness);
 }
@@ -556,6 +559,7 @@ bool CPUComponent::ReadData(uint32_t& data, Endianness endianness)
 	bool writable;
 	VirtualToPhysical(m_addressSelect, paddr, writable);
 
+	QuantumScheduler::BusLock busLock;
 	m_addressDataBus->AddressSelect(paddr);
 	return m_addressDataBus->ReadData(data, endianness);
 }
@@ -572,6 +576,7 @@ bool CPUComponent::ReadData(uint64_t& data, Endianness endianness)
 	bool writable;
 	VirtualToPhysical(m_addressSelect, paddr, writable);
 
+	QuantumScheduler::BusLock busLock;
 	m_addressDataBus->AddressSelect(paddr);
 	return m_addressDataBus->ReadData(data, endianness);
 }
@@ -586,6 +591,7 @@ bool CPUComponent::WriteData(const uint8_t& data, Endianness endianness)
 	bool writable;
 	VirtualToPhysical(m_addressSelect, paddr, writable);
 
+	QuantumScheduler::BusLock busLock;
 	m_addressDataBus->AddressSelect(paddr);
 	return m_addressDataBus->WriteData(data, endianness);
 }
@@ -602,6 +608,7 @@ bool CPUComponent::WriteData(const uint16_t& data, Endianness endianness)
 	bool writable;
 	VirtualToPhysical(m_addressSelect, paddr, writable);
 
+	QuantumScheduler::BusLock busLock;
 	m_addressDataBus->AddressSelect(paddr);
 	return m_addressDataBus->WriteData(data, endianness);
 }
@@ -618,6 +625,7 @@ bool CPUComponent::WriteData(const uint32_t& data, Endianness endianness)
 	bool writable;
 	VirtualToPhysical(m_addressSelect, paddr, writable);
 
+	QuantumScheduler::BusLock busLock;
 	m_addressDataBus->AddressSelect(paddr);
 	return m_addressDataBus->WriteData(data, endianness);
 }
@@ -634,11 +642,31 @@ bool CPUComponent::WriteData(const uint64_t& data, Endianness endianness)
 	bool writable;
 	VirtualToPhysical(m_addressSelect, paddr, writable);
 
+	QuantumScheduler::BusLock busLock;
 	m_addressDataBus->AddressSelect(paddr);
 	return m_addressDataBus->WriteData(data, endianness);
 }
 
 
+uint8_t* CPUComponent::LookupHostPage(uint64_t address, uint64_t pageSize,
+	bool forWriting)
+{
+	if (!LookupAddressDataBus())
+		return NULL;
+
+	uint64_t paddr;
+	bool writable;
+	if (!VirtualToPhysical(address & ~(pageSize - 1), paddr, writable))
+		return NULL;
+
+	if (forWriting && !writable)
+		return NULL;
+
+	QuantumScheduler::BusLock busLock;
+	return m_addressDataBus->LookupHostPage(paddr, pageSize, forWriting);
+}
+
+
 /*****************************************************************************/
 
 
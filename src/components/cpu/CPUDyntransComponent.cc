@@ -26,6 +26,7 @@
  */
 
 #include <assert.h>
+#include <algorithm>
 #include <iomanip>
 
 #include "AddressDataBus.h"
@@ -35,8 +36,25 @@
 
 CPUDyntransComponent::CPUDyntransComponent(const string& className, const string& cpuArchitecture)
 	: CPUComponent(className, cpuArchitecture)
+	, m_dyntransPageShift(0)
+	, m_profiling(false)
+	, m_profileCountdown(DYNTRANS_PROFILE_INTERVAL)
+	, m_nrOfProfileSamples(0)
 {
 	m_abortIC.f = instr_abort;
+
+	DyntransInvalidateHostPages();
+
+	AddVariable("profiling", &m_profiling);
+}
+
+
+void CPUDyntransComponent::ResetState()
+{
+	// Note: m_profiling itself is not reset, only the collected data.
+	ClearProfile();
+
+	CPUComponent::ResetState();
 }
 
 
@@ -59,8 +77,42 @@ void CPUDyntransComponent::DyntransInit()
 		throw std::exception();
 	}
 
+	m_dyntransPageShift = pageShift;
+
 	// 32 MB translation cache (per emulated CPU):
 	m_translationCache.Reinit(32 * 1024 * 1024, m_dyntransICentriesPerPage + DYNTRANS_PAGE_NSPECIALENTRIES, pageShift);
+
+	// Host memory pointers are not kept between calls to Execute(),
+	// since e.g. RAM may have been reset or deserialized in between.
+	DyntransInvalidateHostPages();
+}
+
+
+void CPUDyntransComponent::DyntransInvalidateHostPages()
+{
+	for (size_t i=0; i<N_DYNTRANS_HOST_PAGES; ++i) {
+		m_hostPages[i].m_vaddr = 1;
+		m_hostPages[i].m_host = NULL;
+		m_hostPages[i].m_writable = false;
+	}
+}
+
+
+uint8_t* CPUDyntransComponent::DyntransLookupHostPage(uint64_t vaddr,
+	bool forWriting)
+{
+	uint64_t pageAddr = vaddr & ~(uint64_t)(m_pageSize - 1);
+	uint8_t* host = LookupHostPage(pageAddr, m_pageSize, forWriting);
+	if (host == NULL)
+		return NULL;
+
+	struct DyntransHostPage& hostPage = m_hostPages[
+	    (vaddr >> m_dyntransPageShift) & (N_DYNTRANS_HOST_PAGES - 1)];
+	hostPage.m_vaddr = pageAddr;
+	hostPage.m_host = host;
+	hostPage.m_writable = forWriting;
+
+	return host;
 }
 
 
@@ -139,7 +191,8 @@ int CPUDyntransComponent::Execute(GXemul* gxemul, int nrOfCycles)
 
 	// If possible, do some optimized loops of multiple inlined IC calls...
 	const int ICsPerLoop = 60;
-	const int maxICcycles = 2;	// TODO: Longer when instr combos are reimplemented
+	const int maxICcycles = 3;	// a combined IC, where the second
+					// instruction has a delay slot
 	if (nrOfCycles > ICsPerLoop * maxICcycles) {
 		int hazard = nrOfCycles - ICsPerLoop * maxICcycles;
 
@@ -153,6 +206,13 @@ int CPUDyntransComponent::Execute(GXemul* gxemul, int nrOfCycles)
 			IC IC IC IC IC   IC IC IC IC IC
 
 			m_executedCycles += ICsPerLoop;
+
+			if (m_profiling) {
+				m_profileCountdown -= ICsPerLoop;
+				if (m_profileCountdown <= 0)
+					DyntransProfileSample();
+			}
+
 			if (m_executedCycles >= hazard ||
 			    m_nextIC->f == instr_abort)
 				break;
@@ -189,6 +249,169 @@ int CPUDyntransComponent::Execute(GXemul* gxemul, int nrOfCycles)
 }
 
 
+void CPUDyntransComponent::DyntransProfileSample()
+{
+	m_profileCountdown = DYNTRANS_PROFILE_INTERVAL;
+
+	// Only instruction slots within the current page are sampled. (Not
+	// the end-of-page slots, nor the abort IC.)
+	ptrdiff_t instructionIndex = m_nextIC - m_firstIConPage;
+	if (instructionIndex < 0 || instructionIndex >= m_dyntransICentriesPerPage)
+		return;
+
+	uint64_t pc = (m_pc & ~(uint64_t)m_dyntransPageMask)
+	    + (instructionIndex << m_dyntransICshift);
+
+	++ m_nrOfProfileSamples;
+
+	++ m_profilePCs[pc].m_nrOfSamples;
+
+	DyntransProfileEntry& entry = m_profileICFunctions[m_nextIC->f];
+	if (entry.m_nrOfSamples ++ == 0)
+		entry.m_examplePC = pc;
+}
+
+
+void CPUDyntransComponent::ClearProfile()
+{
+	m_profileCountdown = DYNTRANS_PROFILE_INTERVAL;
+	m_nrOfProfileSamples = 0;
+	m_profilePCs.clear();
+	m_profileICFunctions.clear();
+	m_translationCache.ClearStatistics();
+}
+
+
+uint64_t CPUDyntransComponent::GetNrOfProfileSamples() const
+{
+	return m_nrOfProfileSamples;
+}
+
+
+uint64_t CPUDyntransComponent::GetNrOfProfileSamples(uint64_t pc) const
+{
+	map<uint64_t, DyntransProfileEntry>::const_iterator it = m_profilePCs.find(pc);
+	return it == m_profilePCs.end()? 0 : it->second.m_nrOfSamples;
+}
+
+
+void CPUDyntransComponent::ShowProfile(GXemul* gxemul, size_t nrOfEntries)
+{
+	stringstream ss;
+	ss << "translation cache: " << m_translationCache.GetNrOfHits() << " hits, "
+	    << m_translationCache.GetNrOfMisses() << " misses, "
+	    << m_translationCache.GetNrOfEvictions() << " evictions\n";
+
+	if (!m_profiling && m_nrOfProfileSamples == 0)
+		ss << "profiling is not enabled; set " << GenerateShortestPossiblePath()
+		    << ".profiling = true to collect samples\n";
+
+	ss << m_nrOfProfileSamples << " samples (approximately one per "
+	    << DYNTRANS_PROFILE_INTERVAL << " instructions)\n";
+
+	gxemul->GetUI()->ShowDebugMessage(this, ss.str());
+
+	if (m_nrOfProfileSamples == 0)
+		return;
+
+	// Sort by number of samples, highest first:
+	vector< std::pair<uint64_t, uint64_t> > pcs;
+	for (map<uint64_t, DyntransProfileEntry>::const_iterator it = m_profilePCs.begin();
+	    it != m_profilePCs.end(); ++it)
+		pcs.push_back(std::make_pair(it->second.m_nrOfSamples, it->first));
+
+	vector< std::pair<uint64_t, DyntransICFunction> > functions;
+	for (map<DyntransICFunction, DyntransProfileEntry>::const_iterator it = m_profileICFunctions.begin();
+	    it != m_profileICFunctions.end(); ++it)
+		functions.push_back(std::make_pair(it->second.m_nrOfSamples, it->first));
+
+	std::sort(pcs.rbegin(), pcs.rend());
+	std::sort(functions.rbegin(), functions.rend());
+
+	stringstream hotPCs;
+	hotPCs << "hottest guest addresses:\n";
+
+	for (size_t i=0; i<pcs.size() && i<nrOfEntries; ++i) {
+		uint64_t pc = pcs[i].second;
+
+		hotPCs << std::setw(6) << std::fixed << std::setprecision(2)
+		    << (100.0 * pcs[i].first / m_nrOfProfileSamples) << "%  ";
+
+		string symbol = GetSymbolRegistry().LookupAddress(pc, true);
+		if (symbol != "")
+			hotPCs << "<" << symbol << ">";
+
+		hotPCs << "\n\t";
+		Unassemble(1, false, pc, hotPCs);
+	}
+
+	gxemul->GetUI()->ShowDebugMessage(this, hotPCs.str());
+
+	stringstream hotFunctions;
+	hotFunctions << "hottest instruction call implementations:\n";
+
+	for (size_t i=0; i<functions.size() && i<nrOfEntries; ++i) {
+		const DyntransProfileEntry& entry = m_profileICFunctions[functions[i].second];
+
+		hotFunctions << std::setw(6) << std::fixed << std::setprecision(2)
+		    << (100.0 * functions[i].first / m_nrOfProfileSamples) << "%  ";
+
+		hotFunctions.flags(std::ios::hex | std::ios::showbase);
+		hotFunctions << "f = " << (size_t) functions[i].second << ", e.g.:\n\t";
+		hotFunctions.flags(std::ios::dec);
+
+		Unassemble(1, false, entry.m_examplePC, hotFunctions);
+	}
+
+	gxemul->GetUI()->ShowDebugMessage(this, hotFunctions.str());
+}
+
+
+void CPUDyntransComponent::GetMethodNames(vector<string>& names) const
+{
+	// Add our method names...
+	names.push_back("profile");
+
+	// ... and make sure to call the base class implementation:
+	CPUComponent::GetMethodNames(names);
+}
+
+
+void CPUDyntransComponent::ExecuteMethod(GXemul* gxemul, const string& methodName,
+	const vector<string>& arguments)
+{
+	if (methodName == "profile") {
+		size_t nrOfEntries = 10;
+
+		if (arguments.size() > 1) {
+			gxemul->GetUI()->ShowDebugMessage("syntax: .profile [n | clear]\n");
+			return;
+		}
+
+		if (arguments.size() == 1) {
+			if (arguments[0] == "clear") {
+				ClearProfile();
+				return;
+			}
+
+			stringstream ss;
+			ss << arguments[0];
+			ss >> nrOfEntries;
+			if (ss.fail() || nrOfEntries == 0) {
+				gxemul->GetUI()->ShowDebugMessage("syntax: .profile [n | clear]\n");
+				return;
+			}
+		}
+
+		ShowProfile(gxemul, nrOfEntries);
+		return;
+	}
+
+	// Call base...
+	CPUComponent::ExecuteMethod(gxemul, methodName, arguments);
+}
+
+
 void CPUDyntransComponent::DyntransClearICPage(struct DyntransIC* icpage)
 {
 	// Fill the page with "to be translated" entries, which when executed
@@ -784,14 +1007,140 @@ DYNTRANS_INSTR(CPUDyntransComponent,shift_right_u64_u64asu32_imm5_truncS32)
 
 #include "ComponentFactory.h"
 
+static refcount_ptr<Component> SetupCombinationsTestProgram(GXemul& gxemul,
+	const string& machine, uint64_t addr, const uint32_t* program,
+	size_t nWords)
+{
+	gxemul.GetCommandInterpreter().RunCommand("add " + machine);
+
+	refcount_ptr<Component> cpu = gxemul.GetRootComponent()->LookupPath("root.machine0.mainbus0.cpu0");
+	UnitTest::Assert("huh? no cpu?", !cpu.IsNULL());
+
+	AddressDataBus* bus = cpu->AsAddressDataBus();
+	UnitTest::Assert("cpu should be addressable", bus != NULL);
+
+	for (size_t i=0; i<nWords; ++i) {
+		bus->AddressSelect(addr + i * sizeof(uint32_t));
+		bus->WriteData(program[i], BigEndian);
+	}
+
+	stringstream ss;
+	ss << "0x" << std::hex << addr;
+	cpu->SetVariableValue("pc", ss.str());
+	gxemul.SetRunState(GXemul::Running);
+
+	return cpu;
+}
+
+refcount_ptr<Component> CPUDyntransComponent::RunCombinationsTestProgram(
+	GXemul& gxemulA, GXemul& gxemulB, const string& machine,
+	uint64_t addr, const uint32_t* program, size_t nWords,
+	int nrOfSteps, const char** variablesToCompare)
+{
+	refcount_ptr<Component> cpuA = SetupCombinationsTestProgram(gxemulA,
+	    machine, addr, program, nWords);
+	gxemulA.Execute(nrOfSteps);
+
+	refcount_ptr<Component> cpuB = SetupCombinationsTestProgram(gxemulB,
+	    machine, addr, program, nWords);
+	for (int i=0; i<nrOfSteps; ++i) {
+		gxemulB.SetRunState(GXemul::Running);
+		gxemulB.Execute(1);
+	}
+
+	for (size_t i=0; variablesToCompare[i] != NULL; ++i)
+		UnitTest::Assert(string("mismatch for ") + variablesToCompare[i],
+		    cpuA->GetVariable(variablesToCompare[i])->ToString(),
+		    cpuB->GetVariable(variablesToCompare[i])->ToString());
+
+	return cpuA;
+}
+
 static void Test_CPUDyntransComponent_Dyntrans_PreReq()
 {
 	UnitTest::Assert("nr of dyntrans args too few", N_DYNTRANS_IC_ARGS >= 3);
 }
 
+static void Test_CPUDyntransComponent_Profile_Method()
+{
+	refcount_ptr<Component> cpu =
+	    ComponentFactory::CreateComponent("mips_cpu");
+
+	vector<string> names;
+	cpu->GetMethodNames(names);
+
+	bool found = false;
+	for (size_t i=0; i<names.size(); ++i)
+		if (names[i] == "profile")
+			found = true;
+
+	UnitTest::Assert("the profile method should exist", found);
+	UnitTest::Assert("profile method should NOT be re-executable"
+	    " without args", cpu->MethodMayBeReexecutedWithoutArgs("profile") == false);
+	UnitTest::Assert("profiling should be off by default",
+	    cpu->GetVariable("profiling")->ToString(), "false");
+}
+
+static void Test_CPUDyntransComponent_Profile_Execute()
+{
+	GXemul gxemul;
+	gxemul.GetCommandInterpreter().RunCommand("add testmips");
+
+	refcount_ptr<Component> cpu = gxemul.GetRootComponent()->LookupPath("root.machine0.mainbus0.cpu0");
+	UnitTest::Assert("huh? no cpu?", !cpu.IsNULL());
+
+	AddressDataBus* bus = cpu->AsAddressDataBus();
+	UnitTest::Assert("cpu should be addressable", bus != NULL);
+
+	uint32_t data32 = 0x1000ffff;	// b 0xffffffff80004000 (i.e. itself)
+	bus->AddressSelect(0xffffffff80004000ULL);
+	bus->WriteData(data32, BigEndian);
+
+	data32 = 0x00000000;		// nop
+	bus->AddressSelect(0xffffffff80004004ULL);
+	bus->WriteData(data32, BigEndian);
+
+	cpu->SetVariableValue("pc", "0xffffffff80004000");
+	cpu->SetVariableValue("profiling", "true");
+
+	gxemul.SetRunState(GXemul::Running);
+	gxemul.Execute(100000);
+
+	UnitTest::Assert("pc should still be in the loop",
+	    cpu->GetVariable("pc")->ToInteger() == 0xffffffff80004000ULL ||
+	    cpu->GetVariable("pc")->ToInteger() == 0xffffffff80004004ULL);
+
+	// At most one sample per DYNTRANS_PROFILE_INTERVAL instruction calls
+	// (the branch and its delay slot are executed by one call), and all
+	// of them within the loop:
+	UnitTest::Assert("cpu should be a cpu", cpu->AsCPUComponent() != NULL);
+	CPUDyntransComponent* dyntrans = static_cast<CPUDyntransComponent*>(cpu->AsCPUComponent());
+
+	uint64_t nrOfSamples = dyntrans->GetNrOfProfileSamples();
+	UnitTest::Assert("there should be samples", nrOfSamples > 0);
+	UnitTest::Assert("too many samples", nrOfSamples <= 100000 / DYNTRANS_PROFILE_INTERVAL);
+	UnitTest::Assert("the branch should have been sampled",
+	    dyntrans->GetNrOfProfileSamples(0xffffffff80004000ULL) > 0);
+	UnitTest::Assert("all samples should be within the loop",
+	    dyntrans->GetNrOfProfileSamples(0xffffffff80004000ULL) +
+	    dyntrans->GetNrOfProfileSamples(0xffffffff80004004ULL) == nrOfSamples);
+	UnitTest::Assert("no samples outside the loop",
+	    dyntrans->GetNrOfProfileSamples(0xffffffff80004008ULL) == 0);
+
+	// Showing and clearing the profile should work:
+	cpu->ExecuteMethod(&gxemul, "profile", vector<string>());
+	cpu->ExecuteMethod(&gxemul, "profile", vector<string>(1, "clear"));
+
+	UnitTest::Assert("clear should remove all samples",
+	    dyntrans->GetNrOfProfileSamples() == 0 &&
+	    dyntrans->GetNrOfProfileSamples(0xffffffff80004000ULL) == 0);
+}
+
 UNITTESTS(CPUDyntransComponent)
 {
 	UNITTEST(Test_CPUDyntransComponent_Dyntrans_PreReq);
+	UNITTEST(Test_CPUDyntransComponent_Profile_Method);
+	UNITTEST(Test_CPUDyntransComponent_Profile_Execute);
 }
 
 #endif
@@ -1642,11 +1642,10 @@ template<int scaleFactor> void M88K_CPUComponent::instr_lda(CPUDyntransComponent
  *  arg[1] = pointer to register s1
  *  arg[2] = pointer to register s2  or  uint16_t offset
  */
-template<bool store, typename T, bool doubleword, bool regofs, bool scaled, bool signedLoad> void M88K_CPUComponent::instr_loadstore(CPUDyntransComponent* cpubase, DyntransIC* ic)
+template<bool store, typename T, bool doubleword, bool regofs, bool scaled, bool signedLoad, Endianness endianness> void M88K_CPUComponent::instr_loadstore(CPUDyntransComponent* cpubase, DyntransIC* ic)
 {
 	DYNTRANS_INSTR_HEAD(M88K_CPUComponent)
 
-	// TODO: fast lookups
 	// TODO: usr access
 
 	// TODO: place in M88K's "ongoing memory transaction" registers!
@@ -1661,16 +1660,14 @@ template<bool store, typename T, bool doubleword, bool regofs, bool scaled, bool
 		return;
 	}
 
-	cpu->AddressSelect(addr);
-
 	if (store) {
 		T data = REG32(ic->arg[0]);
-		if (!cpu->WriteData(data, cpu->m_isBigEndian? BigEndian : LittleEndian)) {
+		if (!cpu->DyntransWriteData<T, endianness>(addr, data)) {
 			// TODO: failed to access memory was probably an exception. Handle this!
 		}
 	} else {
 		T data;
-		if (!cpu->ReadData(data, cpu->m_isBigEndian? BigEndian : LittleEndian)) {
+		if (!cpu->DyntransReadData<T, endianness>(addr, data)) {
 			// TODO: failed to access memory was probably an exception. Handle this!
 		}
 
@@ -1688,14 +1685,12 @@ template<bool store, typename T, bool doubleword, bool regofs, bool scaled, bool
 	if (doubleword) {
 		if (store) {
 			uint32_t data2 = (* (((uint32_t*)(ic->arg[0].p)) + 1) );
-			cpu->AddressSelect(addr + sizeof(uint32_t));
-			if (!cpu->WriteData(data2, cpu->m_isBigEndian? BigEndian : LittleEndian)) {
+			if (!cpu->DyntransWriteData<uint32_t, endianness>(addr + sizeof(uint32_t), data2)) {
 				// TODO: failed to access memory was probably an exception. Handle this!
 			}
 		} else {
 			uint32_t data2;
-			cpu->AddressSelect(addr + sizeof(uint32_t));
-			if (!cpu->ReadData(data2, cpu->m_isBigEndian? BigEndian : LittleEndian)) {
+			if (!cpu->DyntransReadData<uint32_t, endianness>(addr + sizeof(uint32_t), data2)) {
 				// TODO: failed to access memory was probably an exception. Handle this!
 			}
 
@@ -1789,17 +1784,34 @@ void M88K_CPUComponent::Translate(uint32_t iw, struct DyntransIC* ic)
 			ic->arg[1].p = &m_r[s1];
 			ic->arg[2].u32 = imm16;
 
-			switch (op26) {
-			case 0x02: ic->f = instr_loadstore<false, uint16_t, false, false, false, false>; opsize = 1; break;
-			case 0x03: ic->f = instr_loadstore<false, uint8_t,  false, false, false, false>; opsize = 0; break;
-			case 0x04: ic->f = instr_loadstore<false, uint32_t, true,  false, false, false>; opsize = 3; break;
-			case 0x05: ic->f = instr_loadstore<false, uint32_t, false, false, false, false>; opsize = 2; break;
-			case 0x06: ic->f = instr_loadstore<false, uint16_t, false, false, false, true>;  opsize = 1; break;
-			case 0x07: ic->f = instr_loadstore<false, uint8_t,  false, false, false, true>;  opsize = 0; break;
-			case 0x08: ic->f = instr_loadstore<true,  uint32_t, true,  false, false, false>; opsize = 3; break;
-			case 0x09: ic->f = instr_loadstore<true,  uint32_t, false, false, false, false>; opsize = 2; break;
-			case 0x0a: ic->f = instr_loadstore<true,  uint16_t, false, false, false, false>; opsize = 1; break;
-			case 0x0b: ic->f = instr_loadstore<true,  uint8_t,  false, false, false, false>; opsize = 0; break;
+			// Note: The endianness is part of the translation, so that
+			// it does not have to be checked at runtime.
+			if (m_isBigEndian) {
+				switch (op26) {
+				case 0x02: ic->f = instr_loadstore<false, uint16_t, false, false, false, false, BigEndian>; opsize = 1; break;
+				case 0x03: ic->f = instr_loadstore<false, uint8_t,  false, false, false, false, BigEndian>; opsize = 0; break;
+				case 0x04: ic->f = instr_loadstore<false, uint32_t, true,  false, false, false, BigEndian>; opsize = 3; break;
+				case 0x05: ic->f = instr_loadstore<false, uint32_t, false, false, false, false, BigEndian>; opsize = 2; break;
+				case 0x06: ic->f = instr_loadstore<false, uint16_t, false, false, false, true,  BigEndian>; opsize = 1; break;
+				case 0x07: ic->f = instr_loadstore<false, uint8_t,  false, false, false, true,  BigEndian>; opsize = 0; break;
+				case 0x08: ic->f = instr_loadstore<true,  uint32_t, true,  false, false, false, BigEndian>; opsize = 3; break;
+				case 0x09: ic->f = instr_loadstore<true,  uint32_t, false, false, false, false, BigEndian>; opsize = 2; break;
+				case 0x0a: ic->f = instr_loadstore<true,  uint16_t, false, false, false, false, BigEndian>; opsize = 1; break;
+				case 0x0b: ic->f = instr_loadstore<true,  uint8_t,  false, false, false, false, BigEndian>; opsize = 0; break;
+				}
+			} else {
+				switch (op26) {
+				case 0x02: ic->f = instr_loadstore<false, uint16_t, false, false, false, false, LittleEndian>; opsize = 1; break;
+				case 0x03: ic->f = instr_loadstore<false, uint8_t,  false, false, false, false, LittleEndian>; opsize = 0; break;
+				case 0x04: ic->f = instr_loadstore<false, uint32_t, true,  false, false, false, LittleEndian>; opsize = 3; break;
+				case 0x05: ic->f = instr_loadstore<false, uint32_t, false, false, false, false, LittleEndian>; opsize = 2; break;
+				case 0x06: ic->f = instr_loadstore<false, uint16_t, false, false, false, true,  LittleEndian>; opsize = 1; break;
+				case 0x07: ic->f = instr_loadstore<false, uint8_t,  false, false, false, true,  LittleEndian>; opsize = 0; break;
+				case 0x08: ic->f = instr_loadstore<true,  uint32_t, true,  false, false, false, LittleEndian>; opsize = 3; break;
+				case 0x09: ic->f = instr_loadstore<true,  uint32_t, false, false, false, false, LittleEndian>; opsize = 2; break;
+				case 0x0a: ic->f = instr_loadstore<true,  uint16_t, false, false, false, false, LittleEndian>; opsize = 1; break;
+				case 0x0b: ic->f = instr_loadstore<true,  uint8_t,  false, false, false, false, LittleEndian>; opsize = 0; break;
+				}
 			}
 
 			if (opsize == 3 && d == 31) {
@@ -2212,43 +2224,43 @@ void M88K_CPUComponent::Translate(uint32_t iw, struct DyntransIC* ic)
 					(scaled? 32 : 0) +
 					(user? 64 : 0);
 
-				// <bool store, typename T, bool doubleword, bool regofs, bool scaled, bool signedLoad>
-				//       4    ,   0123    ,       3        ,     true   ,      32    ,      8           , user (TODO)
+				// <bool store, typename T, bool doubleword, bool regofs, bool scaled, bool signedLoad, Endianness endianness>
+				//       4    ,   0123    ,       3        ,     true   ,      32    ,      8         ,         16           , user (TODO)
 				switch (n) {
 				// load = 0
-				case 0 + 0 + 0 +  0  +  0 +  0: ic->f = instr_loadstore<false, uint8_t,  false, true, false, false>; break;
-				case 0 + 0 + 0 +  0  + 32 +  0: ic->f = instr_loadstore<false, uint8_t,  false, true, true,  false>; break;
-				case 0 + 0 + 0 + 16  +  0 +  0: ic->f = instr_loadstore<false, uint8_t,  false, true, false, false>; break;
-				case 0 + 0 + 0 + 16  + 32 +  0: ic->f = instr_loadstore<false, uint8_t,  false, true, true,  false>; break;
-				case 1 + 0 + 0 +  0  +  0 +  0: ic->f = instr_loadstore<false, uint16_t, false, true, false, false>; break;
-				case 1 + 0 + 0 +  0  + 32 +  0: ic->f = instr_loadstore<false, uint16_t, false, true, true,  false>; break;
-				case 1 + 0 + 0 + 16  +  0 +  0: ic->f = instr_loadstore<false, uint16_t, false, true, false, false>; break;
-				case 1 + 0 + 0 + 16  + 32 +  0: ic->f = instr_loadstore<false, uint16_t, false, true, true,  false>; break;
-				case 2 + 0 + 0 +  0  +  0 +  0: ic->f = instr_loadstore<false, uint32_t, false, true, false, false>; break;
-				case 2 + 0 + 0 +  0  + 32 +  0: ic->f = instr_loadstore<false, uint32_t, false, true, true,  false>; break;
-				case 2 + 0 + 0 + 16  +  0 +  0: ic->f = instr_loadstore<false, uint32_t, false, true, false, false>; break;
-				case 2 + 0 + 0 + 16  + 32 +  0: ic->f = instr_loadstore<false, uint32_t, false, true, true,  false>; break;
-				case 3 + 0 + 0 +  0  +  0 +  0: ic->f = instr_loadstore<false, uint32_t, true,  true, false, false>; break;
-				case 3 + 0 + 0 +  0  + 32 +  0: ic->f = instr_loadstore<false, uint32_t, true,  true, true,  false>; break;
-				case 3 + 0 + 0 + 16  +  0 +  0: ic->f = instr_loadstore<false, uint32_t, true,  true, false, false>; break;
-				case 3 + 0 + 0 + 16  + 32 +  0: ic->f = instr_loadstore<false, uint32_t, true,  true, true,  false>; break;
+				case 0 + 0 + 0 +  0  +  0 +  0: ic->f = instr_loadstore<false, uint8_t,  false, true, false, false, LittleEndian>; break;
+				case 0 + 0 + 0 +  0  + 32 +  0: ic->f = instr_loadstore<false, uint8_t,  false, true, true,  false, LittleEndian>; break;
+				case 0 + 0 + 0 + 16  +  0 +  0: ic->f = instr_loadstore<false, uint8_t,  false, true, false, false, BigEndian>; break;
+				case 0 + 0 + 0 + 16  + 32 +  0: ic->f = instr_loadstore<false, uint8_t,  false, true, true,  false, BigEndian>; break;
+				case 1 + 0 + 0 +  0  +  0 +  0: ic->f = instr_loadstore<false, uint16_t, false, true, false, false, LittleEndian>; break;
+				case 1 + 0 + 0 +  0  + 32 +  0: ic->f = instr_loadstore<false, uint16_t, false, true, true,  false, LittleEndian>; break;
+				case 1 + 0 + 0 + 16  +  0 +  0: ic->f = instr_loadstore<false, uint16_t, false, true, false, false, BigEndian>; break;
+				case 1 + 0 + 0 + 16  + 32 +  0: ic->f = instr_loadstore<false, uint16_t, false, true, true,  false, BigEndian>; break;
+				case 2 + 0 + 0 +  0  +  0 +  0: ic->f = instr_loadstore<false, uint32_t, false, true, false, false, LittleEndian>; break;
+				case 2 + 0 + 0 +  0  + 32 +  0: ic->f = instr_loadstore<false, uint32_t, false, true, true,  false, LittleEndian>; break;
+				case 2 + 0 + 0 + 16  +  0 +  0: ic->f = instr_loadstore<false, uint32_t, false, true, false, false, BigEndian>; break;
+				case 2 + 0 + 0 + 16  + 32 +  0: ic->f = instr_loadstore<false, uint32_t, false, true, true,  false, BigEndian>; break;
+				case 3 + 0 + 0 +  0  +  0 +  0: ic->f = instr_loadstore<false, uint32_t, true,  true, false, false, LittleEndian>; break;
+				case 3 + 0 + 0 +  0  + 32 +  0: ic->f = instr_loadstore<false, uint32_t, true,  true, true,  false, LittleEndian>; break;
+				case 3 + 0 + 0 + 16  +  0 +  0: ic->f = instr_loadstore<false, uint32_t, true,  true, false, false, BigEndian>; break;
+				case 3 + 0 + 0 + 16  + 32 +  0: ic->f = instr_loadstore<false, uint32_t, true,  true, true,  false, BigEndian>; break;
 				// store = 4
-				case 0 + 4 + 0 +  0  +  0 +  0: ic->f = instr_loadstore<true, uint8_t,  false, true, false, false>; break;
-				case 0 + 4 + 0 +  0  + 32 +  0: ic->f = instr_loadstore<true, uint8_t,  false, true, true,  false>; break;
-				case 0 + 4 + 0 + 16  +  0 +  0: ic->f = instr_loadstore<true, uint8_t,  false, true, false, false>; break;
-				case 0 + 4 + 0 + 16  + 32 +  0: ic->f = instr_loadstore<true, uint8_t,  false, true, true,  false>; break;
-				case 1 + 4 + 0 +  0  +  0 +  0: ic->f = instr_loadstore<true, uint16_t, false, true, false, false>; break;
-				case 1 + 4 + 0 +  0  + 32 +  0: ic->f = instr_loadstore<true, uint16_t, false, true, true,  false>; break;
-				case 1 + 4 + 0 + 16  +  0 +  0: ic->f = instr_loadstore<true, uint16_t, false, true, false, false>; break;
-				case 1 + 4 + 0 + 16  + 32 +  0: ic->f = instr_loadstore<true, uint16_t, false, true, true,  false>; break;
-				case 2 + 4 + 0 +  0  +  0 +  0: ic->f = instr_loadstore<true, uint32_t, false, true, false, false>; break;
-				case 2 + 4 + 0 +  0  + 32 +  0: ic->f = instr_loadstore<true, uint32_t, false, true, true,  false>; break;
-				case 2 + 4 + 0 + 16  +  0 +  0: ic->f = instr_loadstore<true, uint32_t, false, true, false, false>; break;
-				case 2 + 4 + 0 + 16  + 32 +  0: ic->f = instr_loadstore<true, uint32_t, false, true, true,  false>; break;
-				case 3 + 4 + 0 +  0  +  0 +  0: ic->f = instr_loadstore<true, uint32_t, true,  true, false, false>; break;
-				case 3 + 4 + 0 +  0  + 32 +  0: ic->f = instr_loadstore<true, uint32_t, true,  true, true,  false>; break;
-				case 3 + 4 + 0 + 16  +  0 +  0: ic->f = instr_loadstore<true, uint32_t, true,  true, false, false>; break;
-				case 3 + 4 + 0 + 16  + 32 +  0: ic->f = instr_loadstore<true, uint32_t, true,  true, true,  false>; break;
+				case 0 + 4 + 0 +  0  +  0 +  0: ic->f = instr_loadstore<true, uint8_t,  false, true, false, false, LittleEndian>; break;
+				case 0 + 4 + 0 +  0  + 32 +  0: ic->f = instr_loadstore<true, uint8_t,  false, true, true,  false, LittleEndian>; break;
+				case 0 + 4 + 0 + 16  +  0 +  0: ic->f = instr_loadstore<true, uint8_t,  false, true, false, false, BigEndian>; break;
+				case 0 + 4 + 0 + 16  + 32 +  0: ic->f = instr_loadstore<true, uint8_t,  false, true, true,  false, BigEndian>; break;
+				case 1 + 4 + 0 +  0  +  0 +  0: ic->f = instr_loadstore<true, uint16_t, false, true, false, false, LittleEndian>; break;
+				case 1 + 4 + 0 +  0  + 32 +  0: ic->f = instr_loadstore<true, uint16_t, false, true, true,  false, LittleEndian>; break;
+				case 1 + 4 + 0 + 16  +  0 +  0: ic->f = instr_loadstore<true, uint16_t, false, true, false, false, BigEndian>; break;
+				case 1 + 4 + 0 + 16  + 32 +  0: ic->f = instr_loadstore<true, uint16_t, false, true, true,  false, BigEndian>; break;
+				case 2 + 4 + 0 +  0  +  0 +  0: ic->f = instr_loadstore<true, uint32_t, false, true, false, false, LittleEndian>; break;
+				case 2 + 4 + 0 +  0  + 32 +  0: ic->f = instr_loadstore<true, uint32_t, false, true, true,  false, LittleEndian>; break;
+				case 2 + 4 + 0 + 16  +  0 +  0: ic->f = instr_loadstore<true, uint32_t, false, true, false, false, BigEndian>; break;
+				case 2 + 4 + 0 + 16  + 32 +  0: ic->f = instr_loadstore<true, uint32_t, false, true, true,  false, BigEndian>; break;
+				case 3 + 4 + 0 +  0  +  0 +  0: ic->f = instr_loadstore<true, uint32_t, true,  true, false, false, LittleEndian>; break;
+				case 3 + 4 + 0 +  0  + 32 +  0: ic->f = instr_loadstore<true, uint32_t, true,  true, true,  false, LittleEndian>; break;
+				case 3 + 4 + 0 + 16  +  0 +  0: ic->f = instr_loadstore<true, uint32_t, true,  true, false, false, BigEndian>; break;
+				case 3 + 4 + 0 + 16  + 32 +  0: ic->f = instr_loadstore<true, uint32_t, true,  true, true,  false, BigEndian>; break;
 				default:
 					std::cerr << "TODO generalize! scaled="<<scaled << " user="<<
 						user<<" signedness="<<signedness << " opsize=" << opsize << "\n";
@@ -2458,6 +2470,64 @@ void M88K_CPUComponent::Translate(uint32_t iw, struct DyntransIC* ic)
 			ui->ShowDebugMessage(this, ss.str());
 		}
 	}
+
+	TranslateCombinations(ic);
+}
+
+
+/*
+ * Replaces the instruction call before ic with a combined instruction call,
+ * for some common pairs of instructions:
+ *
+ *	or.u + or		load of a 32-bit constant
+ *	or.u + ld/st		hi16/lo16 addressing
+ *	cmp + bb0/bb1[.n]	compare and branch
+ *	ld + ld, st + st	load/store bursts (e.g. register save/restore
+ *				sequences, or unrolled memcpy loops)
+ */
+void M88K_CPUComponent::TranslateCombinations(struct DyntransIC* ic)
+{
+	if (ic->f == NULL)
+		return;
+
+	// or.u + or:
+	if (DyntransCombine<instr_or_u32_u32_immu32, instr_or_u32_u32_immu32, 2>(ic))
+		return;
+
+	// cmp + bb0/bb1:
+	if (DyntransCombine<instr_cmp,     instr_bb<false, false>, 2>(ic) ||
+	    DyntransCombine<instr_cmp,     instr_bb<false, true>,  2>(ic) ||
+	    DyntransCombine<instr_cmp,     instr_bb<true,  false>, 2>(ic) ||
+	    DyntransCombine<instr_cmp,     instr_bb<true,  true>,  2>(ic) ||
+	    DyntransCombine<instr_cmp,     instr_bb_n<false>,      3>(ic) ||
+	    DyntransCombine<instr_cmp,     instr_bb_n<true>,       3>(ic) ||
+	    DyntransCombine<instr_cmp_imm, instr_bb<false, false>, 2>(ic) ||
+	    DyntransCombine<instr_cmp_imm, instr_bb<false, true>,  2>(ic) ||
+	    DyntransCombine<instr_cmp_imm, instr_bb<true,  false>, 2>(ic) ||
+	    DyntransCombine<instr_cmp_imm, instr_bb<true,  true>,  2>(ic) ||
+	    DyntransCombine<instr_cmp_imm, instr_bb_n<false>,      3>(ic) ||
+	    DyntransCombine<instr_cmp_imm, instr_bb_n<true>,       3>(ic))
+		return;
+
+	// or.u + ld/st, and load/store bursts:
+	if (m_isBigEndian)
+		TranslateLoadStoreCombinations<BigEndian>(ic);
+	else
+		TranslateLoadStoreCombinations<LittleEndian>(ic);
+}
+
+
+template<Endianness endianness>
+bool M88K_CPUComponent::TranslateLoadStoreCombinations(struct DyntransIC* ic)
+{
+	return DyntransCombine<instr_or_u32_u32_immu32,
+	        instr_loadstore<false, uint32_t, false, false, false, false, endianness>, 2>(ic) ||
+	    DyntransCombine<instr_or_u32_u32_immu32,
+	        instr_loadstore<true,  uint32_t, false, false, false, false, endianness>, 2>(ic) ||
+	    DyntransCombine<instr_loadstore<false, uint32_t, false, false, false, false, endianness>,
+	        instr_loadstore<false, uint32_t, false, false, false, false, endianness>, 2>(ic) ||
+	    DyntransCombine<instr_loadstore<true,  uint32_t, false, false, false, false, endianness>,
+	        instr_loadstore<true,  uint32_t, false, false, false, false, endianness>, 2>(ic);
 }
 
 
@@ -2863,6 +2933,37 @@ static void Test_M88K_CPUComponent_Execute_EarlyAbortDuringRuntime_Running()
 	UnitTest::Assert("delay target should not have been updated", cpu->GetVariable("delaySlotTarget")->ToInteger(), 0x1040);
 }
 
+static void Test_M88K_CPUComponent_Execute_Combinations()
+{
+	const uint32_t program[] = {
+		0x5c401234,	// or.u  r2,r0,0x1234
+		0x58425678,	// or    r2,r2,0x5678
+		0x60600005,	// addu  r3,r0,5
+		0x64630001,	// loop: subu r3,r3,1
+		0x7c830000,	// cmp   r4,r3,0
+		0xd864fffe,	// bb1   ne,r4,loop
+		0x24402000,	// st    r2,r0,0x2000
+		0x24602004,	// st    r3,r0,0x2004
+		0x14a02000,	// ld    r5,r0,0x2000
+		0x14c02004,	// ld    r6,r0,0x2004
+		0xd0000000	// bb0   0,r0,(self)
+	};
+
+	const char* names[] = { "pc", "r2", "r3", "r4", "r5", "r6", "step", NULL };
+
+	GXemul gxemulA, gxemulB;
+	refcount_ptr<Component> cpu =
+	    CPUDyntransComponent::RunCombinationsTestProgram(gxemulA, gxemulB,
+	    "testm88k", 0x1000, program,
+	    sizeof(program) / sizeof(program[0]), 200, names);
+
+	UnitTest::Assert("r2", cpu->GetVariable("r2")->ToInteger(), 0x12345678);
+	UnitTest::Assert("r3", cpu->GetVariable("r3")->ToInteger(), 0);
+	UnitTest::Assert("r4", cpu->GetVariable("r4")->ToInteger() & M88K_CMP_EQ, M88K_CMP_EQ);
+	UnitTest::Assert("r5", cpu->GetVariable("r5")->ToInteger(), 0x12345678);
+	UnitTest::Assert("r6", cpu->GetVariable("r6")->ToInteger(), 0);
+}
+
 UNITTESTS(M88K_CPUComponent)
 {
 	UNITTEST(Test_M88K_CPUComponent_IsStable);
@@ -2882,6 +2983,7 @@ UNITTESTS(M88K_CPUComponent)
 	UNITTEST(Test_M88K_CPUComponent_Execute_DelayBranchWithFault);
 	UNITTEST(Test_M88K_CPUComponent_Execute_EarlyAbortDuringRuntime_Singlestep);
 	UNITTEST(Test_M88K_CPUComponent_Execute_EarlyAbortDuringRuntime_Running);
+	UNITTEST(Test_M88K_CPUComponent_Execute_Combinations);
 //	UNITTEST(Test_M88K_CPUComponent_Execute_LateAbortDuringRuntime);
 }
 
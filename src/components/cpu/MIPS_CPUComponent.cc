@@ -1144,12 +1144,10 @@ DYNTRANS_INSTR(MIPS_CPUComponent,sltu)
 }
 
 
-template<bool store, typename addressType, typename T, bool signedLoad> void MIPS_CPUComponent::instr_loadstore(CPUDyntransComponent* cpubase, DyntransIC* ic)
+template<bool store, typename addressType, typename T, bool signedLoad, Endianness endianness> void MIPS_CPUComponent::instr_loadstore(CPUDyntransComponent* cpubase, DyntransIC* ic)
 {
 	DYNTRANS_INSTR_HEAD(MIPS_CPUComponent)
 
-	// TODO: fast lookups
-
 	uint64_t addr;
 
 	if (sizeof(addressType) == sizeof(uint64_t))
@@ -1165,16 +1163,14 @@ template<bool store, typename addressType, typename T, bool signedLoad> void MIP
 		return;
 	}
 
-	cpu->AddressSelect(addr);
-
 	if (store) {
 		T data = REG64(ic->arg[0]);
-		if (!cpu->WriteData(data, cpu->m_isBigEndian? BigEndian : LittleEndian)) {
+		if (!cpu->DyntransWriteData<T, endianness>(addr, data)) {
 			// TODO: failed to access memory was probably an exception. Handle this!
 		}
 	} else {
 		T data;
-		if (!cpu->ReadData(data, cpu->m_isBigEndian? BigEndian : LittleEndian)) {
+		if (!cpu->DyntransReadData<T, endianness>(addr, data)) {
 			// TODO: failed to access memory was probably an exception. Handle this!
 		}
 
@@ -1655,17 +1651,31 @@ void MIPS_CPUComponent::Translate(uint32_t iword, struct DyntransIC* ic)
 
 			bool store = false;
 
-			if (Is32Bit()) {
+			// Note: The endianness is part of the translation, so that
+			// it does not have to be checked at runtime.
+			if (Is32Bit() && m_isBigEndian) {
+				switch (hi6) {
+				case HI6_LW:  ic->f = instr_loadstore<false, int32_t,  uint32_t, true,  BigEndian>;  break;
+				case HI6_SB:  ic->f = instr_loadstore<true,  int32_t,  uint8_t,  false, BigEndian>; store = true; break;
+				case HI6_SW:  ic->f = instr_loadstore<true,  int32_t,  uint32_t, false, BigEndian>; store = true; break;
+				}
+			} else if (Is32Bit()) {
 				switch (hi6) {
-				case HI6_LW:  ic->f = instr_loadstore<false, int32_t,  uint32_t, true>;  break;
-				case HI6_SB:  ic->f = instr_loadstore<true,  int32_t,  uint8_t,  false>; store = true; break;
-				case HI6_SW:  ic->f = instr_loadstore<true,  int32_t,  uint32_t, false>; store = true; break;
+				case HI6_LW:  ic->f = instr_loadstore<false, int32_t,  uint32_t, true,  LittleEndian>;  break;
+				case HI6_SB:  ic->f = instr_loadstore<true,  int32_t,  uint8_t,  false, LittleEndian>; store = true; break;
+				case HI6_SW:  ic->f = instr_loadstore<true,  int32_t,  uint32_t, false, LittleEndian>; store = true; break;
+				}
+			} else if (m_isBigEndian) {
+				switch (hi6) {
+				case HI6_LW:  ic->f = instr_loadstore<false, uint64_t, uint32_t, true,  BigEndian>;  break;
+				case HI6_SB:  ic->f = instr_loadstore<true,  uint64_t, uint8_t,  false, BigEndian>; store = true; break;
+				case HI6_SW:  ic->f = instr_loadstore<true,  uint64_t, uint32_t, false, BigEndian>; store = true; break;
 				}
 			} else {
 				switch (hi6) {
-				case HI6_LW:  ic->f = instr_loadstore<false, uint64_t, uint32_t, true>;  break;
-				case HI6_SB:  ic->f = instr_loadstore<true,  uint64_t, uint8_t,  false>; store = true; break;
-				case HI6_SW:  ic->f = instr_loadstore<true,  uint64_t, uint32_t, false>; store = true; break;
+				case HI6_LW:  ic->f = instr_loadstore<false, uint64_t, uint32_t, true,  LittleEndian>;  break;
+				case HI6_SB:  ic->f = instr_loadstore<true,  uint64_t, uint8_t,  false, LittleEndian>; store = true; break;
+				case HI6_SW:  ic->f = instr_loadstore<true,  uint64_t, uint32_t, false, LittleEndian>; store = true; break;
 				}
 			}
 
@@ -1734,6 +1744,78 @@ void MIPS_CPUComponent::Translate(uint32_t iword, struct DyntransIC* ic)
 			ui->ShowDebugMessage(this, ss.str());
 		}
 	}
+
+	TranslateCombinations(ic);
+}
+
+
+/*
+ * Replaces the instruction call before ic with a combined instruction call,
+ * for some common pairs of instructions:
+ *
+ *	lui + addiu/ori		load of a 32-bit constant
+ *	lui + lw/sw		%hi/%lo addressing
+ *	slt[u] + beq/bne	compare and branch
+ *	addiu + b*		loop counter update and branch
+ *	lw + lw, sw + sw,	load/store bursts (e.g. register save/restore
+ *	sb + sb			sequences, or unrolled memcpy/memset loops)
+ */
+void MIPS_CPUComponent::TranslateCombinations(struct DyntransIC* ic)
+{
+	if (ic->f == NULL)
+		return;
+
+	// lui + addiu/ori:
+	if (DyntransCombine<instr_set_u64_imms32, instr_add_u64_u64_imms32_truncS32, 2>(ic) ||
+	    DyntransCombine<instr_set_u64_imms32, instr_or_u64_u64_immu32, 2>(ic))
+		return;
+
+	// slt[u] + beq/bne:
+	if (DyntransCombine<instr_slt,  instr_b<0, false, false>, 3>(ic) ||
+	    DyntransCombine<instr_slt,  instr_b<0, true,  false>, 3>(ic) ||
+	    DyntransCombine<instr_slt,  instr_b<1, false, false>, 3>(ic) ||
+	    DyntransCombine<instr_slt,  instr_b<1, true,  false>, 3>(ic) ||
+	    DyntransCombine<instr_sltu, instr_b<0, false, false>, 3>(ic) ||
+	    DyntransCombine<instr_sltu, instr_b<0, true,  false>, 3>(ic) ||
+	    DyntransCombine<instr_sltu, instr_b<1, false, false>, 3>(ic) ||
+	    DyntransCombine<instr_sltu, instr_b<1, true,  false>, 3>(ic))
+		return;
+
+	// addiu + b*:
+	if (DyntransCombine<instr_add_u64_u64_imms32_truncS32, instr_b<0, true,  false>, 3>(ic) ||
+	    DyntransCombine<instr_add_u64_u64_imms32_truncS32, instr_b<1, true,  false>, 3>(ic) ||
+	    DyntransCombine<instr_add_u64_u64_imms32_truncS32, instr_b<2, true,  false>, 3>(ic) ||
+	    DyntransCombine<instr_add_u64_u64_imms32_truncS32, instr_b<3, true,  false>, 3>(ic))
+		return;
+
+	// lui + lw/sw, and load/store bursts:
+	if (Is32Bit()) {
+		if (m_isBigEndian)
+			TranslateLoadStoreCombinations<int32_t, BigEndian>(ic);
+		else
+			TranslateLoadStoreCombinations<int32_t, LittleEndian>(ic);
+	} else {
+		if (m_isBigEndian)
+			TranslateLoadStoreCombinations<uint64_t, BigEndian>(ic);
+		else
+			TranslateLoadStoreCombinations<uint64_t, LittleEndian>(ic);
+	}
+}
+
+
+template<typename addressType, Endianness endianness>
+bool MIPS_CPUComponent::TranslateLoadStoreCombinations(struct DyntransIC* ic)
+{
+	return DyntransCombine<instr_set_u64_imms32,
+	        instr_loadstore<false, addressType, uint32_t, true,  endianness>, 2>(ic) ||
+	    DyntransCombine<instr_set_u64_imms32,
+	        instr_loadstore<true,  addressType, uint32_t, false, endianness>, 2>(ic) ||
+	    DyntransCombine<instr_loadstore<false, addressType, uint32_t, true,  endianness>,
+	        instr_loadstore<false, addressType, uint32_t, true,  endianness>, 2>(ic) ||
+	    DyntransCombine<instr_loadstore<true,  addressType, uint32_t, false, endianness>,
+	        instr_loadstore<true,  addressType, uint32_t, false, endianness>, 2>(ic) ||
+	    DyntransCombine<instr_loadstore<true,  addressType, uint8_t,  false, endianness>,
+	        instr_loadstore<true,  addressType, uint8_t,  false, endianness>, 2>(ic);
 }
 
 
@@ -2011,6 +2093,88 @@ static void Test_MIPS_CPUComponent_Execute_DelayBranchWithFault()
 	UnitTest::Assert("should still be in delay slot", cpu->GetVariable("inDelaySlot")->ToString(), "true");
 }
 
+static void Test_MIPS_CPUComponent_Execute_Combinations()
+{
+	const uint32_t program[] = {
+		0x3c101234,	// lui   s0,0x1234
+		0x36105678,	// ori   s0,s0,0x5678
+		0x3c11ffff,	// lui   s1,0xffff
+		0x2631ffff,	// addiu s1,s1,-1
+		0x24120005,	// addiu s2,zr,5
+		0x2652ffff,	// loop: addiu s2,s2,-1
+		0x1e40fffe,	// bgtz  s2,loop
+		0x26730001,	// addiu s3,s3,1   (delay slot)
+		0x0250a02a,	// slt   s4,s2,s0
+		0x16800002,	// bne   s4,zr,skip
+		0x24150007,	// addiu s5,zr,7   (delay slot)
+		0x24160009,	// addiu s6,zr,9
+		0xafb00000,	// skip: sw s0,0(sp)
+		0xafb10004,	// sw    s1,4(sp)
+		0x8fb70000,	// lw    s7,0(sp)
+		0x8fb80004,	// lw    t8,4(sp)
+		0x1000ffff,	// b     (self)
+		0x00000000	// nop
+	};
+
+	const char* names[] = { "pc", "s0", "s1", "s2", "s3", "s4", "s5",
+	    "s6", "s7", "t8", "inDelaySlot", "step", NULL };
+
+	GXemul gxemulA, gxemulB;
+	refcount_ptr<Component> cpu =
+	    CPUDyntransComponent::RunCombinationsTestProgram(gxemulA, gxemulB,
+	    "testmips", 0xffffffff80004000ULL, program,
+	    sizeof(program) / sizeof(program[0]), 200, names);
+
+	UnitTest::Assert("s0", cpu->GetVariable("s0")->ToInteger(), 0x12345678);
+	UnitTest::Assert("s1", cpu->GetVariable("s1")->ToInteger(), 0xfffffffffffeffffULL);
+	UnitTest::Assert("s2", cpu->GetVariable("s2")->ToInteger(), 0);
+	UnitTest::Assert("s3", cpu->GetVariable("s3")->ToInteger(), 5);
+	UnitTest::Assert("s4", cpu->GetVariable("s4")->ToInteger(), 1);
+	UnitTest::Assert("s5", cpu->GetVariable("s5")->ToInteger(), 7);
+	UnitTest::Assert("s6", cpu->GetVariable("s6")->ToInteger(), 0);
+	UnitTest::Assert("s7", cpu->GetVariable("s7")->ToInteger(), 0x12345678);
+	UnitTest::Assert("t8", cpu->GetVariable("t8")->ToInteger(), 0xfffffffffffeffffULL);
+}
+
+static void Test_MIPS_CPUComponent_Execute_LoadStore_LittleEndian()
+{
+	GXemul gxemul;
+	gxemul.GetCommandInterpreter().RunCommand("add testmips");
+
+	refcount_ptr<Component> cpu = gxemul.GetRootComponent()->LookupPath("root.machine0.mainbus0.cpu0");
+	AddressDataBus* bus = cpu->AsAddressDataBus();
+	cpu->SetVariableValue("bigendian", "false");
+
+	const uint32_t program[] = {
+		0x3c101234,	// lui   s0,0x1234
+		0x36105678,	// ori   s0,s0,0x5678
+		0xafb00000,	// sw    s0,0(sp)
+		0xa3b00005,	// sb    s0,5(sp)
+		0x8fb10000,	// lw    s1,0(sp)
+		0x8fb20004,	// lw    s2,4(sp)
+		0x1000ffff,	// b     (self)
+		0x00000000	// nop
+	};
+
+	for (size_t i=0; i<sizeof(program) / sizeof(program[0]); ++i) {
+		bus->AddressSelect(0xffffffff80004000ULL + i * sizeof(uint32_t));
+		bus->WriteData(program[i], LittleEndian);
+	}
+
+	cpu->SetVariableValue("pc", "0xffffffff80004000");
+	gxemul.SetRunState(GXemul::Running);
+	gxemul.Execute(20);
+
+	UnitTest::Assert("s1", cpu->GetVariable("s1")->ToInteger(), 0x12345678);
+	UnitTest::Assert("s2", cpu->GetVariable("s2")->ToInteger(), 0x7800);
+
+	uint64_t sp = cpu->GetVariable("sp")->ToInteger();
+	uint32_t data32 = 0;
+	bus->AddressSelect(sp);
+	bus->ReadData(data32, LittleEndian);
+	UnitTest::Assert("memory contents", data32, 0x12345678);
+}
+
 UNITTESTS(MIPS_CPUComponent)
 {
 	UNITTEST(Test_MIPS_CPUComponent_IsStable);
@@ -2027,6 +2191,8 @@ UNITTESTS(MIPS_CPUComponent)
 	UNITTEST(Test_MIPS_CPUComponent_Execute_DelayBranchWithValidInstruction_SingleStepping);
 	UNITTEST(Test_MIPS_CPUComponent_Execute_DelayBranchWithValidInstruction_RunTwoTimes);
 	UNITTEST(Test_MIPS_CPUComponent_Execute_DelayBranchWithFault);
+	UNITTEST(Test_MIPS_CPUComponent_Execute_Combinations);
+	UNITTEST(Test_MIPS_CPUComponent_Execute_LoadStore_LittleEndian);
 }
 
 #endif
@@ -218,7 +218,7 @@ void RAMComponent::AddressSelect(uint64_t address)
 }
 
 
-void* RAMComponent::AllocateBlock()
+void* RAMComponent::AllocateBlock(uint64_t blockNr)
 {
 	void * p = mmap(NULL, m_blockSize, PROT_WRITE | PROT_READ,
 	    MAP_ANON | MAP_PRIVATE, -1, 0);
@@ -229,8 +229,6 @@ void* RAMComponent::AllocateBlock()
 		throw std::exception();
 	}
 
-	uint64_t blockNr = m_addressSelect >> m_blockSizeShift;
-
 	if (blockNr+1 > m_memoryBlocks.size())
 		m_memoryBlocks.resize(blockNr + 1);
 
@@ -240,6 +238,32 @@ void* RAMComponent::AllocateBlock()
 }
 
 
+uint8_t* RAMComponent::LookupHostPage(uint64_t address, uint64_t pageSize,
+	bool forWriting)
+{
+	if (pageSize > m_blockSize || (forWriting && m_writeProtected))
+		return NULL;
+
+	uint64_t blockNr = address >> m_blockSizeShift;
+	void* block = blockNr < m_memoryBlocks.size()?
+	    m_memoryBlocks[blockNr] : NULL;
+
+	// Unwritten memory reads as zeroes, without being allocated. Only
+	// allocate a block when it is actually about to be written to.
+	if (block == NULL) {
+		if (!forWriting)
+			return NULL;
+
+		block = AllocateBlock(blockNr);
+
+		// The selected block may have been the one just allocated:
+		AddressSelect(m_addressSelect);
+	}
+
+	return (uint8_t*)block + (address & (m_blockSize-1) & ~(pageSize-1));
+}
+
+
 bool RAMComponent::ReadData(uint8_t& data, Endianness endianness)
 {
 	if (m_selectedHostMemoryBlock == NULL)
@@ -258,14 +282,12 @@ bool RAMComponent::ReadData(uint16_t& data, Endianness endianness)
 
 	if (m_selectedHostMemoryBlock == NULL)
 		data = 0;
+	else if (endianness == BigEndian)
+		data = ReadHostMemory<uint16_t, BigEndian>((uint8_t*)
+		    m_selectedHostMemoryBlock + m_selectedOffsetWithinBlock);
 	else
-		data = (((uint16_t*)m_selectedHostMemoryBlock)
-		    [m_selectedOffsetWithinBlock >> 1]);
-
-	if (endianness == BigEndian)
-		data = BE16_TO_HOST(data);
-	else
-		data = LE16_TO_HOST(data);
+		data = ReadHostMemory<uint16_t, LittleEndian>((uint8_t*)
+		    m_selectedHostMemoryBlock + m_selectedOffsetWithinBlock);
 
 	return true;
 }
@@ -277,14 +299,12 @@ bool RAMComponent::ReadData(uint32_t& data, Endianness endianness)
 
 	if (m_selectedHostMemoryBlock == NULL)
 		data = 0;
+	else if (endianness == BigEndian)
+		data = ReadHostMemory<uint32_t, BigEndian>((uint8_t*)
+		    m_selectedHostMemoryBlock + m_selectedOffsetWithinBlock);
 	else
-		data = (((uint32_t*)m_selectedHostMemoryBlock)
-		    [m_selectedOffsetWithinBlock >> 2]);
-
-	if (endianness == BigEndian)
-		data = BE32_TO_HOST(data);
-	else
-		data = LE32_TO_HOST(data);
+		data = ReadHostMemory<uint32_t, LittleEndian>((uint8_t*)
+		    m_selectedHostMemoryBlock + m_selectedOffsetWithinBlock);
 
 	return true;
 }
@@ -296,14 +316,12 @@ bool RAMComponent::ReadData(uint64_t& data, Endianness endianness)
 
 	if (m_selectedHostMemoryBlock == NULL)
 		data = 0;
+	else if (endianness == BigEndian)
+		data = ReadHostMemory<uint64_t, BigEndian>((uint8_t*)
+		    m_selectedHostMemoryBlock + m_selectedOffsetWithinBlock);
 	else
-		data = (((uint64_t*)m_selectedHostMemoryBlock)
-		    [m_selectedOffsetWithinBlock >> 3]);
-
-	if (endianness == BigEndian)
-		data = BE64_TO_HOST(data);
-	else
-		data = LE64_TO_HOST(data);
+		data = ReadHostMemory<uint64_t, LittleEndian>((uint8_t*)
+		    m_selectedHostMemoryBlock + m_selectedOffsetWithinBlock);
 
 	return true;
 }
@@ -315,7 +333,8 @@ bool RAMComponent::WriteData(const uint8_t& data, Endianness endianness)
 		return false;
 
 	if (m_selectedHostMemoryBlock == NULL)
-		m_selectedHostMemoryBlock = AllocateBlock();
+		m_selectedHostMemoryBlock =
+		    AllocateBlock(m_addressSelect >> m_blockSizeShift);
 
 	(((uint8_t*)m_selectedHostMemoryBlock)
 	    [m_selectedOffsetWithinBlock]) = data;
@@ -332,16 +351,15 @@ bool RAMComponent::WriteData(const uint16_t& data, Endianness endianness)
 		return false;
 
 	if (m_selectedHostMemoryBlock == NULL)
-		m_selectedHostMemoryBlock = AllocateBlock();
+		m_selectedHostMemoryBlock =
+		    AllocateBlock(m_addressSelect >> m_blockSizeShift);
 
-	uint16_t d;
 	if (endianness == BigEndian)
-		d = BE16_TO_HOST(data);
+		WriteHostMemory<uint16_t, BigEndian>((uint8_t*)
+		    m_selectedHostMemoryBlock + m_selectedOffsetWithinBlock, data);
 	else
-		d = LE16_TO_HOST(data);
-
-	(((uint16_t*)m_selectedHostMemoryBlock)
-	    [m_selectedOffsetWithinBlock >> 1]) = d;
+		WriteHostMemory<uint16_t, LittleEndian>((uint8_t*)
+		    m_selectedHostMemoryBlock + m_selectedOffsetWithinBlock, data);
 
 	return true;
 }
@@ -355,16 +373,15 @@ bool RAMComponent::WriteData(const uint32_t& data, Endianness endianness)
 		return false;
 
 	if (m_selectedHostMemoryBlock == NULL)
-		m_selectedHostMemoryBlock = AllocateBlock();
+		m_selectedHostMemoryBlock =
+		    AllocateBlock(m_addressSelect >> m_blockSizeShift);
 
-	uint32_t d;
 	if (endianness == BigEndian)
-		d = BE32_TO_HOST(data);
+		WriteHostMemory<uint32_t, BigEndian>((uint8_t*)
+		    m_selectedHostMemoryBlock + m_selectedOffsetWithinBlock, data);
 	else
-		d = LE32_TO_HOST(data);
-
-	(((uint32_t*)m_selectedHostMemoryBlock)
-	    [m_selectedOffsetWithinBlock >> 2]) = d;
+		WriteHostMemory<uint32_t, LittleEndian>((uint8_t*)
+		    m_selectedHostMemoryBlock + m_selectedOffsetWithinBlock, data);
 
 	return true;
 }
@@ -378,16 +395,15 @@ bool RAMComponent::WriteData(const uint64_t& data, Endianness endianness)
 		return false;
 
 	if (m_selectedHostMemoryBlock == NULL)
-		m_selectedHostMemoryBlock = AllocateBlock();
+		m_selectedHostMemoryBlock =
+		    AllocateBlock(m_addressSelect >> m_blockSizeShift);
 
-	uint64_t d;
 	if (endianness == BigEndian)
-		d = BE64_TO_HOST(data);
+		WriteHostMemory<uint64_t, BigEndian>((uint8_t*)
+		    m_selectedHostMemoryBlock + m_selectedOffsetWithinBlock, data);
 	else
-		d = LE64_TO_HOST(data);
-
-	(((uint64_t*)m_selectedHostMemoryBlock)
-	    [m_selectedOffsetWithinBlock >> 3]) = d;
+		WriteHostMemory<uint64_t, LittleEndian>((uint8_t*)
+		    m_selectedHostMemoryBlock + m_selectedOffsetWithinBlock, data);
 
 	return true;
 }
@@ -560,6 +576,46 @@ static void Test_RAMComponent_WriteProtect()
 	UnitTest::Assert("16-bit read", data16_a, 0x5678);
 }
 
+static void Test_RAMComponent_LookupHostPage()
+{
+	refcount_ptr<Component> ram = ComponentFactory::CreateComponent("ram");
+	AddressDataBus* bus = ram->AsAddressDataBus();
+
+	UnitTest::Assert("unwritten memory should not be allocated by reads",
+	    bus->LookupHostPage(0x3000, 0x1000, false) == NULL);
+
+	uint8_t* page = bus->LookupHostPage(0x3010, 0x1000, true);
+	UnitTest::Assert("writable page expected", page != NULL);
+	UnitTest::Assert("the same page should be readable",
+	    bus->LookupHostPage(0x3ffc, 0x1000, false) == page);
+
+	RAMComponent::WriteHostMemory<uint32_t, BigEndian>(page + 0x20, 0x11223344);
+	RAMComponent::WriteHostMemory<uint16_t, LittleEndian>(page + 0x24, 0x5566);
+
+	uint32_t data32 = 0;
+	bus->AddressSelect(0x3020);
+	bus->ReadData(data32, BigEndian);
+	UnitTest::Assert("32-bit read", data32, 0x11223344);
+
+	uint16_t data16 = 0;
+	bus->AddressSelect(0x3024);
+	bus->ReadData(data16, BigEndian);
+	UnitTest::Assert("16-bit read", data16, 0x6655);
+
+	uint64_t data64 = ((uint64_t)0x1234567 << 32) | 0x89abcdef;
+	bus->AddressSelect(0x3028);
+	bus->WriteData(data64, LittleEndian);
+	UnitTest::Assert("64-bit host read",
+	    RAMComponent::ReadHostMemory<uint64_t, LittleEndian>(page + 0x28),
+	    data64);
+	UnitTest::Assert("8-bit host read",
+	    RAMComponent::ReadHostMemory<uint8_t, BigEndian>(page + 0x28), 0xef);
+
+	ram->SetVariableValue("writeProtect", "true");
+	UnitTest::Assert("write protected memory should not be directly writable",
+	    bus->LookupHostPage(0x3010, 0x1000, true) == NULL);
+}
+
 static void Test_RAMComponent_ClearOnReset()
 {
 	refcount_ptr<Component> ram = ComponentFactory::CreateComponent("ram");
@@ -664,6 +720,7 @@ UNITTESTS(RAMComponent)
 	UNITTEST(Test_RAMComponent_WriteThenRead);
 	UNITTEST(Test_RAMComponent_WriteThenRead_ReverseEndianness);
 	UNITTEST(Test_RAMComponent_WriteProtect);
+	UNITTEST(Test_RAMComponent_LookupHostPage);
 	UNITTEST(Test_RAMComponent_ClearOnReset);
 	UNITTEST(Test_RAMComponent_Clone);
 	UNITTEST(Test_RAMComponent_ManualSerialization);
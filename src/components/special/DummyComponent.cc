@@ -1070,6 +1070,48 @@ static void Test_DummyComponent_Execute_Continuous_ThreeComponentsDifferentSpeed
 	}	
 }
 
+static void Test_DummyComponent_Execute_Sloppy_ThreeComponentsDifferentSpeed()
+{
+	GXemul gxemul;
+	stringstream os;
+	gxemul.GetRootComponent()->AddChild(new DummyComponentWithCounter(&os, 'A'));
+	gxemul.GetRootComponent()->AddChild(new DummyComponentWithCounter(&os, 'B'));
+	gxemul.GetRootComponent()->AddChild(new DummyComponentWithCounter(&os, 'C'));
+
+	gxemul.GetRootComponent()->SetVariableValue("accuracy", "\"sloppy\"");
+	gxemul.GetRootComponent()->SetVariableValue("quantum", "100");
+
+	refcount_ptr<Component> counterA = gxemul.GetRootComponent()->GetChildren()[0];
+	refcount_ptr<Component> counterB = gxemul.GetRootComponent()->GetChildren()[1];
+	refcount_ptr<Component> counterC = gxemul.GetRootComponent()->GetChildren()[2];
+
+	counterA->SetVariableValue("counter", "0");
+	counterB->SetVariableValue("counter", "0");
+	counterC->SetVariableValue("counter", "0");
+
+	counterA->SetVariableValue("frequency", "1");
+	counterB->SetVariableValue("frequency", "100");
+	counterC->SetVariableValue("frequency", "10");
+
+	gxemul.SetRunState(GXemul::Running);
+	gxemul.Execute(2000);
+
+	UnitTest::Assert("step should be exactly 2000", gxemul.GetStep(), 2000);
+	UnitTest::Assert("counter A should be n / 100",
+	    counterA->GetVariable("counter")->ToInteger(), 20);
+	UnitTest::Assert("counter B should be n",
+	    counterB->GetVariable("counter")->ToInteger(), 2000);
+	UnitTest::Assert("counter C should be n / 10",
+	    counterC->GetVariable("counter")->ToInteger(), 200);
+
+	// In sloppy mode, the components are not interleaved cycle by cycle,
+	// but run one quantum at a time, in tree order. The first quantum
+	// (100 steps) is therefore a single A, 100 B's, and 10 C's.
+	string expectedStart = "A" + string(100, 'B') + string(10, 'C');
+	UnitTest::Assert("output stream should begin with one quantum",
+	    os.str().substr(0, expectedStart.length()), expectedStart);
+}
+
 /*
 static void Test_DummyComponent_Execute_Continuous_ThreeComponentsDifferentSpeedWeird2()
 {
@@ -1185,6 +1227,9 @@ UNITTESTS(DummyComponent)
 	UNITTEST(Test_DummyComponent_Execute_Continuous_ThreeComponentsDifferentSpeedWeird);
 // TODO: This currently fails!
 //	UNITTEST(Test_DummyComponent_Execute_Continuous_ThreeComponentsDifferentSpeedWeird2);
+
+	// Sloppy execution
+	UNITTEST(Test_DummyComponent_Execute_Sloppy_ThreeComponentsDifferentSpeed);
 }
 
 #endif
@@ -34,10 +34,12 @@ RootComponent::RootComponent(GXemul* owner)
 	: Component("root", "root")
 	, m_gxemul(owner)
 	, m_accuracy("cycle")
+	, m_quantum(10000)
 {
 	SetVariableValue("name", "\"root\"");
 
 	AddVariable("accuracy", &m_accuracy);
+	AddVariable("quantum", &m_quantum);
 }
 
 
@@ -48,6 +50,11 @@ bool RootComponent::PreRunCheckForComponent(GXemul* gxemul)
 		return false;
 	}
 
+	if (m_quantum < 1) {
+		gxemul->GetUI()->ShowDebugMessage(this, "quantum must be at least 1.\n");
+		return false;
+	}
+
 	return true;
 }
 
@@ -72,6 +79,15 @@ bool RootComponent::CheckVariableWrite(StateVariable& var, const string& oldValu
 		}
 	}
 
+	if (name == "quantum") {
+		if (var.ToInteger() < 1) {
+			if (ui != NULL)
+				ui->ShowDebugMessage(this, "quantum must be at least 1.\n");
+
+			return false;
+		}
+	}
+
 	return Component::CheckVariableWrite(var, oldValue);
 }
 
@@ -97,10 +113,12 @@ static void Test_RootComponent_InitialVariables()
 	StateVariable* name = component->GetVariable("name");
 	StateVariable* step = component->GetVariable("step");
 	StateVariable* accuracy = component->GetVariable("accuracy");
+	StateVariable* quantum = component->GetVariable("quantum");
 
 	UnitTest::Assert("name should be root", name->ToString(), "root");
 	UnitTest::Assert("step should be 0", step->ToInteger(), 0);
 	UnitTest::Assert("accuracy should be cycle", accuracy->ToString(), "cycle");
+	UnitTest::Assert("quantum should be 10000", quantum->ToInteger(), 10000);
 }
 
 static void Test_RootComponent_AccuracyValues()
@@ -120,11 +138,30 @@ static void Test_RootComponent_AccuracyValues()
 	UnitTest::Assert("cycle should be ok", component->PreRunCheck(&dummyGXemul));
 }
 
+static void Test_RootComponent_QuantumValues()
+{
+	GXemul dummyGXemul;
+
+	refcount_ptr<Component> component = new RootComponent;
+	StateVariable* quantum = component->GetVariable("quantum");
+
+	UnitTest::Assert("setting quantum to 500 should be ok",
+	    component->SetVariableValue("quantum", "500"));
+	UnitTest::Assert("quantum should be 500", quantum->ToInteger(), 500);
+
+	UnitTest::Assert("setting quantum to 0 should not be ok",
+	    !component->SetVariableValue("quantum", "0"));
+	UnitTest::Assert("quantum should still be 500", quantum->ToInteger(), 500);
+	UnitTest::Assert("500 should pass the prerun check",
+	    component->PreRunCheck(&dummyGXemul));
+}
+
 UNITTESTS(RootComponent)
 {
 	UNITTEST(Test_RootComponent_CreateComponent);
 	UNITTEST(Test_RootComponent_InitialVariables);
 	UNITTEST(Test_RootComponent_AccuracyValues);
+	UNITTEST(Test_RootComponent_QuantumValues);
 
 	// TODO: Test owner
 }
@@ -6,58 +6,72 @@ extern uint8_t condition_ge[16];
 extern uint8_t condition_gt[16];
 #define Y(n) void arm_instr_ ## n ## __eq(struct cpu *cpu,		\
 			struct arm_instr_call *ic)			\
-	{  if (cpu->cd.arm.flags & ARM_F_Z)				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (cpu->cd.arm.flags & ARM_F_Z)				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __ne(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (!(cpu->cd.arm.flags & ARM_F_Z))				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (!(cpu->cd.arm.flags & ARM_F_Z))				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __cs(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (cpu->cd.arm.flags & ARM_F_C)				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (cpu->cd.arm.flags & ARM_F_C)				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __cc(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (!(cpu->cd.arm.flags & ARM_F_C))				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (!(cpu->cd.arm.flags & ARM_F_C))				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __mi(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (cpu->cd.arm.flags & ARM_F_N)				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (cpu->cd.arm.flags & ARM_F_N)				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __pl(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (!(cpu->cd.arm.flags & ARM_F_N))				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (!(cpu->cd.arm.flags & ARM_F_N))				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __vs(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (cpu->cd.arm.flags & ARM_F_V)				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (cpu->cd.arm.flags & ARM_F_V)				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __vc(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (!(cpu->cd.arm.flags & ARM_F_V))				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (!(cpu->cd.arm.flags & ARM_F_V))				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __hi(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (condition_hi[cpu->cd.arm.flags])				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (condition_hi[cpu->cd.arm.flags])				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __ls(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (!condition_hi[cpu->cd.arm.flags])			\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (!condition_hi[cpu->cd.arm.flags])			\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __ge(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (condition_ge[cpu->cd.arm.flags])				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (condition_ge[cpu->cd.arm.flags])				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __lt(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (!condition_ge[cpu->cd.arm.flags])			\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (!condition_ge[cpu->cd.arm.flags])			\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __gt(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (condition_gt[cpu->cd.arm.flags])				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (condition_gt[cpu->cd.arm.flags])				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __le(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (!condition_gt[cpu->cd.arm.flags])			\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (!condition_gt[cpu->cd.arm.flags])			\
 		arm_instr_ ## n (cpu, ic);		}
 #endif	/*  ARM_TMPHEAD_1  */
@@ -35,6 +35,7 @@
 #include <string.h>
 
 #include "cpu.h"
+#include "debugger.h"
 #include "machine.h"
 #include "memory.h"
 #include "settings.h"
@@ -62,6 +63,7 @@ struct cpu *cpu_new(struct memory *mem, struct machine *machine,
 	struct cpu_family *fp;
 	char *cpu_type_name;
 	char tmpstr[30];
+	int i;
 
 	if (name == NULL) {
 		fprintf(stderr, "cpu_new(): cpu name = NULL?\n");
@@ -94,6 +96,27 @@ struct cpu *cpu_new(struct memory *mem, struct machine *machine,
 	    SETTINGS_FORMAT_STRING, (void *) &cpu->name);
 	settings_add(cpu->settings, "running", 0, SETTINGS_TYPE_UINT8,
 	    SETTINGS_FORMAT_YESNO, (void *) &cpu->running);
+	settings_add(cpu->settings, "tc_evictions", 0, SETTINGS_TYPE_UINT64,
+	    SETTINGS_FORMAT_DECIMAL, (void *) &cpu->translation_cache_evictions);
+	settings_add(cpu->settings, "tc_flushes", 0, SETTINGS_TYPE_UINT64,
+	    SETTINGS_FORMAT_DECIMAL, (void *) &cpu->translation_cache_flushes);
+	settings_add(cpu->settings, "tc_traps", 0, SETTINGS_TYPE_UINT64,
+	    SETTINGS_FORMAT_DECIMAL, (void *) &cpu->translation_cache_traps);
+	settings_add(cpu->settings, "vph_tlb_hits", 0, SETTINGS_TYPE_UINT64,
+	    SETTINGS_FORMAT_DECIMAL, (void *) &cpu->vph_tlb_hits);
+	settings_add(cpu->settings, "vph_tlb_misses", 0, SETTINGS_TYPE_UINT64,
+	    SETTINGS_FORMAT_DECIMAL, (void *) &cpu->vph_tlb_misses);
+	settings_add(cpu->settings, "vph_tlb_evictions", 0,
+	    SETTINGS_TYPE_UINT64, SETTINGS_FORMAT_DECIMAL,
+	    (void *) &cpu->vph_tlb_evictions);
+
+	for (i=NATIVE_ROUTINE_NONE+1; i<N_NATIVE_ROUTINES; i++) {
+		snprintf(tmpstr, sizeof(tmpstr), "native_%s_hits",
+		    native_routine_name(i));
+		settings_add(cpu->settings, tmpstr, 0, SETTINGS_TYPE_UINT64,
+		    SETTINGS_FORMAT_DECIMAL,
+		    (void *) &cpu->native_routine_hits[i]);
+	}
 
 	cpu_create_or_reset_tc(cpu);
 
@@ -139,8 +162,23 @@ struct cpu *cpu_new(struct memory *mem, struct machine *machine,
  */
 void cpu_destroy(struct cpu *cpu)
 {
+	char tmpstr[30];
+	int i;
+
 	settings_remove(cpu->settings, "name");
 	settings_remove(cpu->settings, "running");
+	settings_remove(cpu->settings, "tc_evictions");
+	settings_remove(cpu->settings, "tc_flushes");
+	settings_remove(cpu->settings, "tc_traps");
+	settings_remove(cpu->settings, "vph_tlb_hits");
+	settings_remove(cpu->settings, "vph_tlb_misses");
+	settings_remove(cpu->settings, "vph_tlb_evictions");
+
+	for (i=NATIVE_ROUTINE_NONE+1; i<N_NATIVE_ROUTINES; i++) {
+		snprintf(tmpstr, sizeof(tmpstr), "native_%s_hits",
+		    native_routine_name(i));
+		settings_remove(cpu->settings, tmpstr);
+	}
 
 	/*  Remove any remaining level-1 settings:  */
 	settings_remove_all(cpu->settings);
@@ -292,6 +330,8 @@ void cpu_create_or_reset_tc(struct cpu *cpu)
 
 	if (cpu->translation_cache == NULL)
 		cpu->translation_cache = (unsigned char *) zeroed_alloc(s);
+	else
+		cpu->translation_cache_flushes ++;
 
 	/*  Create an empty table at the beginning of the translation cache:  */
 	memset(cpu->translation_cache, 0, sizeof(uint32_t)
@@ -299,6 +339,7 @@ void cpu_create_or_reset_tc(struct cpu *cpu)
 
 	cpu->translation_cache_cur_ofs =
 	    N_BASE_TABLE_ENTRIES * sizeof(uint32_t);
+	cpu->translation_cache_clock_ofs = cpu->translation_cache_cur_ofs;
 
 	/*
 	 *  There might be other translation pointers that still point to
@@ -309,6 +350,78 @@ void cpu_create_or_reset_tc(struct cpu *cpu)
 }
 
 
+/*
+ *  cpu_invalidate_breakpoint():
+ *
+ *  Called when a breakpoint has been added at virtual address vaddr. The
+ *  breakpoint is only noticed when the instruction is translated, so all
+ *  code translations are thrown away. (Throwing away just the physical page
+ *  which vaddr maps to right now is not enough: vaddr may map to other
+ *  pages in other address spaces, and calls to natively run routines can
+ *  be on any page.)
+ */
+void cpu_invalidate_breakpoint(struct cpu *cpu, uint64_t vaddr)
+{
+	if (cpu->translation_cache == NULL)
+		return;
+
+	cpu_create_or_reset_tc(cpu);
+}
+
+
+/*
+ *  cpu_invalidate_watchpoint():
+ *
+ *  Called when a watchpoint has been added for the len bytes at virtual
+ *  address vaddr. The pages are marked as non-writable in the fast lookup
+ *  tables, so that stores to them go through memory_rw(). (When they are
+ *  mapped again, update_translation_table() keeps them non-writable for
+ *  as long as the watchpoint exists.)
+ */
+void cpu_invalidate_watchpoint(struct cpu *cpu, uint64_t vaddr, int len)
+{
+	uint64_t pagesize = cpu->machine->arch_pagesize;
+	uint64_t page = vaddr & ~(pagesize - 1);
+
+	if (cpu->invalidate_translation_caches == NULL)
+		return;
+
+	for (; page < vaddr + len; page += pagesize)
+		cpu->invalidate_translation_caches(cpu, page,
+		    JUST_MARK_AS_NON_WRITABLE | INVALIDATE_VADDR);
+}
+
+
+/*
+ *  cpu_watchpoint_hit():
+ *
+ *  Called by memory_rw() when a store of len bytes to vaddr overlaps
+ *  watchpoint nr w. The store itself is still carried out. memory_rw() then
+ *  ends the current run of translated instructions, and the debugger is
+ *  entered with pc at the instruction after the store.
+ */
+void cpu_watchpoint_hit(struct cpu *cpu, int w, uint64_t vaddr,
+	unsigned char *data, size_t len)
+{
+	extern int single_step;
+	size_t i;
+
+	if (cpu->is_32bit)
+		fatal("WATCHPOINT %i: pc = 0x%08"PRIx32", write to 0x%08"
+		    PRIx32":", w, (uint32_t) cpu->pc, (uint32_t) vaddr);
+	else
+		fatal("WATCHPOINT %i: pc = 0x%016"PRIx64", write to 0x%016"
+		    PRIx64":", w, (uint64_t) cpu->pc, (uint64_t) vaddr);
+
+	for (i=0; i<len && i<16; i++)
+		fatal(" %02x", data[i]);
+	fatal("%s\n", len > 16? " ..." : "");
+
+	if (single_step == NOT_SINGLE_STEPPING)
+		single_step = ENTER_SINGLE_STEPPING;
+}
+
+
 /*
  *  cpu_dumpinfo():
  *
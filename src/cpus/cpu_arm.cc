@@ -171,6 +171,9 @@ int arm_cpu_new(struct cpu *cpu, struct memory *mem,
 	for (i=0; i<N_ARM_REGS - 1; i++)
 		CPU_SETTINGS_ADD_REGISTER32(arm_regname[i], cpu->cd.arm.r[i]);
 
+	settings_add(cpu->settings, "lazy_lockstep", 1, SETTINGS_TYPE_INT,
+	    SETTINGS_FORMAT_YESNO, (void *) &cpu->cd.arm.lazy_lockstep);
+
 	/*  Register the CPU's "IRQ" and "FIQ" interrupts:  */
 	{
 		struct interrupt templ;
@@ -337,6 +340,7 @@ void arm_cpu_register_dump(struct cpu *cpu, int gprs, int coprocs)
 	int mode = cpu->cd.arm.cpsr & ARM_FLAG_MODE;
 	int i, x = cpu->cpu_id;
 
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.cpsr &= 0x0fffffff;
 	cpu->cd.arm.cpsr |= (cpu->cd.arm.flags << 28);
 
@@ -344,13 +348,14 @@ void arm_cpu_register_dump(struct cpu *cpu, int gprs, int coprocs)
 		symbol = get_symbol_name(&cpu->machine->symbol_context,
 		    cpu->pc, &offset);
 		debug("cpu%i:  cpsr = ", x);
-		debug("%s%s%s%s%s%s",
+		debug("%s%s%s%s%s%s%s",
 		    (cpu->cd.arm.cpsr & ARM_FLAG_N)? "N" : "n",
 		    (cpu->cd.arm.cpsr & ARM_FLAG_Z)? "Z" : "z",
 		    (cpu->cd.arm.cpsr & ARM_FLAG_C)? "C" : "c",
 		    (cpu->cd.arm.cpsr & ARM_FLAG_V)? "V" : "v",
 		    (cpu->cd.arm.cpsr & ARM_FLAG_I)? "I" : "i",
-		    (cpu->cd.arm.cpsr & ARM_FLAG_F)? "F" : "f");
+		    (cpu->cd.arm.cpsr & ARM_FLAG_F)? "F" : "f",
+		    (cpu->cd.arm.cpsr & ARM_FLAG_T)? "T" : "t");
 		if (mode < ARM_MODE_USR32)
 			debug("   pc =  0x%07x", (int)(cpu->pc & 0x03ffffff));
 		else
@@ -579,6 +584,140 @@ void arm_load_register_bank(struct cpu *cpu)
 }
 
 
+/*
+ *  arm_flags_lazy():
+ *
+ *  Calculates the N, Z, C, and V flags for a lazily evaluated operation.
+ */
+static size_t arm_flags_lazy(int op, uint32_t a, uint32_t b)
+{
+	uint32_t c;
+	size_t f = 0;
+
+	if ((op & ~ARM_FLAGS_LAZY_CHECKED) == ARM_FLAGS_LAZY_ADD) {
+		c = a + b;
+		if (c < a)
+			f |= ARM_F_C;
+		if (~(a ^ b) & (a ^ c) & 0x80000000)
+			f |= ARM_F_V;
+	} else {
+		c = a - b;
+		if (a >= b)
+			f |= ARM_F_C;
+		if ((a ^ b) & (a ^ c) & 0x80000000)
+			f |= ARM_F_V;
+	}
+
+	if (c == 0)
+		f |= ARM_F_Z;
+	if (c & 0x80000000)
+		f |= ARM_F_N;
+
+	return f;
+}
+
+
+/*
+ *  arm_flags_materialize():
+ *
+ *  Calculates the N, Z, C, and V flags from the last lazily evaluated
+ *  flag-setting operation, and stores them in 'flags'. (Usually called via
+ *  ARM_FLAGS_SYNC().)
+ */
+void arm_flags_materialize(struct cpu *cpu)
+{
+	cpu->cd.arm.flags = arm_flags_lazy(cpu->cd.arm.flags_lazy_op,
+	    cpu->cd.arm.flags_lazy_a, cpu->cd.arm.flags_lazy_b);
+	cpu->cd.arm.flags_lazy_op = ARM_FLAGS_LAZY_NONE;
+}
+
+
+/*
+ *  arm_flags_eager():
+ *
+ *  Calculates the flags for a lazily evaluated operation the same way as
+ *  the eager code in cpu_arm_instr_dpi.cc did, before the flags were
+ *  evaluated lazily.
+ */
+static size_t arm_flags_eager(int op, uint32_t a, uint32_t b)
+{
+	uint64_t c64;
+	uint32_t c32;
+	size_t f = 0;
+
+	if ((op & ~ARM_FLAGS_LAZY_CHECKED) == ARM_FLAGS_LAZY_ADD) {
+		c64 = (uint64_t)a + (uint64_t)b;
+		c32 = c64;
+		if (c32 != c64)
+			f |= ARM_F_C;
+		if (((int32_t)a >= 0 && (int32_t)b >= 0 && (int32_t)c32 < 0) ||
+		    ((int32_t)a < 0 && (int32_t)b < 0 && (int32_t)c32 >= 0))
+			f |= ARM_F_V;
+	} else {
+		c32 = a - b;
+		if (a >= b)
+			f |= ARM_F_C;
+		if (((int32_t)a >= 0 && (int32_t)b < 0 && (int32_t)c32 < 0) ||
+		    ((int32_t)a < 0 && (int32_t)b >= 0 && (int32_t)c32 >= 0))
+			f |= ARM_F_V;
+	}
+
+	if (c32 == 0)
+		f |= ARM_F_Z;
+	if ((int32_t)c32 < 0)
+		f |= ARM_F_N;
+
+	return f;
+}
+
+
+/*
+ *  arm_lazy_lockstep_check():
+ *
+ *  Called by arm_run_instr() after each instruction, if lazy_lockstep is
+ *  set. If a lazily evaluated operation was recorded by the instruction,
+ *  then the flags it materializes to are compared with the flags the eager
+ *  code would have set.
+ *
+ *  While the operation stays pending, 'flags' is set to the inverse of the
+ *  correct flags. An instruction which reads 'flags' without ARM_FLAGS_SYNC()
+ *  then behaves differently than with eager flags, and an instruction which
+ *  modifies 'flags' without ARM_FLAGS_SYNC() is caught after it has run.
+ */
+void arm_lazy_lockstep_check(struct cpu *cpu)
+{
+	int op = cpu->cd.arm.flags_lazy_op;
+	uint32_t a = cpu->cd.arm.flags_lazy_a, b = cpu->cd.arm.flags_lazy_b;
+	size_t lazy, eager;
+
+	if (op == ARM_FLAGS_LAZY_NONE)
+		return;
+
+	if (op & ARM_FLAGS_LAZY_CHECKED) {
+		if (cpu->cd.arm.flags != cpu->cd.arm.lazy_lockstep_flags) {
+			fatal("arm_lazy_lockstep_check(): flags were modified"
+			    " without ARM_FLAGS_SYNC() (pc=0x%08"PRIx32")\n",
+			    (uint32_t)cpu->pc);
+			exit(1);
+		}
+		return;
+	}
+
+	lazy = arm_flags_lazy(op, a, b);
+	eager = arm_flags_eager(op, a, b);
+	if (lazy != eager) {
+		fatal("arm_lazy_lockstep_check(): op %i, a=0x%08"PRIx32", b="
+		    "0x%08"PRIx32": lazy cpsr flags 0x%x, eager cpsr flags 0x%x"
+		    " (pc=0x%08"PRIx32")\n", op, a, b, (int)lazy, (int)eager,
+		    (uint32_t)cpu->pc);
+		exit(1);
+	}
+
+	cpu->cd.arm.flags = cpu->cd.arm.lazy_lockstep_flags = ~lazy & 0xf;
+	cpu->cd.arm.flags_lazy_op = op | ARM_FLAGS_LAZY_CHECKED;
+}
+
+
 /*
  *  arm_exception():
  */
@@ -631,12 +770,19 @@ void arm_exception(struct cpu *cpu, int exception_nr)
 	case ARM_EXCEPTION_DATA_ABT:
 		retaddr += 4;
 		break;
+	case ARM_EXCEPTION_UND:
+	case ARM_EXCEPTION_SWI:
+		/*  The return address is the next instruction:  */
+		if (cpu->cd.arm.cpsr & ARM_FLAG_T)
+			retaddr -= 2;
+		break;
 	}
 
 	retaddr += 4;
 
 	arm_save_register_bank(cpu);
 
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.cpsr &= 0x0fffffff;
 	cpu->cd.arm.cpsr |= (cpu->cd.arm.flags << 28);
 
@@ -733,6 +879,230 @@ void arm_irq_interrupt_deassert(struct interrupt *interrupt)
 }
 
 
+/*
+ *  arm_cpu_disassemble_thumb():
+ *
+ *  Thumb part of arm_cpu_disassemble_instr(), called when the T bit is set.
+ *  ib should contain 4 bytes, so that the two halves of a BL or BLX can be
+ *  shown together. Returns the length of the instruction(s), 2 or 4.
+ */
+static int arm_cpu_disassemble_thumb(struct cpu *cpu, unsigned char *ib,
+	uint64_t dumpaddr)
+{
+	static const char *shift_name[3] = { "lsl", "lsr", "asr" };
+	static const char *imm8_name[4] = { "mov", "cmp", "add", "sub" };
+	static const char *alu_name[16] = { "and", "eor", "lsl", "lsr",
+	    "asr", "adc", "sbc", "ror", "tst", "neg", "cmp", "cmn", "orr",
+	    "mul", "bic", "mvn" };
+	static const char *hi_name[3] = { "add", "cmp", "mov" };
+	static const char *ls_reg_name[8] = { "str", "strh", "strb", "ldrsb",
+	    "ldr", "ldrh", "ldrb", "ldrsh" };
+	static const char *ls_imm_name[6] = { "str", "ldr", "strb", "ldrb",
+	    "strh", "ldrh" };
+	static const int ls_imm_scale[6] = { 4, 4, 1, 1, 2, 2 };
+	uint32_t iw, iw2, addr, imm;
+	int op, rd, rm, i, n;
+	const char *symbol;
+	uint64_t offset;
+
+	if (cpu->byte_order == EMUL_LITTLE_ENDIAN) {
+		iw = ib[0] + (ib[1]<<8);
+		iw2 = ib[2] + (ib[3]<<8);
+	} else {
+		iw = ib[1] + (ib[0]<<8);
+		iw2 = ib[3] + (ib[2]<<8);
+	}
+
+	op = iw >> 11;
+	rd = iw & 7;
+	rm = (iw >> 3) & 7;
+
+	/*  BL or BLX (immediate), as a pair of 16-bit instructions:  */
+	if (op == 0x1e && ((iw2 >> 11) == 0x1f ||
+	    ((iw2 >> 11) == 0x1d && !(iw2 & 1)))) {
+		debug("%04x %04x\t", (int)iw, (int)iw2);
+		imm = ((iw & 0x7ff) << 12) | ((iw2 & 0x7ff) << 1);
+		if (imm & 0x00400000)
+			imm |= 0xff800000;
+		addr = dumpaddr + 4 + imm;
+		if ((iw2 >> 11) == 0x1d) {
+			addr &= ~3;
+			debug("blx\t");
+		} else
+			debug("bl\t");
+		debug("0x%x", (int)addr);
+		symbol = get_symbol_name(&cpu->machine->symbol_context,
+		    addr, &offset);
+		if (symbol != NULL)
+			debug(" \t<%s>", symbol);
+		debug("\n");
+		return 2 * sizeof(uint16_t);
+	}
+
+	debug("%04x     \t", (int)iw);
+
+	switch (op) {
+	case 0x00:
+	case 0x01:
+	case 0x02:
+		imm = (iw >> 6) & 31;
+		if (op != 0 && imm == 0)
+			imm = 32;
+		debug("%s\t%s,%s,#%i\n", shift_name[op], arm_regname[rd],
+		    arm_regname[rm], imm);
+		break;
+	case 0x03:
+		debug("%s\t%s,%s,", iw & 0x200? "sub" : "add",
+		    arm_regname[rd], arm_regname[rm]);
+		if (iw & 0x400)
+			debug("#%i\n", (int)((iw >> 6) & 7));
+		else
+			debug("%s\n", arm_regname[(iw >> 6) & 7]);
+		break;
+	case 0x04:
+	case 0x05:
+	case 0x06:
+	case 0x07:
+		debug("%s\t%s,#%i\n", imm8_name[op & 3],
+		    arm_regname[(iw >> 8) & 7], (int)(iw & 255));
+		break;
+	case 0x08:
+		if (!(iw & 0x400)) {
+			debug("%s\t%s,%s\n", alu_name[(iw >> 6) & 15],
+			    arm_regname[rd], arm_regname[rm]);
+			break;
+		}
+
+		/*  Hi register operations:  */
+		rd = (iw & 7) | ((iw >> 4) & 8);
+		rm = (iw >> 3) & 15;
+		if (((iw >> 8) & 3) == 3)
+			debug("%s\t%s\n", iw & 0x80? "blx" : "bx",
+			    arm_regname[rm]);
+		else
+			debug("%s\t%s,%s\n", hi_name[(iw >> 8) & 3],
+			    arm_regname[rd], arm_regname[rm]);
+		break;
+	case 0x09:
+		imm = (iw & 255) << 2;
+		addr = ((dumpaddr + 4) & ~3) + imm;
+		debug("ldr\t%s,[pc,#%i]", arm_regname[(iw >> 8) & 7], imm);
+		symbol = get_symbol_name(&cpu->machine->symbol_context,
+		    addr, &offset);
+		if (symbol != NULL)
+			debug(" \t<%s>\n", symbol);
+		else
+			debug(" \t<0x%08x>\n", (int)addr);
+		break;
+	case 0x0a:
+	case 0x0b:
+		debug("%s\t%s,[%s,%s]\n", ls_reg_name[(iw >> 9) & 7],
+		    arm_regname[rd], arm_regname[rm],
+		    arm_regname[(iw >> 6) & 7]);
+		break;
+	case 0x0c:
+	case 0x0d:
+	case 0x0e:
+	case 0x0f:
+	case 0x10:
+	case 0x11:
+		imm = ((iw >> 6) & 31) * ls_imm_scale[op - 0x0c];
+		debug("%s\t%s,[%s", ls_imm_name[op - 0x0c], arm_regname[rd],
+		    arm_regname[rm]);
+		if (imm != 0)
+			debug(",#%i", imm);
+		debug("]\n");
+		break;
+	case 0x12:
+	case 0x13:
+		debug("%s\t%s,[sp,#%i]\n", iw & 0x800? "ldr" : "str",
+		    arm_regname[(iw >> 8) & 7], (int)((iw & 255) << 2));
+		break;
+	case 0x14:
+	case 0x15:
+		debug("add\t%s,%s,#%i\n", arm_regname[(iw >> 8) & 7],
+		    iw & 0x800? "sp" : "pc", (int)((iw & 255) << 2));
+		break;
+	case 0x16:
+	case 0x17:
+		if ((iw & 0xff00) == 0xb000) {
+			debug("%s\tsp,#%i\n", iw & 0x80? "sub" : "add",
+			    (int)((iw & 127) << 2));
+		} else if ((iw & 0xf600) == 0xb400) {
+			debug("%s\t{", iw & 0x800? "pop" : "push");
+			n = 0;
+			for (i=0; i<8; i++)
+				if ((iw >> i) & 1) {
+					debug("%s%s", (n > 0)? ",":"",
+					    arm_regname[i]);
+					n++;
+				}
+			if (iw & 0x100)
+				debug("%s%s", (n > 0)? ",":"",
+				    iw & 0x800? "pc" : "lr");
+			debug("}\n");
+		} else if ((iw & 0xff00) == 0xbe00) {
+			debug("bkpt\t0x%x\n", (int)(iw & 255));
+		} else
+			debug("UNIMPLEMENTED\n");
+		break;
+	case 0x18:
+	case 0x19:
+		debug("%s\t%s!,{", iw & 0x800? "ldmia" : "stmia",
+		    arm_regname[(iw >> 8) & 7]);
+		n = 0;
+		for (i=0; i<8; i++)
+			if ((iw >> i) & 1) {
+				debug("%s%s", (n > 0)? ",":"", arm_regname[i]);
+				n++;
+			}
+		debug("}\n");
+		break;
+	case 0x1a:
+	case 0x1b:
+	case 0x1c:
+		if (op == 0x1c) {
+			debug("b\t");
+			imm = (iw & 0x7ff) << 1;
+			if (imm & 0x800)
+				imm |= 0xfffff000;
+		} else if (((iw >> 8) & 15) == 0xf) {
+			debug("swi\t0x%x\n", (int)(iw & 255));
+			break;
+		} else if (((iw >> 8) & 15) == 0xe) {
+			debug("UNIMPLEMENTED\n");
+			break;
+		} else {
+			debug("b%s\t", arm_condition_string[(iw >> 8) & 15]);
+			imm = (int32_t)(int8_t)(iw & 255) << 1;
+		}
+		addr = dumpaddr + 4 + imm;
+		debug("0x%x", (int)addr);
+		symbol = get_symbol_name(&cpu->machine->symbol_context,
+		    addr, &offset);
+		if (symbol != NULL)
+			debug(" \t<%s>", symbol);
+		debug("\n");
+		break;
+	case 0x1d:
+	case 0x1f:
+		/*  Second half of BL or BLX, on its own:  */
+		debug("%s\tlr+0x%x\n", op == 0x1d? "blx" : "bl",
+		    (int)((iw & 0x7ff) << 1));
+		break;
+	case 0x1e:
+		/*  First half of BL or BLX, on its own:  */
+		imm = (iw & 0x7ff) << 12;
+		if (imm & 0x00400000)
+			imm |= 0xff800000;
+		debug("bl\t(lr = 0x%x)\n", (int)(dumpaddr + 4 + imm));
+		break;
+	}
+
+	return sizeof(uint16_t);
+}
+
+
 /*
  *  arm_cpu_disassemble_instr():
  *
@@ -767,6 +1137,9 @@ int arm_cpu_disassemble_instr(struct cpu *cpu, unsigned char *ib,
 
 	debug("%08x:  ", (int)dumpaddr);
 
+	if (cpu->cd.arm.cpsr & ARM_FLAG_T)
+		return arm_cpu_disassemble_thumb(cpu, ib, dumpaddr);
+
 	if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
 		iw = ib[0] + (ib[1]<<8) + (ib[2]<<16) + (ib[3]<<24);
 	else
@@ -1233,10 +1606,16 @@ int arm_cpu_disassemble_instr(struct cpu *cpu, unsigned char *ib,
 		break;
 	case 0xa:				/*  B: branch  */
 	case 0xb:				/*  BL: branch and link  */
-		debug("b%s%s\t", main_opcode == 0xa? "" : "l", condition);
 		tmp = (iw & 0x00ffffff) << 2;
 		if (tmp & 0x02000000)
 			tmp |= 0xfc000000;
+		if ((iw >> 28) == 0xf) {
+			/*  BLX: branch, link, and switch to Thumb mode  */
+			debug("blx\t");
+			tmp += (iw >> 23) & 2;
+		} else
+			debug("b%s%s\t", main_opcode == 0xa? "" : "l",
+			    condition);
 		tmp = (int32_t)(dumpaddr + tmp + 8);
 		debug("0x%x", (int)tmp);
 		symbol = get_symbol_name(&cpu->machine->symbol_context,
@@ -1379,3 +1758,92 @@ void arm_cdp(struct cpu *cpu, uint32_t iword)
 
 #include "tmp_arm_tail.cc"
 
+
+
+/*
+ *  arm_thumb_pc_to_pointers():
+ *
+ *  Thumb version of arm_pc_to_pointers(). If bit 0 of the pc is set, then
+ *  this is a switch into Thumb mode.
+ *
+ *  The Thumb translation pages are not entered into the phys_page[] array,
+ *  so they are always looked up in the translation cache by their physical
+ *  address. (They are only looked up when leaving a 2 KB Thumb page, so this
+ *  is not as bad as it sounds.)
+ */
+void arm_thumb_pc_to_pointers(struct cpu *cpu)
+{
+	struct arm_tc_physpage *ppp;
+	uint32_t physaddr, key, physpage_ofs, *physpage_entryp;
+	int i, index;
+
+	if (cpu->pc & 1) {
+		cpu->cd.arm.cpsr |= ARM_FLAG_T;
+		cpu->pc &= ~1;
+	}
+
+	index = ARM_ADDR_TO_PAGENR((uint32_t)cpu->pc);
+
+	if (cpu->cd.arm.host_load[index] != NULL)
+		physaddr = cpu->cd.arm.phys_addr[index];
+	else {
+		unsigned char *host_page;
+		uint64_t paddr;
+
+		if (!cpu->translate_v2p(cpu, cpu->pc, &paddr, FLAG_INSTR)) {
+			/*  The exception handler (ARM code) has already
+			    been entered:  */
+			return;
+		}
+
+		physaddr = paddr & ~0xfff;
+		host_page = memory_paddr_to_hostaddr(cpu->mem, physaddr,
+		    MEM_READ);
+		if (host_page != NULL)
+			cpu->update_translation_table(cpu, cpu->pc & ~0xfff,
+			    host_page, 0, physaddr);
+	}
+
+	key = (physaddr & ~0xfff) | ARM_THUMB_PHYSPAGE_TAG(cpu->pc);
+
+	physpage_entryp = &(((uint32_t *)cpu->translation_cache)
+	    [PAGENR_TO_TABLE_INDEX(ARM_ADDR_TO_PAGENR(key))]);
+	physpage_ofs = *physpage_entryp;
+	ppp = NULL;
+
+	while (physpage_ofs != 0) {
+		ppp = (struct arm_tc_physpage *)
+		    (cpu->translation_cache + physpage_ofs);
+		if (ppp->physaddr == key)
+			break;
+		physpage_ofs = ppp->next_ofs;
+	}
+
+	if (physpage_ofs == 0) {
+		/*  (This may evict a page from the same chain, so the
+		    chain is read afterwards.)  */
+		physpage_ofs = arm_tc_allocate_default_page(cpu, physaddr);
+		ppp = (struct arm_tc_physpage *)
+		    (cpu->translation_cache + physpage_ofs);
+
+		ppp->physaddr = key;
+		for (i=0; i<ARM_IC_ENTRIES_PER_PAGE; i++)
+			ppp->ics[i].f = instr(thumb_to_be_translated);
+		ppp->ics[ARM_IC_ENTRIES_PER_PAGE].f = instr(thumb_end_of_page);
+
+		ppp->next_ofs = *physpage_entryp;
+		*physpage_entryp = physpage_ofs;
+	}
+
+	ppp->referenced = 1;
+
+	/*  See arm_pc_to_pointers_generic():  */
+	if (ppp->translations_bitmap == 0)
+		cpu->invalidate_translation_caches(cpu, physaddr,
+		    JUST_MARK_AS_NON_WRITABLE | INVALIDATE_PADDR);
+
+	cpu->cd.arm.cur_ic_page = &ppp->ics[0];
+	cpu->cd.arm.next_ic = cpu->cd.arm.cur_ic_page +
+	    ARM_THUMB_PC_TO_IC_ENTRY(cpu->pc);
+}
+
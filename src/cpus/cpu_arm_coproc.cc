@@ -171,11 +171,14 @@ void arm_coproc_15(struct cpu *cpu, int opcode1, int opcode2, int l_bit,
 		if (l_bit)
 			cpu->cd.arm.r[rd] = cpu->cd.arm.ttb & 0xffffc000;
 		else {
+			uint32_t old_ttb = cpu->cd.arm.ttb;
 			cpu->cd.arm.ttb = cpu->cd.arm.r[rd];
 			if (cpu->cd.arm.ttb & 0x3fff)
 				fatal("[ WARNING! low bits of new TTB non-"
 				    "zero? 0x%08x ]\n", cpu->cd.arm.ttb);
 			cpu->cd.arm.ttb &= 0xffffc000;
+			if (cpu->cd.arm.ttb != old_ttb)
+				arm_walk_cache_invalidate(cpu, 0, 1);
 		}
 		break;
 
@@ -217,12 +220,15 @@ void arm_coproc_15(struct cpu *cpu, int opcode1, int opcode2, int l_bit,
 		}
 		/*  fatal("[ arm_coproc_15: TLB: op2=%i crm=%i rd=0x%08x ]\n",
 		    opcode2, crm, cpu->cd.arm.r[rd]);  */
-		if (opcode2 == 0)
+		if (opcode2 == 0) {
+			arm_walk_cache_invalidate(cpu, 0, 1);
 			cpu->invalidate_translation_caches(cpu, 0,
 			    INVALIDATE_ALL);
-		else
+		} else {
+			arm_walk_cache_invalidate(cpu, cpu->cd.arm.r[rd], 0);
 			cpu->invalidate_translation_caches(cpu,
 			    cpu->cd.arm.r[rd], INVALIDATE_VADDR);
+		}
 		break;
 
 	case 9:	/*  Cache lockdown:  */
@@ -52,10 +52,13 @@
  *  the high bits; this would cause fewer host pages to be used. Anyway, the
  *  current implementation works on hosts with lots of RAM.
  *
- *  The resulting file, bdt_statistics.txt, should then be processed like
- *  this to give a new cpu_arm_multi.txt:
+ *  The resulting file, bdt_statistics.txt, contains one line per opcode
+ *  with the number of times it was executed followed by the opcode. It can
+ *  be used directly as a profile when building tmp_arm_multi.cc (see the
+ *  ARM_MULTI_PROFILE variable in Makefile.skel), or be processed like this
+ *  to give a new cpu_arm_multi.txt:
  *
- *  uniq -c bdt_statistics.txt|sort -nr|head -256|cut -f 2 > cpu_arm_multi.txt
+ *  sort -nr bdt_statistics.txt|head -256|cut -d' ' -f 2 > cpu_arm_multi.txt
  */
 static void update_bdt_statistics(uint32_t iw)
 {
@@ -84,7 +87,6 @@ static void update_bdt_statistics(uint32_t iw)
 	n ++;
 	if ((n % 500000) == 0) {
 		int i;
-		long long j;
 		fatal("[ update_bdt_statistics(): n = %lli ]\n", (long long) n);
 		fseek(f, 0, SEEK_SET);
 		for (i=0; i<0x1000000; i++)
@@ -92,8 +94,7 @@ static void update_bdt_statistics(uint32_t iw)
 				/*  Recreate the opcode:  */
 				uint32_t opcode = ((i & 0x00c00000) << 1)
 				    | (i & 0x003fffff) | 0x08000000;
-				for (j=0; j<counts[i]; j++)
-					fprintf(f, "0x%08x\n", opcode);
+				fprintf(f, "%lli 0x%08x\n", counts[i], opcode);
 			}
 		fflush(f);
 	}
@@ -131,59 +132,73 @@ uint8_t condition_gt[16] = { 1,0,1,0, 0,0,0,0, 0,1,0,1, 0,0,0,0 };
 
 #define Y(n) void arm_instr_ ## n ## __eq(struct cpu *cpu,		\
 			struct arm_instr_call *ic)			\
-	{  if (cpu->cd.arm.flags & ARM_F_Z)				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (cpu->cd.arm.flags & ARM_F_Z)				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __ne(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (!(cpu->cd.arm.flags & ARM_F_Z))				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (!(cpu->cd.arm.flags & ARM_F_Z))				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __cs(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (cpu->cd.arm.flags & ARM_F_C)				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (cpu->cd.arm.flags & ARM_F_C)				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __cc(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (!(cpu->cd.arm.flags & ARM_F_C))				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (!(cpu->cd.arm.flags & ARM_F_C))				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __mi(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (cpu->cd.arm.flags & ARM_F_N)				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (cpu->cd.arm.flags & ARM_F_N)				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __pl(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (!(cpu->cd.arm.flags & ARM_F_N))				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (!(cpu->cd.arm.flags & ARM_F_N))				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __vs(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (cpu->cd.arm.flags & ARM_F_V)				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (cpu->cd.arm.flags & ARM_F_V)				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __vc(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (!(cpu->cd.arm.flags & ARM_F_V))				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (!(cpu->cd.arm.flags & ARM_F_V))				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __hi(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (condition_hi[cpu->cd.arm.flags])				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (condition_hi[cpu->cd.arm.flags])				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __ls(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (!condition_hi[cpu->cd.arm.flags])			\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (!condition_hi[cpu->cd.arm.flags])			\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __ge(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (condition_ge[cpu->cd.arm.flags])				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (condition_ge[cpu->cd.arm.flags])				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __lt(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (!condition_ge[cpu->cd.arm.flags])			\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (!condition_ge[cpu->cd.arm.flags])			\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __gt(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (condition_gt[cpu->cd.arm.flags])				\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (condition_gt[cpu->cd.arm.flags])				\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void arm_instr_ ## n ## __le(struct cpu *cpu,			\
 			struct arm_instr_call *ic)			\
-	{  if (!condition_gt[cpu->cd.arm.flags])			\
+	{  ARM_FLAGS_SYNC(cpu);						\
+	   if (!condition_gt[cpu->cd.arm.flags])			\
 		arm_instr_ ## n (cpu, ic);		}		\
 	void (*arm_cond_instr_ ## n  [16])(struct cpu *,		\
 			struct arm_instr_call *) = {			\
@@ -257,61 +272,75 @@ X(b_samepage) {
 	cpu->cd.arm.next_ic = (struct arm_instr_call *) ic->arg[0];
 }
 X(b_samepage__eq) {
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.next_ic = (struct arm_instr_call *)
 	    ic->arg[cpu->cd.arm.flags & ARM_F_Z? 0 : 1];
 }
 X(b_samepage__ne) {
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.next_ic = (struct arm_instr_call *)
 	    ic->arg[cpu->cd.arm.flags & ARM_F_Z? 1 : 0];
 }
 X(b_samepage__cs) {
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.next_ic = (struct arm_instr_call *)
 	    ic->arg[cpu->cd.arm.flags & ARM_F_C? 0 : 1];
 }
 X(b_samepage__cc) {
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.next_ic = (struct arm_instr_call *)
 	    ic->arg[cpu->cd.arm.flags & ARM_F_C? 1 : 0];
 }
 X(b_samepage__mi) {
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.next_ic = (struct arm_instr_call *)
 	    ic->arg[cpu->cd.arm.flags & ARM_F_N? 0 : 1];
 }
 X(b_samepage__pl) {
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.next_ic = (struct arm_instr_call *)
 	    ic->arg[cpu->cd.arm.flags & ARM_F_N? 1 : 0];
 }
 X(b_samepage__vs) {
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.next_ic = (struct arm_instr_call *)
 	    ic->arg[cpu->cd.arm.flags & ARM_F_V? 0 : 1];
 }
 X(b_samepage__vc) {
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.next_ic = (struct arm_instr_call *)
 	    ic->arg[cpu->cd.arm.flags & ARM_F_V? 1 : 0];
 }
 X(b_samepage__hi) {
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.next_ic = (condition_hi[cpu->cd.arm.flags])?
 	    (struct arm_instr_call *) ic->arg[0] :
 	    (struct arm_instr_call *) ic->arg[1];
 }
 X(b_samepage__ls) {
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.next_ic = (struct arm_instr_call *)
 	    ic->arg[condition_hi[cpu->cd.arm.flags]];
 }
 X(b_samepage__ge) {
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.next_ic = (condition_ge[cpu->cd.arm.flags])?
 	    (struct arm_instr_call *) ic->arg[0] :
 	    (struct arm_instr_call *) ic->arg[1];
 }
 X(b_samepage__lt) {
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.next_ic = (struct arm_instr_call *)
 	    ic->arg[condition_ge[cpu->cd.arm.flags]];
 }
 X(b_samepage__gt) {
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.next_ic = (condition_gt[cpu->cd.arm.flags])?
 	    (struct arm_instr_call *) ic->arg[0] :
 	    (struct arm_instr_call *) ic->arg[1];
 }
 X(b_samepage__le) {
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.next_ic = (struct arm_instr_call *)
 	    ic->arg[condition_gt[cpu->cd.arm.flags]];
 }
@@ -334,12 +363,10 @@ void (*arm_cond_instr_b_samepage[16])(struct cpu *,
  */
 X(bx)
 {
+	/*  Bit 0 set means Thumb mode, see arm_pc_to_pointers():  */
 	cpu->pc = reg(ic->arg[0]);
-	if (cpu->pc & 1) {
-		fatal("thumb: TODO\n");
-		exit(1);
-	}
-	cpu->pc &= ~3;
+	if (!(cpu->pc & 1))
+		cpu->pc &= ~3;
 
 	/*  Find the new physical page and update the translation pointers:  */
 	quick_pc_to_pointers(cpu);
@@ -355,11 +382,8 @@ Y(bx)
 X(bx_trace)
 {
 	cpu->pc = cpu->cd.arm.r[ARM_LR];
-	if (cpu->pc & 1) {
-		fatal("thumb: TODO\n");
-		exit(1);
-	}
-	cpu->pc &= ~3;
+	if (!(cpu->pc & 1))
+		cpu->pc &= ~3;
 
 	cpu_functioncall_trace_return(cpu);
 
@@ -388,6 +412,37 @@ X(bl)
 Y(bl)
 
 
+/*
+ *  bl_native:  Branch and Link to a guest routine which is run natively
+ *
+ *  arg[0] = relative address
+ *  arg[1] = offset of current instruction
+ *  arg[2] = native routine (NATIVE_ROUTINE_xxx)
+ *
+ *  If the routine can't be run natively, this is a normal bl. Otherwise,
+ *  execution continues with the instruction after the bl, as if the routine
+ *  had returned.
+ */
+X(bl_native)
+{
+	uint64_t args[3], retval;
+
+	args[0] = cpu->cd.arm.r[0];
+	args[1] = cpu->cd.arm.r[1];
+	args[2] = cpu->cd.arm.r[2];
+
+	if (!native_routine_run(cpu, ic->arg[2], args, &retval,
+	    DYNTRANS_NATIVE_HOST_PAGE)) {
+		instr(bl)(cpu, ic);
+		return;
+	}
+
+	cpu->cd.arm.r[ARM_LR] = ((uint32_t)cpu->pc & 0xfffff000) +
+	    (int32_t)ic->arg[1] + 4;
+	cpu->cd.arm.r[0] = retval;
+}
+
+
 /*
  *  blx:  Branch and Link, potentially exchanging Thumb/ARM encoding
  *
@@ -398,11 +453,8 @@ X(blx)
 	uint32_t lr = ((uint32_t)cpu->pc & 0xfffff000) + (int32_t)ic->arg[2];
 	cpu->cd.arm.r[ARM_LR] = lr;
 	cpu->pc = reg(ic->arg[0]);
-	if (cpu->pc & 1) {
-		fatal("thumb: TODO\n");
-		exit(1);
-	}
-	cpu->pc &= ~3;
+	if (!(cpu->pc & 1))
+		cpu->pc &= ~3;
 
 	/*  Find the new physical page and update the translation pointers:  */
 	quick_pc_to_pointers(cpu);
@@ -410,6 +462,26 @@ X(blx)
 Y(blx)
 
 
+/*
+ *  blx_imm:  Branch and Link, and switch to Thumb mode
+ *
+ *  arg[0] = relative address (with bit 0 set, for Thumb mode)
+ *  arg[1] = offset of current instruction
+ */
+X(blx_imm)
+{
+	uint32_t pc = ((uint32_t)cpu->pc & 0xfffff000) + (int32_t)ic->arg[1];
+	cpu->cd.arm.r[ARM_LR] = pc + 4;
+	cpu->pc = pc + (int32_t)ic->arg[0];
+
+	if (cpu->machine->show_trace_tree)
+		cpu_functioncall_trace(cpu, cpu->pc & ~1);
+
+	/*  Find the new physical page and update the translation pointers:  */
+	quick_pc_to_pointers(cpu);
+}
+
+
 /*
  *  bl_trace:  Branch and Link (to a different translated page), with trace
  *
@@ -517,6 +589,7 @@ X(muls)
 {
 	uint32_t result;
 	result = reg(ic->arg[1]) * reg(ic->arg[2]);
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.flags &= ~(ARM_F_Z | ARM_F_N);
 	if (result == 0)
 		cpu->cd.arm.flags |= ARM_F_Z;
@@ -552,6 +625,7 @@ X(mlas)
 	rs = (iw >> 8) & 15;  rm = iw & 15;
 	cpu->cd.arm.r[rd] = cpu->cd.arm.r[rm] * cpu->cd.arm.r[rs]
 	    + cpu->cd.arm.r[rn];
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.flags &= ~(ARM_F_Z | ARM_F_N);
 	if (cpu->cd.arm.r[rd] == 0)
 		cpu->cd.arm.flags |= ARM_F_Z;
@@ -703,12 +777,14 @@ Y(ret)
  */
 X(msr_imm)
 {
-	uint32_t mask = ic->arg[1];
+	/*  (The T bit can not be changed this way.)  */
+	uint32_t mask = ic->arg[1] & ~ARM_FLAG_T;
 	int switch_register_banks = (mask & ARM_FLAG_MODE) &&
 	    ((cpu->cd.arm.cpsr & ARM_FLAG_MODE) !=
 	    (ic->arg[0] & ARM_FLAG_MODE));
 	uint32_t new_value = ic->arg[0];
 
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.cpsr &= 0x0fffffff;
 	cpu->cd.arm.cpsr |= (cpu->cd.arm.flags << 28);
 
@@ -785,6 +861,7 @@ Y(msr_spsr)
  */
 X(mrs)
 {
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.cpsr &= 0x0fffffff;
 	cpu->cd.arm.cpsr |= (cpu->cd.arm.flags << 28);
 	reg(ic->arg[0]) = cpu->cd.arm.cpsr;
@@ -1172,7 +1249,7 @@ X(bdt_load)
 			arm_save_register_bank(cpu);
 
 		cpu->cd.arm.cpsr = new_cpsr;
-		cpu->cd.arm.flags = cpu->cd.arm.cpsr >> 28;
+		ARM_FLAGS_SET(cpu, cpu->cd.arm.cpsr >> 28);
 
 		if (switch_register_banks)
 			arm_load_register_bank(cpu);
@@ -1180,7 +1257,10 @@ X(bdt_load)
 
 	/*  NOTE: Special case: Loading the PC  */
 	if (iw & 0x8000) {
-		cpu->pc = cpu->cd.arm.r[ARM_PC] & 0xfffffffc;
+		/*  Bit 0 set means a switch to Thumb mode (ARMv5):  */
+		cpu->pc = cpu->cd.arm.r[ARM_PC];
+		if (!(cpu->pc & 1))
+			cpu->pc &= 0xfffffffc;
 		if (cpu->machine->show_trace_tree)
 			cpu_functioncall_trace_return(cpu);
 		/*  TODO: There is no need to update the
@@ -1188,7 +1268,11 @@ X(bdt_load)
 		    same page!  */
 		/*  Find the new physical page and update the
 		    translation pointers:  */
-		quick_pc_to_pointers(cpu);
+		if (return_flag) {
+			/*  The restored cpsr may have the T bit set:  */
+			arm_pc_to_pointers(cpu);
+		} else
+			quick_pc_to_pointers(cpu);
 	}
 }
 Y(bdt_load)
@@ -1318,6 +1402,162 @@ X(multi_0x08ac000c__ge);
 X(multi_0x08a05018);
 
 
+/*
+ *  multi_load, multi_store:  Load/store multiple, for register lists which
+ *                            don't have a generated function in
+ *                            tmp_arm_multi.cc.
+ *
+ *  arg[0] = pointer to the base register
+ *  arg[1] = 32-bit instruction word (the P, U, and W bits, and bit 15
+ *           for the PC, are used)
+ *  arg[2] = register list, as built by arm_multi_reglist(): the number of
+ *           registers (excluding PC) in the lowest 4 bits, followed by the
+ *           register numbers (4 bits each) in increasing order
+ *
+ *  Just like the generated functions, these only handle the case where all
+ *  words are within one page. The register transfers are unrolled (by
+ *  jumping into the sequence depending on the number of registers).
+ *  Loading the base register with writeback is handled by letting the
+ *  written back value overwrite the loaded value.
+ */
+#define	MULTI_REG(n)	cpu->cd.arm.r[(list >> (4*(n)+4)) & 15]
+X(multi_load)
+{
+	uint32_t *np = (uint32_t *)ic->arg[0];
+	uint32_t iw = ic->arg[1], base = *np, addr, *p;
+	uint64_t list = ic->arg[2];
+	int n_regs = list & 15, n_words = n_regs + ((iw >> 15) & 1);
+	unsigned char *page;
+
+	/*  The lowest address to load from:  */
+	if (iw & 0x00800000)
+		addr = base + (iw & 0x01000000? 4 : 0);
+	else
+		addr = base - 4 * n_words + (iw & 0x01000000? 0 : 4);
+
+	page = cpu->cd.arm.host_load[addr >> 12];
+	addr &= 0xffc;
+	if (page == NULL || addr > (uint32_t)(0x1000 - 4 * n_words)) {
+		instr(bdt_load)(cpu, ic);
+		return;
+	}
+
+	p = (uint32_t *) (page + addr);
+	switch (n_regs) {
+	case 15: MULTI_REG(14) = p[14];
+	case 14: MULTI_REG(13) = p[13];
+	case 13: MULTI_REG(12) = p[12];
+	case 12: MULTI_REG(11) = p[11];
+	case 11: MULTI_REG(10) = p[10];
+	case 10: MULTI_REG(9) = p[9];
+	case 9:	 MULTI_REG(8) = p[8];
+	case 8:	 MULTI_REG(7) = p[7];
+	case 7:	 MULTI_REG(6) = p[6];
+	case 6:	 MULTI_REG(5) = p[5];
+	case 5:	 MULTI_REG(4) = p[4];
+	case 4:	 MULTI_REG(3) = p[3];
+	case 3:	 MULTI_REG(2) = p[2];
+	case 2:	 MULTI_REG(1) = p[1];
+	case 1:	 MULTI_REG(0) = p[0];
+	}
+
+	if (iw & 0x00200000)
+		*np = iw & 0x00800000? base + 4 * n_words : base - 4 * n_words;
+
+	/*  Loading the PC, the same way as in bdt_load:  */
+	if (iw & 0x8000) {
+		/*  Bit 0 set means a switch to Thumb mode (ARMv5):  */
+		cpu->pc = cpu->cd.arm.r[ARM_PC] = p[n_regs];
+		if (!(cpu->pc & 1))
+			cpu->pc &= 0xfffffffc;
+		if (cpu->machine->show_trace_tree)
+			cpu_functioncall_trace_return(cpu);
+		quick_pc_to_pointers(cpu);
+	}
+}
+Y(multi_load)
+X(multi_store)
+{
+	uint32_t *np = (uint32_t *)ic->arg[0];
+	uint32_t iw = ic->arg[1], base = *np, addr, *p;
+	uint64_t list = ic->arg[2];
+	int n_regs = list & 15, n_words = n_regs + ((iw >> 15) & 1);
+	unsigned char *page;
+
+	/*  The lowest address to store to:  */
+	if (iw & 0x00800000)
+		addr = base + (iw & 0x01000000? 4 : 0);
+	else
+		addr = base - 4 * n_words + (iw & 0x01000000? 0 : 4);
+
+	page = cpu->cd.arm.host_store[addr >> 12];
+	addr &= 0xffc;
+	if (page == NULL || addr > (uint32_t)(0x1000 - 4 * n_words)) {
+		instr(bdt_store)(cpu, ic);
+		return;
+	}
+
+	p = (uint32_t *) (page + addr);
+	switch (n_regs) {
+	case 15: p[14] = MULTI_REG(14);
+	case 14: p[13] = MULTI_REG(13);
+	case 13: p[12] = MULTI_REG(12);
+	case 12: p[11] = MULTI_REG(11);
+	case 11: p[10] = MULTI_REG(10);
+	case 10: p[9] = MULTI_REG(9);
+	case 9:	 p[8] = MULTI_REG(8);
+	case 8:	 p[7] = MULTI_REG(7);
+	case 7:	 p[6] = MULTI_REG(6);
+	case 6:	 p[5] = MULTI_REG(5);
+	case 5:	 p[4] = MULTI_REG(4);
+	case 4:	 p[3] = MULTI_REG(3);
+	case 3:	 p[2] = MULTI_REG(2);
+	case 2:	 p[1] = MULTI_REG(1);
+	case 1:	 p[0] = MULTI_REG(0);
+	}
+
+	if (iw & 0x8000) {
+		uint32_t low_pc = ((size_t)ic - (size_t)
+		    cpu->cd.arm.cur_ic_page) / sizeof(struct arm_instr_call);
+		p[n_regs] = (cpu->pc & ~((ARM_IC_ENTRIES_PER_PAGE-1)
+		    << ARM_INSTR_ALIGNMENT_SHIFT)) +
+		    (low_pc << ARM_INSTR_ALIGNMENT_SHIFT) + 12;
+	}
+
+	if (iw & 0x00200000)
+		*np = iw & 0x00800000? base + 4 * n_words : base - 4 * n_words;
+}
+Y(multi_store)
+#undef MULTI_REG
+
+
+/*
+ *  arm_multi_reglist():
+ *
+ *  Returns the register list of a load/store multiple instruction word, in
+ *  the format used by multi_load and multi_store, or 0 if the registers
+ *  don't fit in a size_t or if PC is the only register.
+ */
+#if defined(HOST_LITTLE_ENDIAN) && !defined(GATHER_BDT_STATISTICS)
+static size_t arm_multi_reglist(uint32_t iword)
+{
+	size_t list = 0;
+	int i, n = 0;
+
+	for (i=0; i<ARM_PC; i++) {
+		if (!(iword & (1 << i)))
+			continue;
+		if (4 * n + 8 > 8 * (int)sizeof(size_t))
+			return 0;
+		list |= (size_t)i << (4 * n + 4);
+		n ++;
+	}
+
+	return n > 0? list | n : 0;
+}
+#endif
+
+
 /*****************************************************************************/
 
 
@@ -1334,12 +1574,14 @@ X(multi_0x08a05018);
 X(netbsd_memset)
 {
 	unsigned char *page;
+	uint64_t pattern;
 	uint32_t addr;
 
 	do {
 		addr = cpu->cd.arm.r[ARM_IP];
 
 		instr(subs)(cpu, ic);
+		ARM_FLAGS_SYNC(cpu);
 
 		if (((cpu->cd.arm.flags & ARM_F_N)?1:0) !=
 		    ((cpu->cd.arm.flags & ARM_F_V)?1:0)) {
@@ -1353,10 +1595,6 @@ X(netbsd_memset)
 		if ((addr & 0xfff) + 128 > 0x1000)
 			return;
 
-		/*  R2/R3 non-zero? Not allowed here.  */
-		if (cpu->cd.arm.r[2] != 0 || cpu->cd.arm.r[3] != 0)
-			return;
-
 		/*  printf("addr = 0x%08x\n", addr);  */
 
 		page = cpu->cd.arm.host_store[addr >> 12];
@@ -1364,8 +1602,16 @@ X(netbsd_memset)
 		if (page == NULL)
 			return;
 
-		/*  Clear:  */
-		memset(page + (addr & 0xfff), 0, 128);
+		/*  Fill with the r2,r3 pair (usually both zero):  */
+		if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
+			pattern = ((uint64_t)cpu->cd.arm.r[3] << 32)
+			    | cpu->cd.arm.r[2];
+		else
+			pattern = ((uint64_t)cpu->cd.arm.r[2] << 32)
+			    | cpu->cd.arm.r[3];
+		native_fill_pattern(page + (addr & 0xfff), pattern,
+		    sizeof(uint64_t), cpu->byte_order == EMUL_LITTLE_ENDIAN,
+		    128);
 		cpu->cd.arm.r[ARM_IP] = addr + 128;
 		cpu->n_translated_instrs += 16;
 
@@ -1377,6 +1623,7 @@ X(netbsd_memset)
 
 	/*  Continue at the instruction after the bgt:  */
 	cpu->cd.arm.next_ic = &ic[18];
+	cpu->native_routine_hits[NATIVE_ROUTINE_FILL_LOOP] ++;
 }
 
 
@@ -1427,6 +1674,7 @@ X(netbsd_memcpy)
 		cpu->n_translated_instrs += 4;
 
 		instr(subs)(cpu, ic + 4);
+		ARM_FLAGS_SYNC(cpu);
 		cpu->n_translated_instrs ++;
 
 		/*  Loop while greater or equal:  */
@@ -1437,6 +1685,7 @@ X(netbsd_memcpy)
 	/*  Continue at the instruction after the bge:  */
 	cpu->cd.arm.next_ic = &ic[6];
 	cpu->n_translated_instrs --;
+	cpu->native_routine_hits[NATIVE_ROUTINE_MEMCPY_LOOP] ++;
 }
 
 
@@ -1507,12 +1756,14 @@ X(netbsd_scanc)
 	cpu->cd.arm.r[3] = page[t & 0xfff];
 
 	t = cpu->cd.arm.r[3] & cpu->cd.arm.r[ARM_IP];
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.flags &= ~(ARM_F_Z | ARM_F_N);
 	if (t == 0)
 		cpu->cd.arm.flags |= ARM_F_Z;
 
 	cpu->n_translated_instrs += 2;
 	cpu->cd.arm.next_ic = &ic[3];
+	cpu->native_routine_hits[NATIVE_ROUTINE_SCANC] ++;
 }
 
 
@@ -1603,13 +1854,12 @@ X(strlen)
 		n_loops ++;
 
 		/*  Compare rY to zero:  */
-		cpu->cd.arm.flags = ARM_F_C;
-		if (rY == 0)
-			cpu->cd.arm.flags |= ARM_F_Z;
+		ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_SUB, rY, 0);
 	} while (rY != 0);
 
 	cpu->n_translated_instrs += (n_loops * 3) - 1;
 	cpu->cd.arm.next_ic = &ic[3];
+	cpu->native_routine_hits[NATIVE_ROUTINE_STRLEN_LOOP] ++;
 }
 
 
@@ -1662,6 +1912,7 @@ X(netbsd_copyin)
 	cpu->cd.arm.r[0] = r0 + 24;
 	cpu->n_translated_instrs += 5;
 	cpu->cd.arm.next_ic = &ic[6];
+	cpu->native_routine_hits[NATIVE_ROUTINE_COPYIN] ++;
 }
 
 
@@ -1697,6 +1948,7 @@ X(netbsd_copyout)
 	cpu->cd.arm.r[1] = r1 + 24;
 	cpu->n_translated_instrs += 5;
 	cpu->cd.arm.next_ic = &ic[6];
+	cpu->native_routine_hits[NATIVE_ROUTINE_COPYOUT] ++;
 }
 
 
@@ -1707,12 +1959,7 @@ X(cmps0_beq_samepage)
 {
 	uint32_t a = reg(ic->arg[0]);
 	cpu->n_translated_instrs ++;
-	if (a == 0) {
-		cpu->cd.arm.flags = ARM_F_Z | ARM_F_C;
-	} else {
-		/*  Semi-ugly hack which sets the negative-bit if a < 0:  */
-		cpu->cd.arm.flags = ARM_F_C | ((a >> 28) & 8);
-	}
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_SUB, a, 0);
 	if (a == 0)
 		cpu->cd.arm.next_ic = (struct arm_instr_call *) ic[1].arg[0];
 	else
@@ -1725,20 +1972,13 @@ X(cmps0_beq_samepage)
  */
 X(cmps_beq_samepage)
 {
-	uint32_t a = reg(ic->arg[0]), b = ic->arg[1], c = a - b;
+	uint32_t a = reg(ic->arg[0]), b = ic->arg[1];
 	cpu->n_translated_instrs ++;
-	cpu->cd.arm.flags = ((uint32_t)a >= (uint32_t)b)? ARM_F_C : 0;
-	if (((int32_t)a >= 0 && (int32_t)b < 0 && (int32_t)c < 0) ||
-	    ((int32_t)a < 0 && (int32_t)b >= 0 && (int32_t)c >= 0))
-		cpu->cd.arm.flags |= ARM_F_V;
-	if (c == 0) {
-		cpu->cd.arm.flags |= ARM_F_Z;
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_SUB, a, b);
+	if (a == b)
 		cpu->cd.arm.next_ic = (struct arm_instr_call *) ic[1].arg[0];
-	} else {
+	else
 		cpu->cd.arm.next_ic = &ic[2];
-		if (c & 0x80000000)
-			cpu->cd.arm.flags |= ARM_F_N;
-	}
 }
 
 
@@ -1749,52 +1989,37 @@ X(cmps_0_beq)
 {
 	uint32_t a = reg(ic->arg[0]);
 	cpu->n_translated_instrs ++;
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_SUB, a, 0);
 	if (a == 0) {
-		cpu->cd.arm.flags = ARM_F_Z | ARM_F_C;
 		cpu->pc = (uint32_t)(((uint32_t)cpu->pc & 0xfffff000)
 		    + (int32_t)ic[1].arg[0]);
 		quick_pc_to_pointers(cpu);
-	} else {
-		/*  Semi-ugly hack which sets the negative-bit if a < 0:  */
-		cpu->cd.arm.flags = ARM_F_C | ((a >> 28) & 8);
+	} else
 		cpu->cd.arm.next_ic = &ic[2];
-	}
 }
 X(cmps_pos_beq)
 {
-	uint32_t a = reg(ic->arg[0]), b = ic->arg[1], c = a - b;
+	uint32_t a = reg(ic->arg[0]), b = ic->arg[1];
 	cpu->n_translated_instrs ++;
-	cpu->cd.arm.flags = ((uint32_t)a >= (uint32_t)b)? ARM_F_C : 0;
-	if ((int32_t)a < 0 && (int32_t)c >= 0)
-		cpu->cd.arm.flags |= ARM_F_V;
-	if (c == 0) {
-		cpu->cd.arm.flags |= ARM_F_Z;
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_SUB, a, b);
+	if (a == b) {
 		cpu->pc = (uint32_t)(((uint32_t)cpu->pc & 0xfffff000)
 		    + (int32_t)ic[1].arg[0]);
 		quick_pc_to_pointers(cpu);
-	} else {
+	} else
 		cpu->cd.arm.next_ic = &ic[2];
-		if (c & 0x80000000)
-			cpu->cd.arm.flags |= ARM_F_N;
-	}
 }
 X(cmps_neg_beq)
 {
-	uint32_t a = reg(ic->arg[0]), b = ic->arg[1], c = a - b;
+	uint32_t a = reg(ic->arg[0]), b = ic->arg[1];
 	cpu->n_translated_instrs ++;
-	cpu->cd.arm.flags = ((uint32_t)a >= (uint32_t)b)? ARM_F_C : 0;
-	if ((int32_t)a >= 0 && (int32_t)c < 0)
-		cpu->cd.arm.flags |= ARM_F_V;
-	if (c == 0) {
-		cpu->cd.arm.flags |= ARM_F_Z;
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_SUB, a, b);
+	if (a == b) {
 		cpu->pc = (uint32_t)(((uint32_t)cpu->pc & 0xfffff000)
 		    + (int32_t)ic[1].arg[0]);
 		quick_pc_to_pointers(cpu);
-	} else {
+	} else
 		cpu->cd.arm.next_ic = &ic[2];
-		if (c & 0x80000000)
-			cpu->cd.arm.flags |= ARM_F_N;
-	}
 }
 
 
@@ -1805,12 +2030,7 @@ X(cmps0_bne_samepage)
 {
 	uint32_t a = reg(ic->arg[0]);
 	cpu->n_translated_instrs ++;
-	if (a == 0) {
-		cpu->cd.arm.flags = ARM_F_Z | ARM_F_C;
-	} else {
-		/*  Semi-ugly hack which sets the negative-bit if a < 0:  */
-		cpu->cd.arm.flags = ARM_F_C | ((a >> 28) & 8);
-	}
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_SUB, a, 0);
 	if (a == 0)
 		cpu->cd.arm.next_ic = &ic[2];
 	else
@@ -1823,20 +2043,13 @@ X(cmps0_bne_samepage)
  */
 X(cmps_bne_samepage)
 {
-	uint32_t a = reg(ic->arg[0]), b = ic->arg[1], c = a - b;
+	uint32_t a = reg(ic->arg[0]), b = ic->arg[1];
 	cpu->n_translated_instrs ++;
-	cpu->cd.arm.flags = ((uint32_t)a >= (uint32_t)b)? ARM_F_C : 0;
-	if (((int32_t)a >= 0 && (int32_t)b < 0 && (int32_t)c < 0) ||
-	    ((int32_t)a < 0 && (int32_t)b >= 0 && (int32_t)c >= 0))
-		cpu->cd.arm.flags |= ARM_F_V;
-	if (c == 0) {
-		cpu->cd.arm.flags |= ARM_F_Z;
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_SUB, a, b);
+	if (a == b)
 		cpu->cd.arm.next_ic = &ic[2];
-	} else {
-		if (c & 0x80000000)
-			cpu->cd.arm.flags |= ARM_F_N;
+	else
 		cpu->cd.arm.next_ic = (struct arm_instr_call *) ic[1].arg[0];
-	}
 }
 
 
@@ -1845,16 +2058,9 @@ X(cmps_bne_samepage)
  */
 X(cmps_bcc_samepage)
 {
-	uint32_t a = reg(ic->arg[0]), b = ic->arg[1], c = a - b;
+	uint32_t a = reg(ic->arg[0]), b = ic->arg[1];
 	cpu->n_translated_instrs ++;
-	cpu->cd.arm.flags = ((uint32_t)a >= (uint32_t)b)? ARM_F_C : 0;
-	if (c & 0x80000000)
-		cpu->cd.arm.flags |= ARM_F_N;
-	else if (c == 0)
-		cpu->cd.arm.flags |= ARM_F_Z;
-	if (((int32_t)a >= 0 && (int32_t)b < 0 && (int32_t)c < 0) ||
-	    ((int32_t)a < 0 && (int32_t)b >= 0 && (int32_t)c >= 0))
-		cpu->cd.arm.flags |= ARM_F_V;
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_SUB, a, b);
 	if (a >= b)
 		cpu->cd.arm.next_ic = &ic[2];
 	else
@@ -1867,16 +2073,9 @@ X(cmps_bcc_samepage)
  */
 X(cmps_reg_bcc_samepage)
 {
-	uint32_t a = reg(ic->arg[0]), b = reg(ic->arg[1]), c = a - b;
+	uint32_t a = reg(ic->arg[0]), b = reg(ic->arg[1]);
 	cpu->n_translated_instrs ++;
-	cpu->cd.arm.flags = ((uint32_t)a >= (uint32_t)b)? ARM_F_C : 0;
-	if (c & 0x80000000)
-		cpu->cd.arm.flags |= ARM_F_N;
-	else if (c == 0)
-		cpu->cd.arm.flags |= ARM_F_Z;
-	if (((int32_t)a >= 0 && (int32_t)b < 0 && (int32_t)c < 0) ||
-	    ((int32_t)a < 0 && (int32_t)b >= 0 && (int32_t)c >= 0))
-		cpu->cd.arm.flags |= ARM_F_V;
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_SUB, a, b);
 	if (a >= b)
 		cpu->cd.arm.next_ic = &ic[2];
 	else
@@ -1889,16 +2088,9 @@ X(cmps_reg_bcc_samepage)
  */
 X(cmps_bhi_samepage)
 {
-	uint32_t a = reg(ic->arg[0]), b = ic->arg[1], c = a - b;
+	uint32_t a = reg(ic->arg[0]), b = ic->arg[1];
 	cpu->n_translated_instrs ++;
-	cpu->cd.arm.flags = ((uint32_t)a >= (uint32_t)b)? ARM_F_C : 0;
-	if (c & 0x80000000)
-		cpu->cd.arm.flags |= ARM_F_N;
-	else if (c == 0)
-		cpu->cd.arm.flags |= ARM_F_Z;
-	if (((int32_t)a >= 0 && (int32_t)b < 0 && (int32_t)c < 0) ||
-	    ((int32_t)a < 0 && (int32_t)b >= 0 && (int32_t)c >= 0))
-		cpu->cd.arm.flags |= ARM_F_V;
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_SUB, a, b);
 	if (a > b)
 		cpu->cd.arm.next_ic = (struct arm_instr_call *) ic[1].arg[0];
 	else
@@ -1911,16 +2103,9 @@ X(cmps_bhi_samepage)
  */
 X(cmps_reg_bhi_samepage)
 {
-	uint32_t a = reg(ic->arg[0]), b = reg(ic->arg[1]), c = a - b;
+	uint32_t a = reg(ic->arg[0]), b = reg(ic->arg[1]);
 	cpu->n_translated_instrs ++;
-	cpu->cd.arm.flags = ((uint32_t)a >= (uint32_t)b)? ARM_F_C : 0;
-	if (c & 0x80000000)
-		cpu->cd.arm.flags |= ARM_F_N;
-	else if (c == 0)
-		cpu->cd.arm.flags |= ARM_F_Z;
-	if (((int32_t)a >= 0 && (int32_t)b < 0 && (int32_t)c < 0) ||
-	    ((int32_t)a < 0 && (int32_t)b >= 0 && (int32_t)c >= 0))
-		cpu->cd.arm.flags |= ARM_F_V;
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_SUB, a, b);
 	if (a > b)
 		cpu->cd.arm.next_ic = (struct arm_instr_call *) ic[1].arg[0];
 	else
@@ -1933,16 +2118,9 @@ X(cmps_reg_bhi_samepage)
  */
 X(cmps_bgt_samepage)
 {
-	uint32_t a = reg(ic->arg[0]), b = ic->arg[1], c = a - b;
+	uint32_t a = reg(ic->arg[0]), b = ic->arg[1];
 	cpu->n_translated_instrs ++;
-	cpu->cd.arm.flags = ((uint32_t)a >= (uint32_t)b)? ARM_F_C : 0;
-	if (c & 0x80000000)
-		cpu->cd.arm.flags |= ARM_F_N;
-	else if (c == 0)
-		cpu->cd.arm.flags |= ARM_F_Z;
-	if (((int32_t)a >= 0 && (int32_t)b < 0 && (int32_t)c < 0) ||
-	    ((int32_t)a < 0 && (int32_t)b >= 0 && (int32_t)c >= 0))
-		cpu->cd.arm.flags |= ARM_F_V;
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_SUB, a, b);
 	if ((int32_t)a > (int32_t)b)
 		cpu->cd.arm.next_ic = (struct arm_instr_call *) ic[1].arg[0];
 	else
@@ -1955,16 +2133,9 @@ X(cmps_bgt_samepage)
  */
 X(cmps_ble_samepage)
 {
-	uint32_t a = reg(ic->arg[0]), b = ic->arg[1], c = a - b;
+	uint32_t a = reg(ic->arg[0]), b = ic->arg[1];
 	cpu->n_translated_instrs ++;
-	cpu->cd.arm.flags = ((uint32_t)a >= (uint32_t)b)? ARM_F_C : 0;
-	if (c & 0x80000000)
-		cpu->cd.arm.flags |= ARM_F_N;
-	else if (c == 0)
-		cpu->cd.arm.flags |= ARM_F_Z;
-	if (((int32_t)a >= 0 && (int32_t)b < 0 && (int32_t)c < 0) ||
-	    ((int32_t)a < 0 && (int32_t)b >= 0 && (int32_t)c >= 0))
-		cpu->cd.arm.flags |= ARM_F_V;
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_SUB, a, b);
 	if ((int32_t)a <= (int32_t)b)
 		cpu->cd.arm.next_ic = (struct arm_instr_call *) ic[1].arg[0];
 	else
@@ -1979,6 +2150,7 @@ X(teqs_beq_samepage)
 {
 	uint32_t a = reg(ic->arg[0]), b = ic->arg[1], c = a ^ b;
 	cpu->n_translated_instrs ++;
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.flags &= ~(ARM_F_Z | ARM_F_N);
 	if (c == 0) {
 		cpu->cd.arm.flags |= ARM_F_Z;
@@ -2000,6 +2172,7 @@ X(tsts_lo_beq_samepage)
 {
 	uint32_t a = reg(ic->arg[0]), b = ic->arg[1], c = a & b;
 	cpu->n_translated_instrs ++;
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.flags &= ~(ARM_F_Z | ARM_F_N);
 	if (c == 0)
 		cpu->cd.arm.flags |= ARM_F_Z;
@@ -2018,6 +2191,7 @@ X(teqs_bne_samepage)
 {
 	uint32_t a = reg(ic->arg[0]), b = ic->arg[1], c = a ^ b;
 	cpu->n_translated_instrs ++;
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.flags &= ~(ARM_F_Z | ARM_F_N);
 	if (c == 0) {
 		cpu->cd.arm.flags |= ARM_F_Z;
@@ -2041,6 +2215,7 @@ X(tsts_lo_bne_samepage)
 {
 	uint32_t a = reg(ic->arg[0]), b = ic->arg[1], c = a & b;
 	cpu->n_translated_instrs ++;
+	ARM_FLAGS_SYNC(cpu);
 	cpu->cd.arm.flags &= ~(ARM_F_Z | ARM_F_N);
 	if (c == 0)
 		cpu->cd.arm.flags |= ARM_F_Z;
@@ -2085,6 +2260,9 @@ void COMBINE(netbsd_memset)(struct cpu *cpu,
 	int n_back = (low_addr >> ARM_INSTR_ALIGNMENT_SHIFT)
 	    & (ARM_IC_ENTRIES_PER_PAGE-1);
 
+	if (!cpu->machine->allow_native_routines)
+		return;
+
 	if (n_back >= 17) {
 		int i;
 		for (i=-16; i<=-1; i++)
@@ -2114,6 +2292,9 @@ void COMBINE(netbsd_memcpy)(struct cpu *cpu, struct arm_instr_call *ic,
 	int n_back = (low_addr >> ARM_INSTR_ALIGNMENT_SHIFT)
 	    & (ARM_IC_ENTRIES_PER_PAGE-1);
 
+	if (!cpu->machine->allow_native_routines)
+		return;
+
 	if (n_back >= 5) {
 		if (ic[-5].f==instr(multi_0x08b15018) &&
 		    ic[-4].f==instr(multi_0x08a05018) &&
@@ -2186,6 +2367,9 @@ void COMBINE(netbsd_scanc)(struct cpu *cpu,
 	int n_back = (low_addr >> ARM_INSTR_ALIGNMENT_SHIFT)
 	    & (ARM_IC_ENTRIES_PER_PAGE-1);
 
+	if (!cpu->machine->allow_native_routines)
+		return;
+
 	if (n_back < 2)
 		return;
 
@@ -2211,6 +2395,9 @@ void COMBINE(strlen)(struct cpu *cpu,
 	int n_back = (low_addr >> ARM_INSTR_ALIGNMENT_SHIFT)
 	    & (ARM_IC_ENTRIES_PER_PAGE-1);
 
+	if (!cpu->machine->allow_native_routines)
+		return;
+
 	if (n_back < 2)
 		return;
 
@@ -2260,6 +2447,9 @@ void COMBINE(netbsd_copyin)(struct cpu *cpu,
 	int i, n_back = (low_addr >> ARM_INSTR_ALIGNMENT_SHIFT)
 	    & (ARM_IC_ENTRIES_PER_PAGE-1);
 
+	if (!cpu->machine->allow_native_routines)
+		return;
+
 	if (n_back < 5)
 		return;
 
@@ -2291,6 +2481,9 @@ void COMBINE(netbsd_copyout)(struct cpu *cpu,
 	int i, n_back = (low_addr >> ARM_INSTR_ALIGNMENT_SHIFT)
 	    & (ARM_IC_ENTRIES_PER_PAGE-1);
 
+	if (!cpu->machine->allow_native_routines)
+		return;
+
 	if (n_back < 5)
 		return;
 
@@ -2484,6 +2677,9 @@ static void arm_switch_add1(struct arm_instr_call *ic, int rd,
 }
 
 
+#include "cpu_arm_instr_thumb.cc"
+
+
 /*****************************************************************************/
 
 
@@ -2502,6 +2698,7 @@ X(to_be_translated)
 	unsigned char ib[4];
 	int condition_code, main_opcode, secondary_opcode, s_bit, rn, rd, r8;
 	int p_bit, u_bit, w_bit, l_bit, regform, rm, c, t, any_pc_reg;
+	int native;
 	void (*samepage_function)(struct cpu *, struct arm_instr_call *);
 
 	/*  Figure out the address of the instruction:  */
@@ -2562,6 +2759,18 @@ X(to_be_translated)
 			goto okay;
 		}
 
+		if ((iword & 0x0e000000) == 0x0a000000) {
+			/*  BLX: Branch, link, and switch to Thumb mode.  */
+			ic->f = instr(blx_imm);
+			ic->arg[0] = (iword & 0x00ffffff) << 2;
+			if (ic->arg[0] & 0x02000000)
+				ic->arg[0] |= 0xfc000000;
+			ic->arg[0] = (int32_t)(ic->arg[0] + 8 +
+			    ((iword >> 23) & 2) + 1);
+			ic->arg[1] = addr & 0xffc;
+			goto okay;
+		}
+
 		if (!cpu->translation_readahead)
 			fatal("TODO: ARM condition code 0x%x\n",
 			    condition_code);
@@ -2621,9 +2830,10 @@ X(to_be_translated)
 		}
 		if ((iword & 0x0ff000d0) == 0x01200010) {
 			/*  bx or blx  */
-			if (iword & 0x20)
+			if (iword & 0x20) {
 				ic->f = cond_instr(blx);
-			else {
+				ic->arg[2] = (addr & 0xffc) + 4;
+			} else {
 				if (cpu->machine->show_trace_tree &&
 				    rm == ARM_LR)
 					ic->f = cond_instr(bx_trace);
@@ -2974,6 +3184,16 @@ X(to_be_translated)
 				}
 				i ++;
 			}
+
+			/*  No generated function? Then use a generic one:  */
+			if (multi_opcode[j][i] == 0 &&
+			    !(iword & 0x00400000) && rn != ARM_PC &&
+			    (ic->arg[2] = arm_multi_reglist(iword)) != 0) {
+				if (l_bit)
+					ic->f = cond_instr(multi_load);
+				else
+					ic->f = cond_instr(multi_store);
+			}
 		}
 #endif
 		if (rn == ARM_PC) {
@@ -3025,6 +3245,16 @@ X(to_be_translated)
 		 */
 		ic->arg[0] = (int32_t)(ic->arg[0] + 8);
 
+		/*  Calls to routines which can be run natively:  */
+		if (main_opcode == 0x0b && condition_code == 0xe &&
+		    (native = native_routine_lookup(cpu->machine,
+		    (uint32_t)(addr + (int32_t)ic->arg[0]))) !=
+		    NATIVE_ROUTINE_NONE) {
+			ic->f = instr(bl_native);
+			ic->arg[2] = native;
+			break;
+		}
+
 		/*
 		 *  Special case: branch within the same page:
 		 *
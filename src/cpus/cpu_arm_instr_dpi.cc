@@ -66,6 +66,12 @@
  */
 void A__NAME(struct cpu *cpu, struct arm_instr_call *ic)
 {
+/*  Flag-setting additions and subtractions use lazy flags:  */
+#if defined(A__S) && (defined(A__ADD) || defined(A__CMN) || \
+    defined(A__SUB) || defined(A__CMP) || defined(A__RSB))
+#define A__LAZYFLAGS
+#endif
+
 #if defined(A__RSB) || defined(A__RSC)
 #define VAR_A  b
 #define VAR_B  a
@@ -80,7 +86,7 @@ void A__NAME(struct cpu *cpu, struct arm_instr_call *ic)
 	      (void *)(size_t)ic->arg[1];
 #endif
 
-#ifdef A__S
+#if defined(A__S) && !defined(A__LAZYFLAGS)
 	uint32_t c32;
 #endif
 #if defined(A__CMP) || defined(A__CMN) || defined(A__ADC) || defined(A__ADD) \
@@ -103,12 +109,19 @@ void A__NAME(struct cpu *cpu, struct arm_instr_call *ic)
 	    ic->arg[1]
 #endif
 #endif
+#if !defined(A__LAZYFLAGS) || (!defined(A__CMP) && !defined(A__CMN))
 	    , c64
+#endif
 #if !defined(A__MOV) && !defined(A__MVN)
 	    , VAR_A = reg(ic->arg[0])
 #endif
 	    ;
 
+#if (defined(A__S) && !defined(A__LAZYFLAGS)) || \
+    defined(A__ADC) || defined(A__SBC) || defined(A__RSC)
+	ARM_FLAGS_SYNC(cpu);
+#endif
+
 #if defined(A__MOV) || defined(A__MVN) || defined(A__TST) || defined(A__TEQ) \
  || defined(A__AND) || defined(A__BIC) || defined(A__EOR) || defined(A__ORR)
 #if !defined(A__REG) && defined(A__S)
@@ -152,10 +165,11 @@ void A__NAME(struct cpu *cpu, struct arm_instr_call *ic)
 #if defined(A__EOR) || defined(A__TEQ)
 	c64 = a ^ b;
 #endif
-#if defined(A__SUB) || defined(A__CMP) || defined(A__RSB)
+#if defined(A__SUB) || defined(A__RSB) || \
+    (defined(A__CMP) && !defined(A__LAZYFLAGS))
 	c64 = a - b;
 #endif
-#if defined(A__ADD) || defined(A__CMN)
+#if defined(A__ADD) || (defined(A__CMN) && !defined(A__LAZYFLAGS))
 	c64 = a + b;
 #endif
 #if defined(A__ADC)
@@ -206,8 +220,11 @@ void A__NAME(struct cpu *cpu, struct arm_instr_call *ic)
 		case ARM_MODE_UND32:
 			cpu->cd.arm.cpsr = cpu->cd.arm.spsr_und; break;
 		}
-		cpu->cd.arm.flags = cpu->cd.arm.cpsr >> 28;
+		ARM_FLAGS_SET(cpu, cpu->cd.arm.cpsr >> 28);
 		arm_load_register_bank(cpu);
+
+		/*  The restored cpsr may have the T bit set:  */
+		arm_pc_to_pointers(cpu);
 #else
 		if ((old_pc & ~mask_within_page) ==
 		    ((uint32_t)cpu->pc & ~mask_within_page)) {
@@ -215,8 +232,8 @@ void A__NAME(struct cpu *cpu, struct arm_instr_call *ic)
 			    ((cpu->pc & mask_within_page) >>
 			    ARM_INSTR_ALIGNMENT_SHIFT);
 		} else
-#endif
 			quick_pc_to_pointers(cpu);
+#endif
 		return;
 	} else
 		reg(ic->arg[2]) = c64;
@@ -230,6 +247,13 @@ void A__NAME(struct cpu *cpu, struct arm_instr_call *ic)
 	 *  Status flag update (if the S-bit is set):
 	 */
 #ifdef A__S
+#ifdef A__LAZYFLAGS
+#if defined(A__ADD) || defined(A__CMN)
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_ADD, (uint32_t)a, (uint32_t)b);
+#else
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_SUB, (uint32_t)a, (uint32_t)b);
+#endif
+#else
 	c32 = c64;
 	cpu->cd.arm.flags
 #if defined(A__CMP) || defined(A__CMN) || defined(A__ADC) || defined(A__ADD) \
@@ -281,29 +305,39 @@ void A__NAME(struct cpu *cpu, struct arm_instr_call *ic)
 			cpu->cd.arm.flags |= ARM_F_V;
 	}
 #endif
+#endif	/*  !A__LAZYFLAGS  */
 #endif	/*  A__S  */
 
 #undef VAR_A
 #undef VAR_B
+#undef A__LAZYFLAGS
 }
 
 
 void A__NAME__eq(struct cpu *cpu, struct arm_instr_call *ic)
-{ if (cpu->cd.arm.flags & ARM_F_Z) A__NAME(cpu, ic); }
+{ ARM_FLAGS_SYNC(cpu);
+  if (cpu->cd.arm.flags & ARM_F_Z) A__NAME(cpu, ic); }
 void A__NAME__ne(struct cpu *cpu, struct arm_instr_call *ic)
-{ if (!(cpu->cd.arm.flags & ARM_F_Z)) A__NAME(cpu, ic); }
+{ ARM_FLAGS_SYNC(cpu);
+  if (!(cpu->cd.arm.flags & ARM_F_Z)) A__NAME(cpu, ic); }
 void A__NAME__cs(struct cpu *cpu, struct arm_instr_call *ic)
-{ if (cpu->cd.arm.flags & ARM_F_C) A__NAME(cpu, ic); }
+{ ARM_FLAGS_SYNC(cpu);
+  if (cpu->cd.arm.flags & ARM_F_C) A__NAME(cpu, ic); }
 void A__NAME__cc(struct cpu *cpu, struct arm_instr_call *ic)
-{ if (!(cpu->cd.arm.flags & ARM_F_C)) A__NAME(cpu, ic); }
+{ ARM_FLAGS_SYNC(cpu);
+  if (!(cpu->cd.arm.flags & ARM_F_C)) A__NAME(cpu, ic); }
 void A__NAME__mi(struct cpu *cpu, struct arm_instr_call *ic)
-{ if (cpu->cd.arm.flags & ARM_F_N) A__NAME(cpu, ic); }
+{ ARM_FLAGS_SYNC(cpu);
+  if (cpu->cd.arm.flags & ARM_F_N) A__NAME(cpu, ic); }
 void A__NAME__pl(struct cpu *cpu, struct arm_instr_call *ic)
-{ if (!(cpu->cd.arm.flags & ARM_F_N)) A__NAME(cpu, ic); }
+{ ARM_FLAGS_SYNC(cpu);
+  if (!(cpu->cd.arm.flags & ARM_F_N)) A__NAME(cpu, ic); }
 void A__NAME__vs(struct cpu *cpu, struct arm_instr_call *ic)
-{ if (cpu->cd.arm.flags & ARM_F_V) A__NAME(cpu, ic); }
+{ ARM_FLAGS_SYNC(cpu);
+  if (cpu->cd.arm.flags & ARM_F_V) A__NAME(cpu, ic); }
 void A__NAME__vc(struct cpu *cpu, struct arm_instr_call *ic)
-{ if (!(cpu->cd.arm.flags & ARM_F_V)) A__NAME(cpu, ic); }
+{ ARM_FLAGS_SYNC(cpu);
+  if (!(cpu->cd.arm.flags & ARM_F_V)) A__NAME(cpu, ic); }
 
 #ifndef BLAHURG
 #define BLAHURG
@@ -313,15 +347,21 @@ extern uint8_t condition_gt[16];
 #endif
 
 void A__NAME__hi(struct cpu *cpu, struct arm_instr_call *ic)
-{ if (condition_hi[cpu->cd.arm.flags]) A__NAME(cpu, ic); }
+{ ARM_FLAGS_SYNC(cpu);
+  if (condition_hi[cpu->cd.arm.flags]) A__NAME(cpu, ic); }
 void A__NAME__ls(struct cpu *cpu, struct arm_instr_call *ic)
-{ if (!condition_hi[cpu->cd.arm.flags]) A__NAME(cpu, ic); }
+{ ARM_FLAGS_SYNC(cpu);
+  if (!condition_hi[cpu->cd.arm.flags]) A__NAME(cpu, ic); }
 void A__NAME__ge(struct cpu *cpu, struct arm_instr_call *ic)
-{ if (condition_ge[cpu->cd.arm.flags]) A__NAME(cpu, ic); }
+{ ARM_FLAGS_SYNC(cpu);
+  if (condition_ge[cpu->cd.arm.flags]) A__NAME(cpu, ic); }
 void A__NAME__lt(struct cpu *cpu, struct arm_instr_call *ic)
-{ if (!condition_ge[cpu->cd.arm.flags]) A__NAME(cpu, ic); }
+{ ARM_FLAGS_SYNC(cpu);
+  if (!condition_ge[cpu->cd.arm.flags]) A__NAME(cpu, ic); }
 void A__NAME__gt(struct cpu *cpu, struct arm_instr_call *ic)
-{ if (condition_gt[cpu->cd.arm.flags]) A__NAME(cpu, ic); }
+{ ARM_FLAGS_SYNC(cpu);
+  if (condition_gt[cpu->cd.arm.flags]) A__NAME(cpu, ic); }
 void A__NAME__le(struct cpu *cpu, struct arm_instr_call *ic)
-{ if (!condition_gt[cpu->cd.arm.flags]) A__NAME(cpu, ic); }
+{ ARM_FLAGS_SYNC(cpu);
+  if (!condition_gt[cpu->cd.arm.flags]) A__NAME(cpu, ic); }
 
@@ -0,0 +1,1378 @@
+/*
+ *  Copyright (C) 2010  Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ *
+ *
+ *  ARM Thumb instructions (the 16-bit encoding of ARMv4T and ARMv5).
+ *  Included from cpu_arm_instr.cc.
+ *
+ *  Thumb code is translated into translation pages of its own, each covering
+ *  2 KB (see cpu_arm.h and arm_thumb_pc_to_pointers()). Just like for ARM
+ *  code, the pc is not updated while running within a page, so instructions
+ *  which need it call thumb_sync_pc() first.
+ *
+ *  The 32-bit BL and BLX (immediate) instructions are really two 16-bit
+ *  instructions, and the second half may be on another page than the first.
+ *  Each half is therefore translated on its own, but when both are on the
+ *  same page, the first half is translated into a single call which does the
+ *  work of both.
+ *
+ *  TODO: ARMv6 additions (cps, rev, sxth, ...), Thumb-2.
+ */
+
+
+/*  Start of the current Thumb translation page:  */
+#define	THUMB_PAGE_BASE(cpu)	((uint32_t)(cpu)->pc & \
+				~(ARM_THUMB_PAGE_SIZE - 1))
+
+
+/*
+ *  thumb_sync_pc():
+ *
+ *  Synchronize the program counter with the instruction call ic.
+ */
+static inline void thumb_sync_pc(struct cpu *cpu, struct arm_instr_call *ic)
+{
+	uint32_t low_pc = ((size_t)ic - (size_t)cpu->cd.arm.cur_ic_page)
+	    / sizeof(struct arm_instr_call);
+	cpu->pc = THUMB_PAGE_BASE(cpu) +
+	    (low_pc << ARM_THUMB_INSTR_ALIGNMENT_SHIFT);
+}
+
+
+/*
+ *  thumb_interwork():
+ *
+ *  Continue execution at cpu->pc, in Thumb mode if bit 0 is set, otherwise
+ *  in ARM mode.
+ */
+static void thumb_interwork(struct cpu *cpu)
+{
+	if (!(cpu->pc & 1)) {
+		cpu->cd.arm.cpsr &= ~ARM_FLAG_T;
+		cpu->pc &= ~3;
+	}
+
+	arm_pc_to_pointers(cpu);
+}
+
+
+/*
+ *  thumb_set_nz(), thumb_set_nzc():
+ *
+ *  Most Thumb data processing instructions set the flags. These two set N
+ *  and Z (and C) from a result, leaving the other flags unmodified.
+ */
+static inline void thumb_set_nz(struct cpu *cpu, uint32_t x)
+{
+	ARM_FLAGS_SYNC(cpu);
+	cpu->cd.arm.flags &= ~(ARM_F_N | ARM_F_Z);
+	if (x == 0)
+		cpu->cd.arm.flags |= ARM_F_Z;
+	if (x & 0x80000000)
+		cpu->cd.arm.flags |= ARM_F_N;
+}
+static inline void thumb_set_nzc(struct cpu *cpu, uint32_t x, int c)
+{
+	ARM_FLAGS_SYNC(cpu);
+	cpu->cd.arm.flags &= ARM_F_V;
+	if (x == 0)
+		cpu->cd.arm.flags |= ARM_F_Z;
+	if (x & 0x80000000)
+		cpu->cd.arm.flags |= ARM_F_N;
+	if (c)
+		cpu->cd.arm.flags |= ARM_F_C;
+}
+
+
+/*
+ *  thumb_lsl(), thumb_lsr(), thumb_asr(), thumb_ror():
+ *
+ *  Shift x by s (0..255) bits, and set the flags. A shift by 0 leaves C
+ *  unmodified.
+ */
+static inline uint32_t thumb_lsl(struct cpu *cpu, uint32_t x, int s)
+{
+	int c;
+	if (s == 0) {
+		thumb_set_nz(cpu, x);
+		return x;
+	}
+	if (s < 32) {
+		c = (x >> (32 - s)) & 1;
+		x <<= s;
+	} else {
+		c = s == 32? x & 1 : 0;
+		x = 0;
+	}
+	thumb_set_nzc(cpu, x, c);
+	return x;
+}
+static inline uint32_t thumb_lsr(struct cpu *cpu, uint32_t x, int s)
+{
+	int c;
+	if (s == 0) {
+		thumb_set_nz(cpu, x);
+		return x;
+	}
+	if (s < 32) {
+		c = (x >> (s - 1)) & 1;
+		x >>= s;
+	} else {
+		c = s == 32? x >> 31 : 0;
+		x = 0;
+	}
+	thumb_set_nzc(cpu, x, c);
+	return x;
+}
+static inline uint32_t thumb_asr(struct cpu *cpu, uint32_t x, int s)
+{
+	int c;
+	if (s == 0) {
+		thumb_set_nz(cpu, x);
+		return x;
+	}
+	if (s < 32) {
+		c = (x >> (s - 1)) & 1;
+		x = (int32_t)x >> s;
+	} else {
+		c = x >> 31;
+		x = c? 0xffffffff : 0;
+	}
+	thumb_set_nzc(cpu, x, c);
+	return x;
+}
+static inline uint32_t thumb_ror(struct cpu *cpu, uint32_t x, int s)
+{
+	if (s == 0) {
+		thumb_set_nz(cpu, x);
+		return x;
+	}
+	s &= 31;
+	if (s != 0)
+		x = (x >> s) | (x << (32 - s));
+	thumb_set_nzc(cpu, x, x >> 31);
+	return x;
+}
+
+
+/*
+ *  thumb_load(), thumb_store():
+ *
+ *  Load or store len (1, 2, or 4) bytes of little-endian data. Aligned
+ *  accesses to pages in the host translation arrays are done directly,
+ *  everything else goes through memory_rw(). Returns 0 if there was an
+ *  exception.
+ */
+static inline int thumb_load(struct cpu *cpu, struct arm_instr_call *ic,
+	uint32_t addr, int len, uint32_t *valuep)
+{
+	unsigned char *page = cpu->cd.arm.host_load[addr >> 12];
+	unsigned char data[4];
+	int i;
+
+	if (page != NULL && !(addr & (len - 1))) {
+		page += (addr & 0xfff);
+		switch (len) {
+		case 1:	*valuep = page[0];
+			break;
+		case 2:	*valuep = page[0] + (page[1] << 8);
+			break;
+		default:
+#ifdef HOST_LITTLE_ENDIAN
+			*valuep = *(uint32_t *)page;
+#else
+			*valuep = page[0] + (page[1] << 8) +
+			    (page[2] << 16) + (page[3] << 24);
+#endif
+		}
+		return 1;
+	}
+
+	thumb_sync_pc(cpu, ic);
+	if (!cpu->memory_rw(cpu, cpu->mem, addr, data, len, MEM_READ,
+	    CACHE_DATA)) {
+		/*  load failed, an exception was generated  */
+		return 0;
+	}
+
+	*valuep = 0;
+	for (i=len-1; i>=0; i--)
+		*valuep = (*valuep << 8) + data[i];
+	return 1;
+}
+static inline int thumb_store(struct cpu *cpu, struct arm_instr_call *ic,
+	uint32_t addr, int len, uint32_t value)
+{
+	unsigned char *page = cpu->cd.arm.host_store[addr >> 12];
+	unsigned char data[4];
+	int i;
+
+	if (page != NULL && !(addr & (len - 1))) {
+		page += (addr & 0xfff);
+		switch (len) {
+		case 1:	page[0] = value;
+			break;
+		case 2:	page[0] = value;
+			page[1] = value >> 8;
+			break;
+		default:
+#ifdef HOST_LITTLE_ENDIAN
+			*(uint32_t *)page = value;
+#else
+			page[0] = value;
+			page[1] = value >> 8;
+			page[2] = value >> 16;
+			page[3] = value >> 24;
+#endif
+		}
+		return 1;
+	}
+
+	for (i=0; i<len; i++)
+		data[i] = value >> (8 * i);
+
+	thumb_sync_pc(cpu, ic);
+	return cpu->memory_rw(cpu, cpu->mem, addr, data, len, MEM_WRITE,
+	    CACHE_DATA);
+}
+
+
+/*****************************************************************************/
+
+
+/*
+ *  thumb_lsl_imm, thumb_lsr_imm, thumb_asr_imm:  Shift by immediate
+ *
+ *  arg[0] = ptr to rd
+ *  arg[1] = ptr to rm
+ *  arg[2] = shift amount (1..32)
+ */
+X(thumb_lsl_imm)
+{
+	reg(ic->arg[0]) = thumb_lsl(cpu, reg(ic->arg[1]), ic->arg[2]);
+}
+X(thumb_lsr_imm)
+{
+	reg(ic->arg[0]) = thumb_lsr(cpu, reg(ic->arg[1]), ic->arg[2]);
+}
+X(thumb_asr_imm)
+{
+	reg(ic->arg[0]) = thumb_asr(cpu, reg(ic->arg[1]), ic->arg[2]);
+}
+
+
+/*
+ *  thumb_movs:  Move register, setting N and Z  (lsl rd,rm,#0)
+ *
+ *  arg[0] = ptr to rd
+ *  arg[1] = ptr to rm
+ */
+X(thumb_movs)
+{
+	uint32_t x = reg(ic->arg[1]);
+	reg(ic->arg[0]) = x;
+	thumb_set_nz(cpu, x);
+}
+
+
+/*
+ *  thumb_movs_imm:  Move immediate, setting N and Z
+ *
+ *  arg[0] = ptr to rd
+ *  arg[1] = 8-bit immediate
+ */
+X(thumb_movs_imm)
+{
+	reg(ic->arg[0]) = ic->arg[1];
+	thumb_set_nz(cpu, ic->arg[1]);
+}
+
+
+/*
+ *  thumb_adds, thumb_subs:  rd = rn + rm, rd = rn - rm
+ *  thumb_adds_imm, thumb_subs_imm:  rd = rn + imm, rd = rn - imm
+ *
+ *  arg[0] = ptr to rd
+ *  arg[1] = ptr to rn
+ *  arg[2] = ptr to rm, or immediate value
+ */
+X(thumb_adds)
+{
+	uint32_t a = reg(ic->arg[1]), b = reg(ic->arg[2]);
+	reg(ic->arg[0]) = a + b;
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_ADD, a, b);
+}
+X(thumb_subs)
+{
+	uint32_t a = reg(ic->arg[1]), b = reg(ic->arg[2]);
+	reg(ic->arg[0]) = a - b;
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_SUB, a, b);
+}
+X(thumb_adds_imm)
+{
+	uint32_t a = reg(ic->arg[1]), b = ic->arg[2];
+	reg(ic->arg[0]) = a + b;
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_ADD, a, b);
+}
+X(thumb_subs_imm)
+{
+	uint32_t a = reg(ic->arg[1]), b = ic->arg[2];
+	reg(ic->arg[0]) = a - b;
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_SUB, a, b);
+}
+
+
+/*
+ *  thumb_cmp_imm:  Compare with immediate
+ *
+ *  arg[0] = ptr to rn
+ *  arg[1] = 8-bit immediate
+ */
+X(thumb_cmp_imm)
+{
+	uint32_t a = reg(ic->arg[0]), b = ic->arg[1];
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_SUB, a, b);
+}
+
+
+/*
+ *  thumb_add_imm:  rd = rn + imm, without setting any flags
+ *
+ *  arg[0] = ptr to rd
+ *  arg[1] = ptr to rn (usually sp)
+ *  arg[2] = 32-bit immediate value
+ */
+X(thumb_add_imm)
+{
+	reg(ic->arg[0]) = reg(ic->arg[1]) + (uint32_t)ic->arg[2];
+}
+
+
+/*
+ *  ALU operations:  rd = rd OP rm, setting the flags
+ *
+ *  arg[0] = ptr to rd (rn for tst, cmp, and cmn)
+ *  arg[1] = ptr to rm (rs for the shifts)
+ */
+X(thumb_and)
+{
+	uint32_t x = reg(ic->arg[0]) & reg(ic->arg[1]);
+	reg(ic->arg[0]) = x;
+	thumb_set_nz(cpu, x);
+}
+X(thumb_eor)
+{
+	uint32_t x = reg(ic->arg[0]) ^ reg(ic->arg[1]);
+	reg(ic->arg[0]) = x;
+	thumb_set_nz(cpu, x);
+}
+X(thumb_lsl)
+{
+	reg(ic->arg[0]) = thumb_lsl(cpu, reg(ic->arg[0]),
+	    reg(ic->arg[1]) & 255);
+}
+X(thumb_lsr)
+{
+	reg(ic->arg[0]) = thumb_lsr(cpu, reg(ic->arg[0]),
+	    reg(ic->arg[1]) & 255);
+}
+X(thumb_asr)
+{
+	reg(ic->arg[0]) = thumb_asr(cpu, reg(ic->arg[0]),
+	    reg(ic->arg[1]) & 255);
+}
+X(thumb_adc)
+{
+	uint32_t a = reg(ic->arg[0]), b = reg(ic->arg[1]), x, f = 0;
+	uint64_t c64;
+
+	ARM_FLAGS_SYNC(cpu);
+	c64 = (uint64_t)a + b + (cpu->cd.arm.flags & ARM_F_C? 1 : 0);
+	x = reg(ic->arg[0]) = c64;
+
+	if (x == 0)
+		f |= ARM_F_Z;
+	if (x & 0x80000000)
+		f |= ARM_F_N;
+	if (c64 >> 32)
+		f |= ARM_F_C;
+	if ((~(a ^ b) & (a ^ x)) & 0x80000000)
+		f |= ARM_F_V;
+	ARM_FLAGS_SET(cpu, f);
+}
+X(thumb_sbc)
+{
+	uint32_t a = reg(ic->arg[0]), b = reg(ic->arg[1]), x, f = 0;
+	uint64_t borrow;
+
+	ARM_FLAGS_SYNC(cpu);
+	borrow = cpu->cd.arm.flags & ARM_F_C? 0 : 1;
+	x = reg(ic->arg[0]) = a - b - borrow;
+
+	if (x == 0)
+		f |= ARM_F_Z;
+	if (x & 0x80000000)
+		f |= ARM_F_N;
+	if ((uint64_t)a >= (uint64_t)b + borrow)
+		f |= ARM_F_C;
+	if (((a ^ b) & (a ^ x)) & 0x80000000)
+		f |= ARM_F_V;
+	ARM_FLAGS_SET(cpu, f);
+}
+X(thumb_ror)
+{
+	reg(ic->arg[0]) = thumb_ror(cpu, reg(ic->arg[0]),
+	    reg(ic->arg[1]) & 255);
+}
+X(thumb_tst)
+{
+	thumb_set_nz(cpu, reg(ic->arg[0]) & reg(ic->arg[1]));
+}
+X(thumb_neg)
+{
+	uint32_t b = reg(ic->arg[1]);
+	reg(ic->arg[0]) = 0 - b;
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_SUB, 0, b);
+}
+X(thumb_cmp)
+{
+	uint32_t a = reg(ic->arg[0]), b = reg(ic->arg[1]);
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_SUB, a, b);
+}
+X(thumb_cmn)
+{
+	uint32_t a = reg(ic->arg[0]), b = reg(ic->arg[1]);
+	ARM_FLAGS_LAZY(cpu, ARM_FLAGS_LAZY_ADD, a, b);
+}
+X(thumb_orr)
+{
+	uint32_t x = reg(ic->arg[0]) | reg(ic->arg[1]);
+	reg(ic->arg[0]) = x;
+	thumb_set_nz(cpu, x);
+}
+X(thumb_mul)
+{
+	uint32_t x = reg(ic->arg[0]) * reg(ic->arg[1]);
+	reg(ic->arg[0]) = x;
+	thumb_set_nz(cpu, x);
+}
+X(thumb_bic)
+{
+	uint32_t x = reg(ic->arg[0]) & ~reg(ic->arg[1]);
+	reg(ic->arg[0]) = x;
+	thumb_set_nz(cpu, x);
+}
+X(thumb_mvn)
+{
+	uint32_t x = ~reg(ic->arg[1]);
+	reg(ic->arg[0]) = x;
+	thumb_set_nz(cpu, x);
+}
+
+static void (*thumb_alu_instr[16])(struct cpu *, struct arm_instr_call *) = {
+	arm_instr_thumb_and, arm_instr_thumb_eor, arm_instr_thumb_lsl,
+	arm_instr_thumb_lsr, arm_instr_thumb_asr, arm_instr_thumb_adc,
+	arm_instr_thumb_sbc, arm_instr_thumb_ror, arm_instr_thumb_tst,
+	arm_instr_thumb_neg, arm_instr_thumb_cmp, arm_instr_thumb_cmn,
+	arm_instr_thumb_orr, arm_instr_thumb_mul, arm_instr_thumb_bic,
+	arm_instr_thumb_mvn };
+
+
+/*
+ *  thumb_add_hi, thumb_mov_hi:  Hi register add and mov (no flags)
+ *
+ *  arg[0] = ptr to rd
+ *  arg[1] = ptr to rm
+ */
+X(thumb_add_hi)
+{
+	reg(ic->arg[0]) += reg(ic->arg[1]);
+}
+X(thumb_mov_hi)
+{
+	reg(ic->arg[0]) = reg(ic->arg[1]);
+}
+
+
+/*
+ *  thumb_add_pcrel:  rd = rd + pc-relative value
+ *  thumb_mov_pcrel:  rd = pc-relative value  (mov rd,pc and adr)
+ *
+ *  arg[0] = ptr to rd
+ *  arg[1] = offset from the start of the Thumb page
+ */
+X(thumb_add_pcrel)
+{
+	reg(ic->arg[0]) += THUMB_PAGE_BASE(cpu) + ic->arg[1];
+}
+X(thumb_mov_pcrel)
+{
+	reg(ic->arg[0]) = THUMB_PAGE_BASE(cpu) + ic->arg[1];
+}
+
+
+/*
+ *  thumb_mov_imm:  rd = imm  (no flags; used for pc-relative loads of
+ *                             constants on the same page)
+ *
+ *  arg[0] = ptr to rd
+ *  arg[1] = 32-bit value
+ */
+X(thumb_mov_imm)
+{
+	reg(ic->arg[0]) = ic->arg[1];
+}
+
+
+/*****************************************************************************/
+
+
+/*
+ *  Loads and stores, register offset:  [rn,rm]
+ *
+ *  arg[0] = ptr to rd
+ *  arg[1] = ptr to rn
+ *  arg[2] = ptr to rm
+ *
+ *  and immediate offset:  [rn,#imm]  (also sp-relative)
+ *
+ *  arg[0] = ptr to rd
+ *  arg[1] = ptr to rn
+ *  arg[2] = offset
+ */
+#define	THUMB_LOAD(n, offset, len, type)				\
+	X(n) {								\
+		uint32_t value;						\
+		if (thumb_load(cpu, ic, reg(ic->arg[1]) + (offset),	\
+		    len, &value))					\
+			reg(ic->arg[0]) = (type) value;			\
+	}
+#define	THUMB_STORE(n, offset, len)					\
+	X(n) {								\
+		thumb_store(cpu, ic, reg(ic->arg[1]) + (offset), len,	\
+		    reg(ic->arg[0]));					\
+	}
+
+THUMB_LOAD(thumb_ldr, reg(ic->arg[2]), 4, uint32_t)
+THUMB_LOAD(thumb_ldrh, reg(ic->arg[2]), 2, uint32_t)
+THUMB_LOAD(thumb_ldrb, reg(ic->arg[2]), 1, uint32_t)
+THUMB_LOAD(thumb_ldrsh, reg(ic->arg[2]), 2, int16_t)
+THUMB_LOAD(thumb_ldrsb, reg(ic->arg[2]), 1, int8_t)
+THUMB_STORE(thumb_str, reg(ic->arg[2]), 4)
+THUMB_STORE(thumb_strh, reg(ic->arg[2]), 2)
+THUMB_STORE(thumb_strb, reg(ic->arg[2]), 1)
+
+THUMB_LOAD(thumb_ldr_imm, ic->arg[2], 4, uint32_t)
+THUMB_LOAD(thumb_ldrh_imm, ic->arg[2], 2, uint32_t)
+THUMB_LOAD(thumb_ldrb_imm, ic->arg[2], 1, uint32_t)
+THUMB_STORE(thumb_str_imm, ic->arg[2], 4)
+THUMB_STORE(thumb_strh_imm, ic->arg[2], 2)
+THUMB_STORE(thumb_strb_imm, ic->arg[2], 1)
+
+/*  Indexed by bits 11..9 of the instruction word:  */
+static void (*thumb_ls_reg_instr[8])(struct cpu *, struct arm_instr_call *) = {
+	arm_instr_thumb_str, arm_instr_thumb_strh, arm_instr_thumb_strb,
+	arm_instr_thumb_ldrsb, arm_instr_thumb_ldr, arm_instr_thumb_ldrh,
+	arm_instr_thumb_ldrb, arm_instr_thumb_ldrsh };
+
+
+/*
+ *  thumb_ldr_pcrel:  Load from a pc-relative address on another page.
+ *
+ *  arg[0] = ptr to rd
+ *  arg[1] = offset from the start of the Thumb page
+ */
+X(thumb_ldr_pcrel)
+{
+	uint32_t value;
+	if (thumb_load(cpu, ic, THUMB_PAGE_BASE(cpu) + ic->arg[1], 4, &value))
+		reg(ic->arg[0]) = value;
+}
+
+
+/*
+ *  thumb_ldmia:  Load multiple (also pop)
+ *
+ *  arg[0] = ptr to rn
+ *  arg[1] = register list (bit 15 = pc)
+ *  arg[2] = 1 if rn should be updated
+ *
+ *  Loading the pc is a return, possibly to ARM mode (ARMv5 semantics).
+ */
+X(thumb_ldmia)
+{
+	uint32_t addr = reg(ic->arg[0]), list = ic->arg[1], value[9];
+	int i, n = 0;
+
+	for (i=0; i<16; i++)
+		if (list & (1 << i)) {
+			if (!thumb_load(cpu, ic, addr + n * 4, 4, &value[n]))
+				return;
+			n ++;
+		}
+
+	if (ic->arg[2])
+		reg(ic->arg[0]) = addr + n * 4;
+
+	n = 0;
+	for (i=0; i<8; i++)
+		if (list & (1 << i))
+			cpu->cd.arm.r[i] = value[n++];
+
+	if (list & 0x8000) {
+		cpu->pc = value[n];
+		if (cpu->machine->show_trace_tree)
+			cpu_functioncall_trace_return(cpu);
+		thumb_interwork(cpu);
+	}
+}
+
+
+/*
+ *  thumb_stmia:  Store multiple, ascending from rn, with writeback
+ *  thumb_push:  Store multiple, descending from sp, with writeback
+ *
+ *  arg[0] = ptr to rn (sp for push)
+ *  arg[1] = register list (bit 14 = lr)
+ *  arg[2] = number of bytes to store
+ */
+static int thumb_store_multiple(struct cpu *cpu, struct arm_instr_call *ic,
+	uint32_t addr)
+{
+	uint32_t list = ic->arg[1];
+	int i;
+
+	for (i=0; i<15; i++)
+		if (list & (1 << i)) {
+			if (!thumb_store(cpu, ic, addr, 4, cpu->cd.arm.r[i]))
+				return 0;
+			addr += 4;
+		}
+
+	return 1;
+}
+X(thumb_stmia)
+{
+	uint32_t addr = reg(ic->arg[0]);
+	if (thumb_store_multiple(cpu, ic, addr))
+		reg(ic->arg[0]) = addr + ic->arg[2];
+}
+X(thumb_push)
+{
+	uint32_t addr = reg(ic->arg[0]) - ic->arg[2];
+	if (thumb_store_multiple(cpu, ic, addr))
+		reg(ic->arg[0]) = addr;
+}
+
+
+/*****************************************************************************/
+
+
+/*
+ *  thumb_b:  Branch (to a different translated page)
+ *
+ *  arg[0] = offset from the start of the Thumb page
+ */
+X(thumb_b)
+{
+	cpu->pc = THUMB_PAGE_BASE(cpu) + (int32_t)ic->arg[0];
+	arm_thumb_pc_to_pointers(cpu);
+}
+Y(thumb_b)
+
+
+/*
+ *  thumb_b_samepage:  Branch (to within the same translated page)
+ *
+ *  arg[0] = pointer to new arm_instr_call
+ */
+X(thumb_b_samepage)
+{
+	cpu->cd.arm.next_ic = (struct arm_instr_call *) ic->arg[0];
+}
+Y(thumb_b_samepage)
+
+
+/*
+ *  thumb_bx:  Branch, and exchange to ARM mode unless bit 0 is set
+ *
+ *  arg[0] = ptr to rm
+ */
+X(thumb_bx)
+{
+	cpu->pc = reg(ic->arg[0]);
+	if (cpu->machine->show_trace_tree &&
+	    ic->arg[0] == (size_t)&cpu->cd.arm.r[ARM_LR])
+		cpu_functioncall_trace_return(cpu);
+	thumb_interwork(cpu);
+}
+
+
+/*
+ *  thumb_bx_pcrel:  bx pc  (Switch to ARM mode.)
+ *
+ *  arg[1] = offset from the start of the Thumb page
+ */
+X(thumb_bx_pcrel)
+{
+	cpu->pc = THUMB_PAGE_BASE(cpu) + ic->arg[1];
+	thumb_interwork(cpu);
+}
+
+
+/*
+ *  thumb_blx:  Branch and link, and exchange to ARM mode unless bit 0 is set
+ *
+ *  arg[0] = ptr to rm
+ *  arg[1] = offset of the following instruction, from the start of the page
+ */
+X(thumb_blx)
+{
+	uint32_t rm = reg(ic->arg[0]);
+	cpu->cd.arm.r[ARM_LR] = (THUMB_PAGE_BASE(cpu) + ic->arg[1]) | 1;
+	cpu->pc = rm;
+	if (cpu->machine->show_trace_tree)
+		cpu_functioncall_trace(cpu, cpu->pc & ~1);
+	thumb_interwork(cpu);
+}
+
+
+/*
+ *  thumb_mov_pc:  mov pc,rm  (stays in Thumb mode)
+ *
+ *  arg[0] = ptr to rm
+ */
+X(thumb_mov_pc)
+{
+	cpu->pc = reg(ic->arg[0]) & ~1;
+	if (cpu->machine->show_trace_tree &&
+	    ic->arg[0] == (size_t)&cpu->cd.arm.r[ARM_LR])
+		cpu_functioncall_trace_return(cpu);
+	arm_thumb_pc_to_pointers(cpu);
+}
+
+
+/*
+ *  thumb_add_pc:  add pc,rm  (stays in Thumb mode)
+ *
+ *  arg[0] = ptr to rm
+ *  arg[1] = offset from the start of the Thumb page (instruction + 4)
+ */
+X(thumb_add_pc)
+{
+	cpu->pc = (THUMB_PAGE_BASE(cpu) + ic->arg[1] + reg(ic->arg[0])) & ~1;
+	arm_thumb_pc_to_pointers(cpu);
+}
+
+
+/*
+ *  thumb_bl_prefix:  First half of BL or BLX, on its own.
+ *
+ *  arg[0] = value for lr, relative to the start of the Thumb page
+ */
+X(thumb_bl_prefix)
+{
+	cpu->cd.arm.r[ARM_LR] = THUMB_PAGE_BASE(cpu) + (int32_t)ic->arg[0];
+}
+
+
+/*
+ *  thumb_bl_suffix, thumb_blx_suffix:  Second half of BL or BLX, on its own.
+ *
+ *  arg[0] = offset from lr
+ *  arg[1] = offset of the following instruction, from the start of the page
+ */
+X(thumb_bl_suffix)
+{
+	uint32_t lr = cpu->cd.arm.r[ARM_LR];
+	cpu->cd.arm.r[ARM_LR] = (THUMB_PAGE_BASE(cpu) + ic->arg[1]) | 1;
+	cpu->pc = lr + ic->arg[0];
+	if (cpu->machine->show_trace_tree)
+		cpu_functioncall_trace(cpu, cpu->pc);
+	arm_thumb_pc_to_pointers(cpu);
+}
+X(thumb_blx_suffix)
+{
+	uint32_t lr = cpu->cd.arm.r[ARM_LR];
+	cpu->cd.arm.r[ARM_LR] = (THUMB_PAGE_BASE(cpu) + ic->arg[1]) | 1;
+	cpu->pc = (lr + ic->arg[0]) & ~3;
+	if (cpu->machine->show_trace_tree)
+		cpu_functioncall_trace(cpu, cpu->pc);
+	thumb_interwork(cpu);
+}
+
+
+/*
+ *  thumb_bl, thumb_blx_imm:  Both halves of BL or BLX (immediate).
+ *
+ *  arg[0] = branch target, relative to the start of the Thumb page
+ *  arg[1] = offset of the following instruction, from the start of the page
+ */
+X(thumb_bl)
+{
+	uint32_t base = THUMB_PAGE_BASE(cpu);
+	cpu->cd.arm.r[ARM_LR] = (base + ic->arg[1]) | 1;
+	cpu->pc = base + (int32_t)ic->arg[0];
+	cpu->n_translated_instrs ++;
+	if (cpu->machine->show_trace_tree)
+		cpu_functioncall_trace(cpu, cpu->pc);
+	arm_thumb_pc_to_pointers(cpu);
+}
+X(thumb_blx_imm)
+{
+	uint32_t base = THUMB_PAGE_BASE(cpu);
+	cpu->cd.arm.r[ARM_LR] = (base + ic->arg[1]) | 1;
+	cpu->pc = (base + (int32_t)ic->arg[0]) & ~3;
+	cpu->n_translated_instrs ++;
+	if (cpu->machine->show_trace_tree)
+		cpu_functioncall_trace(cpu, cpu->pc);
+	thumb_interwork(cpu);
+}
+
+
+/*
+ *  thumb_bl_samepage:  Both halves of BL, to within the same page.
+ *
+ *  arg[0] = pointer to new arm_instr_call
+ *  arg[1] = offset of the following instruction, from the start of the page
+ */
+X(thumb_bl_samepage)
+{
+	cpu->cd.arm.r[ARM_LR] = (THUMB_PAGE_BASE(cpu) + ic->arg[1]) | 1;
+	cpu->cd.arm.next_ic = (struct arm_instr_call *) ic->arg[0];
+	cpu->n_translated_instrs ++;
+}
+
+
+/*
+ *  thumb_swi, thumb_und, thumb_bkpt:  Software interrupt, undefined
+ *                                     instruction, and breakpoint.
+ */
+X(thumb_swi)
+{
+	thumb_sync_pc(cpu, ic);
+	arm_exception(cpu, ARM_EXCEPTION_SWI);
+}
+X(thumb_und)
+{
+	thumb_sync_pc(cpu, ic);
+	arm_exception(cpu, ARM_EXCEPTION_UND);
+}
+X(thumb_bkpt)
+{
+	thumb_sync_pc(cpu, ic);
+	arm_exception(cpu, ARM_EXCEPTION_PREF_ABT);
+}
+
+
+/*****************************************************************************/
+
+
+X(thumb_end_of_page)
+{
+	/*  Update the PC:  (offset 0, but on the next page)  */
+	cpu->pc = THUMB_PAGE_BASE(cpu) + ARM_THUMB_PAGE_SIZE;
+
+	/*  Find the new physical page and update the translation pointers:  */
+	arm_thumb_pc_to_pointers(cpu);
+
+	/*  end_of_page doesn't count as an executed instruction:  */
+	cpu->n_translated_instrs --;
+}
+
+
+/*
+ *  arm_instr_thumb_to_be_translated():
+ *
+ *  Translate a 16-bit Thumb instruction into an arm_instr_call, and then
+ *  execute it. This is the Thumb counterpart of to_be_translated, below.
+ */
+X(thumb_to_be_translated)
+{
+	uint32_t addr, low_pc, iword, iword2 = 0, imm, list;
+	unsigned char *page;
+	unsigned char ib[4];
+	int condition_code, op, rd, rm, rn, i, n;
+	int32_t target;
+
+	/*  Figure out the address of the instruction:  */
+	low_pc = ((size_t)ic - (size_t)cpu->cd.arm.cur_ic_page)
+	    / sizeof(struct arm_instr_call);
+	addr = THUMB_PAGE_BASE(cpu) +
+	    (low_pc << ARM_THUMB_INSTR_ALIGNMENT_SHIFT);
+	cpu->pc = addr;
+
+	/*  Read the instruction (and the next one, if it is on the same
+	    Thumb page, for BL):  */
+	memset(ib, 0, sizeof(ib));
+	page = cpu->cd.arm.host_load[addr >> 12];
+
+	if (page != NULL) {
+		memcpy(ib, page + (addr & 0xfff),
+		    low_pc < ARM_IC_ENTRIES_PER_PAGE - 1? 4 : 2);
+	} else {
+		if (!cpu->memory_rw(cpu, cpu->mem, addr, &ib[0],
+		    sizeof(uint16_t), MEM_READ, CACHE_INSTRUCTION)) {
+			fatal("thumb_to_be_translated(): "
+			    "read failed: TODO\n");
+			return;
+		}
+	}
+
+	if (cpu->byte_order == EMUL_LITTLE_ENDIAN) {
+		iword = ib[0] + (ib[1]<<8);
+		iword2 = ib[2] + (ib[3]<<8);
+	} else {
+		iword = ib[1] + (ib[0]<<8);
+		iword2 = ib[3] + (ib[2]<<8);
+	}
+
+
+#define DYNTRANS_TO_BE_TRANSLATED_HEAD
+#include "cpu_dyntrans.cc"
+#undef  DYNTRANS_TO_BE_TRANSLATED_HEAD
+
+
+	op = iword >> 11;
+	rd = iword & 7;
+	rn = rm = (iword >> 3) & 7;
+
+	/*
+	 *  Translate the instruction:
+	 */
+
+	switch (op) {
+
+	case 0x00:
+	case 0x01:
+	case 0x02:
+		/*  lsl, lsr, asr rd,rm,#imm  */
+		imm = (iword >> 6) & 31;
+		ic->arg[0] = (size_t)(&cpu->cd.arm.r[rd]);
+		ic->arg[1] = (size_t)(&cpu->cd.arm.r[rm]);
+		ic->arg[2] = imm == 0? 32 : imm;
+		switch (op) {
+		case 0:	ic->f = imm == 0? instr(thumb_movs) :
+			    instr(thumb_lsl_imm);
+			break;
+		case 1:	ic->f = instr(thumb_lsr_imm);
+			break;
+		case 2:	ic->f = instr(thumb_asr_imm);
+			break;
+		}
+		break;
+
+	case 0x03:
+		/*  add, sub rd,rn,rm  or  add, sub rd,rn,#imm  */
+		imm = (iword >> 6) & 7;
+		ic->arg[0] = (size_t)(&cpu->cd.arm.r[rd]);
+		ic->arg[1] = (size_t)(&cpu->cd.arm.r[rn]);
+		if (iword & 0x400) {
+			ic->f = iword & 0x200? instr(thumb_subs_imm) :
+			    instr(thumb_adds_imm);
+			ic->arg[2] = imm;
+		} else {
+			ic->f = iword & 0x200? instr(thumb_subs) :
+			    instr(thumb_adds);
+			ic->arg[2] = (size_t)(&cpu->cd.arm.r[imm]);
+		}
+		break;
+
+	case 0x04:
+	case 0x05:
+	case 0x06:
+	case 0x07:
+		/*  mov, cmp, add, sub rd,#imm  */
+		rd = (iword >> 8) & 7;
+		imm = iword & 255;
+		ic->arg[0] = ic->arg[1] = (size_t)(&cpu->cd.arm.r[rd]);
+		ic->arg[2] = imm;
+		switch (op) {
+		case 4:	ic->f = instr(thumb_movs_imm);
+			ic->arg[1] = imm;
+			break;
+		case 5:	ic->f = instr(thumb_cmp_imm);
+			ic->arg[1] = imm;
+			break;
+		case 6:	ic->f = instr(thumb_adds_imm);
+			break;
+		case 7:	ic->f = instr(thumb_subs_imm);
+			break;
+		}
+		break;
+
+	case 0x08:
+		if (!(iword & 0x400)) {
+			/*  ALU operations:  op rd,rm  */
+			ic->f = thumb_alu_instr[(iword >> 6) & 15];
+			ic->arg[0] = (size_t)(&cpu->cd.arm.r[rd]);
+			ic->arg[1] = (size_t)(&cpu->cd.arm.r[rm]);
+			break;
+		}
+
+		/*  Hi register operations, and bx/blx:  */
+		rd = (iword & 7) | ((iword >> 4) & 8);
+		rm = (iword >> 3) & 15;
+		ic->arg[0] = (size_t)(&cpu->cd.arm.r[rd]);
+		ic->arg[1] = (size_t)(&cpu->cd.arm.r[rm]);
+
+		switch ((iword >> 8) & 3) {
+		case 0:	/*  add rd,rm  */
+			if (rd == ARM_PC) {
+				if (rm == ARM_PC)
+					goto bad;
+				ic->f = instr(thumb_add_pc);
+				ic->arg[0] = (size_t)(&cpu->cd.arm.r[rm]);
+				ic->arg[1] = (low_pc << 1) + 4;
+			} else if (rm == ARM_PC) {
+				ic->f = instr(thumb_add_pcrel);
+				ic->arg[1] = (low_pc << 1) + 4;
+			} else
+				ic->f = instr(thumb_add_hi);
+			break;
+		case 1:	/*  cmp rn,rm  */
+			if (rd == ARM_PC || rm == ARM_PC)
+				goto bad;
+			ic->f = instr(thumb_cmp);
+			break;
+		case 2:	/*  mov rd,rm  */
+			if (rd == ARM_PC) {
+				if (rm == ARM_PC)
+					goto bad;
+				ic->f = instr(thumb_mov_pc);
+				ic->arg[0] = (size_t)(&cpu->cd.arm.r[rm]);
+			} else if (rm == ARM_PC) {
+				ic->f = instr(thumb_mov_pcrel);
+				ic->arg[1] = (low_pc << 1) + 4;
+			} else if (rd == rm)
+				ic->f = instr(nop);
+			else
+				ic->f = instr(thumb_mov_hi);
+			break;
+		case 3:	/*  bx rm  or  blx rm  */
+			ic->arg[0] = (size_t)(&cpu->cd.arm.r[rm]);
+			if (iword & 0x80) {
+				if (rm == ARM_PC)
+					goto bad;
+				ic->f = instr(thumb_blx);
+				ic->arg[1] = (low_pc << 1) + 2;
+			} else if (rm == ARM_PC) {
+				ic->f = instr(thumb_bx_pcrel);
+				ic->arg[1] = (low_pc << 1) + 4;
+			} else
+				ic->f = instr(thumb_bx);
+			break;
+		}
+
+		/*  Abort read-ahead on unconditional branches:  */
+		if ((ic->f == instr(thumb_bx) || ic->f == instr(thumb_bx_pcrel)
+		    || ic->f == instr(thumb_mov_pc)) &&
+		    cpu->translation_readahead > 1)
+			cpu->translation_readahead = 1;
+		break;
+
+	case 0x09:
+		/*  ldr rd,[pc,#imm]  */
+		rd = (iword >> 8) & 7;
+		imm = ((((low_pc << 1) + 4) & ~3) + ((iword & 255) << 2));
+		ic->arg[0] = (size_t)(&cpu->cd.arm.r[rd]);
+
+		/*  Special case: a constant on the same page:  */
+		if (page != NULL && ((addr & ~(ARM_THUMB_PAGE_SIZE - 1)) +
+		    imm) >> 12 == addr >> 12) {
+			unsigned char *p = page + ((addr & 0xfff &
+			    ~(ARM_THUMB_PAGE_SIZE - 1)) + imm);
+			ic->f = instr(thumb_mov_imm);
+			if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
+				ic->arg[1] = p[0] + (p[1]<<8) +
+				    (p[2]<<16) + (p[3]<<24);
+			else
+				ic->arg[1] = p[3] + (p[2]<<8) +
+				    (p[1]<<16) + (p[0]<<24);
+		} else {
+			ic->f = instr(thumb_ldr_pcrel);
+			ic->arg[1] = imm;
+		}
+		break;
+
+	case 0x0a:
+	case 0x0b:
+		/*  Load/store with register offset:  op rd,[rn,rm]  */
+		ic->f = thumb_ls_reg_instr[(iword >> 9) & 7];
+		ic->arg[0] = (size_t)(&cpu->cd.arm.r[rd]);
+		ic->arg[1] = (size_t)(&cpu->cd.arm.r[rn]);
+		ic->arg[2] = (size_t)(&cpu->cd.arm.r[(iword >> 6) & 7]);
+		break;
+
+	case 0x0c:
+	case 0x0d:
+	case 0x0e:
+	case 0x0f:
+	case 0x10:
+	case 0x11:
+		/*  Load/store with immediate offset:  op rd,[rn,#imm]  */
+		imm = (iword >> 6) & 31;
+		ic->arg[0] = (size_t)(&cpu->cd.arm.r[rd]);
+		ic->arg[1] = (size_t)(&cpu->cd.arm.r[rn]);
+		switch (op) {
+		case 0x0c: ic->f = instr(thumb_str_imm);  imm <<= 2; break;
+		case 0x0d: ic->f = instr(thumb_ldr_imm);  imm <<= 2; break;
+		case 0x0e: ic->f = instr(thumb_strb_imm); break;
+		case 0x0f: ic->f = instr(thumb_ldrb_imm); break;
+		case 0x10: ic->f = instr(thumb_strh_imm); imm <<= 1; break;
+		case 0x11: ic->f = instr(thumb_ldrh_imm); imm <<= 1; break;
+		}
+		ic->arg[2] = imm;
+		break;
+
+	case 0x12:
+	case 0x13:
+		/*  str, ldr rd,[sp,#imm]  */
+		ic->f = op == 0x13? instr(thumb_ldr_imm) : instr(thumb_str_imm);
+		ic->arg[0] = (size_t)(&cpu->cd.arm.r[(iword >> 8) & 7]);
+		ic->arg[1] = (size_t)(&cpu->cd.arm.r[ARM_SP]);
+		ic->arg[2] = (iword & 255) << 2;
+		break;
+
+	case 0x14:
+		/*  add rd,pc,#imm  (adr)  */
+		ic->f = instr(thumb_mov_pcrel);
+		ic->arg[0] = (size_t)(&cpu->cd.arm.r[(iword >> 8) & 7]);
+		ic->arg[1] = (((low_pc << 1) + 4) & ~3) + ((iword & 255) << 2);
+		break;
+
+	case 0x15:
+		/*  add rd,sp,#imm  */
+		ic->f = instr(thumb_add_imm);
+		ic->arg[0] = (size_t)(&cpu->cd.arm.r[(iword >> 8) & 7]);
+		ic->arg[1] = (size_t)(&cpu->cd.arm.r[ARM_SP]);
+		ic->arg[2] = (iword & 255) << 2;
+		break;
+
+	case 0x16:
+	case 0x17:
+		if ((iword & 0xff00) == 0xb000) {
+			/*  add, sub sp,#imm  */
+			imm = (iword & 127) << 2;
+			ic->f = instr(thumb_add_imm);
+			ic->arg[0] = ic->arg[1] =
+			    (size_t)(&cpu->cd.arm.r[ARM_SP]);
+			ic->arg[2] = (uint32_t)(iword & 0x80? -imm : imm);
+		} else if ((iword & 0xf600) == 0xb400) {
+			/*  push, pop  */
+			list = iword & 255;
+			if (iword & 0x100)
+				list |= iword & 0x800? 0x8000 : 0x4000;
+			if (list == 0)
+				goto bad;
+			for (i=n=0; i<16; i++)
+				n += (list >> i) & 1;
+			ic->arg[0] = (size_t)(&cpu->cd.arm.r[ARM_SP]);
+			ic->arg[1] = list;
+			if (iword & 0x800) {
+				ic->f = instr(thumb_ldmia);
+				ic->arg[2] = 1;
+				if (list & 0x8000 &&
+				    cpu->translation_readahead > 1)
+					cpu->translation_readahead = 1;
+			} else {
+				ic->f = instr(thumb_push);
+				ic->arg[2] = n * 4;
+			}
+		} else if ((iword & 0xff00) == 0xbe00) {
+			ic->f = instr(thumb_bkpt);
+		} else {
+			if (!cpu->translation_readahead)
+				fatal("TODO: Thumb instruction 0x%04x\n",
+				    (int)iword);
+			goto bad;
+		}
+		break;
+
+	case 0x18:
+	case 0x19:
+		/*  stmia, ldmia rn!,{...}  */
+		rn = (iword >> 8) & 7;
+		list = iword & 255;
+		if (list == 0)
+			goto bad;
+		for (i=n=0; i<8; i++)
+			n += (list >> i) & 1;
+		ic->arg[0] = (size_t)(&cpu->cd.arm.r[rn]);
+		ic->arg[1] = list;
+		if (op == 0x19) {
+			ic->f = instr(thumb_ldmia);
+			ic->arg[2] = !(list & (1 << rn));
+		} else {
+			ic->f = instr(thumb_stmia);
+			ic->arg[2] = n * 4;
+		}
+		break;
+
+	case 0x1a:
+	case 0x1b:
+	case 0x1c:
+		/*  b<cond>, swi, and b  */
+		if (op == 0x1c) {
+			condition_code = 0xe;
+			target = (int32_t)(iword << 21) >> 20;
+
+			/*  Abort read-ahead on unconditional branches:  */
+			if (cpu->translation_readahead > 1)
+				cpu->translation_readahead = 1;
+		} else {
+			condition_code = (iword >> 8) & 15;
+			target = (int32_t)(int8_t)iword << 1;
+		}
+
+		if (condition_code == 0xf) {
+			ic->f = instr(thumb_swi);
+			break;
+		}
+		if (condition_code == 0xe && op != 0x1c) {
+			ic->f = instr(thumb_und);
+			break;
+		}
+
+		target += (low_pc << 1) + 4;
+		if (target >= 0 && target < ARM_THUMB_PAGE_SIZE) {
+			ic->f = cond_instr(thumb_b_samepage);
+			ic->arg[0] = (size_t)(cpu->cd.arm.cur_ic_page +
+			    (target >> 1));
+		} else {
+			ic->f = cond_instr(thumb_b);
+			ic->arg[0] = target;
+		}
+		break;
+
+	case 0x1d:
+	case 0x1f:
+		/*  Second half of BLX or BL:  */
+		if (op == 0x1d && iword & 1)
+			goto bad;
+		ic->f = op == 0x1d? instr(thumb_blx_suffix) :
+		    instr(thumb_bl_suffix);
+		ic->arg[0] = (iword & 0x7ff) << 1;
+		ic->arg[1] = (low_pc << 1) + 2;
+		break;
+
+	case 0x1e:
+		/*  First half of BL or BLX:  */
+		target = (int32_t)(iword << 21) >> 9;
+		target += (low_pc << 1) + 4;
+
+		/*  Both halves on the same page? Then do both at once:  */
+		if (low_pc < ARM_IC_ENTRIES_PER_PAGE - 1 && page != NULL &&
+		    ((iword2 >> 11) == 0x1f ||
+		    ((iword2 >> 11) == 0x1d && !(iword2 & 1)))) {
+			target += (iword2 & 0x7ff) << 1;
+			ic->arg[0] = target;
+			ic->arg[1] = (low_pc << 1) + 4;
+			if ((iword2 >> 11) == 0x1d)
+				ic->f = instr(thumb_blx_imm);
+			else if (target >= 0 && target < ARM_THUMB_PAGE_SIZE &&
+			    !cpu->machine->show_trace_tree) {
+				ic->f = instr(thumb_bl_samepage);
+				ic->arg[0] = (size_t)(cpu->cd.arm.cur_ic_page +
+				    (target >> 1));
+			} else
+				ic->f = instr(thumb_bl);
+		} else {
+			ic->f = instr(thumb_bl_prefix);
+			ic->arg[0] = target;
+		}
+		break;
+	}
+
+
+	/*
+	 *  Mark the part of the page as containing translations:
+	 */
+	cpu->cd.arm.cur_physpage = (struct arm_tc_physpage *)
+	    cpu->cd.arm.cur_ic_page;
+	cpu->cd.arm.cur_physpage->translations_bitmap |= 1 << (low_pc /
+	    (ARM_IC_ENTRIES_PER_PAGE / (8 * sizeof(cpu->cd.arm.
+	    cur_physpage->translations_bitmap))));
+
+	/*  (Except when doing read-ahead!)  */
+	if (cpu->translation_readahead)
+		return;
+
+	/*  Single-stepping: execute, but don't keep the translation:  */
+	if (single_step_breakpoint) {
+		single_step_breakpoint = 0;
+		ic->f(cpu, ic);
+		ic->f = instr(thumb_to_be_translated);
+		return;
+	}
+
+	cpu->translation_cache_traps ++;
+
+	/*  Translation read-ahead, within the same Thumb page:  */
+	if (!single_step && !cpu->machine->instruction_trace)
+		DYNTRANS_TRANSLATE_READAHEAD(cpu, cpu->cd.arm.cur_ic_page,
+		    low_pc + 1, ARM_IC_ENTRIES_PER_PAGE,
+		    instr(thumb_to_be_translated));
+
+	/*  ... and finally execute the translated instruction:  */
+	ic->f(cpu, ic);
+	return;
+
+
+bad:	/*
+	 *  Nothing was translated. (Unimplemented or illegal instruction.)
+	 */
+
+	/*  Clear the translation, in case it was "half-way" done:  */
+	ic->f = instr(thumb_to_be_translated);
+
+	if (cpu->translation_readahead)
+		return;
+
+	quiet_mode = 0;
+	fatal("thumb_to_be_translated(): TODO: unimplemented instruction");
+
+	if (cpu->machine->instruction_trace)
+		fatal(" at 0x%" PRIx32 "\n", (uint32_t)cpu->pc);
+	else {
+		fatal(":\n");
+		DISASSEMBLE(cpu, ib, 1, 0);
+	}
+
+	cpu->running = 0;
+
+	/*  Note: Single-stepping can jump here.  */
+stop_running_translated:
+
+	debugger_n_steps_left_before_interaction = 0;
+
+	ic = cpu->cd.arm.next_ic = &nothing_call;
+	cpu->cd.arm.next_ic ++;
+
+	/*  Execute the "nothing" instruction:  */
+	ic->f(cpu, ic);
+}
+
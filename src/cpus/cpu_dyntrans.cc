@@ -74,9 +74,27 @@ static void gather_statistics(struct cpu *cpu)
 			cpu->cd.DYNTRANS_ARCH.cur_physpage = (struct DYNTRANS_TC_PHYSPAGE *)
 			    cpu->cd.DYNTRANS_ARCH.cur_ic_page;
 			a = cpu->cd.DYNTRANS_ARCH.cur_physpage->physaddr;
-			a &= ~((DYNTRANS_IC_ENTRIES_PER_PAGE-1) <<
-			    DYNTRANS_INSTR_ALIGNMENT_SHIFT);
-			a += low_pc << DYNTRANS_INSTR_ALIGNMENT_SHIFT;
+#ifdef DYNTRANS_ARM
+			/*  Thumb pages have a tag (1 or 2) in the low bits:  */
+			if (a & (DYNTRANS_PAGESIZE - 1)) {
+				a = (a & ~(DYNTRANS_PAGESIZE - 1)) +
+				    ((a & 2)? ARM_THUMB_PAGE_SIZE : 0);
+				a += low_pc << ARM_THUMB_INSTR_ALIGNMENT_SHIFT;
+			} else
+#endif
+#ifdef DYNTRANS_MIPS
+			/*  So do MIPS16 pages:  */
+			if (a & (DYNTRANS_PAGESIZE - 1)) {
+				a = (a & ~(DYNTRANS_PAGESIZE - 1)) +
+				    ((a & 2)? MIPS16_PAGE_SIZE : 0);
+				a += low_pc << MIPS16_INSTR_ALIGNMENT_SHIFT;
+			} else
+#endif
+			{
+				a &= ~((DYNTRANS_IC_ENTRIES_PER_PAGE-1) <<
+				    DYNTRANS_INSTR_ALIGNMENT_SHIFT);
+				a += low_pc << DYNTRANS_INSTR_ALIGNMENT_SHIFT;
+			}
 			if (cpu->is_32bit)
 				snprintf(buf + strlen(buf), sizeof(buf),
 				    "0x%08"PRIx32, (uint32_t)a);
@@ -87,9 +105,23 @@ static void gather_statistics(struct cpu *cpu)
 		case 'v':
 			/*  Virtual program counter address:  */
 			a = cpu->pc;
-			a &= ~((DYNTRANS_IC_ENTRIES_PER_PAGE-1) <<
-			    DYNTRANS_INSTR_ALIGNMENT_SHIFT);
-			a += low_pc << DYNTRANS_INSTR_ALIGNMENT_SHIFT;
+#ifdef DYNTRANS_ARM
+			if (cpu->cd.arm.cpsr & ARM_FLAG_T) {
+				a &= ~(ARM_THUMB_PAGE_SIZE - 1);
+				a += low_pc << ARM_THUMB_INSTR_ALIGNMENT_SHIFT;
+			} else
+#endif
+#ifdef DYNTRANS_MIPS
+			if (cpu->cd.mips.mips16) {
+				a &= ~(MIPS16_PAGE_SIZE - 1);
+				a += low_pc << MIPS16_INSTR_ALIGNMENT_SHIFT;
+			} else
+#endif
+			{
+				a &= ~((DYNTRANS_IC_ENTRIES_PER_PAGE-1) <<
+				    DYNTRANS_INSTR_ALIGNMENT_SHIFT);
+				a += low_pc << DYNTRANS_INSTR_ALIGNMENT_SHIFT;
+			}
 			if (cpu->is_32bit)
 				snprintf(buf + strlen(buf), sizeof(buf),
 				    "0x%08"PRIx32, (uint32_t)a);
@@ -165,6 +197,20 @@ static void gather_statistics(struct cpu *cpu)
 
 
 #ifdef	DYNTRANS_RUN_INSTR_DEF
+/*  Lockstep check of lazily evaluated flags, see cpu_arm.h and cpu_ppc.h:  */
+#ifdef DYNTRANS_ARM
+#define	LAZY_LOCKSTEP		cpu->cd.arm.lazy_lockstep
+#define	LAZY_LOCKSTEP_CHECK	if (LAZY_LOCKSTEP) arm_lazy_lockstep_check(cpu)
+#endif
+#ifdef DYNTRANS_PPC
+#define	LAZY_LOCKSTEP		cpu->cd.ppc.lazy_lockstep
+#define	LAZY_LOCKSTEP_CHECK	if (LAZY_LOCKSTEP) ppc_lazy_lockstep_check(cpu)
+#endif
+#ifndef LAZY_LOCKSTEP_CHECK
+#define	LAZY_LOCKSTEP_CHECK	{ }
+#endif
+
+
 /*
  *  XXX_run_instr():
  *
@@ -315,8 +361,33 @@ int DYNTRANS_RUN_INSTR_DEF(struct cpu *cpu)
 
 		/*  Execute just one instruction:  */
 		I;
+		LAZY_LOCKSTEP_CHECK;
+
+#ifdef DYNTRANS_MIPS
+		/*  Don't stop in the middle of a 32-bit MIPS16 instruction:  */
+		if (cpu->cd.mips.next_ic->f == instr(mips16_skip) ||
+		    cpu->cd.mips.next_ic->f == instr32(mips16_skip)) {
+			I;
+		}
+#endif
 
 		n_instrs = 1;
+#ifdef LAZY_LOCKSTEP
+	} else if (LAZY_LOCKSTEP) {
+		/*  Compare lazily evaluated flags after each instruction:  */
+		n_instrs = 0;
+		for (;;) {
+			struct DYNTRANS_IC *ic;
+
+			I; LAZY_LOCKSTEP_CHECK;
+
+			n_instrs ++;
+
+			if (n_instrs + cpu->n_translated_instrs >=
+			    N_SAFE_DYNTRANS_LIMIT)
+				break;
+		}
+#endif
 	} else if (cpu->machine->statistics.enabled) {
 		/*  Gather statistics while executing multiple instructions:  */
 		n_instrs = 0;
@@ -372,6 +443,25 @@ int DYNTRANS_RUN_INSTR_DEF(struct cpu *cpu)
 	/*  Synchronize the program counter:  */
 	low_pc = ((size_t)cpu->cd.DYNTRANS_ARCH.next_ic - (size_t)
 	    cpu->cd.DYNTRANS_ARCH.cur_ic_page) / sizeof(struct DYNTRANS_IC);
+#ifdef DYNTRANS_ARM
+	if (cpu->cd.arm.cpsr & ARM_FLAG_T) {
+		/*  Thumb pages have 16-bit entries, and no delay slots:  */
+		if (low_pc >= 0 && low_pc <= DYNTRANS_IC_ENTRIES_PER_PAGE) {
+			cpu->pc &= ~(ARM_THUMB_PAGE_SIZE - 1);
+			cpu->pc += (low_pc << ARM_THUMB_INSTR_ALIGNMENT_SHIFT);
+		}
+	} else
+#endif
+#ifdef DYNTRANS_MIPS
+	if (cpu->cd.mips.mips16) {
+		/*  MIPS16 pages have 16-bit entries. Entry ENTRIES_PER_PAGE
+		    + 1 is the second halfword of the next page:  */
+		if (low_pc >= 0 && low_pc <= DYNTRANS_IC_ENTRIES_PER_PAGE + 1) {
+			cpu->pc &= ~(MIPS16_PAGE_SIZE - 1);
+			cpu->pc += (low_pc << MIPS16_INSTR_ALIGNMENT_SHIFT);
+		}
+	} else
+#endif
 	if (low_pc >= 0 && low_pc < DYNTRANS_IC_ENTRIES_PER_PAGE) {
 		cpu->pc &= ~((DYNTRANS_IC_ENTRIES_PER_PAGE-1) <<
 		    DYNTRANS_INSTR_ALIGNMENT_SHIFT);
@@ -391,6 +481,15 @@ int DYNTRANS_RUN_INSTR_DEF(struct cpu *cpu)
 		    DYNTRANS_INSTR_ALIGNMENT_SHIFT);
 	}
 
+#ifdef DYNTRANS_ARM
+	/*  Flags are only evaluated lazily within this function:  */
+	ARM_FLAGS_SYNC(cpu);
+#endif
+#ifdef DYNTRANS_PPC
+	/*  ... and so is CR0:  */
+	PPC_CR0_SYNC(cpu);
+#endif
+
 #ifdef DYNTRANS_MIPS
 	/*  Update the count register (on everything except EXC3K):  */
 	if (cpu->cd.mips.cpu_type.exc_model != EXC3K) {
@@ -536,20 +635,237 @@ void DYNTRANS_FUNCTION_TRACE_DEF(struct cpu *cpu, int n_args)
 
 
 
+#ifdef DYNTRANS_VPH_PADDR_INDEX_DEF
+/*
+ *  XXX_vph_paddr_link():
+ *
+ *  Mark a VPH TLB entry as valid, and add it to the reverse (physical page
+ *  to TLB entry) index. The entry's paddr_page must already be filled in.
+ */
+static void DYNTRANS_VPH_PADDR_LINK(struct cpu *cpu, int r)
+{
+	uint16_t *headp = &cpu->cd.DYNTRANS_ARCH.vph_paddr_hash[VPH_PADDR_HASH(
+	    cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].paddr_page)];
+
+	cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].valid = 1;
+	cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].paddr_next = *headp;
+	*headp = r + 1;
+}
+
+
+/*
+ *  XXX_vph_park():
+ *
+ *  Mark a valid VPH TLB entry, which has already been removed from the
+ *  fast lookup tables, as parked, i.e. kept resident for its address space
+ *  (see INVALIDATE_ASID). Parked entries are indexed on their virtual page.
+ */
+static void DYNTRANS_VPH_PARK(struct cpu *cpu, int r)
+{
+	uint16_t *headp = &cpu->cd.DYNTRANS_ARCH.vph_parked_hash[VPH_PADDR_HASH(
+	    cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].vaddr_page)];
+
+	cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].parked = 1;
+	cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].parked_next = *headp;
+	*headp = r + 1;
+	cpu->cd.DYNTRANS_ARCH.n_vph_parked ++;
+}
+
+
+/*
+ *  XXX_vph_paddr_unlink():
+ *
+ *  Mark a VPH TLB entry as invalid, and remove it from the reverse index
+ *  (and from the parked index, if it was parked). Nothing is done if the
+ *  entry is already invalid.
+ */
+static void DYNTRANS_VPH_PADDR_UNLINK(struct cpu *cpu, int r)
+{
+	uint16_t *p;
+
+	if (!cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].valid)
+		return;
+
+	if (cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].parked) {
+		p = &cpu->cd.DYNTRANS_ARCH.vph_parked_hash[VPH_PADDR_HASH(
+		    cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].vaddr_page)];
+		while (*p != 0 && *p != r + 1)
+			p = &cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[*p - 1]
+			    .parked_next;
+		if (*p != 0)
+			*p = cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].parked_next;
+
+		cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].parked = 0;
+		cpu->cd.DYNTRANS_ARCH.n_vph_parked --;
+	}
+
+	p = &cpu->cd.DYNTRANS_ARCH.vph_paddr_hash[VPH_PADDR_HASH(
+	    cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].paddr_page)];
+
+	while (*p != 0) {
+		if (*p == r + 1) {
+			*p = cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].paddr_next;
+			break;
+		}
+
+		p = &cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[*p - 1].paddr_next;
+	}
+
+	cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].valid = 0;
+}
+#endif	/*  DYNTRANS_VPH_PADDR_INDEX_DEF  */
+
+
+
 #ifdef DYNTRANS_TC_ALLOCATE_DEFAULT_PAGE_DEF
+/*
+ *  XXX_tc_unmap_page():
+ *
+ *  Remove all virtual page => physpage pointers to a specific physpage.
+ *  The next time one of those virtual pages is executed, the physpage is
+ *  found via the slow path in XXX_pc_to_pointers_generic() again.
+ */
+static void DYNTRANS_TC_UNMAP_PAGE(struct cpu *cpu,
+	struct DYNTRANS_TC_PHYSPAGE *ppp)
+{
+	int r, next;
+
+	for (r = cpu->cd.DYNTRANS_ARCH.vph_paddr_hash[VPH_PADDR_HASH(
+	    ppp->physaddr)] - 1; r >= 0; r = next) {
+		uint64_t vaddr_page;
+
+		next = cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].paddr_next - 1;
+
+		if (cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].paddr_page !=
+		    ppp->physaddr)
+			continue;
+
+		vaddr_page = cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].vaddr_page;
+
+#ifndef MODE32
+		if (!cpu->is_32bit) {
+			const uint32_t mask1 = (1 << DYNTRANS_L1N) - 1;
+			const uint32_t mask2 = (1 << DYNTRANS_L2N) - 1;
+			const uint32_t mask3 = (1 << DYNTRANS_L3N) - 1;
+			uint32_t x1, x2, x3;
+			struct DYNTRANS_L3_64_TABLE *l3;
+
+			x1 = (vaddr_page >> (64-DYNTRANS_L1N)) & mask1;
+			x2 = (vaddr_page >> (64-DYNTRANS_L1N-DYNTRANS_L2N))
+			    & mask2;
+			x3 = (vaddr_page >> (64-DYNTRANS_L1N-DYNTRANS_L2N
+			    - DYNTRANS_L3N)) & mask3;
+			l3 = cpu->cd.DYNTRANS_ARCH.l1_64[x1]->l3[x2];
+			if (l3->phys_page[x3] == ppp)
+				l3->phys_page[x3] = NULL;
+			continue;
+		}
+#endif
+
+		{
+			uint32_t index = DYNTRANS_ADDR_TO_PAGENR(
+			    (uint32_t) vaddr_page);
+			if (cpu->cd.DYNTRANS_ARCH.phys_page[index] == ppp)
+				cpu->cd.DYNTRANS_ARCH.phys_page[index] = NULL;
+		}
+	}
+}
+
+
+/*
+ *  XXX_tc_evict_page():
+ *
+ *  Evict one cold physpage from the translation cache, and return its offset.
+ *
+ *  The physpages are treated as a circular list of fixed-size slots, swept
+ *  by a CLOCK hand. A physpage with its referenced flag set gets a second
+ *  chance: the flag is cleared, and the page is unmapped from the virtual
+ *  to physpage tables, so that the next time it is executed, the slow path
+ *  (which sets the flag again) is taken. A physpage which has not been used
+ *  since the previous sweep is evicted. The current page is never evicted.
+ */
+static uint32_t DYNTRANS_TC_EVICT_PAGE(struct cpu *cpu)
+{
+	const size_t first_ofs = N_BASE_TABLE_ENTRIES * sizeof(uint32_t);
+	const size_t slot_size = (sizeof(struct DYNTRANS_TC_PHYSPAGE) + 63)
+	    & ~63;
+
+	for (;;) {
+		size_t ofs = cpu->translation_cache_clock_ofs;
+		struct DYNTRANS_TC_PHYSPAGE *ppp, *p;
+		uint32_t *physpage_entryp;
+		int pagenr;
+
+		if (ofs < first_ofs || ofs >= cpu->translation_cache_cur_ofs)
+			ofs = first_ofs;
+
+		cpu->translation_cache_clock_ofs = ofs + slot_size;
+
+		ppp = (struct DYNTRANS_TC_PHYSPAGE *)
+		    (cpu->translation_cache + ofs);
+
+		if (&ppp->ics[0] == cpu->cd.DYNTRANS_ARCH.cur_ic_page)
+			continue;
+
+		DYNTRANS_TC_UNMAP_PAGE(cpu, ppp);
+
+		if (ppp->referenced) {
+			ppp->referenced = 0;
+			continue;
+		}
+
+		/*  Remove the victim from its physical page chain:  */
+		pagenr = DYNTRANS_ADDR_TO_PAGENR(ppp->physaddr);
+		physpage_entryp = &(((uint32_t *)cpu->translation_cache)
+		    [PAGENR_TO_TABLE_INDEX(pagenr)]);
+
+		while (*physpage_entryp != 0) {
+			if (*physpage_entryp == ofs) {
+				*physpage_entryp = ppp->next_ofs;
+				break;
+			}
+
+			p = (struct DYNTRANS_TC_PHYSPAGE *)
+			    (cpu->translation_cache + *physpage_entryp);
+			physpage_entryp = &p->next_ofs;
+		}
+
+		cpu->translation_cache_evictions ++;
+		return ofs;
+	}
+}
+
+
 /*
  *  XXX_tc_allocate_default_page():
  *
- *  Create a default page (with just pointers to instr(to_be_translated)
- *  at cpu->translation_cache_cur_ofs.
+ *  Create a default page (with just pointers to instr(to_be_translated)),
+ *  and return its offset within the translation cache. The page is taken
+ *  from the unused part of the translation cache, if there is any left.
+ *  Otherwise, a cold page is evicted and reused.
+ *
+ *  The page is not linked into any physical page chain; that is up to the
+ *  caller.
  */
-static void DYNTRANS_TC_ALLOCATE_DEFAULT_PAGE_DEF(struct cpu *cpu,
+static uint32_t DYNTRANS_TC_ALLOCATE_DEFAULT_PAGE_DEF(struct cpu *cpu,
 	uint64_t physaddr)
 { 
 	struct DYNTRANS_TC_PHYSPAGE *ppp;
+	uint32_t ofs;
+
+	if (cpu->translation_cache_cur_ofs < dyntrans_cache_size) {
+		ofs = cpu->translation_cache_cur_ofs;
+
+		cpu->translation_cache_cur_ofs +=
+		    sizeof(struct DYNTRANS_TC_PHYSPAGE);
+
+		cpu->translation_cache_cur_ofs --;
+		cpu->translation_cache_cur_ofs |= 63;
+		cpu->translation_cache_cur_ofs ++;
+	} else
+		ofs = DYNTRANS_TC_EVICT_PAGE(cpu);
 
-	ppp = (struct DYNTRANS_TC_PHYSPAGE *)(cpu->translation_cache
-	    + cpu->translation_cache_cur_ofs);
+	ppp = (struct DYNTRANS_TC_PHYSPAGE *)(cpu->translation_cache + ofs);
 
 	/*  Copy the entire template page first:  */
 	memcpy(ppp, cpu->cd.DYNTRANS_ARCH.physpage_template, sizeof(
@@ -557,11 +873,7 @@ static void DYNTRANS_TC_ALLOCATE_DEFAULT_PAGE_DEF(struct cpu *cpu,
 
 	ppp->physaddr = physaddr & ~(DYNTRANS_PAGESIZE - 1);
 
-	cpu->translation_cache_cur_ofs += sizeof(struct DYNTRANS_TC_PHYSPAGE);
-
-	cpu->translation_cache_cur_ofs --;
-	cpu->translation_cache_cur_ofs |= 63;
-	cpu->translation_cache_cur_ofs ++;
+	return ofs;
 }
 #endif	/*  DYNTRANS_TC_ALLOCATE_DEFAULT_PAGE_DEF  */
 
@@ -706,13 +1018,6 @@ void DYNTRANS_PC_TO_POINTERS_GENERIC(struct cpu *cpu)
 		}
 	}
 
-	if (cpu->translation_cache_cur_ofs >= dyntrans_cache_size) {
-#ifdef UNSTABLE_DEVEL
-		fatal("[ dyntrans: resetting the translation cache ]\n");
-#endif
-		cpu_create_or_reset_tc(cpu);
-	}
-
 	pagenr = DYNTRANS_ADDR_TO_PAGENR(physaddr);
 	table_index = PAGENR_TO_TABLE_INDEX(pagenr);
 
@@ -739,29 +1044,25 @@ void DYNTRANS_PC_TO_POINTERS_GENERIC(struct cpu *cpu)
 	 *  the chain.
 	 */
 	if (physpage_ofs == 0) {
-		uint32_t previous_first_page_in_chain;
-
 		/*  fatal("CREATING page %lli (physaddr 0x%"PRIx64"), table "
 		    "index %i\n", (long long)pagenr, (uint64_t)physaddr,
 		    (int)table_index);  */
 
-		previous_first_page_in_chain = *physpage_entryp;
-
-		/*  Insert the new page first in the chain:  */
-		*physpage_entryp = physpage_ofs =
-		    cpu->translation_cache_cur_ofs;
-
-		/*  Allocate a default page, with to_be_translated entries:  */
-		DYNTRANS_TC_ALLOCATE(cpu, physaddr);
+		/*  Allocate a default page, with to_be_translated entries.
+		    (This may evict some other page, possibly from the same
+		    chain, so the chain is read afterwards.)  */
+		physpage_ofs = DYNTRANS_TC_ALLOCATE(cpu, physaddr);
 
 		ppp = (struct DYNTRANS_TC_PHYSPAGE *)(cpu->translation_cache
 		    + physpage_ofs);
 
-		/*  Point to the other pages in the same chain:  */
-		ppp->next_ofs = previous_first_page_in_chain;
+		/*  Insert the new page first in the chain:  */
+		ppp->next_ofs = *physpage_entryp;
+		*physpage_entryp = physpage_ofs;
 	}
 
 	/*  Here, ppp points to a valid physical page struct.  */
+	ppp->referenced = 1;
 
 #ifdef MODE32
 	if (cpu->cd.DYNTRANS_ARCH.host_load[index] != NULL)
@@ -815,6 +1116,27 @@ void DYNTRANS_PC_TO_POINTERS_FUNC(struct cpu *cpu)
 	    cached_pc = cpu->pc;
 	struct DYNTRANS_TC_PHYSPAGE *ppp;
 
+#ifdef DYNTRANS_ARM
+	/*  Thumb code has translation pages of its own:  */
+	if (cached_pc & 1 || cpu->cd.arm.cpsr & ARM_FLAG_T) {
+		arm_thumb_pc_to_pointers(cpu);
+		return;
+	}
+#endif
+
+#ifdef DYNTRANS_MIPS
+	/*  So does MIPS16 code:  */
+	if (cpu->cd.mips.mips16 ||
+	    (cached_pc & 1 && cpu->cd.mips.mips16_available)) {
+#ifdef MODE32
+		mips32_mips16_pc_to_pointers(cpu);
+#else
+		mips_mips16_pc_to_pointers(cpu);
+#endif
+		return;
+	}
+#endif
+
 #ifdef MODE32
 	int index;
 	index = DYNTRANS_ADDR_TO_PAGENR(cached_pc);
@@ -856,6 +1178,189 @@ have_it:
 
 
 
+#ifdef DYNTRANS_NATIVE_HOST_PAGE_DEF
+/*
+ *  XXX_native_host_page():
+ *
+ *  Returns the host page which a virtual address is mapped to in the fast
+ *  lookup tables (host_store if writeflag is set, host_load otherwise), or
+ *  NULL if there is no such mapping. Used by native_routine_run().
+ */
+unsigned char *DYNTRANS_NATIVE_HOST_PAGE_DEF(struct cpu *cpu, uint64_t vaddr,
+	int writeflag)
+{
+#ifdef MODE32
+	uint32_t index = (uint32_t)vaddr >> 12;
+
+	if (writeflag)
+		return cpu->cd.DYNTRANS_ARCH.host_store[index];
+	else
+		return cpu->cd.DYNTRANS_ARCH.host_load[index];
+#else
+	const uint32_t mask1 = (1 << DYNTRANS_L1N) - 1;
+	const uint32_t mask2 = (1 << DYNTRANS_L2N) - 1;
+	const uint32_t mask3 = (1 << DYNTRANS_L3N) - 1;
+	uint32_t x1, x2, x3;
+	struct DYNTRANS_L2_64_TABLE *l2;
+	struct DYNTRANS_L3_64_TABLE *l3;
+
+	x1 = (vaddr >> (64-DYNTRANS_L1N)) & mask1;
+	x2 = (vaddr >> (64-DYNTRANS_L1N-DYNTRANS_L2N)) & mask2;
+	x3 = (vaddr >> (64-DYNTRANS_L1N-DYNTRANS_L2N-DYNTRANS_L3N)) & mask3;
+	l2 = cpu->cd.DYNTRANS_ARCH.l1_64[x1];
+	l3 = l2->l3[x2];
+
+	if (writeflag)
+		return l3->host_store[x3];
+	else
+		return l3->host_load[x3];
+#endif
+}
+#endif	/*  DYNTRANS_NATIVE_HOST_PAGE_DEF  */
+
+
+
+#ifdef DYNTRANS_TRANSLATE_READAHEAD_DEF
+/*
+ *  XXX_translate_readahead():
+ *
+ *  Translates instructions ahead of the one which is about to be executed,
+ *  starting at entry "first" of the current translation page. Translation
+ *  continues sequentially until an already translated entry is reached,
+ *  until an instruction cannot be translated, or until the instruction
+ *  itself signals (by lowering translation_readahead) that execution
+ *  cannot fall through, e.g. after an unconditional branch.
+ *
+ *  Whenever a translated instruction call has an argument which points to
+ *  an entry on the same translation page (i.e. a samepage branch target),
+ *  that entry is queued and translated the same way. The result is that a
+ *  function is usually translated in full the first time it is entered,
+ *  instead of one basic block at a time.
+ */
+void DYNTRANS_TRANSLATE_READAHEAD_DEF(struct cpu *cpu,
+	struct DYNTRANS_IC *page_ics, int first, int n_entries,
+	void (*to_be_translated)(struct cpu *, struct DYNTRANS_IC *))
+{
+	int targets[MAX_DYNTRANS_READAHEAD_TARGETS];
+	int n_targets = 0, budget = n_entries;
+	uint64_t old_pc = cpu->pc;
+
+	if (first < n_entries)
+		targets[n_targets++] = first;
+
+	while (n_targets > 0 && budget > 0) {
+		int i = targets[--n_targets];
+
+		cpu->translation_readahead = MAX_DYNTRANS_READAHEAD;
+
+		while (i < n_entries && cpu->translation_readahead > 0 &&
+		    budget > 0) {
+			struct DYNTRANS_IC *ic = page_ics + i;
+			size_t j;
+
+#ifdef DYNTRANS_MIPS
+			/*  The second half of a 32-bit MIPS16 instruction:  */
+			if (ic->f == instr(mips16_skip)) {
+				++i;
+				continue;
+			}
+#endif
+
+			/*  Already translated? Then abort:  */
+			if (ic->f != to_be_translated)
+				break;
+
+			/*  Translate the instruction:  */
+			ic->f(cpu, ic);
+
+			/*  Translation failed? Then abort.  */
+			if (ic->f == to_be_translated)
+				break;
+
+			/*  Queue untranslated samepage branch targets:  */
+			for (j=0; j<sizeof(ic->arg) / sizeof(ic->arg[0]); j++) {
+				struct DYNTRANS_IC *target =
+				    (struct DYNTRANS_IC *) ic->arg[j];
+				size_t ofs = (size_t)target - (size_t)page_ics;
+
+				if (target < page_ics ||
+				    target >= page_ics + n_entries ||
+				    ofs % sizeof(struct DYNTRANS_IC) != 0 ||
+				    target->f != to_be_translated ||
+				    n_targets >= MAX_DYNTRANS_READAHEAD_TARGETS)
+					continue;
+
+				targets[n_targets++] = target - page_ics;
+			}
+
+			cpu->translation_readahead --;
+			budget --;
+			++i;
+		}
+	}
+
+	cpu->translation_readahead = 0;
+	cpu->pc = old_pc;
+}
+#endif	/*  DYNTRANS_TRANSLATE_READAHEAD_DEF  */
+
+
+
+#ifdef DYNTRANS_STOP_TRANSLATED_RUN_DEF
+/*
+ *  XXX_stop_translated_run():
+ *
+ *  Called from within an instruction call (e.g. by memory_rw() when a store
+ *  hits a watchpoint), to end the current run of translated instructions
+ *  right after that instruction. The program counter is synchronized to the
+ *  next instruction, the same way as at the end of XXX_run_instr(), and the
+ *  rest of the run executes the "nothing" instruction.
+ *
+ *  An instruction in a delay slot is not stopped at, since the branch must
+ *  complete first. The run then ends as usual.
+ */
+void DYNTRANS_STOP_TRANSLATED_RUN_DEF(struct cpu *cpu)
+{
+	int low_pc;
+
+#ifdef DYNTRANS_DELAYSLOT
+	if (cpu->delay_slot != NOT_DELAYED)
+		return;
+#endif
+
+	low_pc = ((size_t)cpu->cd.DYNTRANS_ARCH.next_ic - (size_t)
+	    cpu->cd.DYNTRANS_ARCH.cur_ic_page) / sizeof(struct DYNTRANS_IC);
+#ifdef DYNTRANS_ARM
+	if (cpu->cd.arm.cpsr & ARM_FLAG_T) {
+		if (low_pc < 0 || low_pc > DYNTRANS_IC_ENTRIES_PER_PAGE)
+			return;
+		cpu->pc &= ~(ARM_THUMB_PAGE_SIZE - 1);
+		cpu->pc += (low_pc << ARM_THUMB_INSTR_ALIGNMENT_SHIFT);
+	} else
+#endif
+#ifdef DYNTRANS_MIPS
+	if (cpu->cd.mips.mips16) {
+		if (low_pc < 0 || low_pc > DYNTRANS_IC_ENTRIES_PER_PAGE)
+			return;
+		cpu->pc &= ~(MIPS16_PAGE_SIZE - 1);
+		cpu->pc += (low_pc << MIPS16_INSTR_ALIGNMENT_SHIFT);
+	} else
+#endif
+	{
+		if (low_pc < 0 || low_pc > DYNTRANS_IC_ENTRIES_PER_PAGE)
+			return;
+		cpu->pc &= ~((DYNTRANS_IC_ENTRIES_PER_PAGE-1) <<
+		    DYNTRANS_INSTR_ALIGNMENT_SHIFT);
+		cpu->pc += (low_pc << DYNTRANS_INSTR_ALIGNMENT_SHIFT);
+	}
+
+	debugger_n_steps_left_before_interaction = 0;
+	cpu->cd.DYNTRANS_ARCH.next_ic = &nothing_call;
+}
+#endif	/*  DYNTRANS_STOP_TRANSLATED_RUN_DEF  */
+
+
+
 #ifdef DYNTRANS_INIT_TABLES
 
 /*  forward declaration of to_be_translated and end_of_page:  */
@@ -873,6 +1378,28 @@ static void instr32(end_of_page)(struct cpu *,struct DYNTRANS_IC *);
 #define TO_BE_TRANSLATED    ( instr(to_be_translated) )
 #endif
 
+#ifdef DYNTRANS_ARM
+/*  Thumb translation pages, see cpu_arm.h:  */
+static void instr(thumb_to_be_translated)(struct cpu *, struct DYNTRANS_IC *);
+static void instr(thumb_end_of_page)(struct cpu *, struct DYNTRANS_IC *);
+#endif
+
+#ifdef DYNTRANS_MIPS
+/*  MIPS16 translation pages, see cpu_mips.h:  */
+static void instr(mips16_to_be_translated)(struct cpu *, struct DYNTRANS_IC *);
+static void instr(mips16_end_of_page)(struct cpu *, struct DYNTRANS_IC *);
+static void instr(mips16_end_of_page2)(struct cpu *, struct DYNTRANS_IC *);
+static void instr32(mips16_to_be_translated)(struct cpu *,
+	struct DYNTRANS_IC *);
+static void instr32(mips16_end_of_page)(struct cpu *, struct DYNTRANS_IC *);
+static void instr32(mips16_end_of_page2)(struct cpu *, struct DYNTRANS_IC *);
+static void instr(mips16_skip)(struct cpu *, struct DYNTRANS_IC *);
+static void instr32(mips16_skip)(struct cpu *, struct DYNTRANS_IC *);
+#define	MIPS16_TO_BE_TRANSLATED	( cpu->is_32bit?			\
+				  instr32(mips16_to_be_translated) :	\
+				  instr(mips16_to_be_translated) )
+#endif
+
 #ifdef DYNTRANS_DELAYSLOT
 static void instr(end_of_page2)(struct cpu *,struct DYNTRANS_IC *);
 #ifdef DYNTRANS_DUALMODE_32
@@ -902,6 +1429,7 @@ void DYNTRANS_INIT_TABLES(struct cpu *cpu)
 	ppp->next_ofs = 0;
 	ppp->translations_bitmap = 0;
 	ppp->translation_ranges_ofs = 0;
+	ppp->referenced = 0;
 	/*  ppp->physaddr is filled in by the page allocator  */
 
 	for (i=0; i<DYNTRANS_IC_ENTRIES_PER_PAGE; i++)
@@ -925,6 +1453,17 @@ void DYNTRANS_INIT_TABLES(struct cpu *cpu)
 
 	cpu->cd.DYNTRANS_ARCH.physpage_template = ppp;
 
+	/*  Number of virtual to host TLB entries to use (see cpu.h):  */
+	cpu->cd.DYNTRANS_ARCH.n_vph_tlb_entries =
+	    DYNTRANS_DEFAULT_VPH_TLB_ENTRIES;
+	if (dyntrans_vph_tlb_entries > 0)
+		cpu->cd.DYNTRANS_ARCH.n_vph_tlb_entries =
+		    dyntrans_vph_tlb_entries > DYNTRANS_MAX_VPH_TLB_ENTRIES?
+		    DYNTRANS_MAX_VPH_TLB_ENTRIES : dyntrans_vph_tlb_entries;
+	cpu->cd.DYNTRANS_ARCH.vph_tlb_clock = 0;
+	cpu->cd.DYNTRANS_ARCH.n_vph_parked = 0;
+	cpu->cd.DYNTRANS_ARCH.vph_asid = 0;
+
 
 	/*  Prepare 64-bit virtual address translation tables:  */
 #ifndef MODE32
@@ -956,7 +1495,9 @@ void DYNTRANS_INIT_TABLES(struct cpu *cpu)
  *
  *  If the JUST_MARK_AS_NON_WRITABLE flag is set, then the translation entry
  *  is just downgraded to non-writable (ie the host store page is set to
- *  NULL). Otherwise, the entire translation is removed.
+ *  NULL). Otherwise, the entire translation is removed. If INVALIDATE_ASID
+ *  is set, and the translation belongs to the address space in vph_asid,
+ *  then its VPH TLB entry is parked instead of being invalidated.
  */
 static void DYNTRANS_INVALIDATE_TLB_ENTRY(struct cpu *cpu,
 #ifdef MODE32
@@ -983,8 +1524,14 @@ static void DYNTRANS_INVALIDATE_TLB_ENTRY(struct cpu *cpu,
 		cpu->cd.DYNTRANS_ARCH.host_store[index] = NULL;
 		cpu->cd.DYNTRANS_ARCH.phys_addr[index] = 0;
 		cpu->cd.DYNTRANS_ARCH.phys_page[index] = NULL;
-		if (tlbi > 0)
-			cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[tlbi-1].valid = 0;
+		if (tlbi > 0) {
+			if (flags & INVALIDATE_ASID && cpu->cd.DYNTRANS_ARCH.
+			    vph_tlb_entry[tlbi-1].asid ==
+			    cpu->cd.DYNTRANS_ARCH.vph_asid)
+				DYNTRANS_VPH_PARK(cpu, tlbi-1);
+			else
+				DYNTRANS_VPH_PADDR_UNLINK(cpu, tlbi-1);
+		}
 		cpu->cd.DYNTRANS_ARCH.vaddr_to_tlbindex[index] = 0;
 	}
 #else
@@ -1061,8 +1608,12 @@ static void DYNTRANS_INVALIDATE_TLB_ENTRY(struct cpu *cpu,
 	l3->phys_addr[x3] = 0;
 	l3->phys_page[x3] = NULL;
 	if (l3->vaddr_to_tlbindex[x3] != 0) {
-		cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[
-		    l3->vaddr_to_tlbindex[x3] - 1].valid = 0;
+		int tlbi = l3->vaddr_to_tlbindex[x3];
+		if (flags & INVALIDATE_ASID && cpu->cd.DYNTRANS_ARCH.
+		    vph_tlb_entry[tlbi-1].asid == cpu->cd.DYNTRANS_ARCH.vph_asid)
+			DYNTRANS_VPH_PARK(cpu, tlbi-1);
+		else
+			DYNTRANS_VPH_PADDR_UNLINK(cpu, tlbi-1);
 		l3->refcount --;
 	}
 	l3->vaddr_to_tlbindex[x3] = 0;
@@ -1123,13 +1674,20 @@ static void DYNTRANS_INVALIDATE_TLB_ENTRY(struct cpu *cpu,
  *  In the case when all translations are invalidated, paddr doesn't need
  *  to be supplied.
  *
+ *  INVALIDATE_ASID is used when the guest switches address spaces: with
+ *  INVALIDATE_VADDR, the translation for addr is removed from the fast
+ *  lookup tables, but kept resident (parked) if it belongs to the address
+ *  space in vph_asid. Used on its own, addr is the identifier of the new
+ *  address space, and translations which were parked for that address
+ *  space are made active again.
+ *
  *  NOTE/TODO: When invalidating a virtual address, it is only cleared from
  *             the quick translation array, not from the linear
  *             vph_tlb_entry[] array.  Hopefully this is enough anyway.
  */
 void DYNTRANS_INVALIDATE_TC(struct cpu *cpu, uint64_t addr, int flags)
 {
-	int r;
+	int r, next;
 #ifdef MODE32
 	uint32_t
 #else
@@ -1139,10 +1697,75 @@ void DYNTRANS_INVALIDATE_TC(struct cpu *cpu, uint64_t addr, int flags)
 
 	/*  fatal("invalidate(): ");  */
 
+	/*  Switch to another address space:  */
+	if (flags == INVALIDATE_ASID) {
+		cpu->cd.DYNTRANS_ARCH.vph_asid = addr;
+
+		for (r=0; r<cpu->cd.DYNTRANS_ARCH.n_vph_tlb_entries &&
+		    cpu->cd.DYNTRANS_ARCH.n_vph_parked > 0; r++) {
+			uint64_t vaddr_page, paddr_page;
+			unsigned char *host_page;
+			int writeflag, occupied;
+
+			if (!cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].parked ||
+			    cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].asid != addr)
+				continue;
+
+			vaddr_page = cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r]
+			    .vaddr_page;
+			paddr_page = cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r]
+			    .paddr_page;
+			host_page = cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r]
+			    .host_page;
+			writeflag = cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r]
+			    .writeflag;
+			DYNTRANS_VPH_PADDR_UNLINK(cpu, r);
+#ifdef MODE32
+			occupied = cpu->cd.DYNTRANS_ARCH.vaddr_to_tlbindex[
+			    DYNTRANS_ADDR_TO_PAGENR(vaddr_page)] != 0;
+#else
+			{
+				const uint32_t mask1 = (1 << DYNTRANS_L1N) - 1;
+				const uint32_t mask2 = (1 << DYNTRANS_L2N) - 1;
+				const uint32_t mask3 = (1 << DYNTRANS_L3N) - 1;
+				struct DYNTRANS_L3_64_TABLE *l3 = cpu->cd.
+				    DYNTRANS_ARCH.l1_64[(vaddr_page >> (64-
+				    DYNTRANS_L1N)) & mask1]->l3[(vaddr_page >>
+				    (64-DYNTRANS_L1N-DYNTRANS_L2N)) & mask2];
+				occupied = l3->vaddr_to_tlbindex[(vaddr_page
+				    >> (64-DYNTRANS_L1N-DYNTRANS_L2N-
+				    DYNTRANS_L3N)) & mask3] != 0;
+			}
+#endif
+			/*  Put the translation back, unless the virtual page
+			    has been mapped to something else meanwhile:  */
+			if (!occupied)
+				cpu->update_translation_table(cpu, vaddr_page,
+				    host_page, writeflag, paddr_page);
+		}
+
+		return;
+	}
+
 	/*  Quick case for _one_ virtual addresses: see note above.  */
 	if (flags & INVALIDATE_VADDR) {
 		/*  fatal("vaddr 0x%08x\n", (int)addr_page);  */
 		DYNTRANS_INVALIDATE_TLB_ENTRY(cpu, addr_page, flags);
+
+		/*  Translations of this page which are parked for other
+		    address spaces may be stale now as well:  */
+		if (!(flags & INVALIDATE_ASID) &&
+		    cpu->cd.DYNTRANS_ARCH.n_vph_parked > 0) {
+			r = cpu->cd.DYNTRANS_ARCH.vph_parked_hash[
+			    VPH_PADDR_HASH(addr_page)] - 1;
+			for (; r >= 0; r = next) {
+				next = cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r]
+				    .parked_next - 1;
+				if (cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r]
+				    .vaddr_page == addr_page)
+					DYNTRANS_VPH_PADDR_UNLINK(cpu, r);
+			}
+		}
 		return;
 	}
 
@@ -1150,14 +1773,16 @@ void DYNTRANS_INVALIDATE_TC(struct cpu *cpu, uint64_t addr, int flags)
 #ifdef DYNTRANS_PPC
 	if (flags & INVALIDATE_ALL && flags & INVALIDATE_VADDR_UPPER4) {
 		/*  fatal("all, upper4 (PowerPC segment)\n");  */
-		for (r=0; r<DYNTRANS_MAX_VPH_TLB_ENTRIES; r++) {
+		for (r=0; r<cpu->cd.DYNTRANS_ARCH.n_vph_tlb_entries; r++) {
 			if (cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].valid &&
 			    (cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].vaddr_page
 			    & 0xf0000000) == addr_page) {
-				DYNTRANS_INVALIDATE_TLB_ENTRY(cpu, cpu->cd.
-				    DYNTRANS_ARCH.vph_tlb_entry[r].vaddr_page,
-				    0);
-				cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].valid=0;
+				if (!cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r]
+				    .parked)
+					DYNTRANS_INVALIDATE_TLB_ENTRY(cpu, cpu->
+					    cd.DYNTRANS_ARCH.vph_tlb_entry[r].
+					    vaddr_page, 0);
+				DYNTRANS_VPH_PADDR_UNLINK(cpu, r);
 			}
 		}
 		return;
@@ -1165,12 +1790,14 @@ void DYNTRANS_INVALIDATE_TC(struct cpu *cpu, uint64_t addr, int flags)
 #endif
 	if (flags & INVALIDATE_ALL) {
 		/*  fatal("all\n");  */
-		for (r=0; r<DYNTRANS_MAX_VPH_TLB_ENTRIES; r++) {
+		for (r=0; r<cpu->cd.DYNTRANS_ARCH.n_vph_tlb_entries; r++) {
 			if (cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].valid) {
-				DYNTRANS_INVALIDATE_TLB_ENTRY(cpu, cpu->cd.
-				    DYNTRANS_ARCH.vph_tlb_entry[r].vaddr_page,
-				    0);
-				cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].valid=0;
+				if (!cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r]
+				    .parked)
+					DYNTRANS_INVALIDATE_TLB_ENTRY(cpu, cpu->
+					    cd.DYNTRANS_ARCH.vph_tlb_entry[r].
+					    vaddr_page, 0);
+				DYNTRANS_VPH_PADDR_UNLINK(cpu, r);
 			}
 		}
 		return;
@@ -1183,18 +1810,23 @@ void DYNTRANS_INVALIDATE_TC(struct cpu *cpu, uint64_t addr, int flags)
 
 	/*  fatal("addr 0x%08x\n", (int)addr_page);  */
 
-	for (r=0; r<DYNTRANS_MAX_VPH_TLB_ENTRIES; r++) {
+	/*  Only the entries in the reverse index chain for this physical
+	    page need to be checked:  */
+	for (r = cpu->cd.DYNTRANS_ARCH.vph_paddr_hash[VPH_PADDR_HASH(
+	    addr_page)] - 1; r >= 0; r = next) {
+		next = cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].paddr_next - 1;
+
 		if (cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].valid && addr_page
 		    == cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].paddr_page) {
-			DYNTRANS_INVALIDATE_TLB_ENTRY(cpu,
-			    cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].vaddr_page,
-			    flags);
+			if (!cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].parked)
+				DYNTRANS_INVALIDATE_TLB_ENTRY(cpu, cpu->cd.
+				    DYNTRANS_ARCH.vph_tlb_entry[r].vaddr_page,
+				    flags);
 			if (flags & JUST_MARK_AS_NON_WRITABLE)
 				cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r]
 				    .writeflag = 0;
 			else
-				cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r]
-				    .valid = 0;
+				DYNTRANS_VPH_PADDR_UNLINK(cpu, r);
 		}
 	}
 }
@@ -1203,15 +1835,127 @@ void DYNTRANS_INVALIDATE_TC(struct cpu *cpu, uint64_t addr, int flags)
 
 
 #ifdef DYNTRANS_INVALIDATE_TC_CODE
+/*
+ *  XXX_invalidate_tc_physpage():
+ *
+ *  Set the translated entries of one physpage back to "to_be_translated".
+ *  With INVALIDATE_SUBPAGE, only the parts of the page around addr_in_page
+ *  are cleared. Returns 1 if there are translations left on the page.
+ *
+ *  Instead of removing the page from the code cache, each entry is set to
+ *  "to_be_translated". This is slow in the general case, but in the case of
+ *  self-modifying code, it might be faster since we don't risk wasting cache
+ *  memory as quickly (which would force unnecessary Restarts).
+ */
+static int DYNTRANS_INVALIDATE_TC_PHYSPAGE(struct cpu *cpu,
+	struct DYNTRANS_TC_PHYSPAGE *ppp, int addr_in_page, int flags)
+{
+	void (*to_be_translated)(struct cpu *, struct DYNTRANS_IC *) =
+	    TO_BE_TRANSLATED;
+	uint32_t x = ppp->translations_bitmap;	/*  TODO:
+		urk Should be same type as the bitmap */
+	uint32_t cleared;
+	int i, j, n, m;
+
+	if (x == 0)
+		return 0;
+
+#ifdef DYNTRANS_ARM
+	/*  Thumb pages have a tag in the low bits of physaddr:  */
+	if (ppp->physaddr & (DYNTRANS_PAGESIZE - 1))
+		to_be_translated = instr(thumb_to_be_translated);
+#endif
+#ifdef DYNTRANS_MIPS
+	/*  ... and so do MIPS16 pages:  */
+	if (ppp->physaddr & (DYNTRANS_PAGESIZE - 1))
+		to_be_translated = MIPS16_TO_BE_TRANSLATED;
+#endif
+
+	if (flags & INVALIDATE_SUBPAGE) {
+		/*
+		 *  Only the part(s) of the page covering the written bytes,
+		 *  and the part before that, since an instruction combination
+		 *  may begin there and cover the written instruction.
+		 */
+		int range = DYNTRANS_PAGESIZE / (8 * sizeof(x));
+		int first = addr_in_page / range;
+		int last = (addr_in_page + 7) / range;
+		uint32_t mask = 0;
+
+		if (first > 0)
+			first --;
+		if (last >= (int) (8 * sizeof(x)))
+			last = 8 * sizeof(x) - 1;
+
+		for (i=first; i<=last; i++)
+			mask |= 1 << i;
+
+		x &= mask;
+	}
+
+#ifdef DYNTRANS_ARM
+	/*
+	 *  Note: On ARM, PC-relative load instructions are implemented as
+	 *  immediate mov instructions. When setting parts of the page to
+	 *  "to be translated", we cannot keep track of which of the immediate
+	 *  movs that were affected, so we need to clear the entire page.
+	 *  (ARM only; not for the general case.) This also takes care of
+	 *  the Thumb pages, which have a different geometry.
+	 */
+	x = 0xffffffff;
+#endif
+#ifdef DYNTRANS_MIPS
+	/*  MIPS16 pages have a different geometry too:  */
+	if (ppp->physaddr & (DYNTRANS_PAGESIZE - 1))
+		x = 0xffffffff;
+#endif
+	/*  No translations where the write went?  */
+	if (x == 0)
+		return 1;
+
+	cleared = x;
+	n = 8 * sizeof(x);
+	m = DYNTRANS_IC_ENTRIES_PER_PAGE / n;
+
+	for (i=0; i<n; i++) {
+		if (x & 1) {
+			for (j=0; j<m; j++)
+				ppp->ics[i*m + j].f = to_be_translated;
+		}
+
+		x >>= 1;
+	}
+
+	ppp->translations_bitmap &= ~cleared;
+
+	/*  Clear the list of translatable ranges:  */
+	if (ppp->translations_bitmap == 0 &&
+	    ppp->translation_ranges_ofs != 0) {
+		struct physpage_ranges *physpage_ranges =
+		    (struct physpage_ranges *)
+		    (cpu->translation_cache + ppp->translation_ranges_ofs);
+		physpage_ranges->next_ofs = 0;
+		physpage_ranges->n_entries_used = 0;
+	}
+
+	return ppp->translations_bitmap != 0;
+}
+
+
 /*
  *  XXX_invalidate_code_translation():
  *
  *  Invalidate code translations for a specific physical address, a specific
  *  virtual address, or for all entries in the cache.
+ *
+ *  If INVALIDATE_SUBPAGE is set together with INVALIDATE_PADDR, then addr is
+ *  the exact address of a write of at most 8 bytes, and only the parts of the
+ *  page which may contain translations of the overwritten instructions are
+ *  invalidated. The rest of the page is kept translated (and non-writable).
  */
 void DYNTRANS_INVALIDATE_TC_CODE(struct cpu *cpu, uint64_t addr, int flags)
 {
-	int r;
+	int r, next, addr_in_page = addr & (DYNTRANS_PAGESIZE-1);
 #ifdef MODE32
 	uint32_t
 #else
@@ -1225,113 +1969,75 @@ void DYNTRANS_INVALIDATE_TC_CODE(struct cpu *cpu, uint64_t addr, int flags)
 	    (int)addr, flags);  */
 
 	if (flags & INVALIDATE_PADDR) {
-		int pagenr, table_index;
-		uint32_t physpage_ofs, *physpage_entryp;
-		struct DYNTRANS_TC_PHYSPAGE *ppp, *prev_ppp;
+		int pagenr, table_index, found = 0, translations_left = 0;
+		uint32_t physpage_ofs;
+		struct DYNTRANS_TC_PHYSPAGE *ppp;
 
 		pagenr = DYNTRANS_ADDR_TO_PAGENR(addr);
 		table_index = PAGENR_TO_TABLE_INDEX(pagenr);
 
-		physpage_entryp = &(((uint32_t *)cpu->
-		    translation_cache)[table_index]);
-		physpage_ofs = *physpage_entryp;
+		physpage_ofs = ((uint32_t *)cpu->translation_cache)
+		    [table_index];
 
 		/*  Return immediately if there is no code translation
 		    for this page.  */
 		if (physpage_ofs == 0)
 			return;
 
-		prev_ppp = ppp = NULL;
-
-		/*  Traverse the physical page chain:  */
+		/*
+		 *  Traverse the physical page chain. There may be more than
+		 *  one translation page for the physical page (ARM and Thumb
+		 *  code, see cpu_arm.h), whose physaddr is the page address
+		 *  plus a small tag, so all of them are checked.
+		 */
 		while (physpage_ofs != 0) {
-			prev_ppp = ppp;
 			ppp = (struct DYNTRANS_TC_PHYSPAGE *)
 			    (cpu->translation_cache + physpage_ofs);
 
-			/*  If we found the page in the cache,
-			    then we're done:  */
-			if (ppp->physaddr == addr)
-				break;
+			if ((ppp->physaddr & ~(DYNTRANS_PAGESIZE-1)) == addr) {
+				found = 1;
+				translations_left |=
+				    DYNTRANS_INVALIDATE_TC_PHYSPAGE(cpu, ppp,
+				    addr_in_page, flags);
+			}
 
-			/*  Try the next page in the chain:  */
 			physpage_ofs = ppp->next_ofs;
 		}
 
 		/*  If there is no translation, there is no need to go
 		    on and try to remove it from the vph_tlb_entry array:  */
-		if (physpage_ofs == 0)
+		if (!found)
 			return;
 
-#if 0
 		/*
-		 *  "Bypass" the page, removing it from the code cache.
-		 *
-		 *  NOTE/TODO: This gives _TERRIBLE_ performance with self-
-		 *  modifying code, or when a single page is used for both
-		 *  code and (writable) data.
+		 *  If there are translations left on the page, then it is
+		 *  still non-writable, and there is no need to remove it from
+		 *  the VPH table. Otherwise, it is removed, so that it will be
+		 *  marked as non-writable again before being translated.
 		 */
-		if (ppp != NULL) {
-			if (prev_ppp != NULL)
-				prev_ppp->next_ofs = ppp->next_ofs;
-			else
-				*physpage_entryp = ppp->next_ofs;
-		}
-#else
-		/*
-		 *  Instead of removing the page from the code cache, each
-		 *  entry can be set to "to_be_translated". This is slow in
-		 *  the general case, but in the case of self-modifying code,
-		 *  it might be faster since we don't risk wasting cache
-		 *  memory as quickly (which would force unnecessary Restarts).
-		 */
-		if (ppp != NULL && ppp->translations_bitmap != 0) {
-			uint32_t x = ppp->translations_bitmap;	/*  TODO:
-				urk Should be same type as the bitmap */
-			int i, j, n, m;
-
-#ifdef DYNTRANS_ARM
-			/*
-			 *  Note: On ARM, PC-relative load instructions are
-			 *  implemented as immediate mov instructions. When
-			 *  setting parts of the page to "to be translated",
-			 *  we cannot keep track of which of the immediate
-			 *  movs that were affected, so we need to clear
-			 *  the entire page. (ARM only; not for the general
-			 *  case.)
-			 */
-			x = 0xffffffff;
-#endif
-			n = 8 * sizeof(x);
-			m = DYNTRANS_IC_ENTRIES_PER_PAGE / n;
-
-			for (i=0; i<n; i++) {
-				if (x & 1) {
-					for (j=0; j<m; j++)
-						ppp->ics[i*m + j].f =
-						    TO_BE_TRANSLATED;
-				}
-
-				x >>= 1;
-			}
-
-			ppp->translations_bitmap = 0;
-
-			/*  Clear the list of translatable ranges:  */
-			if (ppp->translation_ranges_ofs != 0) {
-				struct physpage_ranges *physpage_ranges =
-				    (struct physpage_ranges *)
-				    (cpu->translation_cache +
-				    ppp->translation_ranges_ofs);
-				physpage_ranges->next_ofs = 0;
-				physpage_ranges->n_entries_used = 0;
-			}
-		}
-#endif
+		if (flags & INVALIDATE_SUBPAGE && translations_left)
+			return;
 	}
 
-	/*  Invalidate entries in the VPH table:  */
-	for (r = 0; r < DYNTRANS_MAX_VPH_TLB_ENTRIES; r ++) {
+	/*
+	 *  Invalidate entries in the VPH table. For a physical page, only the
+	 *  entries in the reverse index chain for that page need to be
+	 *  checked; otherwise, all entries are checked.
+	 */
+	if (flags & INVALIDATE_PADDR)
+		r = cpu->cd.DYNTRANS_ARCH.vph_paddr_hash[VPH_PADDR_HASH(addr)]
+		    - 1;
+	else
+		r = 0;
+
+	for (; r >= 0 && r < cpu->cd.DYNTRANS_ARCH.n_vph_tlb_entries;
+	    r = next) {
+		if (flags & INVALIDATE_PADDR)
+			next = cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r]
+			    .paddr_next - 1;
+		else
+			next = r + 1;
+
 		if (cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].valid) {
 			vaddr_page = cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r]
 			    .vaddr_page & ~(DYNTRANS_PAGESIZE-1);
@@ -1371,10 +2077,43 @@ void DYNTRANS_INVALIDATE_TC_CODE(struct cpu *cpu, uint64_t addr, int flags)
 
 
 #ifdef DYNTRANS_UPDATE_TRANSLATION_TABLE
+/*
+ *  XXX_physpage_has_translations():
+ *
+ *  Returns 1 if there are any code translations for a physical page.
+ */
+static int DYNTRANS_PHYSPAGE_HAS_TRANSLATIONS(struct cpu *cpu,
+	uint64_t paddr_page)
+{
+	int pagenr = DYNTRANS_ADDR_TO_PAGENR(paddr_page);
+	uint32_t physpage_ofs = ((uint32_t *)cpu->translation_cache)[
+	    PAGENR_TO_TABLE_INDEX(pagenr)];
+
+	while (physpage_ofs != 0) {
+		struct DYNTRANS_TC_PHYSPAGE *ppp = (struct DYNTRANS_TC_PHYSPAGE *)
+		    (cpu->translation_cache + physpage_ofs);
+
+		/*  (Any of the tagged pages, e.g. ARM and Thumb.)  */
+		if ((ppp->physaddr & ~(DYNTRANS_PAGESIZE-1)) == paddr_page &&
+		    ppp->translations_bitmap != 0)
+			return 1;
+
+		physpage_ofs = ppp->next_ofs;
+	}
+
+	return 0;
+}
+
+
 /*
  *  XXX_update_translation_table():
  *
  *  Update the virtual memory translation tables.
+ *
+ *  Pages which contain code translations are never made writable. Stores to
+ *  such pages go through the slow memory_rw() path instead, which then
+ *  invalidates just the overwritten parts of the page. The same goes for
+ *  pages which contain watchpoints.
  */
 void DYNTRANS_UPDATE_TRANSLATION_TABLE(struct cpu *cpu, uint64_t vaddr_page,
 	unsigned char *host_page, int writeflag, uint64_t paddr_page)
@@ -1422,6 +2161,17 @@ void DYNTRANS_UPDATE_TRANSLATION_TABLE(struct cpu *cpu, uint64_t vaddr_page,
 		return;
 #endif
 
+	if (writeflag & MEM_WRITE &&
+	    DYNTRANS_PHYSPAGE_HAS_TRANSLATIONS(cpu, paddr_page))
+		writeflag &= ~MEM_WRITE;
+
+	/*  Neither are pages with watchpoints, see memory_rw():  */
+	if (writeflag & MEM_WRITE && cpu->machine->watchpoints.n > 0 &&
+	    machine_watchpoint_lookup(cpu->machine, vaddr_page,
+	    DYNTRANS_PAGESIZE, cpu->is_32bit? 0xffffffffULL : (uint64_t) -1)
+	    >= 0)
+		writeflag &= ~MEM_WRITE;
+
 	/*  Scan the current TLB entries:  */
 
 #ifdef MODE32
@@ -1429,9 +2179,8 @@ void DYNTRANS_UPDATE_TRANSLATION_TABLE(struct cpu *cpu, uint64_t vaddr_page,
 	 *  NOTE 1: vaddr_to_tlbindex is one more than the index, so that
 	 *          0 becomes -1, which means a miss.
 	 *
-	 *  NOTE 2: When a miss occurs, instead of scanning the entire tlb
-	 *          for the entry with the lowest time stamp, just choosing
-	 *          one at random will work as well.
+	 *  NOTE 2: When a miss occurs, the entry to replace is chosen using
+	 *          a CLOCK algorithm; see the comment in cpu.h.
 	 */
 	found = (int)cpu->cd.DYNTRANS_ARCH.vaddr_to_tlbindex[
 	    DYNTRANS_ADDR_TO_PAGENR(vaddr_page)] - 1;
@@ -1454,23 +2203,65 @@ void DYNTRANS_UPDATE_TRANSLATION_TABLE(struct cpu *cpu, uint64_t vaddr_page,
 #endif
 
 	if (found < 0) {
-		/*  Create the new TLB entry, overwriting a "random" entry:  */
-		static unsigned int x = 0;
-		r = (x++) % DYNTRANS_MAX_VPH_TLB_ENTRIES;
+		/*
+		 *  Create the new TLB entry. Advance the clock hand until an
+		 *  unused entry, or an entry which has not been referenced
+		 *  since the hand last passed it, is found. Referenced entries
+		 *  get a second chance, but are soft-unmapped so that the next
+		 *  access to them ends up here and sets the referenced flag.
+		 */
+		for (;;) {
+			r = cpu->cd.DYNTRANS_ARCH.vph_tlb_clock;
+			cpu->cd.DYNTRANS_ARCH.vph_tlb_clock = r + 1 >=
+			    cpu->cd.DYNTRANS_ARCH.n_vph_tlb_entries? 0 : r + 1;
+
+			if (!cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].valid ||
+			    !cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].referenced)
+				break;
 
+			cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].referenced = 0;
+			if (!cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].parked) {
+				uint64_t va = cpu->cd.DYNTRANS_ARCH.
+				    vph_tlb_entry[r].vaddr_page;
+#ifdef MODE32
+				index = DYNTRANS_ADDR_TO_PAGENR(va);
+				cpu->cd.DYNTRANS_ARCH.host_load[index] = NULL;
+				cpu->cd.DYNTRANS_ARCH.host_store[index] = NULL;
+				cpu->cd.DYNTRANS_ARCH.phys_page[index] = NULL;
+#else
+				struct DYNTRANS_L3_64_TABLE *l3v = cpu->cd.
+				    DYNTRANS_ARCH.l1_64[(va >> (64-DYNTRANS_L1N)
+				    ) & mask1]->l3[(va >> (64-DYNTRANS_L1N-
+				    DYNTRANS_L2N)) & mask2];
+				int x3v = (va >> (64-DYNTRANS_L1N-DYNTRANS_L2N-
+				    DYNTRANS_L3N)) & mask3;
+				l3v->host_load[x3v] = NULL;
+				l3v->host_store[x3v] = NULL;
+				l3v->phys_page[x3v] = NULL;
+#endif
+			}
+		}
+
+		cpu->vph_tlb_misses ++;
 		if (cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].valid) {
 			/*  This one has to be invalidated first:  */
-			DYNTRANS_INVALIDATE_TLB_ENTRY(cpu,
-			    cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].vaddr_page,
-			    0);
+			cpu->vph_tlb_evictions ++;
+			if (!cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].parked)
+				DYNTRANS_INVALIDATE_TLB_ENTRY(cpu, cpu->cd.
+				    DYNTRANS_ARCH.vph_tlb_entry[r].vaddr_page,
+				    0);
+			DYNTRANS_VPH_PADDR_UNLINK(cpu, r);
 		}
 
-		cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].valid = 1;
 		cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].host_page = host_page;
 		cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].paddr_page = paddr_page;
 		cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].vaddr_page = vaddr_page;
 		cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].writeflag =
 		    writeflag & MEM_WRITE;
+		cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].referenced = 1;
+		cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].asid =
+		    cpu->cd.DYNTRANS_ARCH.vph_asid;
+		DYNTRANS_VPH_PADDR_LINK(cpu, r);
 
 		/*  Add the new translation to the table:  */
 #ifdef MODE32
@@ -1574,10 +2365,26 @@ void DYNTRANS_UPDATE_TRANSLATION_TABLE(struct cpu *cpu, uint64_t vaddr_page,
 		 *	Writeflag = MEM_DOWNGRADE: Downgrade to readonly.
 		 */
 		r = found;
+		cpu->vph_tlb_hits ++;
+		cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].referenced = 1;
+		cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].asid =
+		    cpu->cd.DYNTRANS_ARCH.vph_asid;
 		if (writeflag & MEM_WRITE)
 			cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].writeflag = 1;
 		if (writeflag & MEM_DOWNGRADE)
 			cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].writeflag = 0;
+
+		/*  Keep the reverse index up to date, if the virtual page
+		    now maps to a different physical page:  */
+		if (cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].paddr_page !=
+		    paddr_page) {
+			DYNTRANS_VPH_PADDR_UNLINK(cpu, r);
+			cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].host_page =
+			    host_page;
+			cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].paddr_page =
+			    paddr_page;
+			DYNTRANS_VPH_PADDR_LINK(cpu, r);
+		}
 #ifdef MODE32
 		index = DYNTRANS_ADDR_TO_PAGENR(vaddr_page);
 		cpu->cd.DYNTRANS_ARCH.phys_page[index] = NULL;
@@ -1588,6 +2395,8 @@ void DYNTRANS_UPDATE_TRANSLATION_TABLE(struct cpu *cpu, uint64_t vaddr_page,
 			    |= 1 << (index & 31);
 #endif
 		if (cpu->cd.DYNTRANS_ARCH.phys_addr[index] == paddr_page) {
+			/*  May have been soft-unmapped by the clock:  */
+			cpu->cd.DYNTRANS_ARCH.host_load[index] = host_page;
 			if (writeflag & MEM_WRITE)
 				cpu->cd.DYNTRANS_ARCH.host_store[index] =
 				    host_page;
@@ -1608,6 +2417,8 @@ void DYNTRANS_UPDATE_TRANSLATION_TABLE(struct cpu *cpu, uint64_t vaddr_page,
 		l2 = cpu->cd.DYNTRANS_ARCH.l1_64[x1];
 		l3 = l2->l3[x2];
 		if (l3->phys_addr[x3] == paddr_page) {
+			/*  May have been soft-unmapped by the clock:  */
+			l3->host_load[x3] = host_page;
 			if (writeflag & MEM_WRITE)
 				l3->host_store[x3] = host_page;
 			if (writeflag & MEM_DOWNGRADE)
@@ -1657,41 +2468,43 @@ cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].valid);
 #ifdef DYNTRANS_TO_BE_TRANSLATED_HEAD
 	/*
 	 *  Check for breakpoints.
+	 *
+	 *  Instructions at breakpoint addresses are never kept translated;
+	 *  the to_be_translated call in their slot acts as the breakpoint
+	 *  check. Read-ahead leaves them alone, and after single-stepping
+	 *  past a breakpoint the slot is reset to to_be_translated again.
+	 *  All other instructions are translated and run as usual.
 	 */
-	if (!single_step_breakpoint && !cpu->translation_readahead) {
-		MODE_uint_t curpc = cpu->pc;
-		int i;
-		for (i=0; i<cpu->machine->breakpoints.n; i++)
-			if (curpc == (MODE_uint_t)
-			    cpu->machine->breakpoints.addr[i]) {
-				if (!cpu->machine->instruction_trace) {
-					int old_quiet_mode = quiet_mode;
-					quiet_mode = 0;
-					DISASSEMBLE(cpu, ib, 1, 0);
-					quiet_mode = old_quiet_mode;
-				}
+	if (cpu->machine->breakpoints.n > 0 && machine_breakpoint_lookup(
+	    cpu->machine, (MODE_uint_t) cpu->pc, (MODE_uint_t) -1) >= 0) {
+		if (cpu->translation_readahead)
+			goto bad;
+
+		if (!single_step_breakpoint) {
+			if (!cpu->machine->instruction_trace) {
+				int old_quiet_mode = quiet_mode;
+				quiet_mode = 0;
+				DISASSEMBLE(cpu, ib, 1, 0);
+				quiet_mode = old_quiet_mode;
+			}
 #ifdef MODE32
-				fatal("BREAKPOINT: pc = 0x%"PRIx32"\n(The "
-				    "instruction has not yet executed.)\n",
-				    (uint32_t)cpu->pc);
+			fatal("BREAKPOINT: pc = 0x%"PRIx32"\n(The "
+			    "instruction has not yet executed.)\n",
+			    (uint32_t)cpu->pc);
 #else
-				fatal("BREAKPOINT: pc = 0x%"PRIx64"\n(The "
-				    "instruction has not yet executed.)\n",
-				    (uint64_t)cpu->pc);
- 				    int gprs = 1;
- 				    int coprocs = 0x0;
- 				    cpu_register_dump(cpu->machine, cpu, gprs, coprocs);
- 				    exit(0);
+			fatal("BREAKPOINT: pc = 0x%"PRIx64"\n(The "
+			    "instruction has not yet executed.)\n",
+			    (uint64_t)cpu->pc);
 #endif
 #ifdef DYNTRANS_DELAYSLOT
-				if (cpu->delay_slot != NOT_DELAYED)
-					fatal("ERROR! Breakpoint in a delay"
-					    " slot! Not yet supported.\n");
+			if (cpu->delay_slot != NOT_DELAYED)
+				fatal("ERROR! Breakpoint in a delay"
+				    " slot! Not yet supported.\n");
 #endif
-				single_step_breakpoint = 1;
-				single_step = ENTER_SINGLE_STEPPING;
-				goto stop_running_translated;
-			}
+			single_step_breakpoint = 1;
+			single_step = ENTER_SINGLE_STEPPING;
+			goto stop_running_translated;
+		}
 	}
 #endif	/*  DYNTRANS_TO_BE_TRANSLATED_HEAD  */
 
@@ -1728,7 +2541,8 @@ cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].valid);
 	 *  Note: Single-stepping or instruction tracing doesn't work with
 	 *  instruction combinations. For architectures with delay slots,
 	 *  we also ignore combinations if the delay slot is across a page
-	 *  boundary.
+	 *  boundary. A combination may also run the instructions before this
+	 *  one, so none are made if any of those is at a breakpoint.
 	 */
 	if (!single_step && !cpu->machine->instruction_trace
 #ifdef DYNTRANS_DELAYSLOT
@@ -1736,8 +2550,19 @@ cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].valid);
 #endif
 	    && cpu->cd.DYNTRANS_ARCH.combination_check != NULL
 	    && cpu->machine->allow_instruction_combinations) {
-		cpu->cd.DYNTRANS_ARCH.combination_check(cpu, ic,
-		    addr & (DYNTRANS_PAGESIZE - 1));
+		int k, bp_near = 0;
+
+		for (k=0; k<MAX_COMBINATION_LENGTH &&
+		    cpu->machine->breakpoints.n > 0; k++)
+			if (machine_breakpoint_lookup(cpu->machine,
+			    (MODE_uint_t) (cpu->pc - (k <<
+			    DYNTRANS_INSTR_ALIGNMENT_SHIFT)),
+			    (MODE_uint_t) -1) >= 0)
+				bp_near = 1;
+
+		if (!bp_near)
+			cpu->cd.DYNTRANS_ARCH.combination_check(cpu, ic,
+			    addr & (DYNTRANS_PAGESIZE - 1));
 	}
 
 	cpu->cd.DYNTRANS_ARCH.combination_check = NULL;
@@ -1778,38 +2603,14 @@ cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].valid);
 	}
 
 
-	/*  Translation read-ahead:  */
-	if (!single_step && !cpu->machine->instruction_trace &&
-	    cpu->machine->breakpoints.n == 0) {
-		uint64_t baseaddr = cpu->pc;
-		uint64_t pagenr = DYNTRANS_ADDR_TO_PAGENR(baseaddr);
-		int i = 1;
-
-		cpu->translation_readahead = MAX_DYNTRANS_READAHEAD;
-
-		while (DYNTRANS_ADDR_TO_PAGENR(baseaddr +
-		    (i << DYNTRANS_INSTR_ALIGNMENT_SHIFT)) == pagenr &&
-		    cpu->translation_readahead > 0) {
-			void (*old_f)(struct cpu *,
-			    struct DYNTRANS_IC *) = ic[i].f;
-
-			/*  Already translated? Then abort:  */
-			if (old_f != TO_BE_TRANSLATED)
-				break;
-
-			/*  Translate the instruction:  */
-			ic[i].f(cpu, ic+i);
-
-			/*  Translation failed? Then abort.  */
-			if (ic[i].f == old_f)
-				break;
+	cpu->translation_cache_traps ++;
 
-			cpu->translation_readahead --;
-			++i;
-		}
-
-		cpu->translation_readahead = 0;
-	}
+	/*  Translation read-ahead:  */
+	if (!single_step && !cpu->machine->instruction_trace)
+		DYNTRANS_TRANSLATE_READAHEAD(cpu,
+		    cpu->cd.DYNTRANS_ARCH.cur_ic_page,
+		    (ic - cpu->cd.DYNTRANS_ARCH.cur_ic_page) + 1,
+		    DYNTRANS_IC_ENTRIES_PER_PAGE, TO_BE_TRANSLATED);
 
 
 	/*
@@ -136,6 +136,12 @@ int mips_cpu_new(struct cpu *cpu, struct memory *mem, struct machine *machine,
 
 	cpu->instruction_has_delayslot = mips_cpu_instruction_has_delayslot;
 
+	/*  MIPS16 is implemented by the MIPS32/64 and VR41xx cores:  */
+	if (cpu->cd.mips.cpu_type.isa_level == 32 ||
+	    cpu->cd.mips.cpu_type.isa_level == 64 ||
+	    cpu->cd.mips.cpu_type.rev == MIPS_R4100)
+		cpu->cd.mips.mips16_available = 1;
+
 	if (cpu_id == 0)
 		debug("%s", cpu->cd.mips.cpu_type.name);
 
@@ -441,6 +447,16 @@ int mips_cpu_instruction_has_delayslot(struct cpu *cpu, unsigned char *ib)
 {
 	uint32_t iword = *((uint32_t *)&ib[0]);
 
+	if (cpu->cd.mips.mips16) {
+		/*  jal, jalx, and jr/jalr without the nd bit:  */
+		if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
+			iword = ib[0] + (ib[1] << 8);
+		else
+			iword = ib[1] + (ib[0] << 8);
+		return (iword >> 11) == 0x03 ||
+		    ((iword >> 11) == 0x1d && (iword & 0x9f) == 0x00);
+	}
+
 	if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
 		iword = LE32_TO_HOST(iword);
 	else
@@ -477,6 +493,7 @@ int mips_cpu_instruction_has_delayslot(struct cpu *cpu, unsigned char *ib)
 	case HI6_BLEZL:
 	case HI6_J:
 	case HI6_JAL:
+	case HI6_JALX:
 		return 1;
 	}
 
@@ -679,6 +696,293 @@ void mips_cpu_tlbdump(struct machine *m, int x, int rawflag)
 }
 
 
+/*
+ *  mips_cpu_disassemble_mips16():
+ *
+ *  MIPS16 part of mips_cpu_disassemble_instr(), called in MIPS16 mode. ib
+ *  should contain 4 bytes, so that EXTENDed instructions and JAL/JALX can be
+ *  shown as a whole. Returns the length of the instruction, 2 or 4.
+ */
+static int mips_cpu_disassemble_mips16(struct cpu *cpu, unsigned char *ib,
+	int running, uint64_t dumpaddr)
+{
+	static const char *ls_name[12] = { "lb", "lh", "lw", "lw", "lbu",
+	    "lhu", "lw", "lwu", "sb", "sh", "sw", "sw" };
+	static const int ls_scale[12] = { 1, 2, 4, 4, 1, 2, 4, 4, 1, 2, 4, 4 };
+	static const char *rrr_name[4] = { "daddu", "addu", "dsubu", "subu" };
+	static const char *shift_name[4] = { "sll", "dsll", "srl", "sra" };
+	static const char *rr_name[32] = { "?", "sdbbp", "slt", "sltu",
+	    "sllv", "break", "srlv", "srav", "dsrl", "?", "cmp", "neg", "and",
+	    "or", "xor", "not", "mfhi", "?", "mflo", "dsra", "dsllv", "?",
+	    "dsrlv", "dsrav", "mult", "multu", "div", "divu", "dmult",
+	    "dmultu", "ddiv", "ddivu" };
+	static const char *cnvt_name[8] = { "zeb", "zeh", "zew", "?", "seb",
+	    "seh", "sew", "?" };
+	uint32_t iw, iw2, ext = 0;
+	int op, rx, ry, rz, imm, extended = 0, len = sizeof(uint16_t);
+	uint64_t addr, offset;
+	char *symbol;
+
+	if (cpu->byte_order == EMUL_LITTLE_ENDIAN) {
+		iw = ib[0] + (ib[1]<<8);
+		iw2 = ib[2] + (ib[3]<<8);
+	} else {
+		iw = ib[1] + (ib[0]<<8);
+		iw2 = ib[3] + (ib[2]<<8);
+	}
+
+	op = iw >> 11;
+	if (op == 0x1e || op == 0x03) {
+		debug(": %04x %04x", (int)iw, (int)iw2);
+		len = 2 * sizeof(uint16_t);
+	} else
+		debug(": %04x     ", (int)iw);
+
+	if (running && cpu->delay_slot)
+		debug(" (d)");
+
+	debug("\t");
+
+	if (op == 0x1e) {
+		ext = iw & 0x7ff;
+		iw = iw2;
+		op = iw >> 11;
+		extended = 1;
+	}
+
+	rx = (iw >> 8) & 7;  rx = rx < 2? rx + 16 : rx;
+	ry = (iw >> 5) & 7;  ry = ry < 2? ry + 16 : ry;
+	rz = (iw >> 2) & 7;  rz = rz < 2? rz + 16 : rz;
+	imm = (int16_t)(((ext & 0x1f) << 11) | (ext & 0x7e0) | (iw & 0x1f));
+
+	switch (op) {
+	case 0x00:
+	case 0x01:
+		debug("addiu\t%s,%s,%i", regnames[rx], op? "pc" : "sp",
+		    extended? imm : (int)(iw & 0xff) << 2);
+		break;
+	case 0x02:
+	case 0x04:
+	case 0x05:
+		if (extended)
+			imm <<= 1;
+		else if (op == 0x02)
+			imm = (int32_t)(iw << 21) >> 20;
+		else
+			imm = (int8_t)iw << 1;
+		addr = dumpaddr + (extended? 4 : 2) + imm;
+		if (cpu->is_32bit)
+			addr = (uint32_t)addr;
+		if (op == 0x02)
+			debug("b\t0x%"PRIx64, (uint64_t)addr);
+		else
+			debug("%s\t%s,0x%"PRIx64, op == 0x04? "beqz" : "bnez",
+			    regnames[rx], (uint64_t)addr);
+		break;
+	case 0x03:
+		addr = (dumpaddr + 4) & ~(uint64_t)0x0fffffff;
+		addr |= (((iw & 0x1f) << 21) | (((iw >> 5) & 0x1f) << 16) |
+		    iw2) << 2;
+		if (cpu->is_32bit)
+			addr = (uint32_t)addr;
+		debug("%s\t0x%"PRIx64, iw & 0x400? "jalx" : "jal",
+		    (uint64_t)addr);
+		symbol = get_symbol_name(&cpu->machine->symbol_context,
+		    addr, &offset);
+		if (symbol != NULL && offset == 0)
+			debug("\t<%s>", symbol);
+		break;
+	case 0x06:
+		imm = (iw >> 2) & 7;
+		if (extended)
+			imm = ((ext >> 6) & 31) | (ext & 0x20);
+		else if (imm == 0)
+			imm = 8;
+		debug("%s\t%s,%s,%i", shift_name[iw & 3], regnames[rx],
+		    regnames[ry], imm);
+		break;
+	case 0x07:
+	case 0x0f:
+		debug("%s\t%s,%i(%s)", op == 0x07? "ld" : "sd", regnames[ry],
+		    extended? imm : (int)(iw & 31) << 3, regnames[rx]);
+		break;
+	case 0x08:
+		if (extended)
+			imm = (int32_t)((((ext & 0xf) << 11) | (ext & 0x7f0) |
+			    (iw & 0xf)) << 17) >> 17;
+		else
+			imm = (int32_t)(iw << 28) >> 28;
+		debug("%s\t%s,%s,%i", iw & 0x10? "daddiu" : "addiu",
+		    regnames[ry], regnames[rx], imm);
+		break;
+	case 0x09:
+	case 0x0a:
+	case 0x0b:
+	case 0x0d:
+	case 0x0e:
+		if (!extended)
+			imm = op == 0x09? (int8_t)iw : (int)(iw & 0xff);
+		else if (op == 0x0d || op == 0x0e)
+			imm &= 0xffff;
+		debug("%s\t%s,%i", op == 0x09? "addiu" : op == 0x0a? "slti" :
+		    op == 0x0b? "sltiu" : op == 0x0d? "li" : "cmpi",
+		    regnames[rx], imm);
+		break;
+	case 0x0c:
+		switch ((iw >> 8) & 7) {
+		case 0:
+		case 1:
+			imm = extended? imm << 1 : (int8_t)iw << 1;
+			addr = dumpaddr + (extended? 4 : 2) + imm;
+			if (cpu->is_32bit)
+				addr = (uint32_t)addr;
+			debug("%s\t0x%"PRIx64, iw & 0x100? "btnez" : "bteqz",
+			    (uint64_t)addr);
+			break;
+		case 2:
+			debug("sw\tra,%i(sp)", extended? imm :
+			    (int)(iw & 0xff) << 2);
+			break;
+		case 3:
+			debug("addiu\tsp,%i", extended? imm : (int8_t)iw << 3);
+			break;
+		case 4:
+			imm = extended? ((ext & 0xf0) | (iw & 0xf)) << 3 :
+			    (iw & 0xf? (iw & 0xf) << 3 : 128);
+			debug("%s\t%i%s%s%s", iw & 0x80? "save" : "restore",
+			    imm, iw & 0x40? ",ra" : "", iw & 0x20? ",s0" : "",
+			    iw & 0x10? ",s1" : "");
+			if (extended)
+				debug(" (xsregs=%i,aregs=%i)",
+				    (int)(ext >> 8) & 7, (int)ext & 0xf);
+			break;
+		case 5:
+			rz = iw & 7;  rz = rz < 2? rz + 16 : rz;
+			imm = ((iw >> 5) & 7) | (((iw >> 3) & 3) << 3);
+			if (imm == 0)
+				debug("nop");
+			else
+				debug("move\t%s,%s", regnames[imm],
+				    regnames[rz]);
+			break;
+		case 7:
+			debug("move\t%s,%s", regnames[ry], regnames[iw & 31]);
+			break;
+		default:debug("unimplemented mips16 I8 instruction");
+		}
+		break;
+	case 0x10:
+	case 0x11:
+	case 0x13:
+	case 0x14:
+	case 0x15:
+	case 0x17:
+	case 0x18:
+	case 0x19:
+	case 0x1b:
+		debug("%s\t%s,%i(%s)", ls_name[op - 0x10], regnames[ry],
+		    extended? imm : (int)(iw & 31) * ls_scale[op - 0x10],
+		    regnames[rx]);
+		break;
+	case 0x12:
+	case 0x16:
+	case 0x1a:
+		debug("%s\t%s,%i(%s)", ls_name[op - 0x10], regnames[rx],
+		    extended? imm : (int)(iw & 0xff) << 2,
+		    op == 0x16? "pc" : "sp");
+		break;
+	case 0x1c:
+		debug("%s\t%s,%s,%s", rrr_name[iw & 3], regnames[rz],
+		    regnames[rx], regnames[ry]);
+		break;
+	case 0x1d:
+		switch (iw & 31) {
+		case 0x00:
+			switch ((iw >> 5) & 7) {
+			case 0:	debug("jr\t%s", regnames[rx]); break;
+			case 1:	debug("jr\tra"); break;
+			case 2:	debug("jalr\t%s", regnames[rx]); break;
+			case 4:	debug("jrc\t%s", regnames[rx]); break;
+			case 5:	debug("jrc\tra"); break;
+			case 6:	debug("jalrc\t%s", regnames[rx]); break;
+			default:debug("unimplemented mips16 jump");
+			}
+			break;
+		case 0x05:
+			debug("break");
+			break;
+		case 0x0b:
+		case 0x0f:
+			debug("%s\t%s,%s", rr_name[iw & 31], regnames[rx],
+			    regnames[ry]);
+			break;
+		case 0x10:
+		case 0x12:
+			debug("%s\t%s", rr_name[iw & 31], regnames[rx]);
+			break;
+		case 0x11:
+			debug("%s\t%s", cnvt_name[(iw >> 5) & 7],
+			    regnames[rx]);
+			break;
+		case 0x04:
+		case 0x06:
+		case 0x07:
+		case 0x14:
+		case 0x16:
+		case 0x17:
+			debug("%s\t%s,%s", rr_name[iw & 31], regnames[ry],
+			    regnames[rx]);
+			break;
+		case 0x08:
+		case 0x13:
+			imm = (iw >> 8) & 7;
+			if (extended)
+				imm = ((ext >> 6) & 31) | (ext & 0x20);
+			else if (imm == 0)
+				imm = 8;
+			debug("%s\t%s,%i", rr_name[iw & 31], regnames[ry], imm);
+			break;
+		default:
+			debug("%s\t%s,%s", rr_name[iw & 31], regnames[rx],
+			    regnames[ry]);
+		}
+		break;
+	case 0x1f:
+		switch ((iw >> 8) & 7) {
+		case 0:
+		case 1:
+			debug("%s\t%s,%i(sp)", iw & 0x100? "sd" : "ld",
+			    regnames[ry], extended? imm : (int)(iw & 31) << 3);
+			break;
+		case 2:
+			debug("sd\tra,%i(sp)", extended? imm :
+			    (int)(iw & 0xff) << 3);
+			break;
+		case 3:
+			debug("daddiu\tsp,%i", extended? imm : (int8_t)iw << 3);
+			break;
+		case 4:
+			debug("ld\t%s,%i(pc)", regnames[ry], extended? imm :
+			    (int)(iw & 31) << 3);
+			break;
+		case 5:
+			debug("daddiu\t%s,%i", regnames[ry], extended? imm :
+			    (int32_t)(iw << 27) >> 27);
+			break;
+		default:
+			debug("daddiu\t%s,%s,%i", regnames[ry], iw & 0x100?
+			    "sp" : "pc", extended? imm : (int)(iw & 31) << 2);
+		}
+		break;
+	default:
+		debug("unimplemented mips16 op = 0x%02x", op);
+	}
+
+	debug("\n");
+	return len;
+}
+
+
 /*
  *  mips_cpu_disassemble_instr():
  *
@@ -698,6 +1002,7 @@ int mips_cpu_disassemble_instr(struct cpu *cpu, unsigned char *originstr,
 {
 	int hi6, special6, regimm5, sub;
 	int rt, rd, rs, sa, imm, copz, cache_op, which_cache, showtag;
+	int mips16;
 	uint64_t addr, offset;
 	uint32_t instrword;
 	unsigned char instr[4];
@@ -706,7 +1011,11 @@ int mips_cpu_disassemble_instr(struct cpu *cpu, unsigned char *originstr,
 	if (running)
 		dumpaddr = cpu->pc;
 
-	if ((dumpaddr & 3) != 0)
+	/*  (Like for ARM Thumb, the current mode is used also when
+	    disassembling from the debugger.)  */
+	mips16 = cpu->cd.mips.mips16;
+
+	if ((dumpaddr & (mips16? 1 : 3)) != 0)
 		printf("WARNING: Unaligned address!\n");
 
 	symbol = get_symbol_name(&cpu->machine->symbol_context,
@@ -722,6 +1031,10 @@ int mips_cpu_disassemble_instr(struct cpu *cpu, unsigned char *originstr,
 	else
 		debug("%016"PRIx64, (uint64_t)dumpaddr);
 
+	if (mips16)
+		return mips_cpu_disassemble_mips16(cpu, originstr, running,
+		    dumpaddr);
+
 	memcpy(instr, originstr, sizeof(uint32_t));
 
 	/*
@@ -1231,6 +1544,7 @@ int mips_cpu_disassemble_instr(struct cpu *cpu, unsigned char *originstr,
 
 	case HI6_J:
 	case HI6_JAL:
+	case HI6_JALX:
 		imm = (((instr[3] & 3) << 24) + (instr[2] << 16) +
 		    (instr[1] << 8) + instr[0]) << 2;
 		addr = (dumpaddr + 4) & ~((1 << 28) - 1);
@@ -1497,7 +1811,7 @@ disasm_ret:
 void mips_cpu_register_dump(struct cpu *cpu, int gprs, int coprocs)
 {
 	int coprocnr, i, bits32;
-	uint64_t offset;
+	uint64_t offset, paddr;
 	char *symbol;
 	int bits128 = cpu->cd.mips.cpu_type.rev == MIPS_R5900;
 
@@ -1671,9 +1985,9 @@ void mips_cpu_register_dump(struct cpu *cpu, int gprs, int coprocs)
 		}
 	}
 
-	if (cpu->cd.mips.rmw) {
-		printf("cpu%i: Read-Modify-Write in progress, address "
-		    "0x%016"PRIx64"\n", cpu->cpu_id, cpu->cd.mips.rmw_addr);
+	if (memory_reservation_get(cpu, &paddr)) {
+		printf("cpu%i: Read-Modify-Write in progress, physical "
+		    "address 0x%016"PRIx64"\n", cpu->cpu_id, paddr);
 	}
 }
 
@@ -1893,14 +2207,22 @@ void mips_cpu_exception(struct cpu *cpu, int exccode, int tlb, uint64_t vaddr,
 		    " not setting EPC ]\n", cpu->cpu_id);  */
 	} else {
 		if (cpu->delay_slot) {
-			reg[COP0_EPC] = cpu->pc - 4;
+			reg[COP0_EPC] = cpu->pc - (cpu->cd.mips.mips16?
+			    cpu->cd.mips.mips16_jump_len : 4);
 			reg[COP0_CAUSE] |= CAUSE_BD;
 		} else {
 			reg[COP0_EPC] = cpu->pc;
 			reg[COP0_CAUSE] &= ~CAUSE_BD;
 		}
+
+		/*  The ISA mode is kept in bit 0 of the EPC:  */
+		if (cpu->cd.mips.mips16)
+			reg[COP0_EPC] |= 1;
 	}
 
+	/*  Exception handlers are always entered in 32-bit mode:  */
+	cpu->cd.mips.mips16 = 0;
+
 	if (cpu->delay_slot)
 		cpu->delay_slot = EXCEPTION_IN_DELAY_SLOT;
 	else
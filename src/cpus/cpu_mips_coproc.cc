@@ -59,7 +59,7 @@ static const char *regnames[] = MIPS_REGISTER_NAMES;
  */
 static void initialize_cop0_config(struct cpu *cpu, struct mips_coproc *c)
 {
-	const int m16 = 0;	/*  TODO: MIPS16 support  */
+	const int m16 = cpu->cd.mips.mips16_available;
 	int IB, DB, SB, IC, DC, SC, IA, DA;
 
 	/*  Generic case for MIPS32/64:  */
@@ -348,6 +348,90 @@ static void initialize_cop1(struct cpu *cpu, struct mips_coproc *c)
 }
 
 
+/*
+ *  tlb_hash_chain(), tlb_asid_chain():
+ *
+ *  Return a pointer to the head of the hash chain, or the per-ASID list,
+ *  that a TLB entry belongs to (see cpu_mips.h). Global entries are not
+ *  in any per-ASID list, so tlb_asid_chain() returns NULL for them.
+ */
+static uint16_t *tlb_hash_chain(struct cpu *cpu, struct mips_coproc *cp,
+	struct mips_tlb *tlb)
+{
+	if (cpu->cd.mips.cpu_type.mmu_model == MMU3K)
+		return &cp->tlb_hash[MIPS_TLB_HASH(MIPS_TLB_VPN(1, tlb->hi),
+		    tlb->lo0 & R2K3K_ENTRYLO_G? MIPS_TLB_GLOBAL_ASID :
+		    (tlb->hi & R2K3K_ENTRYHI_ASID_MASK) >>
+		    R2K3K_ENTRYHI_ASID_SHIFT)];
+
+	if (cpu->cd.mips.cpu_type.rev == MIPS_R4100 ||
+	    (tlb->mask & PAGEMASK_MASK) != 0)
+		return &cp->tlb_large;
+
+	return &cp->tlb_hash[MIPS_TLB_HASH(MIPS_TLB_VPN(0, tlb->hi),
+	    tlb->hi & TLB_G? MIPS_TLB_GLOBAL_ASID : tlb->hi & ENTRYHI_ASID)];
+}
+static uint16_t *tlb_asid_chain(struct cpu *cpu, struct mips_coproc *cp,
+	struct mips_tlb *tlb)
+{
+	if (cpu->cd.mips.cpu_type.mmu_model == MMU3K) {
+		if (tlb->lo0 & R2K3K_ENTRYLO_G)
+			return NULL;
+		return &cp->tlb_asid[(tlb->hi & R2K3K_ENTRYHI_ASID_MASK) >>
+		    R2K3K_ENTRYHI_ASID_SHIFT];
+	}
+
+	if (tlb->hi & TLB_G)
+		return NULL;
+	return &cp->tlb_asid[tlb->hi & ENTRYHI_ASID];
+}
+
+
+/*
+ *  tlb_index_add(), tlb_index_remove():
+ *
+ *  Add a TLB entry to, or remove it from, the TLB lookup index. Since the
+ *  chains that an entry belongs to depend on its contents, an entry must be
+ *  removed before it is modified, and added again afterwards.
+ */
+static void tlb_index_add(struct cpu *cpu, struct mips_coproc *cp, int index)
+{
+	struct mips_tlb *tlb = &cp->tlbs[index];
+	uint16_t *headp = tlb_hash_chain(cpu, cp, tlb);
+
+	tlb->hash_next = *headp;
+	*headp = index + 1;
+
+	headp = tlb_asid_chain(cpu, cp, tlb);
+	if (headp != NULL) {
+		tlb->asid_next = *headp;
+		*headp = index + 1;
+	} else
+		tlb->asid_next = 0;
+}
+static void tlb_index_remove(struct cpu *cpu, struct mips_coproc *cp,
+	int index)
+{
+	struct mips_tlb *tlb = &cp->tlbs[index];
+	uint16_t *p = tlb_hash_chain(cpu, cp, tlb);
+
+	while (*p != 0 && *p != index + 1)
+		p = &cp->tlbs[*p - 1].hash_next;
+	if (*p != 0)
+		*p = tlb->hash_next;
+
+	p = tlb_asid_chain(cpu, cp, tlb);
+	if (p != NULL) {
+		while (*p != 0 && *p != index + 1)
+			p = &cp->tlbs[*p - 1].asid_next;
+		if (*p != 0)
+			*p = tlb->asid_next;
+	}
+
+	tlb->hash_next = tlb->asid_next = 0;
+}
+
+
 /*
  *  mips_coproc_new():
  *
@@ -356,6 +440,7 @@ static void initialize_cop1(struct cpu *cpu, struct mips_coproc *c)
 struct mips_coproc *mips_coproc_new(struct cpu *cpu, int coproc_nr)
 {
 	struct mips_coproc *c;
+	int i;
 
 	CHECK_ALLOCATION(c = (struct mips_coproc *) malloc(sizeof(struct mips_coproc)));
 	memset(c, 0, sizeof(struct mips_coproc));
@@ -365,6 +450,8 @@ struct mips_coproc *mips_coproc_new(struct cpu *cpu, int coproc_nr)
 	if (coproc_nr == 0) {
 		c->nr_of_tlbs = cpu->cd.mips.cpu_type.nr_of_tlb_entries;
 		c->tlbs = (struct mips_tlb *) zeroed_alloc(c->nr_of_tlbs * sizeof(struct mips_tlb));
+		for (i=0; i<c->nr_of_tlbs; i++)
+			tlb_index_add(cpu, c, i);
 
 		/*
 		 *  Start with nothing in the status register. This makes sure
@@ -446,6 +533,8 @@ void mips_coproc_tlb_set_entry(struct cpu *cpu, int entrynr, int size,
 		exit(1);
 	}
 
+	tlb_index_remove(cpu, cpu->cd.mips.coproc[0], entrynr);
+
 	switch (cpu->cd.mips.cpu_type.mmu_model) {
 	case MMU3K:
 		if (size != 4096) {
@@ -497,32 +586,45 @@ void mips_coproc_tlb_set_entry(struct cpu *cpu, int entrynr, int size,
 		    ((cachealgo1 << ENTRYLO_C_SHIFT) & ENTRYLO_C_MASK);
 		/*  TODO: R4100, 1KB pages etc  */
 	}
+
+	tlb_index_add(cpu, cpu->cd.mips.coproc[0], entrynr);
 }
 
 
 /*
  *  invalidate_asid():
  *
- *  Go through all entries in the TLB. If an entry has a matching asid, is
- *  valid, and is not global (i.e. the ASID matters), then its virtual address
- *  translation is invalidated.
+ *  Go through the TLB entries in the per-ASID list for asid, i.e. entries
+ *  which have a matching asid and are not global (i.e. the ASID matters).
+ *  If such an entry is valid, then its virtual address translation is
+ *  removed from the translation caches. The translations are kept resident
+ *  (see INVALIDATE_ASID in cpu_dyntrans.cc), and are reused if the CPU
+ *  switches back to asid later on. Finally, the translation caches are
+ *  switched to new_asid.
  *
- *  Note: In the R3000 case, the asid argument is shifted 6 bits.
+ *  Note: In the R3000 case, the asid arguments are shifted 6 bits.
  */
-static void invalidate_asid(struct cpu *cpu, unsigned int asid)
+static void invalidate_asid(struct cpu *cpu, unsigned int asid,
+	unsigned int new_asid)
 {
 	struct mips_coproc *cp = cpu->cd.mips.coproc[0];
-	unsigned int i, ntlbs = cp->nr_of_tlbs;
 	struct mips_tlb *tlb = cp->tlbs;
+	int i;
+
+	/*  EntryHi may have been changed by tlbr, without switching the
+	    translation caches. Only translations which were actually made
+	    while asid was active may be kept resident:  */
+	cpu->cd.mips.vph_asid = asid;
 
 	if (cpu->cd.mips.cpu_type.mmu_model == MMU3K) {
-		for (i=0; i<ntlbs; i++)
+		i = cp->tlb_asid[asid >> R2K3K_ENTRYHI_ASID_SHIFT] - 1;
+		for (; i >= 0; i = tlb[i].asid_next - 1)
 			if ((tlb[i].hi & R2K3K_ENTRYHI_ASID_MASK) == asid
 			    && (tlb[i].lo0 & R2K3K_ENTRYLO_V)
 			    && !(tlb[i].lo0 & R2K3K_ENTRYLO_G)) {
 				cpu->invalidate_translation_caches(cpu,
 				    tlb[i].hi & R2K3K_ENTRYHI_VPN_MASK,
-				    INVALIDATE_VADDR);
+				    INVALIDATE_VADDR | INVALIDATE_ASID);
 			}
 	} else {
 		int non4kpages = 0;
@@ -538,7 +640,8 @@ static void invalidate_asid(struct cpu *cpu, unsigned int asid)
 			topbit <<= 39;
 		}
 
-		for (i=0; i<ntlbs; i++) {
+		i = cp->tlb_asid[asid & ENTRYHI_ASID] - 1;
+		for (; i >= 0; i = tlb[i].asid_next - 1) {
 			if (tlb[i].mask != 0 && tlb[i].mask != 0x1800) {
 				non4kpages = 1;
 				continue;
@@ -554,10 +657,12 @@ static void invalidate_asid(struct cpu *cpu, unsigned int asid)
 
 				if (tlb[i].lo0 & ENTRYLO_V)
 					cpu->invalidate_translation_caches(cpu,
-					    vaddr0, INVALIDATE_VADDR);
+					    vaddr0, INVALIDATE_VADDR |
+					    INVALIDATE_ASID);
 				if (tlb[i].lo1 & ENTRYLO_V)
 					cpu->invalidate_translation_caches(cpu,
-					    vaddr1, INVALIDATE_VADDR);
+					    vaddr1, INVALIDATE_VADDR |
+					    INVALIDATE_ASID);
 			}
 		}
 
@@ -566,6 +671,8 @@ static void invalidate_asid(struct cpu *cpu, unsigned int asid)
 			    0, INVALIDATE_ALL);
 		}
 	}
+
+	cpu->invalidate_translation_caches(cpu, new_asid, INVALIDATE_ASID);
 }
 
 
@@ -658,7 +765,7 @@ void coproc_register_write(struct cpu *cpu,
 	uint64_t tmp = *ptr;
 	uint64_t tmp2 = 0, old;
 	int inval = 0;
-	unsigned int old_asid;
+	unsigned int old_asid, new_asid;
 	uint64_t oldmode;
 
 	switch (cp->coproc_nr) {
@@ -805,6 +912,7 @@ hz = 100.0;
 			case MMU3K:
 				old_asid = cp->reg[COP0_ENTRYHI] &
 				    R2K3K_ENTRYHI_ASID_MASK;
+				new_asid = tmp & R2K3K_ENTRYHI_ASID_MASK;
 				if ((cp->reg[COP0_ENTRYHI] &
 				    R2K3K_ENTRYHI_ASID_MASK) !=
 				    (tmp & R2K3K_ENTRYHI_ASID_MASK))
@@ -812,6 +920,7 @@ hz = 100.0;
 				break;
 			default:
 				old_asid = cp->reg[COP0_ENTRYHI] & ENTRYHI_ASID;
+				new_asid = tmp & ENTRYHI_ASID;
 				if ((cp->reg[COP0_ENTRYHI] & ENTRYHI_ASID) !=
 				    (tmp & ENTRYHI_ASID))
 					inval = 1;
@@ -819,7 +928,7 @@ hz = 100.0;
 			}
 
 			if (inval)
-				invalidate_asid(cpu, old_asid);
+				invalidate_asid(cpu, old_asid, new_asid);
 
 			unimpl = 0;
 			if (cpu->cd.mips.cpu_type.mmu_model == MMU3K &&
@@ -1019,7 +1128,17 @@ static void fpu_store_float_value(struct mips_coproc *cp, int fd,
 	double nf, int fmt, int nan)
 {
 	int ieee_fmt = mips_fmt_to_ieee_fmt[fmt];
-	uint64_t r = ieee_store_float_value(nf, ieee_fmt, nan);
+	uint64_t r;
+	float f;
+
+	/*  Round to single precision, in the current rounding mode:  */
+	if (fmt == COP1_FMT_S && !nan) {
+		f = nf;
+		if (!isinf(f))
+			nf = f;
+	}
+
+	r = ieee_store_float_value(nf, ieee_fmt, nan);
 
 	/*
 	 *  TODO: This is for 32-bit mode. It has to be updated later
@@ -1050,6 +1169,10 @@ static void fpu_store_float_value(struct mips_coproc *cp, int fd,
  *
  *  Only FPU_OP_C (compare) returns anything of interest, 1 for true, 0 for
  *  false.
+ *
+ *  Arithmetic operations are done in the rounding mode selected in the FCSR,
+ *  and the host's exception flags are copied to the FCSR's Cause and Flags
+ *  fields afterwards. (TODO: Trap when the corresponding Enable bit is set.)
  */
 static int fpu_op(struct cpu *cpu, struct mips_coproc *cp, int op, int fmt,
 	int ft, int fs, int fd, int cond, int output_fmt)
@@ -1057,6 +1180,8 @@ static int fpu_op(struct cpu *cpu, struct mips_coproc *cp, int op, int fmt,
 	/*  Potentially two input registers, fs and ft  */
 	struct ieee_float_value float_value[2];
 	int unordered, nan, ieee_fmt = mips_fmt_to_ieee_fmt[fmt];
+	int rm = cp->fcr[MIPS_FPU_FCSR] & MIPS_FCSR_RM, exc = 0;
+	int arith = op != FPU_OP_C && op != FPU_OP_MOV;
 	uint64_t fs_v = 0;
 	double nf;
 
@@ -1079,6 +1204,9 @@ static int fpu_op(struct cpu *cpu, struct mips_coproc *cp, int op, int fmt,
 		ieee_interpret_float_value(v, &float_value[1], ieee_fmt);
 	}
 
+	if (arith)
+		ieee_fenv_begin(rm);
+
 	switch (op) {
 	case FPU_OP_ADD:
 		nf = float_value[0].f + float_value[1].f;
@@ -1109,6 +1237,9 @@ static int fpu_op(struct cpu *cpu, struct mips_coproc *cp, int op, int fmt,
 			fatal("DIV by zero !!!!\n");
 			nf = 0.0;	/*  TODO  */
 			nan = 1;
+			if (float_value[1].f == 0.0)
+				exc = float_value[0].f == 0.0?
+				    IEEE_EXC_INVALID : IEEE_EXC_DIVBYZERO;
 		}
 		/*  debug("  div: %f / %f = %f\n",
 		    float_value[0].f, float_value[1].f, nf);  */
@@ -1123,6 +1254,7 @@ static int fpu_op(struct cpu *cpu, struct mips_coproc *cp, int op, int fmt,
 			    float_value[0].f);
 			nf = 0.0;	/*  TODO  */
 			nan = 1;
+			exc = IEEE_EXC_INVALID;
 		}
 		/*  debug("  sqrt: %f => %f\n", float_value[0].f, nf);  */
 		fpu_store_float_value(cp, fd, nf, output_fmt, nan);
@@ -1141,6 +1273,8 @@ static int fpu_op(struct cpu *cpu, struct mips_coproc *cp, int op, int fmt,
 		break;
 	case FPU_OP_CVT:
 		nf = float_value[0].f;
+		if (output_fmt == COP1_FMT_W || output_fmt == COP1_FMT_L)
+			nf = rint(nf);
 		/*  debug("  cvt: %f => %f\n", float_value[0].f, nf);  */
 		fpu_store_float_value(cp, fd, nf, output_fmt,
 		    float_value[0].nan);
@@ -1249,6 +1383,13 @@ static int fpu_op(struct cpu *cpu, struct mips_coproc *cp, int op, int fmt,
 		fatal("fpu_op(): unimplemented op %i\n", op);
 	}
 
+	if (arith) {
+		exc |= ieee_fenv_end(rm);
+		cp->fcr[MIPS_FPU_FCSR] &= ~MIPS_FCSR_CAUSE;
+		cp->fcr[MIPS_FPU_FCSR] |= (exc << MIPS_FCSR_CAUSE_SHIFT)
+		    | (exc << MIPS_FCSR_FLAGS_SHIFT);
+	}
+
 	return 0;
 }
 
@@ -1748,10 +1889,9 @@ void coproc_tlbwri(struct cpu *cpu, int randomflag)
 		oldvaddr = cp->tlbs[index].hi & R2K3K_ENTRYHI_VPN_MASK;
 		oldvaddr = (int32_t) oldvaddr;
 
-		if (cp->tlbs[index].lo0 & R2K3K_ENTRYLO_V &&
-		    (cp->tlbs[index].lo0 & R2K3K_ENTRYLO_G ||
-		    (cp->tlbs[index].hi & R2K3K_ENTRYHI_ASID_MASK) ==
-		    (cp->reg[COP0_ENTRYHI] & R2K3K_ENTRYHI_ASID_MASK) ))
+		/*  Translations for other ASIDs may be resident in the
+		    translation caches too, so the ASID doesn't matter:  */
+		if (cp->tlbs[index].lo0 & R2K3K_ENTRYLO_V)
 			cpu->invalidate_translation_caches(cpu, oldvaddr,
 			    INVALIDATE_VADDR);
 
@@ -1831,6 +1971,8 @@ void coproc_tlbwri(struct cpu *cpu, int randomflag)
 
 	/*  Write the new entry:  */
 
+	tlb_index_remove(cpu, cp, index);
+
 	if (cpu->cd.mips.cpu_type.mmu_model == MMU3K) {
 		uint32_t vaddr, paddr;
 		int wf = cp->reg[COP0_ENTRYLO0] & R2K3K_ENTRYLO_D? 1 : 0;
@@ -1838,6 +1980,7 @@ void coproc_tlbwri(struct cpu *cpu, int randomflag)
 
 		cp->tlbs[index].hi = cp->reg[COP0_ENTRYHI];
 		cp->tlbs[index].lo0 = cp->reg[COP0_ENTRYLO0];
+		tlb_index_add(cpu, cp, index);
 
 		vaddr =  cp->reg[COP0_ENTRYHI] & R2K3K_ENTRYHI_VPN_MASK;
 		paddr = cp->reg[COP0_ENTRYLO0] & R2K3K_ENTRYLO_PFN_MASK;
@@ -1851,9 +1994,6 @@ void coproc_tlbwri(struct cpu *cpu, int randomflag)
 			    INVALIDATE_PADDR);
 		}
 
-		/*  Set new last_written_tlb_index hint:  */
-		cpu->cd.mips.last_written_tlb_index = index;
-
 		if (cp->reg[COP0_STATUS] & MIPS1_ISOL_CACHES) {
 			fatal("Wow! Interesting case; tlbw* while caches"
 			    " are isolated. TODO\n");
@@ -1956,6 +2096,8 @@ void coproc_tlbwri(struct cpu *cpu, int randomflag)
 				cp->tlbs[index].hi |= TLB_G;
 		}
 
+		tlb_index_add(cpu, cp, index);
+
 		/*
 		 *  Invalidate any code translations, if we are writing Dirty
 		 *  pages to the TLB:  (TODO: 4KB hardcoded... ugly)
@@ -1988,9 +2130,6 @@ void coproc_tlbwri(struct cpu *cpu, int randomflag)
 		if (memblock != NULL && cp->reg[COP0_ENTRYLO1] & ENTRYLO_V)
 			cpu->update_translation_table(cpu, vaddr1, memblock,
 			    wf1, paddr1);
-
-		/*  Set new last_written_tlb_index hint:  */
-		cpu->cd.mips.last_written_tlb_index = index;
 	}
 }
 
@@ -2011,7 +2150,7 @@ void coproc_eret(struct cpu *cpu)
 		cpu->cd.mips.coproc[0]->reg[COP0_STATUS] &= ~STATUS_EXL;
 	}
 
-	cpu->cd.mips.rmw = 0;	/*  the "LL bit"  */
+	memory_reservation_clear(cpu);	/*  the "LL bit"  */
 }
 
 
@@ -1134,6 +1134,80 @@ X(jal_trace)
 }
 
 
+/*
+ *  jalx:  Jump and link, and exchange to MIPS16 mode.
+ *
+ *  arg[0] = lowest 28 bits of new pc.
+ *  arg[1] = offset from start of page to the jalx instruction + 8
+ */
+X(jalx)
+{
+	MODE_int_t old_pc = cpu->pc;
+	cpu->delay_slot = TO_BE_DELAYED;
+	cpu->pc &= ~((MIPS_IC_ENTRIES_PER_PAGE-1)<<MIPS_INSTR_ALIGNMENT_SHIFT);
+	cpu->cd.mips.gpr[31] = (MODE_int_t)cpu->pc + (int32_t)ic->arg[1];
+	ic[1].f(cpu, ic+1);
+	cpu->n_translated_instrs ++;
+	if (!(cpu->delay_slot & EXCEPTION_IN_DELAY_SLOT)) {
+		/*  Note: Must be non-delayed when jumping to the new pc:  */
+		cpu->delay_slot = NOT_DELAYED;
+		old_pc &= ~0x0fffffff;
+		cpu->pc = old_pc | (int32_t)ic->arg[0] | 1;
+		if (cpu->machine->show_trace_tree)
+			cpu_functioncall_trace(cpu, cpu->pc & ~1);
+		quick_pc_to_pointers(cpu);
+	} else
+		cpu->delay_slot = NOT_DELAYED;
+}
+
+
+/*
+ *  jal_native:  Jump and link to a guest routine which is run natively
+ *
+ *  arg[0] = lowest 28 bits of new pc
+ *  arg[1] = offset from start of page to the instruction after the delay slot
+ *  arg[2] = native routine (NATIVE_ROUTINE_xxx)
+ *
+ *  The delay slot is executed first, since it usually sets up one of the
+ *  arguments. If the routine can't be run natively, the jump is then done
+ *  as for a normal jal. Otherwise, execution continues after the delay slot,
+ *  as if the routine had returned.
+ */
+X(jal_native)
+{
+	MODE_int_t old_pc = cpu->pc;
+	uint64_t args[3], retval;
+
+	cpu->delay_slot = TO_BE_DELAYED;
+	cpu->pc &= ~((MIPS_IC_ENTRIES_PER_PAGE-1)<<MIPS_INSTR_ALIGNMENT_SHIFT);
+	cpu->cd.mips.gpr[31] = (MODE_int_t)cpu->pc + (int32_t)ic->arg[1];
+	ic[1].f(cpu, ic+1);
+	cpu->n_translated_instrs ++;
+	if (cpu->delay_slot & EXCEPTION_IN_DELAY_SLOT) {
+		cpu->delay_slot = NOT_DELAYED;
+		return;
+	}
+
+	/*  Note: Must be non-delayed when jumping to the new pc:  */
+	cpu->delay_slot = NOT_DELAYED;
+
+	args[0] = cpu->cd.mips.gpr[MIPS_GPR_A0];
+	args[1] = cpu->cd.mips.gpr[MIPS_GPR_A1];
+	args[2] = cpu->cd.mips.gpr[MIPS_GPR_A2];
+
+	if (native_routine_run(cpu, ic->arg[2], args, &retval,
+	    DYNTRANS_NATIVE_HOST_PAGE)) {
+		cpu->cd.mips.gpr[MIPS_GPR_V0] = (MODE_int_t)retval;
+		cpu->cd.mips.next_ic = ic + 2;
+		return;
+	}
+
+	old_pc &= ~0x03ffffff;
+	cpu->pc = old_pc | (int32_t)ic->arg[0];
+	quick_pc_to_pointers(cpu);
+}
+
+
 /*
  *  cache:  Cache operation.
  */
@@ -1141,8 +1215,8 @@ X(cache)
 {
 	/*  TODO: Implement cache operations.  */
 
-	/*  Make sure the rmw bit is cleared:  */
-	cpu->cd.mips.rmw = 0;
+	/*  Make sure the LL bit is cleared:  */
+	memory_reservation_clear(cpu);
 }
 
 
@@ -2155,7 +2229,7 @@ X(eret)
 
 	quick_pc_to_pointers(cpu);
 
-	cpu->cd.mips.rmw = 0;   /*  the "LL bit"  */
+	memory_reservation_clear(cpu);	/*  the "LL bit"  */
 }
 
 
@@ -2269,6 +2343,9 @@ X(rdhwr_cpunum)
  *
  *  A Store-conditional instruction ends the sequence.
  *
+ *  The reservation itself is kept by memory_rw(), keyed by physical address
+ *  (see memory_reservation_set() in memory.cc).
+ *
  *  arg[0] = ptr to rt
  *  arg[1] = ptr to rs
  *  arg[2] = int32_t imm
@@ -2292,14 +2369,11 @@ X(ll)
 	}
 
 	if (!cpu->memory_rw(cpu, cpu->mem, addr, word,
-	    sizeof(word), MEM_READ, CACHE_DATA)) {
+	    sizeof(word), MEM_READ, CACHE_DATA | MEMORY_LOAD_LINKED)) {
 		/*  An exception occurred.  */
 		return;
 	}
 
-	cpu->cd.mips.rmw = 1;
-	cpu->cd.mips.rmw_addr = addr;
-	cpu->cd.mips.rmw_len = sizeof(word);
 	if (cpu->cd.mips.cpu_type.exc_model != MMU10K)
 		cpu->cd.mips.coproc[0]->reg[COP0_LLADDR] =
 		    (addr >> 4) & 0xffffffffULL;
@@ -2330,14 +2404,11 @@ X(lld)
 	}
 
 	if (!cpu->memory_rw(cpu, cpu->mem, addr, word,
-	    sizeof(word), MEM_READ, CACHE_DATA)) {
+	    sizeof(word), MEM_READ, CACHE_DATA | MEMORY_LOAD_LINKED)) {
 		/*  An exception occurred.  */
 		return;
 	}
 
-	cpu->cd.mips.rmw = 1;
-	cpu->cd.mips.rmw_addr = addr;
-	cpu->cd.mips.rmw_len = sizeof(word);
 	if (cpu->cd.mips.cpu_type.exc_model != MMU10K)
 		cpu->cd.mips.coproc[0]->reg[COP0_LLADDR] =
 		    (addr >> 4) & 0xffffffffULL;
@@ -2357,7 +2428,7 @@ X(sc)
 {
 	MODE_int_t addr = reg(ic->arg[1]) + (int32_t)ic->arg[2];
 	uint64_t r = reg(ic->arg[0]);
-	int low_pc, i;
+	int low_pc, res;
 	uint8_t word[sizeof(uint32_t)];
 
 	/*  Synch. PC and store using slow memory_rw():  */
@@ -2378,44 +2449,29 @@ X(sc)
 		word[3]=r; word[2]=r>>8; word[1]=r>>16; word[0]=r>>24;
 	}
 
-	/*  If rmw is 0, then the store failed.  (This cache-line was written
-	    to by someone else.)  */
-	if (cpu->cd.mips.rmw == 0 || (MODE_int_t)cpu->cd.mips.rmw_addr != addr
-	    || cpu->cd.mips.rmw_len != sizeof(word)) {
+	/*  Without a reservation, the store fails without accessing
+	    memory at all:  */
+	if (!memory_reservation_get(cpu, NULL)) {
 		reg(ic->arg[0]) = 0;
-		cpu->cd.mips.rmw = 0;
 		return;
 	}
 
-	if (!cpu->memory_rw(cpu, cpu->mem, addr, word,
-	    sizeof(word), MEM_WRITE, CACHE_DATA)) {
+	/*  The store also fails if the reservation was lost, i.e. if the
+	    granule was written to by someone else, or if the data changed:  */
+	res = cpu->memory_rw(cpu, cpu->mem, addr, word, sizeof(word),
+	    MEM_WRITE, CACHE_DATA | MEMORY_STORE_CONDITIONAL);
+	if (res == MEMORY_ACCESS_FAILED) {
 		/*  An exception occurred.  */
 		return;
 	}
 
-	/*  We succeeded. Let's invalidate everybody else's store to this
-	    cache line:  */
-	for (i=0; i<cpu->machine->ncpus; i++) {
-		if (cpu->machine->cpus[i]->cd.mips.rmw) {
-			uint64_t yaddr = addr, xaddr = cpu->machine->cpus[i]->
-			    cd.mips.rmw_addr;
-			uint64_t mask = ~(cpu->machine->cpus[i]->
-			    cd.mips.cache_linesize[CACHE_DATA] - 1);
-			xaddr &= mask;
-			yaddr &= mask;
-			if (xaddr == yaddr)
-				cpu->machine->cpus[i]->cd.mips.rmw = 0;
-		}
-	}
-
-	reg(ic->arg[0]) = 1;
-	cpu->cd.mips.rmw = 0;
+	reg(ic->arg[0]) = res == MEMORY_ACCESS_OK;
 }
 X(scd)
 {
 	MODE_int_t addr = reg(ic->arg[1]) + (int32_t)ic->arg[2];
 	uint64_t r = reg(ic->arg[0]);
-	int low_pc, i;
+	int low_pc, res;
 	uint8_t word[sizeof(uint64_t)];
 
 	/*  Synch. PC and store using slow memory_rw():  */
@@ -2438,38 +2494,23 @@ X(scd)
 		word[3]=r>>32; word[2]=r>>40; word[1]=r>>48; word[0]=r>>56;
 	}
 
-	/*  If rmw is 0, then the store failed.  (This cache-line was written
-	    to by someone else.)  */
-	if (cpu->cd.mips.rmw == 0 || (MODE_int_t)cpu->cd.mips.rmw_addr != addr
-	    || cpu->cd.mips.rmw_len != sizeof(word)) {
+	/*  Without a reservation, the store fails without accessing
+	    memory at all:  */
+	if (!memory_reservation_get(cpu, NULL)) {
 		reg(ic->arg[0]) = 0;
-		cpu->cd.mips.rmw = 0;
 		return;
 	}
 
-	if (!cpu->memory_rw(cpu, cpu->mem, addr, word,
-	    sizeof(word), MEM_WRITE, CACHE_DATA)) {
+	/*  The store also fails if the reservation was lost, i.e. if the
+	    granule was written to by someone else, or if the data changed:  */
+	res = cpu->memory_rw(cpu, cpu->mem, addr, word, sizeof(word),
+	    MEM_WRITE, CACHE_DATA | MEMORY_STORE_CONDITIONAL);
+	if (res == MEMORY_ACCESS_FAILED) {
 		/*  An exception occurred.  */
 		return;
 	}
 
-	/*  We succeeded. Let's invalidate everybody else's store to this
-	    cache line:  */
-	for (i=0; i<cpu->machine->ncpus; i++) {
-		if (cpu->machine->cpus[i]->cd.mips.rmw) {
-			uint64_t yaddr = addr, xaddr = cpu->machine->cpus[i]->
-			    cd.mips.rmw_addr;
-			uint64_t mask = ~(cpu->machine->cpus[i]->
-			    cd.mips.cache_linesize[CACHE_DATA] - 1);
-			xaddr &= mask;
-			yaddr &= mask;
-			if (xaddr == yaddr)
-				cpu->machine->cpus[i]->cd.mips.rmw = 0;
-		}
-	}
-
-	reg(ic->arg[0]) = 1;
-	cpu->cd.mips.rmw = 0;
+	reg(ic->arg[0]) = res == MEMORY_ACCESS_OK;
 }
 
 
@@ -2613,6 +2654,13 @@ X(ei_r5900)
  *  s:	addiu	rX,rX,4			rX = arg[0] and arg[1]
  *	bne	rY,rX,s  (or rX,rY,s)	rt=arg[1], rs=arg[0]
  *	sw	rZ,-4(rX)		rt=arg[0], rs=arg[1]
+ *
+ *  or the 64-bit variant, daddiu rX,rX,8 + bne + sd rZ,-8(rX). (The size
+ *  is taken from the immediate, arg[2].)
+ *
+ *  All of the words up to rY, or to the end of the page, are filled at once.
+ *  Pages with translated code never have host_store pointers, so there is
+ *  nothing to invalidate.
  */
 X(sw_loop)
 {
@@ -2620,13 +2668,17 @@ X(sw_loop)
 	uint64_t *rYp = (uint64_t *) ic[1].arg[0];
 	MODE_uint_t rY, bytes_to_write;
 	unsigned char *page;
-	int partial = 0;
+	int size = ic->arg[2], partial = 0;
 
-	page = cpu->cd.mips.host_store[rX >> 12];
+	page = DYNTRANS_NATIVE_HOST_PAGE(cpu, rX, 1);
 
 	/*  Fallback:  */
-	if (cpu->delay_slot || page == NULL || (rX & 3) != 0 || rZ != 0) {
-		instr(addiu)(cpu, ic);
+	if (cpu->delay_slot || page == NULL || (rX & (size - 1)) != 0 ||
+	    (size == 4 && (MODE_int_t)(int32_t)rX != (MODE_int_t)rX)) {
+		if (size == 4)
+			instr(addiu)(cpu, ic);
+		else
+			instr(daddiu)(cpu, ic);
 		return;
 	}
 
@@ -2635,25 +2687,102 @@ X(sw_loop)
 
 	rY = reg(rYp);
 
+	/*  Fill to the end of the page, if rY is not reached on this page:  */
 	bytes_to_write = rY - rX;
-	if ((rX & 0xfff) + bytes_to_write > 0x1000) {
+	if (bytes_to_write == 0 || (bytes_to_write & (size - 1)) != 0 ||
+	    (rX & 0xfff) + bytes_to_write > 0x1000) {
 		bytes_to_write = 0x1000 - (rX & 0xfff);
 		partial = 1;
 	}
 
-	/*  printf("rX = %08x\n", (int)rX);
-	    printf("rY = %08x\n", (int)rY);
-	    printf("rZ = %08x\n", (int)rZ);
-	    printf("%i bytes\n", (int)bytes_to_write);  */
-
-	memset(page + (rX & 0xfff), 0, bytes_to_write);
+	native_fill_pattern(page + (rX & 0xfff), rZ, size,
+	    cpu->byte_order == EMUL_LITTLE_ENDIAN, bytes_to_write);
 
-	reg(ic->arg[0]) = rX + bytes_to_write;
+	if (size == 4)
+		reg(ic->arg[0]) = (int32_t) (rX + bytes_to_write);
+	else
+		reg(ic->arg[0]) = rX + bytes_to_write;
 
-	cpu->n_translated_instrs += bytes_to_write / 4 * 3 - 1;
+	cpu->n_translated_instrs += bytes_to_write / size * 3 - 1;
 	cpu->cd.mips.next_ic = partial?
 	    (struct mips_instr_call *) &ic[0] :
 	    (struct mips_instr_call *) &ic[3];
+	cpu->native_routine_hits[NATIVE_ROUTINE_FILL_LOOP] ++;
+}
+
+
+/*
+ *  lw_sw_loop:
+ *
+ *  s:	lw	rT,0(rS)
+ *	addiu	rS,rS,4
+ *	sw	rT,0(rD)
+ *	bne	rS,rE,s  (or rE,rS,s)
+ *	addiu	rD,rD,4
+ *
+ *  Copies all of the words up to rE, or up to the end of the source or
+ *  destination page, at once. When the destination overlaps the source from
+ *  above, the loop replicates data instead of copying it; that case is left
+ *  to the individual instructions.
+ */
+X(lw_sw_loop)
+{
+	MODE_uint_t rS = reg(ic[0].arg[1]), rD = reg(ic[2].arg[1]);
+	uint64_t *rEp = (uint64_t *) ic[3].arg[0];
+	MODE_uint_t rE, bytes, max_bytes;
+	unsigned char *src_page, *dst_page;
+	uint32_t last_word;
+	int partial = 0;
+
+	if (rEp == (uint64_t *) ic[0].arg[1])
+		rEp = (uint64_t *) ic[3].arg[1];
+
+	rE = reg(rEp);
+
+	bytes = rE - rS;
+	max_bytes = 0x1000 - ((rS & 0xfff) > (rD & 0xfff)?
+	    (rS & 0xfff) : (rD & 0xfff));
+	if (bytes == 0 || (bytes & 3) != 0 || bytes > max_bytes) {
+		bytes = max_bytes;
+		partial = 1;
+	}
+
+	src_page = DYNTRANS_NATIVE_HOST_PAGE(cpu, rS, 0);
+	dst_page = DYNTRANS_NATIVE_HOST_PAGE(cpu, rD, 1);
+
+	/*  Fallback:  */
+	if (cpu->delay_slot || src_page == NULL || dst_page == NULL ||
+	    ((rS | rD) & 3) != 0 || (MODE_uint_t)(rD - rS) < bytes ||
+	    (MODE_int_t)(int32_t)rS != (MODE_int_t)rS ||
+	    (MODE_int_t)(int32_t)rD != (MODE_int_t)rD) {
+#ifdef MODE32
+		mips32_loadstore
+#else
+		mips_loadstore
+#endif
+		    [(cpu->byte_order == EMUL_LITTLE_ENDIAN? 0 : 16) + 5]
+		    (cpu, ic);
+		return;
+	}
+
+	memmove(dst_page + (rD & 0xfff), src_page + (rS & 0xfff), bytes);
+
+	/*  rT is left with the last word that was copied:  */
+	memcpy(&last_word, dst_page + (rD & 0xfff) + bytes - 4, 4);
+	if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
+		last_word = LE32_TO_HOST(last_word);
+	else
+		last_word = BE32_TO_HOST(last_word);
+
+	reg(ic[0].arg[0]) = (int32_t) last_word;
+	reg(ic[0].arg[1]) = (int32_t) (rS + bytes);
+	reg(ic[2].arg[1]) = (int32_t) (rD + bytes);
+
+	cpu->n_translated_instrs += bytes / 4 * 5 - 1;
+	cpu->cd.mips.next_ic = partial?
+	    (struct mips_instr_call *) &ic[0] :
+	    (struct mips_instr_call *) &ic[5];
+	cpu->native_routine_hits[NATIVE_ROUTINE_COPY_LOOP] ++;
 }
 
 
@@ -2708,6 +2837,7 @@ X(netbsd_r3k_picache_do_inv)
 
 	reg(ic[3].arg[0]) = ry;
 	cpu->n_translated_instrs += (ry - rx + 4) / 4 * 3 + 4;
+	cpu->native_routine_hits[NATIVE_ROUTINE_CACHE_INV] ++;
 
 	/*  Run the last mtc0 instruction:  */
 	cpu->cd.mips.next_ic = ic + 8;
@@ -2827,9 +2957,10 @@ X(netbsd_strlen)
 	reg(ic[2].arg[0]) = rv;
 
 	/*  Done with the loop? Or continue on the next rx page?  */
-	if (rv == 0)
+	if (rv == 0) {
 		cpu->cd.mips.next_ic = ic + 4;
-	else
+		cpu->native_routine_hits[NATIVE_ROUTINE_STRLEN_LOOP] ++;
+	} else
 		cpu->cd.mips.next_ic = ic;
 }
 #endif
@@ -3044,39 +3175,6 @@ X(end_of_page2)
 /*****************************************************************************/
 
 
-/*
- *  Combine:  Memory fill loop (addiu, bne, sw)
- *
- *  s:	addiu	rX,rX,4
- *	bne	rY,rX,s
- *	sw	rZ,-4(rX)
- */
-void COMBINE(sw_loop)(struct cpu *cpu, struct mips_instr_call *ic, int low_addr)
-{
-	int n_back = (low_addr >> MIPS_INSTR_ALIGNMENT_SHIFT)
-	    & (MIPS_IC_ENTRIES_PER_PAGE - 1);
-
-	/*  Only for 32-bit virtual address translation so far.  */
-	if (!cpu->is_32bit)
-		return;
-
-	if (n_back < 2)
-		return;
-
-	if (ic[-2].f == instr(addiu) && ic[-2].arg[0] == ic[-2].arg[1] &&
-	    (int32_t)ic[-2].arg[2] == 4 &&
-	    ic[-1].f == instr(bne_samepage) &&
-	    (ic[-1].arg[0] == ic[-2].arg[0] ||
-		ic[-1].arg[1] == ic[-2].arg[0]) &&
-	    ic[-1].arg[0] != ic[-1].arg[1] &&
-	    ic[-1].arg[2] == (size_t) &ic[-2] &&
-	    ic[0].arg[0] != ic[0].arg[1] &&
-	    ic[0].arg[1] == ic[-2].arg[0] && (int32_t)ic[0].arg[2] == -4) {
-		ic[-2].f = instr(sw_loop);
-	}
-}
-
-
 /*  Only for 32-bit virtual address translation so far.  */
 #ifdef MODE32
 /*
@@ -3180,6 +3278,110 @@ void COMBINE(multi_lw)(struct cpu *cpu, struct mips_instr_call *ic,
 #endif
 
 
+/*
+ *  Combine:  Memory fill loop (addiu, bne, sw)
+ *
+ *  s:	addiu	rX,rX,4
+ *	bne	rY,rX,s
+ *	sw	rZ,-4(rX)
+ *
+ *  (Also used for the corresponding daddiu, bne, sd loop, with the size
+ *  being 8 instead of 4.)
+ */
+void COMBINE(store_loop)(struct cpu *cpu, struct mips_instr_call *ic,
+	int low_addr, int size)
+{
+	int n_back = (low_addr >> MIPS_INSTR_ALIGNMENT_SHIFT)
+	    & (MIPS_IC_ENTRIES_PER_PAGE - 1);
+
+	if (n_back < 2 || !cpu->machine->allow_native_routines)
+		return;
+
+	if (ic[-2].f == (size == 4? instr(addiu) : instr(daddiu)) &&
+	    ic[-2].arg[0] == ic[-2].arg[1] &&
+	    (int32_t)ic[-2].arg[2] == size &&
+	    ic[-1].f == instr(bne_samepage) &&
+	    (ic[-1].arg[0] == ic[-2].arg[0] ||
+		ic[-1].arg[1] == ic[-2].arg[0]) &&
+	    ic[-1].arg[0] != ic[-1].arg[1] &&
+	    ic[-1].arg[2] == (size_t) &ic[-2] &&
+	    ic[0].arg[0] != ic[0].arg[1] &&
+	    ic[0].arg[1] == ic[-2].arg[0] && (int32_t)ic[0].arg[2] == -size) {
+		ic[-2].f = instr(sw_loop);
+	}
+}
+void COMBINE(sw_loop)(struct cpu *cpu, struct mips_instr_call *ic, int low_addr)
+{
+	COMBINE(store_loop)(cpu, ic, low_addr, sizeof(uint32_t));
+
+#ifdef MODE32
+	/*  Not a loop? Then check for multiple stores in a row:  */
+	if (ic[-2].f != instr(sw_loop))
+		COMBINE(multi_sw)(cpu, ic, low_addr);
+#endif
+}
+#ifndef MODE32
+void COMBINE(sd_loop)(struct cpu *cpu, struct mips_instr_call *ic, int low_addr)
+{
+	COMBINE(store_loop)(cpu, ic, low_addr, sizeof(uint64_t));
+}
+#endif
+
+
+/*
+ *  Combine:  Memory copy loop (lw, addiu, sw, bne, addiu)
+ *
+ *  s:	lw	rT,0(rS)
+ *	addiu	rS,rS,4
+ *	sw	rT,0(rD)
+ *	bne	rS,rE,s
+ *	addiu	rD,rD,4
+ *
+ *  Returns 1 if the loop was recognized.
+ */
+int COMBINE(lw_sw_loop)(struct cpu *cpu, struct mips_instr_call *ic,
+	int low_addr)
+{
+	int n_back = (low_addr >> MIPS_INSTR_ALIGNMENT_SHIFT)
+	    & (MIPS_IC_ENTRIES_PER_PAGE - 1);
+	int be = cpu->byte_order == EMUL_LITTLE_ENDIAN? 0 : 16;
+	void (**loadstore)(struct cpu *, struct mips_instr_call *) =
+#ifdef MODE32
+	    mips32_loadstore;
+#else
+	    mips_loadstore;
+#endif
+	size_t rT, rS, rD, rE;
+
+	if (n_back < 4 || !cpu->machine->allow_native_routines)
+		return 0;
+
+	if (ic[-4].f != loadstore[be + 5] || ic[-2].f != loadstore[be + 12])
+		return 0;
+
+	rT = ic[-4].arg[0]; rS = ic[-4].arg[1]; rD = ic[0].arg[0];
+	rE = ic[-1].arg[0] == rS? ic[-1].arg[1] : ic[-1].arg[0];
+
+	if (ic[-4].arg[2] != 0 ||
+	    ic[-3].f != instr(addiu) || ic[-3].arg[0] != rS ||
+	    ic[-3].arg[1] != rS || (int32_t)ic[-3].arg[2] != 4 ||
+	    ic[-2].arg[0] != rT || ic[-2].arg[1] != rD || ic[-2].arg[2] != 0 ||
+	    ic[-1].f != instr(bne_samepage) ||
+	    ic[-1].arg[2] != (size_t) &ic[-4] ||
+	    (ic[-1].arg[0] != rS && ic[-1].arg[1] != rS) ||
+	    ic[0].arg[1] != rD || (int32_t)ic[0].arg[2] != 4)
+		return 0;
+
+	/*  All of the registers must be different:  */
+	if (rT == rS || rT == rD || rT == rE || rS == rD || rS == rE ||
+	    rD == rE)
+		return 0;
+
+	ic[-4].f = instr(lw_sw_loop);
+	return 1;
+}
+
+
 /*
  *  Combine:  NetBSD/pmax 3.0 R2000/R3000 physical cache invalidation loop
  *
@@ -3201,7 +3403,7 @@ void COMBINE(netbsd_r3k_cache_inv)(struct cpu *cpu,
 	int n_back = (low_addr >> MIPS_INSTR_ALIGNMENT_SHIFT)
 	    & (MIPS_IC_ENTRIES_PER_PAGE - 1);
 
-	if (n_back < 8)
+	if (n_back < 8 || !cpu->machine->allow_native_routines)
 		return;
 
 	if (ic[-8].f == instr(mtc0) && ic[-8].arg[1] == COP0_STATUS &&
@@ -3266,7 +3468,8 @@ void COMBINE(nop)(struct cpu *cpu, struct mips_instr_call *ic, int low_addr)
 		return;
 	}
 
-	if ((ic[-3].f == mips32_loadstore[1] ||
+	if (cpu->machine->allow_native_routines &&
+	    (ic[-3].f == mips32_loadstore[1] ||
 	    ic[-3].f == mips32_loadstore[16 + 1]) &&
 	    ic[-3].arg[2] == 0 &&
 	    ic[-3].arg[0] == ic[-1].arg[0] && ic[-3].arg[1] == ic[-2].arg[0] &&
@@ -3373,6 +3576,9 @@ void COMBINE(addiu)(struct cpu *cpu, struct mips_instr_call *ic, int low_addr)
 	if (n_back < 2)
 		return;
 
+	if (COMBINE(lw_sw_loop)(cpu, ic, low_addr))
+		return;
+
 	if (ic[-2].f == instr(addiu) &&
 	    ic[-1].f == instr(bne_samepage)) {
 		ic[-2].f = instr(addiu_bne_samepage_addiu);
@@ -3428,6 +3634,9 @@ void COMBINE(b_daddiu)(struct cpu *cpu, struct mips_instr_call *ic,
 }
 
 
+#include "cpu_mips_instr_mips16.cc"
+
+
 /*****************************************************************************/
 
 
@@ -3448,7 +3657,7 @@ X(to_be_translated)
 	int main_opcode, rt, rs, rd, sa, s6, x64 = 0, s10;
 	int in_crosspage_delayslot = 0;
 	void (*samepage_function)(struct cpu *, struct mips_instr_call *);
-	int store, signedness, size;
+	int store, signedness, size, native;
 
 	/*  Figure out the (virtual) address of the instruction:  */
 	low_pc = ((size_t)ic - (size_t)cpu->cd.mips.cur_ic_page)
@@ -3969,6 +4178,7 @@ X(to_be_translated)
 
 	case HI6_J:
 	case HI6_JAL:
+	case HI6_JALX:
 		switch (main_opcode) {
 		case HI6_J:
 			ic->f = instr(j);
@@ -3981,9 +4191,27 @@ X(to_be_translated)
 			else
 				ic->f = instr(jal);
 			break;
+		case HI6_JALX:
+			if (cpu->cd.mips.mips16_available)
+				ic->f = instr(jalx);
+			else
+				ic->f = instr(reserved);
+			break;
 		}
 		ic->arg[0] = (iword & 0x03ffffff) << 2;
 		ic->arg[1] = (addr & 0xffc) + 8;
+
+		/*
+		 *  Calls to routines which can be run natively. (The delay
+		 *  slot and the instruction after it must be on this page.)
+		 */
+		if (main_opcode == HI6_JAL && (addr & 0xffc) < 0xff8 &&
+		    (native = native_routine_lookup(cpu->machine,
+		    (MODE_int_t)((addr & ~0x03ffffff) | ic->arg[0]))) !=
+		    NATIVE_ROUTINE_NONE) {
+			ic->f = instr(jal_native);
+			ic->arg[2] = native;
+		}
 		if (cpu->delay_slot) {
 			if (!cpu->translation_readahead)
 				fatal("TODO: branch in delay slot (=%i)? (3);"
@@ -4497,13 +4725,16 @@ X(to_be_translated)
 		if (!store && rt == MIPS_GPR_ZERO)
 			ic->arg[0] = (size_t)&cpu->cd.mips.scratch;
 
-		/*  Check for multiple loads or stores in a row using the same
-		    base register:  */
+		/*  Check for memory fill loops, and for multiple loads or
+		    stores in a row using the same base register:  */
+		if (main_opcode == HI6_SW)
+			cpu->cd.mips.combination_check = COMBINE(sw_loop);
 #ifdef MODE32
 		if (main_opcode == HI6_LW)
 			cpu->cd.mips.combination_check = COMBINE(multi_lw);
-		if (main_opcode == HI6_SW)
-			cpu->cd.mips.combination_check = COMBINE(multi_sw);
+#else
+		if (main_opcode == HI6_SD)
+			cpu->cd.mips.combination_check = COMBINE(sd_loop);
 #endif
 		break;
 
@@ -0,0 +1,1389 @@
+/*
+ *  Copyright (C) 2010  Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ *
+ *
+ *  MIPS16 instructions (the 16-bit encoding of the MIPS16e ASE).
+ *  Included from cpu_mips_instr.cc, once for each mode.
+ *
+ *  MIPS16 code is translated into translation pages of its own, each covering
+ *  2 KB (see cpu_mips.h and mips16_pc_to_pointers()). Just like for 32-bit
+ *  code, the pc is not updated while running within a page, so instructions
+ *  which need it call mips16_sync_pc() first.
+ *
+ *  EXTENDed instructions, and JAL/JALX, are 32 bits long. They are translated
+ *  into the entry of their first halfword, and the entry of the second
+ *  halfword is set to mips16_skip. An instruction like that which begins in
+ *  the last halfword of a page is translated, executed, and then thrown away,
+ *  each time it is run.
+ *
+ *  Jumps with a delay slot store the length of the jump in mips16_jump_len,
+ *  since mips_cpu_exception() needs it for the EPC.
+ *
+ *  The 64-bit instructions (ld, sd, daddiu, and so on) cause Reserved
+ *  Instruction exceptions on 32-bit CPUs.
+ */
+
+
+#undef M16
+#ifdef MODE32
+#define	M16(n)		mips32_mips16_ ## n
+#else
+#define	M16(n)		mips_mips16_ ## n
+#endif
+
+/*  Start of the current MIPS16 translation page:  */
+#define	MIPS16_PAGE_BASE(cpu)	((cpu)->pc & ~(uint64_t)(MIPS16_PAGE_SIZE - 1))
+
+/*  MIPS16 register numbers 0..7 are s0, s1, v0, v1, a0, a1, a2, a3:  */
+#define	MIPS16_REG(r)		((r) < 2? (r) + 16 : (r))
+
+/*  The T (condition) register is t8:  */
+#define	MIPS16_REG_T		24
+
+
+/*
+ *  mips16_sync_pc():
+ *
+ *  Synchronize the program counter with the instruction call ic.
+ */
+static inline void M16(sync_pc)(struct cpu *cpu, struct mips_instr_call *ic)
+{
+	int low_pc = ((size_t)ic - (size_t)cpu->cd.mips.cur_ic_page)
+	    / sizeof(struct mips_instr_call);
+	cpu->pc = MIPS16_PAGE_BASE(cpu) +
+	    (low_pc << MIPS16_INSTR_ALIGNMENT_SHIFT);
+}
+
+
+/*
+ *  mips16_pc_to_pointers():
+ *
+ *  MIPS16 version of mips_pc_to_pointers(). If bit 0 of the pc is set, then
+ *  this is a switch into MIPS16 mode.
+ *
+ *  The MIPS16 translation pages are not entered into the phys_page[] array,
+ *  so they are always looked up in the translation cache by their physical
+ *  address, like the ARM Thumb pages.
+ */
+void M16(pc_to_pointers)(struct cpu *cpu)
+{
+	struct mips_tc_physpage *ppp;
+	MODE_uint_t cached_pc;
+	uint64_t physaddr = 0, key;
+	uint32_t physpage_ofs, *physpage_entryp;
+	unsigned char *host_load;
+	int i;
+
+	if (cpu->pc & 1) {
+		cpu->cd.mips.mips16 = 1;
+		cpu->pc &= ~1;
+	}
+
+	cached_pc = cpu->pc;
+
+#ifdef MODE32
+	host_load = cpu->cd.mips.host_load[DYNTRANS_ADDR_TO_PAGENR(cached_pc)];
+	if (host_load != NULL)
+		physaddr = cpu->cd.mips.phys_addr[
+		    DYNTRANS_ADDR_TO_PAGENR(cached_pc)];
+#else
+	{
+		const uint32_t mask1 = (1 << DYNTRANS_L1N) - 1;
+		const uint32_t mask2 = (1 << DYNTRANS_L2N) - 1;
+		const uint32_t mask3 = (1 << DYNTRANS_L3N) - 1;
+		uint32_t x1 = (cached_pc >> (64-DYNTRANS_L1N)) & mask1;
+		uint32_t x2 = (cached_pc >> (64-DYNTRANS_L1N-DYNTRANS_L2N))
+		    & mask2;
+		uint32_t x3 = (cached_pc >> (64-DYNTRANS_L1N-DYNTRANS_L2N-
+		    DYNTRANS_L3N)) & mask3;
+		struct DYNTRANS_L3_64_TABLE *l3 =
+		    cpu->cd.mips.l1_64[x1]->l3[x2];
+		host_load = l3->host_load[x3];
+		if (host_load != NULL)
+			physaddr = l3->phys_addr[x3];
+	}
+#endif
+
+	if (host_load == NULL) {
+		unsigned char *host_page;
+		uint64_t paddr;
+
+		if (!cpu->translate_v2p(cpu, (MODE_int_t)cached_pc, &paddr,
+		    FLAG_INSTR)) {
+			/*  The exception handler (32-bit code) has already
+			    been entered:  */
+			return;
+		}
+
+		physaddr = paddr & ~0xfff;
+		host_page = memory_paddr_to_hostaddr(cpu->mem, physaddr,
+		    MEM_READ);
+		if (host_page != NULL)
+			cpu->update_translation_table(cpu, cached_pc & ~0xfff,
+			    host_page, 0, physaddr);
+	}
+
+	key = (physaddr & ~0xfff) | MIPS16_PHYSPAGE_TAG(cached_pc);
+
+	physpage_entryp = &(((uint32_t *)cpu->translation_cache)
+	    [PAGENR_TO_TABLE_INDEX(DYNTRANS_ADDR_TO_PAGENR(key))]);
+	physpage_ofs = *physpage_entryp;
+	ppp = NULL;
+
+	while (physpage_ofs != 0) {
+		ppp = (struct mips_tc_physpage *)
+		    (cpu->translation_cache + physpage_ofs);
+		if (ppp->physaddr == key)
+			break;
+		physpage_ofs = ppp->next_ofs;
+	}
+
+	if (physpage_ofs == 0) {
+		/*  (This may evict a page from the same chain, so the
+		    chain is read afterwards.)  */
+		physpage_ofs = DYNTRANS_TC_ALLOCATE(cpu, physaddr);
+		ppp = (struct mips_tc_physpage *)
+		    (cpu->translation_cache + physpage_ofs);
+
+		ppp->physaddr = key;
+		for (i=0; i<MIPS_IC_ENTRIES_PER_PAGE; i++)
+			ppp->ics[i].f = instr(mips16_to_be_translated);
+		ppp->ics[MIPS_IC_ENTRIES_PER_PAGE].f =
+		    instr(mips16_end_of_page);
+		ppp->ics[MIPS_IC_ENTRIES_PER_PAGE + 1].f =
+		    instr(mips16_end_of_page2);
+
+		ppp->next_ofs = *physpage_entryp;
+		*physpage_entryp = physpage_ofs;
+	}
+
+	ppp->referenced = 1;
+
+	/*  See mips_pc_to_pointers_generic():  */
+	if (ppp->translations_bitmap == 0)
+		cpu->invalidate_translation_caches(cpu, physaddr,
+		    JUST_MARK_AS_NON_WRITABLE | INVALIDATE_PADDR);
+
+	cpu->cd.mips.cur_ic_page = &ppp->ics[0];
+	cpu->cd.mips.next_ic = cpu->cd.mips.cur_ic_page +
+	    MIPS16_PC_TO_IC_ENTRY(cached_pc);
+}
+
+
+/*
+ *  mips16_interwork():
+ *
+ *  Continue execution at cpu->pc, in MIPS16 mode if bit 0 is set, otherwise
+ *  in 32-bit mode.
+ */
+static void M16(interwork)(struct cpu *cpu)
+{
+	if (cpu->pc & 1) {
+		M16(pc_to_pointers)(cpu);
+		return;
+	}
+
+	cpu->cd.mips.mips16 = 0;
+	quick_pc_to_pointers(cpu);
+}
+
+
+/*
+ *  mips16_host_page(), mips16_load(), mips16_store():
+ *
+ *  Load or store len (1, 2, 4, or 8) bytes. Aligned accesses to pages in the
+ *  host translation arrays are done directly, everything else goes through
+ *  memory_rw(). Returns 0 if there was an exception.
+ */
+static inline unsigned char *M16(host_page)(struct cpu *cpu,
+	MODE_uint_t addr, int writeflag)
+{
+#ifdef MODE32
+	if (writeflag)
+		return cpu->cd.mips.host_store[addr >> 12];
+	return cpu->cd.mips.host_load[addr >> 12];
+#else
+	const uint32_t mask1 = (1 << DYNTRANS_L1N) - 1;
+	const uint32_t mask2 = (1 << DYNTRANS_L2N) - 1;
+	const uint32_t mask3 = (1 << DYNTRANS_L3N) - 1;
+	uint32_t x1 = (addr >> (64-DYNTRANS_L1N)) & mask1;
+	uint32_t x2 = (addr >> (64-DYNTRANS_L1N-DYNTRANS_L2N)) & mask2;
+	uint32_t x3 = (addr >> (64-DYNTRANS_L1N-DYNTRANS_L2N-DYNTRANS_L3N))
+	    & mask3;
+	struct DYNTRANS_L3_64_TABLE *l3 = cpu->cd.mips.l1_64[x1]->l3[x2];
+	if (writeflag)
+		return l3->host_store[x3];
+	return l3->host_load[x3];
+#endif
+}
+static inline int M16(load)(struct cpu *cpu, struct mips_instr_call *ic,
+	MODE_int_t addr, int len, uint64_t *valuep)
+{
+	unsigned char *page = M16(host_page)(cpu, addr, 0);
+	unsigned char data[8];
+
+	if (addr & (len - 1)) {
+		M16(sync_pc)(cpu, ic);
+		mips_cpu_exception(cpu, EXCEPTION_ADEL, 0, addr, 0, 0, 0, 0);
+		return 0;
+	}
+
+	if (page != NULL) {
+		*valuep = memory_readmax64(cpu, page + (addr & 0xfff), len);
+		return 1;
+	}
+
+	M16(sync_pc)(cpu, ic);
+	if (!cpu->memory_rw(cpu, cpu->mem, addr, data, len, MEM_READ,
+	    CACHE_DATA)) {
+		/*  load failed, an exception was generated  */
+		return 0;
+	}
+
+	*valuep = memory_readmax64(cpu, data, len);
+	return 1;
+}
+static inline int M16(store)(struct cpu *cpu, struct mips_instr_call *ic,
+	MODE_int_t addr, int len, uint64_t value)
+{
+	unsigned char *page = M16(host_page)(cpu, addr, 1);
+	unsigned char data[8];
+
+	if (addr & (len - 1)) {
+		M16(sync_pc)(cpu, ic);
+		mips_cpu_exception(cpu, EXCEPTION_ADES, 0, addr, 0, 0, 0, 0);
+		return 0;
+	}
+
+	if (page != NULL) {
+		memory_writemax64(cpu, page + (addr & 0xfff), len, value);
+		return 1;
+	}
+
+	memory_writemax64(cpu, data, len, value);
+
+	M16(sync_pc)(cpu, ic);
+	return cpu->memory_rw(cpu, cpu->mem, addr, data, len, MEM_WRITE,
+	    CACHE_DATA);
+}
+
+
+/*
+ *  mips16_pc_relative():
+ *
+ *  The base address of a pc-relative instruction. In a delay slot, this is
+ *  the address of the jump instruction.
+ *
+ *  arg[1] = offset of the instruction, from the start of the page
+ */
+static inline uint64_t M16(pc_relative)(struct cpu *cpu,
+	struct mips_instr_call *ic)
+{
+	uint64_t pc = MIPS16_PAGE_BASE(cpu) + ic->arg[1];
+	if (cpu->delay_slot != NOT_DELAYED)
+		pc -= cpu->cd.mips.mips16_jump_len;
+	return pc;
+}
+
+
+/*****************************************************************************/
+
+
+/*
+ *  mips16_lb, lbu, lh, lhu, lw, lwu, ld, sb, sh, sw, sd:  Load/store
+ *
+ *  arg[0] = ptr to rt
+ *  arg[1] = ptr to the base register
+ *  arg[2] = (int32_t) offset
+ */
+#define	MIPS16_LOAD(n, len, type)					\
+	X(mips16_ ## n) {						\
+		uint64_t x;						\
+		if (M16(load)(cpu, ic, reg(ic->arg[1]) +		\
+		    (int32_t)ic->arg[2], len, &x))			\
+			reg(ic->arg[0]) = (type)x;			\
+	}
+#define	MIPS16_STORE(n, len)						\
+	X(mips16_ ## n) {						\
+		M16(store)(cpu, ic, reg(ic->arg[1]) +			\
+		    (int32_t)ic->arg[2], len, reg(ic->arg[0]));		\
+	}
+MIPS16_LOAD(lb, 1, int8_t)
+MIPS16_LOAD(lbu, 1, uint8_t)
+MIPS16_LOAD(lh, 2, int16_t)
+MIPS16_LOAD(lhu, 2, uint16_t)
+MIPS16_LOAD(lw, 4, int32_t)
+MIPS16_LOAD(lwu, 4, uint32_t)
+MIPS16_LOAD(ld, 8, uint64_t)
+MIPS16_STORE(sb, 1)
+MIPS16_STORE(sh, 2)
+MIPS16_STORE(sw, 4)
+MIPS16_STORE(sd, 8)
+
+
+/*
+ *  mips16_lwpc, mips16_ldpc:  Load word/doubleword, pc-relative
+ *  mips16_addiupc, mips16_daddiupc:  Add pc-relative address
+ *
+ *  arg[0] = ptr to rx (or ry)
+ *  arg[1] = offset of the instruction, from the start of the page
+ *  arg[2] = (int32_t) offset
+ */
+X(mips16_lwpc)
+{
+	uint64_t x;
+	if (M16(load)(cpu, ic, (M16(pc_relative)(cpu, ic) & ~3) +
+	    (int32_t)ic->arg[2], 4, &x))
+		reg(ic->arg[0]) = (int32_t)x;
+}
+X(mips16_ldpc)
+{
+	uint64_t x;
+	if (M16(load)(cpu, ic, (M16(pc_relative)(cpu, ic) & ~7) +
+	    (int32_t)ic->arg[2], 8, &x))
+		reg(ic->arg[0]) = x;
+}
+X(mips16_addiupc)
+{
+	reg(ic->arg[0]) = (int32_t)((M16(pc_relative)(cpu, ic) & ~3) +
+	    (int32_t)ic->arg[2]);
+}
+X(mips16_daddiupc)
+{
+	reg(ic->arg[0]) = (MODE_int_t)((M16(pc_relative)(cpu, ic) & ~3) +
+	    (int32_t)ic->arg[2]);
+}
+
+
+/*
+ *  mips16_save, mips16_restore:  Save or restore registers on the stack,
+ *                                and adjust the stack pointer.
+ *
+ *  arg[0] = the low 8 bits of the instruction, and the 11 bits of the
+ *           EXTEND prefix (if any) shifted left by 8
+ *  arg[1] = frame size, in bytes
+ *
+ *  The argument registers are saved first, into the caller's frame. Then
+ *  ra, the extra static registers (s2..s8), s1, s0, and the "static"
+ *  argument registers are saved below the old stack pointer, in that
+ *  order. restore reloads everything except the arguments.
+ */
+static int M16(save_restore_regs)(struct cpu *cpu, int bits, int *regs)
+{
+	int aregs = (bits >> 8) & 15, xsregs = (bits >> 16) & 7;
+	int nstatics, n = 0, i;
+	static const int xs[7] = { 18, 19, 20, 21, 22, 23, 30 };
+
+	if (bits & 0x40)
+		regs[n++] = MIPS_GPR_RA;
+	for (i=xsregs-1; i>=0; i--)
+		regs[n++] = xs[i];
+	if (bits & 0x10)
+		regs[n++] = 17;
+	if (bits & 0x20)
+		regs[n++] = 16;
+
+	nstatics = aregs == 11? 4 : (aregs == 14? 0 : aregs & 3);
+	for (i=0; i<nstatics; i++)
+		regs[n++] = MIPS_GPR_A3 - i;
+
+	return n;
+}
+X(mips16_save)
+{
+	int bits = ic->arg[0], regs[16], n, nargs, aregs, i;
+	MODE_int_t sp = cpu->cd.mips.gpr[MIPS_GPR_SP];
+
+	aregs = (bits >> 8) & 15;
+	nargs = aregs == 14? 4 : (aregs == 11? 0 : aregs >> 2);
+	for (i=0; i<nargs; i++)
+		if (!M16(store)(cpu, ic, sp + 4*i, 4,
+		    cpu->cd.mips.gpr[MIPS_GPR_A0 + i]))
+			return;
+
+	n = M16(save_restore_regs)(cpu, bits, regs);
+	for (i=0; i<n; i++)
+		if (!M16(store)(cpu, ic, sp - 4*(i+1), 4,
+		    cpu->cd.mips.gpr[regs[i]]))
+			return;
+
+	cpu->cd.mips.gpr[MIPS_GPR_SP] = (MODE_int_t)(sp - (int32_t)ic->arg[1]);
+}
+X(mips16_restore)
+{
+	int bits = ic->arg[0], regs[16], n, i;
+	MODE_int_t sp = cpu->cd.mips.gpr[MIPS_GPR_SP] + (int32_t)ic->arg[1];
+	uint64_t x;
+
+	n = M16(save_restore_regs)(cpu, bits, regs);
+	for (i=0; i<n; i++) {
+		if (!M16(load)(cpu, ic, sp - 4*(i+1), 4, &x))
+			return;
+		cpu->cd.mips.gpr[regs[i]] = (int32_t)x;
+	}
+
+	cpu->cd.mips.gpr[MIPS_GPR_SP] = sp;
+}
+
+
+/*****************************************************************************/
+
+
+/*
+ *  mips16_b:  Branch (to a different translated page)
+ *
+ *  arg[0] = offset from the start of the MIPS16 page
+ */
+X(mips16_b)
+{
+	cpu->pc = MIPS16_PAGE_BASE(cpu) + (int32_t)ic->arg[0];
+	M16(pc_to_pointers)(cpu);
+}
+
+
+/*
+ *  mips16_b_samepage:  Branch (to within the same translated page)
+ *
+ *  arg[0] = pointer to new mips_instr_call
+ */
+X(mips16_b_samepage)
+{
+	cpu->cd.mips.next_ic = (struct mips_instr_call *) ic->arg[0];
+}
+
+
+/*
+ *  mips16_beqz, mips16_bnez:  Branch if a register is (not) zero
+ *
+ *  arg[0] = ptr to rx (or to t8, for bteqz and btnez)
+ *  arg[1] = offset from the start of the MIPS16 page, or pointer to new
+ *           mips_instr_call for the samepage variants
+ */
+X(mips16_beqz)
+{
+	if (reg(ic->arg[0]) == 0) {
+		cpu->pc = MIPS16_PAGE_BASE(cpu) + (int32_t)ic->arg[1];
+		M16(pc_to_pointers)(cpu);
+	}
+}
+X(mips16_beqz_samepage)
+{
+	if (reg(ic->arg[0]) == 0)
+		cpu->cd.mips.next_ic = (struct mips_instr_call *) ic->arg[1];
+}
+X(mips16_bnez)
+{
+	if (reg(ic->arg[0]) != 0) {
+		cpu->pc = MIPS16_PAGE_BASE(cpu) + (int32_t)ic->arg[1];
+		M16(pc_to_pointers)(cpu);
+	}
+}
+X(mips16_bnez_samepage)
+{
+	if (reg(ic->arg[0]) != 0)
+		cpu->cd.mips.next_ic = (struct mips_instr_call *) ic->arg[1];
+}
+
+
+/*
+ *  mips16_jr, mips16_jalr:  Jump to a register [and link], with a delay slot
+ *  mips16_jrc, mips16_jalrc:  The same, without a delay slot
+ *
+ *  arg[0] = ptr to rx
+ *  arg[1] = offset of the following instruction, from the start of the page
+ *
+ *  The target is in 32-bit code unless bit 0 of it is set.
+ */
+X(mips16_jr)
+{
+	MODE_int_t rx = reg(ic->arg[0]);
+	cpu->delay_slot = TO_BE_DELAYED;
+	cpu->cd.mips.mips16_jump_len = sizeof(uint16_t);
+	ic[1].f(cpu, ic+1);
+	cpu->n_translated_instrs ++;
+	if (!(cpu->delay_slot & EXCEPTION_IN_DELAY_SLOT)) {
+		cpu->pc = rx;
+		if (cpu->machine->show_trace_tree &&
+		    ic->arg[0] == (size_t)&cpu->cd.mips.gpr[MIPS_GPR_RA])
+			cpu_functioncall_trace_return(cpu);
+		/*  Note: Must be non-delayed when jumping to the new pc:  */
+		cpu->delay_slot = NOT_DELAYED;
+		M16(interwork)(cpu);
+	} else
+		cpu->delay_slot = NOT_DELAYED;
+}
+X(mips16_jalr)
+{
+	MODE_int_t rx = reg(ic->arg[0]);
+	cpu->delay_slot = TO_BE_DELAYED;
+	cpu->cd.mips.mips16_jump_len = sizeof(uint16_t);
+	cpu->cd.mips.gpr[MIPS_GPR_RA] = (MODE_int_t)
+	    ((MIPS16_PAGE_BASE(cpu) + ic->arg[1]) | 1);
+	ic[1].f(cpu, ic+1);
+	cpu->n_translated_instrs ++;
+	if (!(cpu->delay_slot & EXCEPTION_IN_DELAY_SLOT)) {
+		cpu->pc = rx;
+		if (cpu->machine->show_trace_tree)
+			cpu_functioncall_trace(cpu, cpu->pc & ~1);
+		/*  Note: Must be non-delayed when jumping to the new pc:  */
+		cpu->delay_slot = NOT_DELAYED;
+		M16(interwork)(cpu);
+	} else
+		cpu->delay_slot = NOT_DELAYED;
+}
+X(mips16_jrc)
+{
+	cpu->pc = (MODE_int_t)reg(ic->arg[0]);
+	if (cpu->machine->show_trace_tree &&
+	    ic->arg[0] == (size_t)&cpu->cd.mips.gpr[MIPS_GPR_RA])
+		cpu_functioncall_trace_return(cpu);
+	M16(interwork)(cpu);
+}
+X(mips16_jalrc)
+{
+	MODE_int_t rx = reg(ic->arg[0]);
+	cpu->cd.mips.gpr[MIPS_GPR_RA] = (MODE_int_t)
+	    ((MIPS16_PAGE_BASE(cpu) + ic->arg[1]) | 1);
+	cpu->pc = rx;
+	if (cpu->machine->show_trace_tree)
+		cpu_functioncall_trace(cpu, cpu->pc & ~1);
+	M16(interwork)(cpu);
+}
+
+
+/*
+ *  mips16_jal, mips16_jalx:  Jump and link [and exchange to 32-bit mode]
+ *
+ *  arg[0] = lowest 28 bits of new pc
+ *  arg[1] = offset of the instruction after the delay slot, from the start
+ *           of the page
+ *
+ *  The delay slot is in ic[2], since ic[1] is the second half of the jal.
+ */
+X(mips16_jal)
+{
+	uint64_t ret = MIPS16_PAGE_BASE(cpu) + ic->arg[1];
+	cpu->delay_slot = TO_BE_DELAYED;
+	cpu->cd.mips.mips16_jump_len = sizeof(uint32_t);
+	cpu->cd.mips.gpr[MIPS_GPR_RA] = (MODE_int_t)(ret | 1);
+	ic[2].f(cpu, ic+2);
+	cpu->n_translated_instrs ++;
+	if (!(cpu->delay_slot & EXCEPTION_IN_DELAY_SLOT)) {
+		cpu->pc = (MODE_int_t)(((ret - 2) & ~(uint64_t)0x0fffffff)
+		    | (uint32_t)ic->arg[0]);
+		if (cpu->machine->show_trace_tree)
+			cpu_functioncall_trace(cpu, cpu->pc);
+		/*  Note: Must be non-delayed when jumping to the new pc:  */
+		cpu->delay_slot = NOT_DELAYED;
+		M16(pc_to_pointers)(cpu);
+	} else
+		cpu->delay_slot = NOT_DELAYED;
+}
+X(mips16_jalx)
+{
+	uint64_t ret = MIPS16_PAGE_BASE(cpu) + ic->arg[1];
+	cpu->delay_slot = TO_BE_DELAYED;
+	cpu->cd.mips.mips16_jump_len = sizeof(uint32_t);
+	cpu->cd.mips.gpr[MIPS_GPR_RA] = (MODE_int_t)(ret | 1);
+	ic[2].f(cpu, ic+2);
+	cpu->n_translated_instrs ++;
+	if (!(cpu->delay_slot & EXCEPTION_IN_DELAY_SLOT)) {
+		cpu->pc = (MODE_int_t)(((ret - 2) & ~(uint64_t)0x0fffffff)
+		    | (uint32_t)ic->arg[0]);
+		if (cpu->machine->show_trace_tree)
+			cpu_functioncall_trace(cpu, cpu->pc);
+		/*  Note: Must be non-delayed when jumping to the new pc:  */
+		cpu->delay_slot = NOT_DELAYED;
+		M16(interwork)(cpu);
+	} else
+		cpu->delay_slot = NOT_DELAYED;
+}
+
+
+/*
+ *  mips16_break, mips16_reserved:  Breakpoint, and reserved instruction
+ *                                  (e.g. a 64-bit one on a 32-bit CPU).
+ */
+X(mips16_break)
+{
+	M16(sync_pc)(cpu, ic);
+	mips_cpu_exception(cpu, EXCEPTION_BP, 0, 0, 0, 0, 0, 0);
+}
+X(mips16_reserved)
+{
+	M16(sync_pc)(cpu, ic);
+	mips_cpu_exception(cpu, EXCEPTION_RI, 0, 0, 0, 0, 0, 0);
+}
+
+
+/*
+ *  mips16_skip:  The second half of a 32-bit instruction, which has already
+ *                been executed as a whole.
+ */
+X(mips16_skip)
+{
+	cpu->n_translated_instrs --;
+}
+
+
+/*****************************************************************************/
+
+
+X(mips16_end_of_page)
+{
+	/*  Update the PC:  (offset 0, but on the next page)  */
+	cpu->pc = MIPS16_PAGE_BASE(cpu) + MIPS16_PAGE_SIZE;
+
+	/*  end_of_page doesn't count as an executed instruction:  */
+	cpu->n_translated_instrs --;
+
+	/*  Find the new physical page and update the translation pointers:  */
+	M16(pc_to_pointers)(cpu);
+
+	/*
+	 *  If this was the delay slot of a jump, then the delay slot is on
+	 *  the next page. (If there was an exception, then the jump takes
+	 *  care of that.)
+	 */
+	if (cpu->delay_slot == TO_BE_DELAYED)
+		cpu->cd.mips.next_ic->f(cpu, cpu->cd.mips.next_ic);
+}
+
+
+X(mips16_end_of_page2)
+{
+	/*  Like end_of_page, but after a 32-bit instruction which began in
+	    the last halfword of the page:  (offset 2, on the next page)  */
+	cpu->pc = MIPS16_PAGE_BASE(cpu) + MIPS16_PAGE_SIZE + sizeof(uint16_t);
+
+	cpu->n_translated_instrs --;
+
+	M16(pc_to_pointers)(cpu);
+
+	if (cpu->delay_slot == TO_BE_DELAYED)
+		cpu->cd.mips.next_ic->f(cpu, cpu->cd.mips.next_ic);
+}
+
+
+/*
+ *  mips_instr_mips16_to_be_translated():
+ *
+ *  Translate a MIPS16 instruction into a mips_instr_call, and then execute
+ *  it. This is the MIPS16 counterpart of to_be_translated, below.
+ */
+X(mips16_to_be_translated)
+{
+	uint64_t addr;
+	uint32_t iword, iword2 = 0, ext = 0;
+	unsigned char *page;
+	unsigned char ib[4];
+	int low_pc, op, rx, ry, rz, sa, sub, extended = 0, crosspage = 0;
+	int32_t imm, target;
+
+	/*  Figure out the address of the instruction:  */
+	low_pc = ((size_t)ic - (size_t)cpu->cd.mips.cur_ic_page)
+	    / sizeof(struct mips_instr_call);
+	addr = MIPS16_PAGE_BASE(cpu) +
+	    (low_pc << MIPS16_INSTR_ALIGNMENT_SHIFT);
+	cpu->pc = addr;
+
+	/*  Read the instruction (and the next halfword, if it is on the same
+	    MIPS16 page, for EXTEND and JAL):  */
+	memset(ib, 0, sizeof(ib));
+	page = M16(host_page)(cpu, addr, 0);
+
+	if (page != NULL) {
+		memcpy(ib, page + (addr & 0xfff),
+		    low_pc < MIPS_IC_ENTRIES_PER_PAGE - 1? 4 : 2);
+	} else {
+		if (!cpu->memory_rw(cpu, cpu->mem, addr, &ib[0],
+		    sizeof(uint16_t), MEM_READ, CACHE_INSTRUCTION)) {
+			fatal("mips16_to_be_translated(): "
+			    "read failed: TODO\n");
+			return;
+		}
+	}
+
+	if (cpu->byte_order == EMUL_LITTLE_ENDIAN) {
+		iword = ib[0] + (ib[1]<<8);
+		iword2 = ib[2] + (ib[3]<<8);
+	} else {
+		iword = ib[1] + (ib[0]<<8);
+		iword2 = ib[3] + (ib[2]<<8);
+	}
+
+	op = iword >> 11;
+
+	/*  The second half of a 32-bit instruction is not in ib?  */
+	if ((op == 0x1e || op == 0x03) &&
+	    (page == NULL || low_pc == MIPS_IC_ENTRIES_PER_PAGE - 1)) {
+		/*  (Not during read-ahead, since this may fail.)  */
+		if (cpu->translation_readahead)
+			return;
+
+		if (!cpu->memory_rw(cpu, cpu->mem, addr + sizeof(uint16_t),
+		    &ib[2], sizeof(uint16_t), MEM_READ, CACHE_INSTRUCTION)) {
+			/*  An exception was generated.  */
+			return;
+		}
+
+		if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
+			iword2 = ib[2] + (ib[3]<<8);
+		else
+			iword2 = ib[3] + (ib[2]<<8);
+
+		crosspage = low_pc == MIPS_IC_ENTRIES_PER_PAGE - 1;
+	}
+
+
+#define DYNTRANS_TO_BE_TRANSLATED_HEAD
+#include "cpu_dyntrans.cc"
+#undef  DYNTRANS_TO_BE_TRANSLATED_HEAD
+
+
+	if (op == 0x1e) {
+		/*  EXTEND: the immediate bits, and the real instruction  */
+		ext = iword & 0x7ff;
+		iword = iword2;
+		op = iword >> 11;
+		extended = 1;
+
+		if (op == 0x1e || op == 0x03)
+			goto bad;
+	}
+
+	/*  32-bit instructions are not allowed in delay slots:  */
+	if ((extended || op == 0x03) && cpu->delay_slot != NOT_DELAYED)
+		goto bad;
+
+	rx = MIPS16_REG((iword >> 8) & 7);
+	ry = MIPS16_REG((iword >> 5) & 7);
+	rz = MIPS16_REG((iword >> 2) & 7);
+
+	/*  The immediate value of most EXTENDed instructions:  */
+	imm = (int16_t)(((ext & 0x1f) << 11) | (ext & 0x7e0) | (iword & 0x1f));
+
+	/*
+	 *  Translate the instruction:
+	 *
+	 *  Note: None of the MIPS16 registers is the zero register, but
+	 *  mov32r can have it as its destination.
+	 */
+
+	switch (op) {
+
+	case 0x00:
+	case 0x01:
+		/*  addiu rx,sp,imm  or  addiu rx,pc,imm  */
+		if (!extended)
+			imm = (iword & 0xff) << 2;
+		if (op == 0x00) {
+			ic->f = instr(addiu);
+			ic->arg[0] = (size_t)&cpu->cd.mips.gpr[MIPS_GPR_SP];
+			ic->arg[1] = (size_t)&cpu->cd.mips.gpr[rx];
+		} else {
+			ic->f = instr(mips16_addiupc);
+			ic->arg[0] = (size_t)&cpu->cd.mips.gpr[rx];
+			ic->arg[1] = low_pc << MIPS16_INSTR_ALIGNMENT_SHIFT;
+		}
+		ic->arg[2] = imm;
+		break;
+
+	case 0x02:
+	case 0x04:
+	case 0x05:
+		/*  b, beqz, bnez  */
+		if (extended)
+			target = imm << 1;
+		else if (op == 0x02)
+			target = (int32_t)(iword << 21) >> 20;
+		else
+			target = (int8_t)iword << 1;
+		target += (low_pc << MIPS16_INSTR_ALIGNMENT_SHIFT) +
+		    (extended? 4 : 2);
+
+		if (op == 0x02) {
+			/*  Abort read-ahead on unconditional branches:  */
+			if (cpu->translation_readahead > 1)
+				cpu->translation_readahead = 1;
+
+			if (target >= 0 && target < MIPS16_PAGE_SIZE) {
+				ic->f = instr(mips16_b_samepage);
+				ic->arg[0] = (size_t)(cpu->cd.mips.cur_ic_page
+				    + (target >> MIPS16_INSTR_ALIGNMENT_SHIFT));
+			} else {
+				ic->f = instr(mips16_b);
+				ic->arg[0] = target;
+			}
+			break;
+		}
+
+		ic->arg[0] = (size_t)&cpu->cd.mips.gpr[rx];
+		goto conditional_branch;
+
+	case 0x03:
+		/*  jal, jalx  */
+		ic->f = iword & 0x400? instr(mips16_jalx) : instr(mips16_jal);
+		ic->arg[0] = (((iword & 0x1f) << 21) |
+		    (((iword >> 5) & 0x1f) << 16) | iword2) << 2;
+		ic->arg[1] = (low_pc << MIPS16_INSTR_ALIGNMENT_SHIFT) + 6;
+		break;
+
+	case 0x06:
+		/*  sll, srl, sra rx,ry,sa  */
+		sa = (iword >> 2) & 7;
+		if (extended)
+			sa = ((ext >> 6) & 31) | (ext & 0x20);
+		else if (sa == 0)
+			sa = 8;
+		switch (iword & 3) {
+		case 0:	ic->f = instr(sll); break;
+		case 1:	ic->f = instr(dsll); break;
+		case 2:	ic->f = instr(srl); break;
+		case 3:	ic->f = instr(sra); break;
+		}
+		if ((iword & 3) == 1 && cpu->is_32bit)
+			goto mips16_64bit;
+		ic->arg[0] = (size_t)&cpu->cd.mips.gpr[ry];
+		ic->arg[1] = sa;
+		ic->arg[2] = (size_t)&cpu->cd.mips.gpr[rx];
+		break;
+
+	case 0x07:
+	case 0x0f:
+	case 0x17:
+		/*  ld, sd, lwu ry,imm(rx)  */
+		if (cpu->is_32bit)
+			goto mips16_64bit;
+		ic->f = op == 0x07? instr(mips16_ld) : op == 0x0f?
+		    instr(mips16_sd) : instr(mips16_lwu);
+		ic->arg[0] = (size_t)&cpu->cd.mips.gpr[ry];
+		ic->arg[1] = (size_t)&cpu->cd.mips.gpr[rx];
+		ic->arg[2] = extended? imm : (iword & 31) << (op == 0x17? 2:3);
+		break;
+
+	case 0x08:
+		/*  addiu, daddiu ry,rx,imm  */
+		if (iword & 0x10 && cpu->is_32bit)
+			goto mips16_64bit;
+		if (extended)
+			imm = (int32_t)((((ext & 0xf) << 11) | (ext & 0x7f0) |
+			    (iword & 0xf)) << 17) >> 17;
+		else
+			imm = (int32_t)(iword << 28) >> 28;
+		ic->f = iword & 0x10? instr(daddiu) : instr(addiu);
+		ic->arg[0] = (size_t)&cpu->cd.mips.gpr[rx];
+		ic->arg[1] = (size_t)&cpu->cd.mips.gpr[ry];
+		ic->arg[2] = imm;
+		break;
+
+	case 0x09:
+	case 0x0a:
+	case 0x0b:
+	case 0x0d:
+	case 0x0e:
+		/*  addiu rx,imm; slti, sltiu, li, cmpi rx,imm  */
+		if (!extended)
+			imm = op == 0x09? (int8_t)iword : (iword & 0xff);
+		else if (op == 0x0d || op == 0x0e)
+			imm &= 0xffff;
+		ic->arg[0] = (size_t)&cpu->cd.mips.gpr[rx];
+		ic->arg[1] = (size_t)&cpu->cd.mips.gpr[MIPS16_REG_T];
+		ic->arg[2] = imm;
+		switch (op) {
+		case 0x09:
+			ic->f = instr(addiu);
+			ic->arg[1] = ic->arg[0];
+			break;
+		case 0x0a:
+			ic->f = instr(slti);
+			break;
+		case 0x0b:
+			ic->f = instr(sltiu);
+			break;
+		case 0x0d:
+			ic->f = instr(set);
+			ic->arg[1] = imm;
+			break;
+		case 0x0e:
+			ic->f = instr(xori);
+			break;
+		}
+		break;
+
+	case 0x0c:
+		/*  I8 instructions:  */
+		sub = (iword >> 8) & 7;
+		switch (sub) {
+
+		case 0:
+		case 1:
+			/*  bteqz, btnez  */
+			target = extended? imm << 1 : (int8_t)iword << 1;
+			target += (low_pc << MIPS16_INSTR_ALIGNMENT_SHIFT) +
+			    (extended? 4 : 2);
+			op = sub == 0? 0x04 : 0x05;
+			ic->arg[0] = (size_t)&cpu->cd.mips.gpr[MIPS16_REG_T];
+			goto conditional_branch;
+
+		case 2:
+			/*  sw ra,imm(sp)  */
+			ic->f = instr(mips16_sw);
+			ic->arg[0] = (size_t)&cpu->cd.mips.gpr[MIPS_GPR_RA];
+			ic->arg[1] = (size_t)&cpu->cd.mips.gpr[MIPS_GPR_SP];
+			ic->arg[2] = extended? imm : (iword & 0xff) << 2;
+			break;
+
+		case 3:
+			/*  addiu sp,imm  (adjsp)  */
+			ic->f = instr(addiu);
+			ic->arg[0] = ic->arg[1] =
+			    (size_t)&cpu->cd.mips.gpr[MIPS_GPR_SP];
+			ic->arg[2] = extended? imm : (int8_t)iword << 3;
+			break;
+
+		case 4:
+			/*  save, restore  */
+			ic->f = iword & 0x80? instr(mips16_save) :
+			    instr(mips16_restore);
+			ic->arg[0] = (iword & 0xff) | (ext << 8);
+			if (extended)
+				ic->arg[1] = ((ext & 0xf0) | (iword & 0xf))
+				    << 3;
+			else
+				ic->arg[1] = iword & 0xf? (iword & 0xf) << 3
+				    : 128;
+			break;
+
+		case 5:
+			/*  move r32,rz  */
+			if (extended)
+				goto bad;
+			sa = ((iword >> 5) & 7) | (((iword >> 3) & 3) << 3);
+			if (sa == MIPS_GPR_ZERO) {
+				ic->f = instr(nop);
+				break;
+			}
+			ic->f = instr(mov);
+			ic->arg[0] = (size_t)&cpu->cd.mips.gpr[
+			    MIPS16_REG(iword & 7)];
+			ic->arg[2] = (size_t)&cpu->cd.mips.gpr[sa];
+			break;
+
+		case 7:
+			/*  move ry,r32  */
+			if (extended)
+				goto bad;
+			ic->f = instr(mov);
+			ic->arg[0] = (size_t)&cpu->cd.mips.gpr[iword & 31];
+			ic->arg[2] = (size_t)&cpu->cd.mips.gpr[ry];
+			break;
+
+		default:goto bad;
+		}
+		break;
+
+	case 0x10:
+	case 0x11:
+	case 0x13:
+	case 0x14:
+	case 0x15:
+	case 0x18:
+	case 0x19:
+	case 0x1b:
+		/*  Load/store:  op ry,imm(rx)  */
+		switch (op) {
+		case 0x10: ic->f = instr(mips16_lb); sa = 0; break;
+		case 0x11: ic->f = instr(mips16_lh); sa = 1; break;
+		case 0x13: ic->f = instr(mips16_lw); sa = 2; break;
+		case 0x14: ic->f = instr(mips16_lbu); sa = 0; break;
+		case 0x15: ic->f = instr(mips16_lhu); sa = 1; break;
+		case 0x18: ic->f = instr(mips16_sb); sa = 0; break;
+		case 0x19: ic->f = instr(mips16_sh); sa = 1; break;
+		default:   ic->f = instr(mips16_sw); sa = 2; break;
+		}
+		ic->arg[0] = (size_t)&cpu->cd.mips.gpr[ry];
+		ic->arg[1] = (size_t)&cpu->cd.mips.gpr[rx];
+		ic->arg[2] = extended? imm : (iword & 31) << sa;
+		break;
+
+	case 0x12:
+	case 0x1a:
+		/*  lw, sw rx,imm(sp)  */
+		ic->f = op == 0x12? instr(mips16_lw) : instr(mips16_sw);
+		ic->arg[0] = (size_t)&cpu->cd.mips.gpr[rx];
+		ic->arg[1] = (size_t)&cpu->cd.mips.gpr[MIPS_GPR_SP];
+		ic->arg[2] = extended? imm : (iword & 0xff) << 2;
+		break;
+
+	case 0x16:
+		/*  lw rx,imm(pc)  */
+		ic->f = instr(mips16_lwpc);
+		ic->arg[0] = (size_t)&cpu->cd.mips.gpr[rx];
+		ic->arg[1] = low_pc << MIPS16_INSTR_ALIGNMENT_SHIFT;
+		ic->arg[2] = extended? imm : (iword & 0xff) << 2;
+		break;
+
+	case 0x1c:
+		/*  daddu, addu, dsubu, subu rz,rx,ry  */
+		if (extended)
+			goto bad;
+		if (!(iword & 1) && cpu->is_32bit)
+			goto mips16_64bit;
+		switch (iword & 3) {
+		case 0:	ic->f = instr(daddu); break;
+		case 1:	ic->f = instr(addu); break;
+		case 2:	ic->f = instr(dsubu); break;
+		case 3:	ic->f = instr(subu); break;
+		}
+		ic->arg[0] = (size_t)&cpu->cd.mips.gpr[rx];
+		ic->arg[1] = (size_t)&cpu->cd.mips.gpr[ry];
+		ic->arg[2] = (size_t)&cpu->cd.mips.gpr[rz];
+		break;
+
+	case 0x1d:
+		/*  RR instructions:  */
+		if (extended && (iword & 31) != 0x08 && (iword & 31) != 0x13)
+			goto bad;
+		ic->arg[0] = (size_t)&cpu->cd.mips.gpr[rx];
+		ic->arg[1] = (size_t)&cpu->cd.mips.gpr[ry];
+		ic->arg[2] = (size_t)&cpu->cd.mips.gpr[rx];
+
+		switch (iword & 31) {
+
+		case 0x00:
+			/*  jr, jalr, jrc, jalrc  */
+			sub = (iword >> 5) & 7;
+			if (sub & 1) {
+				if ((iword >> 8) & 7)
+					goto bad;
+				ic->arg[0] = (size_t)
+				    &cpu->cd.mips.gpr[MIPS_GPR_RA];
+			}
+			switch (sub) {
+			case 0:
+			case 1:	ic->f = instr(mips16_jr); break;
+			case 2:	ic->f = instr(mips16_jalr); break;
+			case 4:
+			case 5:	ic->f = instr(mips16_jrc); break;
+			case 6:	ic->f = instr(mips16_jalrc); break;
+			default:goto bad;
+			}
+			ic->arg[1] = (low_pc << MIPS16_INSTR_ALIGNMENT_SHIFT)
+			    + (sub & 4? 2 : 4);
+
+			if (cpu->delay_slot != NOT_DELAYED)
+				goto bad;
+
+			/*  Abort read-ahead on unconditional jumps (but
+			    translate the delay slot):  */
+			if (!(sub & 2) && cpu->translation_readahead >
+			    (sub & 4? 1 : 2))
+				cpu->translation_readahead = sub & 4? 1 : 2;
+			break;
+
+		case 0x02:
+		case 0x03:
+			/*  slt, sltu rx,ry  */
+			ic->f = (iword & 31) == 0x02? instr(slt) : instr(sltu);
+			ic->arg[2] = (size_t)&cpu->cd.mips.gpr[MIPS16_REG_T];
+			break;
+
+		case 0x04:
+		case 0x06:
+		case 0x07:
+		case 0x14:
+		case 0x16:
+		case 0x17:
+			/*  sllv, srlv, srav, dsllv, dsrlv, dsrav ry,rx  */
+			switch (iword & 31) {
+			case 0x04: ic->f = instr(sllv); break;
+			case 0x06: ic->f = instr(srlv); break;
+			case 0x07: ic->f = instr(srav); break;
+			case 0x14: ic->f = instr(dsllv); break;
+			case 0x16: ic->f = instr(dsrlv); break;
+			default:   ic->f = instr(dsrav); break;
+			}
+			if (iword & 0x10 && cpu->is_32bit)
+				goto mips16_64bit;
+			ic->arg[0] = ic->arg[2] = (size_t)&cpu->cd.mips.gpr[ry];
+			ic->arg[1] = (size_t)&cpu->cd.mips.gpr[rx];
+			break;
+
+		case 0x08:
+		case 0x13:
+			/*  dsrl, dsra ry,sa  */
+			if (cpu->is_32bit)
+				goto mips16_64bit;
+			sa = (iword >> 8) & 7;
+			if (extended)
+				sa = ((ext >> 6) & 31) | (ext & 0x20);
+			else if (sa == 0)
+				sa = 8;
+			ic->f = (iword & 31) == 0x08? instr(dsrl) : instr(dsra);
+			ic->arg[0] = ic->arg[2] = (size_t)&cpu->cd.mips.gpr[ry];
+			ic->arg[1] = sa;
+			break;
+
+		case 0x05:
+			ic->f = instr(mips16_break);
+			break;
+
+		case 0x0a:
+			/*  cmp rx,ry  */
+			ic->f = instr(xor);
+			ic->arg[2] = (size_t)&cpu->cd.mips.gpr[MIPS16_REG_T];
+			break;
+
+		case 0x0b:
+			/*  neg rx,ry  */
+			ic->f = instr(subu);
+			ic->arg[0] = (size_t)&cpu->cd.mips.gpr[MIPS_GPR_ZERO];
+			break;
+
+		case 0x0c: ic->f = instr(and); break;
+		case 0x0d: ic->f = instr(or); break;
+		case 0x0e: ic->f = instr(xor); break;
+
+		case 0x0f:
+			/*  not rx,ry  */
+			ic->f = instr(nor);
+			ic->arg[0] = (size_t)&cpu->cd.mips.gpr[ry];
+			ic->arg[1] = (size_t)&cpu->cd.mips.gpr[MIPS_GPR_ZERO];
+			break;
+
+		case 0x10:
+		case 0x12:
+			/*  mfhi, mflo rx  */
+			ic->f = instr(mov);
+			ic->arg[0] = (iword & 31) == 0x10?
+			    (size_t)&cpu->cd.mips.hi : (size_t)&cpu->cd.mips.lo;
+			break;
+
+		case 0x11:
+			/*  zeb, zeh, seb, seh rx  */
+			ic->arg[0] = ic->arg[1] = ic->arg[2];
+			switch ((iword >> 5) & 7) {
+			case 0:	ic->f = instr(andi); ic->arg[2] = 0xff; break;
+			case 1:	ic->f = instr(andi); ic->arg[2] = 0xffff; break;
+			case 4:	ic->f = instr(seb); break;
+			case 5:	ic->f = instr(seh); break;
+			case 2:	/*  zew  */
+				if (cpu->is_32bit)
+					goto mips16_64bit;
+				ic->f = instr(andi);
+				ic->arg[2] = 0xffffffff;
+				break;
+			case 6:	/*  sew  */
+				if (cpu->is_32bit)
+					goto mips16_64bit;
+				ic->f = instr(sll);
+				ic->arg[1] = 0;
+				break;
+			default:goto bad;
+			}
+			break;
+
+		case 0x18: ic->f = instr(mult); break;
+		case 0x19: ic->f = instr(multu); break;
+		case 0x1a: ic->f = instr(div); break;
+		case 0x1b: ic->f = instr(divu); break;
+
+		case 0x1c:
+		case 0x1d:
+		case 0x1e:
+		case 0x1f:
+			/*  dmult, dmultu, ddiv, ddivu rx,ry  */
+			if (cpu->is_32bit)
+				goto mips16_64bit;
+			switch (iword & 31) {
+			case 0x1c: ic->f = instr(dmult); break;
+			case 0x1d: ic->f = instr(dmultu); break;
+			case 0x1e: ic->f = instr(ddiv); break;
+			default:   ic->f = instr(ddivu); break;
+			}
+			break;
+
+		default:goto bad;
+		}
+		break;
+
+	case 0x1f:
+		/*  I64 instructions:  */
+		if (cpu->is_32bit)
+			goto mips16_64bit;
+		ic->arg[0] = (size_t)&cpu->cd.mips.gpr[ry];
+		ic->arg[1] = (size_t)&cpu->cd.mips.gpr[MIPS_GPR_SP];
+		switch ((iword >> 8) & 7) {
+		case 0:
+		case 1:
+			/*  ld, sd ry,imm(sp)  */
+			ic->f = iword & 0x100? instr(mips16_sd) :
+			    instr(mips16_ld);
+			ic->arg[2] = extended? imm : (iword & 31) << 3;
+			break;
+		case 2:
+			/*  sd ra,imm(sp)  */
+			ic->f = instr(mips16_sd);
+			ic->arg[0] = (size_t)&cpu->cd.mips.gpr[MIPS_GPR_RA];
+			ic->arg[2] = extended? imm : (iword & 0xff) << 3;
+			break;
+		case 3:
+			/*  daddiu sp,imm  (dadjsp)  */
+			ic->f = instr(daddiu);
+			ic->arg[0] = ic->arg[1];
+			ic->arg[2] = extended? imm : (int8_t)iword << 3;
+			break;
+		case 4:
+		case 6:
+			/*  ld ry,imm(pc), daddiu ry,pc,imm  */
+			ic->f = iword & 0x200? instr(mips16_daddiupc) :
+			    instr(mips16_ldpc);
+			ic->arg[1] = low_pc << MIPS16_INSTR_ALIGNMENT_SHIFT;
+			ic->arg[2] = extended? imm :
+			    (iword & 31) << (iword & 0x200? 2 : 3);
+			break;
+		case 5:
+			/*  daddiu ry,imm  */
+			ic->f = instr(daddiu);
+			ic->arg[1] = ic->arg[0];
+			ic->arg[2] = extended? imm :
+			    (int32_t)(iword << 27) >> 27;
+			break;
+		case 7:
+			/*  daddiu ry,sp,imm  */
+			ic->f = instr(daddiu);
+			ic->arg[1] = ic->arg[0];
+			ic->arg[0] = (size_t)&cpu->cd.mips.gpr[MIPS_GPR_SP];
+			ic->arg[2] = extended? imm : (iword & 31) << 2;
+			break;
+		}
+		break;
+
+	default:goto bad;
+	}
+
+	goto translated;
+
+
+conditional_branch:
+	/*  beqz, bnez, bteqz, btnez, to offset target in the page  */
+	if (target >= 0 && target < MIPS16_PAGE_SIZE) {
+		ic->f = op == 0x04? instr(mips16_beqz_samepage) :
+		    instr(mips16_bnez_samepage);
+		ic->arg[1] = (size_t)(cpu->cd.mips.cur_ic_page +
+		    (target >> MIPS16_INSTR_ALIGNMENT_SHIFT));
+	} else {
+		ic->f = op == 0x04? instr(mips16_beqz) : instr(mips16_bnez);
+		ic->arg[1] = target;
+	}
+	goto translated;
+
+
+mips16_64bit:
+	/*  64-bit instructions are reserved on 32-bit CPUs:  */
+	ic->f = instr(mips16_reserved);
+
+
+translated:
+	/*  The second half of a 32-bit instruction is never run on its own:  */
+	if ((extended || op == 0x03) && !crosspage)
+		ic[1].f = instr(mips16_skip);
+
+	/*
+	 *  Mark the part of the page as containing translations:
+	 */
+	cpu->cd.mips.cur_physpage = (struct mips_tc_physpage *)
+	    cpu->cd.mips.cur_ic_page;
+	cpu->cd.mips.cur_physpage->translations_bitmap |= 1 << (low_pc /
+	    (MIPS_IC_ENTRIES_PER_PAGE / (8 * sizeof(cpu->cd.mips.
+	    cur_physpage->translations_bitmap))));
+
+	/*  (Except when doing read-ahead!)  */
+	if (cpu->translation_readahead)
+		return;
+
+	/*
+	 *  Single-stepping, or a 32-bit instruction across the page boundary:
+	 *  execute, but don't keep the translation. (In the second case, the
+	 *  instruction continues at offset 2 on the next page.)
+	 */
+	if ((single_step_breakpoint && cpu->delay_slot == NOT_DELAYED) ||
+	    crosspage) {
+		single_step_breakpoint = 0;
+		ic->f(cpu, ic);
+		ic->f = instr(mips16_to_be_translated);
+		if (crosspage && cpu->cd.mips.next_ic == ic + 1)
+			cpu->cd.mips.next_ic = ic + 2;
+		return;
+	}
+
+	cpu->translation_cache_traps ++;
+
+	/*  Translation read-ahead, within the same MIPS16 page:  */
+	if (!single_step && !cpu->machine->instruction_trace)
+		DYNTRANS_TRANSLATE_READAHEAD(cpu, cpu->cd.mips.cur_ic_page,
+		    low_pc + 1, MIPS_IC_ENTRIES_PER_PAGE,
+		    instr(mips16_to_be_translated));
+
+	/*  ... and finally execute the translated instruction:  */
+	ic->f(cpu, ic);
+	return;
+
+
+bad:	/*
+	 *  Nothing was translated. (Unimplemented or illegal instruction.)
+	 */
+
+	/*  Clear the translation, in case it was "half-way" done:  */
+	ic->f = instr(mips16_to_be_translated);
+
+	if (cpu->translation_readahead)
+		return;
+
+	quiet_mode = 0;
+	fatal("mips16_to_be_translated(): TODO: unimplemented instruction");
+
+	if (cpu->machine->instruction_trace)
+		fatal(" at 0x%"PRIx64"\n", (uint64_t)cpu->pc);
+	else {
+		fatal(":\n");
+		DISASSEMBLE(cpu, ib, 1, 0);
+	}
+
+	cpu->running = 0;
+
+	/*  Note: Single-stepping can jump here.  */
+stop_running_translated:
+
+	debugger_n_steps_left_before_interaction = 0;
+
+	ic = cpu->cd.mips.next_ic = &nothing_call;
+	cpu->cd.mips.next_ic ++;
+
+	/*  Execute the "nothing" instruction:  */
+	ic->f(cpu, ic);
+}
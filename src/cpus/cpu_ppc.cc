@@ -35,6 +35,7 @@
 
 #include "cpu.h"
 #include "devices.h"
+#include "float_emul.h"
 #include "interrupt.h"
 #include "machine.h"
 #include "memory.h"
@@ -116,6 +117,7 @@ int ppc_cpu_new(struct cpu *cpu, struct memory *mem, struct machine *machine,
 	cpu->cd.ppc.spr[SPR_DBAT2L] = 0xe0000000 | BAT_PP_RW;
 	cpu->cd.ppc.spr[SPR_DBAT3U] = 0xf0001ffc | BAT_Vs;
 	cpu->cd.ppc.spr[SPR_DBAT3L] = 0xf0000000 | BAT_PP_RW;
+	ppc_bat_update(cpu);
 
 	cpu->is_32bit = (cpu->cd.ppc.bits == 32)? 1 : 0;
 
@@ -201,6 +203,8 @@ int ppc_cpu_new(struct cpu *cpu, struct memory *mem, struct machine *machine,
 	CPU_SETTINGS_ADD_REGISTER64("lr", cpu->cd.ppc.spr[SPR_LR]);
 	CPU_SETTINGS_ADD_REGISTER32("cr", cpu->cd.ppc.cr);
 	CPU_SETTINGS_ADD_REGISTER32("fpscr", cpu->cd.ppc.fpscr);
+	settings_add(cpu->settings, "lazy_lockstep", 1, SETTINGS_TYPE_INT,
+	    SETTINGS_FORMAT_YESNO, (void *) &cpu->cd.ppc.lazy_lockstep);
 	/*  Integer GPRs, floating point registers, and segment registers:  */
 	for (i=0; i<PPC_NGPRS; i++) {
 		char tmpstr[5];
@@ -293,6 +297,58 @@ void ppc_cpu_dumpinfo(struct cpu *cpu)
 }
 
 
+/*
+ *  ppc_settings_written():
+ *
+ *  Called by the debugger after registers have been written through the
+ *  settings. The decoded BATs and the cached page table entries are derived
+ *  from SPRs (e.g. ibat0u or sdr1), so they are rebuilt here, the same way
+ *  as when mtspr writes to those registers.
+ */
+void ppc_settings_written(struct cpu *cpu)
+{
+	ppc_bat_update(cpu);
+	ppc_pte_cache_invalidate(cpu, 0, 1);
+	cpu->invalidate_translation_caches(cpu, 0, INVALIDATE_ALL);
+}
+
+
+/*
+ *  ppc_fpscr_exceptions(), ppc_fenv_begin(), ppc_fenv_end():
+ *
+ *  Floating point arithmetic is done on the host, in the rounding mode
+ *  selected by FPSCR[RN]. Overflow, Underflow, Zero Divide and Inexact
+ *  exceptions are then recorded in the FPSCR (and FX is set if any of them
+ *  is new). TODO: Invalid Operation, FR/FI, and enabled exceptions.
+ */
+void ppc_fpscr_exceptions(struct cpu *cpu, int exc)
+{
+	uint32_t bits = 0;
+
+	if (exc & IEEE_EXC_OVERFLOW)
+		bits |= PPC_FPSCR_OX;
+	if (exc & IEEE_EXC_UNDERFLOW)
+		bits |= PPC_FPSCR_UX;
+	if (exc & IEEE_EXC_DIVBYZERO)
+		bits |= PPC_FPSCR_ZX;
+	if (exc & IEEE_EXC_INEXACT)
+		bits |= PPC_FPSCR_XX;
+
+	bits &= ~cpu->cd.ppc.fpscr;
+	if (bits)
+		cpu->cd.ppc.fpscr |= bits | PPC_FPSCR_FX;
+}
+void ppc_fenv_begin(struct cpu *cpu)
+{
+	ieee_fenv_begin(cpu->cd.ppc.fpscr & PPC_FPSCR_RN);
+}
+void ppc_fenv_end(struct cpu *cpu)
+{
+	ppc_fpscr_exceptions(cpu,
+	    ieee_fenv_end(cpu->cd.ppc.fpscr & PPC_FPSCR_RN));
+}
+
+
 /*
  *  reg_access_msr():
  */
@@ -354,6 +410,7 @@ void ppc_exception(struct cpu *cpu, int exception_nr)
 	/*  Save PC and MSR:  */
 	cpu->cd.ppc.spr[SPR_SRR0] = cpu->pc;
 
+	PPC_CR0_SYNC(cpu);
 	if (exception_nr >= 0x10 && exception_nr <= 0x13)
 		cpu->cd.ppc.spr[SPR_SRR1] = (cpu->cd.ppc.msr & 0xffff)
 		    | (cpu->cd.ppc.cr & 0xf0000000);
@@ -394,6 +451,8 @@ void ppc_cpu_register_dump(struct cpu *cpu, int gprs, int coprocs)
 	int i, x = cpu->cpu_id;
 	int bits32 = cpu->cd.ppc.bits == 32;
 
+	PPC_CR0_SYNC(cpu);
+
 	if (gprs) {
 		/*  Special registers (pc, ...) first:  */
 		symbol = get_symbol_name(&cpu->machine->symbol_context,
@@ -1826,13 +1885,13 @@ static void debug_spr_usage(uint64_t pc, int spr)
 
 
 /*
- *  update_cr0():
+ *  ppc_cr0_bits():
  *
- *  Sets the top 4 bits of the CR register.
+ *  Returns the 4 bits of CR field 0 corresponding to a result value.
  */
-void update_cr0(struct cpu *cpu, uint64_t value)
+static uint32_t ppc_cr0_bits(struct cpu *cpu, uint64_t value)
 {
-	int c;
+	uint32_t c;
 
 	if (cpu->cd.ppc.bits == 64) {
 		if ((int64_t)value < 0)
@@ -1853,8 +1912,81 @@ void update_cr0(struct cpu *cpu, uint64_t value)
 	/*  SO bit, copied from XER:  */
 	c |= ((cpu->cd.ppc.spr[SPR_XER] >> 31) & 1);
 
+	return c;
+}
+
+
+/*
+ *  ppc_cr0_materialize():
+ *
+ *  Sets the top 4 bits of the CR register from the value recorded by the
+ *  last update_cr0(). (Usually called via PPC_CR0_SYNC().)
+ */
+void ppc_cr0_materialize(struct cpu *cpu)
+{
+	uint32_t c = ppc_cr0_bits(cpu, cpu->cd.ppc.cr0_lazy_value);
+
+	cpu->cd.ppc.cr &= ~((uint32_t)0xf << 28);
+	cpu->cd.ppc.cr |= (c << 28);
+	cpu->cd.ppc.cr0_lazy = 0;
+}
+
+
+/*
+ *  ppc_lazy_lockstep_check():
+ *
+ *  Called by ppc_run_instr() after each instruction, if lazy_lockstep is
+ *  set. While a CR0 update is pending, the bits it materializes to are
+ *  compared with the bits the eager code calculated in update_cr0(). (They
+ *  differ e.g. if XER[SO] was changed without PPC_CR0_SYNC().)
+ *
+ *  While the update stays pending, CR0 is set to the inverse of the correct
+ *  bits. An instruction which reads CR0 without PPC_CR0_SYNC() then behaves
+ *  differently than with eager CR0 updates, and an instruction which
+ *  modifies CR0 without PPC_CR0_SYNC() is caught after it has run.
+ */
+void ppc_lazy_lockstep_check(struct cpu *cpu)
+{
+	uint32_t lazy;
+
+	if (!cpu->cd.ppc.cr0_lazy)
+		return;
+
+	if (cpu->cd.ppc.cr0_lazy > 1 && (cpu->cd.ppc.cr >> 28) !=
+	    cpu->cd.ppc.lazy_lockstep_cr0) {
+		fatal("ppc_lazy_lockstep_check(): CR0 was modified without "
+		    "PPC_CR0_SYNC() (pc=0x%016"PRIx64")\n", (uint64_t) cpu->pc);
+		exit(1);
+	}
+
+	lazy = ppc_cr0_bits(cpu, cpu->cd.ppc.cr0_lazy_value);
+	if (lazy != cpu->cd.ppc.lazy_lockstep_eager) {
+		fatal("ppc_lazy_lockstep_check(): value 0x%016"PRIx64": lazy "
+		    "cr0 0x%x, eager cr0 0x%x (pc=0x%016"PRIx64")\n",
+		    (uint64_t) cpu->cd.ppc.cr0_lazy_value, (int)lazy,
+		    (int)cpu->cd.ppc.lazy_lockstep_eager, (uint64_t) cpu->pc);
+		exit(1);
+	}
+
+	cpu->cd.ppc.lazy_lockstep_cr0 = ~lazy & 0xf;
 	cpu->cd.ppc.cr &= ~((uint32_t)0xf << 28);
-	cpu->cd.ppc.cr |= ((uint32_t)c << 28);
+	cpu->cd.ppc.cr |= (cpu->cd.ppc.lazy_lockstep_cr0 << 28);
+	cpu->cd.ppc.cr0_lazy = 2;
+}
+
+
+/*
+ *  update_cr0():
+ *
+ *  Sets the top 4 bits of the CR register. The bits are not calculated
+ *  until they are needed; see PPC_CR0_SYNC() in cpu_ppc.h.
+ */
+static inline void update_cr0(struct cpu *cpu, uint64_t value)
+{
+	cpu->cd.ppc.cr0_lazy = 1;
+	cpu->cd.ppc.cr0_lazy_value = value;
+	if (cpu->cd.ppc.lazy_lockstep)
+		cpu->cd.ppc.lazy_lockstep_eager = ppc_cr0_bits(cpu, value);
 }
 
 
@@ -190,6 +190,7 @@ X(bclr)
 	tmp = cpu->cd.ppc.spr[SPR_CTR];
 	ctr_ok |= ( (tmp == 0) == ((bo >> 1) & 1) );
 	cond_ok = (bo >> 4) & 1;
+	PPC_CR0_SYNC(cpu);
 	cond_ok |= ( ((bo >> 3) & 1) == ((cpu->cd.ppc.cr >> bi31m) & 1) );
 	if (ctr_ok && cond_ok) {
 		uint64_t mask_within_page =
@@ -228,6 +229,7 @@ X(bclr_l)
 	tmp = cpu->cd.ppc.spr[SPR_CTR];
 	ctr_ok |= ( (tmp == 0) == ((bo >> 1) & 1) );
 	cond_ok = (bo >> 4) & 1;
+	PPC_CR0_SYNC(cpu);
 	cond_ok |= ( ((bo >> 3) & 1) == ((cpu->cd.ppc.cr >> bi31m) & 1) );
 
 	/*  Calculate return PC:  */
@@ -274,6 +276,7 @@ X(bcctr)
 	uint64_t old_pc = cpu->pc;
 	MODE_uint_t addr = cpu->cd.ppc.spr[SPR_CTR];
 	int cond_ok = (bo >> 4) & 1;
+	PPC_CR0_SYNC(cpu);
 	cond_ok |= ( ((bo >> 3) & 1) == ((cpu->cd.ppc.cr >> bi31m) & 1) );
 	if (cond_ok) {
 		uint64_t mask_within_page =
@@ -301,6 +304,7 @@ X(bcctr_l)
 	unsigned int bo = ic->arg[0], bi31m = ic->arg[1]  /*,bh = ic->arg[2] */;
 	MODE_uint_t addr = cpu->cd.ppc.spr[SPR_CTR];
 	int cond_ok = (bo >> 4) & 1;
+	PPC_CR0_SYNC(cpu);
 	cond_ok |= ( ((bo >> 3) & 1) == ((cpu->cd.ppc.cr >> bi31m) & 1) );
 
 	/*  Calculate return PC:  */
@@ -369,6 +373,7 @@ X(bc)
 	tmp = cpu->cd.ppc.spr[SPR_CTR];
 	ctr_ok |= ( (tmp == 0) == ((bo >> 1) & 1) );
 	cond_ok = (bo >> 4) & 1;
+	PPC_CR0_SYNC(cpu);
 	cond_ok |= ( ((bo >> 3) & 1) ==
 	    ((cpu->cd.ppc.cr >> (bi31m)) & 1)  );
 	if (ctr_ok && cond_ok)
@@ -393,6 +398,7 @@ X(bcl)
 	tmp = cpu->cd.ppc.spr[SPR_CTR];
 	ctr_ok |= ( (tmp == 0) == ((bo >> 1) & 1) );
 	cond_ok = (bo >> 4) & 1;
+	PPC_CR0_SYNC(cpu);
 	cond_ok |= ( ((bo >> 3) & 1) ==
 	    ((cpu->cd.ppc.cr >> bi31m) & 1)  );
 	if (ctr_ok && cond_ok)
@@ -428,6 +434,7 @@ X(bc_samepage)
 	tmp = cpu->cd.ppc.spr[SPR_CTR];
 	ctr_ok |= ( (tmp == 0) == ((bo >> 1) & 1) );
 	cond_ok = (bo >> 4) & 1;
+	PPC_CR0_SYNC(cpu);
 	cond_ok |= ( ((bo >> 3) & 1) ==
 	    ((cpu->cd.ppc.cr >> bi31m) & 1)  );
 	if (ctr_ok && cond_ok)
@@ -436,12 +443,14 @@ X(bc_samepage)
 X(bc_samepage_simple0)
 {
 	int bi31m = ic->arg[2];
+	PPC_CR0_SYNC(cpu);
 	if (!((cpu->cd.ppc.cr >> bi31m) & 1))
 		cpu->cd.ppc.next_ic = (struct ppc_instr_call *) ic->arg[0];
 }
 X(bc_samepage_simple1)
 {
 	int bi31m = ic->arg[2];
+	PPC_CR0_SYNC(cpu);
 	if ((cpu->cd.ppc.cr >> bi31m) & 1)
 		cpu->cd.ppc.next_ic = (struct ppc_instr_call *) ic->arg[0];
 }
@@ -464,6 +473,7 @@ X(bcl_samepage)
 	tmp = cpu->cd.ppc.spr[SPR_CTR];
 	ctr_ok |= ( (tmp == 0) == ((bo >> 1) & 1) );
 	cond_ok = (bo >> 4) & 1;
+	PPC_CR0_SYNC(cpu);
 	cond_ok |= ( ((bo >> 3) & 1) ==
 	    ((cpu->cd.ppc.cr >> bi31m) & 1)  );
 	if (ctr_ok && cond_ok)
@@ -498,6 +508,37 @@ X(bla)
 }
 
 
+/*
+ *  bl_native:  Branch and Link to a guest routine which is run natively
+ *
+ *  arg[0] = relative offset (as an int32_t) from start of page
+ *  arg[1] = lr offset (relative to start of current page)
+ *  arg[2] = native routine (NATIVE_ROUTINE_xxx)
+ *
+ *  If the routine can't be run natively, this is a normal bl. Otherwise,
+ *  execution continues with the instruction after the bl, as if the routine
+ *  had returned.
+ */
+X(bl_native)
+{
+	uint64_t args[3], retval;
+
+	args[0] = cpu->cd.ppc.gpr[3];
+	args[1] = cpu->cd.ppc.gpr[4];
+	args[2] = cpu->cd.ppc.gpr[5];
+
+	if (!native_routine_run(cpu, ic->arg[2], args, &retval,
+	    DYNTRANS_NATIVE_HOST_PAGE)) {
+		instr(bl)(cpu, ic);
+		return;
+	}
+
+	cpu->cd.ppc.spr[SPR_LR] = (cpu->pc & ~((PPC_IC_ENTRIES_PER_PAGE-1)
+	    << PPC_INSTR_ALIGNMENT_SHIFT)) + ic->arg[1];
+	cpu->cd.ppc.gpr[3] = retval;
+}
+
+
 /*
  *  bl_trace:  Branch and Link (to a different translated page)  (with trace)
  *
@@ -610,6 +651,7 @@ X(cmpd)
 		c = 2;
 	/*  SO bit, copied from XER  */
 	c |= ((cpu->cd.ppc.spr[SPR_XER] >> 31) & 1);
+	PPC_CR0_SYNC(cpu);
 	cpu->cd.ppc.cr &= ~(0xf << bf_shift);
 	cpu->cd.ppc.cr |= (c << bf_shift);
 }
@@ -634,6 +676,7 @@ X(cmpld)
 		c = 2;
 	/*  SO bit, copied from XER  */
 	c |= ((cpu->cd.ppc.spr[SPR_XER] >> 31) & 1);
+	PPC_CR0_SYNC(cpu);
 	cpu->cd.ppc.cr &= ~(0xf << bf_shift);
 	cpu->cd.ppc.cr |= (c << bf_shift);
 }
@@ -658,6 +701,7 @@ X(cmpdi)
 		c = 2;
 	/*  SO bit, copied from XER  */
 	c |= ((cpu->cd.ppc.spr[SPR_XER] >> 31) & 1);
+	PPC_CR0_SYNC(cpu);
 	cpu->cd.ppc.cr &= ~(0xf << bf_shift);
 	cpu->cd.ppc.cr |= (c << bf_shift);
 }
@@ -682,6 +726,7 @@ X(cmpldi)
 		c = 2;
 	/*  SO bit, copied from XER  */
 	c |= ((cpu->cd.ppc.spr[SPR_XER] >> 31) & 1);
+	PPC_CR0_SYNC(cpu);
 	cpu->cd.ppc.cr &= ~(0xf << bf_shift);
 	cpu->cd.ppc.cr |= (c << bf_shift);
 }
@@ -706,6 +751,7 @@ X(cmpw)
 		c = 2;
 	/*  SO bit, copied from XER  */
 	c |= ((cpu->cd.ppc.spr[SPR_XER] >> 31) & 1);
+	PPC_CR0_SYNC(cpu);
 	cpu->cd.ppc.cr &= ~(0xf << bf_shift);
 	cpu->cd.ppc.cr |= (c << bf_shift);
 }
@@ -713,6 +759,7 @@ X(cmpw_cr0)
 {
 	/*  arg[2] is assumed to be 28  */
 	int32_t tmp = reg(ic->arg[0]), tmp2 = reg(ic->arg[1]);
+	PPC_CR0_OVERWRITE(cpu);
 	cpu->cd.ppc.cr &= ~(0xf0000000);
 	if (tmp < tmp2)
 		cpu->cd.ppc.cr |= 0x80000000;
@@ -743,6 +790,7 @@ X(cmplw)
 		c = 2;
 	/*  SO bit, copied from XER  */
 	c |= ((cpu->cd.ppc.spr[SPR_XER] >> 31) & 1);
+	PPC_CR0_SYNC(cpu);
 	cpu->cd.ppc.cr &= ~(0xf << bf_shift);
 	cpu->cd.ppc.cr |= (c << bf_shift);
 }
@@ -767,6 +815,7 @@ X(cmpwi)
 		c = 2;
 	/*  SO bit, copied from XER  */
 	c |= ((cpu->cd.ppc.spr[SPR_XER] >> 31) & 1);
+	PPC_CR0_SYNC(cpu);
 	cpu->cd.ppc.cr &= ~(0xf << bf_shift);
 	cpu->cd.ppc.cr |= (c << bf_shift);
 }
@@ -774,6 +823,7 @@ X(cmpwi_cr0)
 {
 	/*  arg[2] is assumed to be 28  */
 	int32_t tmp = reg(ic->arg[0]), imm = ic->arg[1];
+	PPC_CR0_OVERWRITE(cpu);
 	cpu->cd.ppc.cr &= ~(0xf0000000);
 	if (tmp < imm)
 		cpu->cd.ppc.cr |= 0x80000000;
@@ -804,6 +854,7 @@ X(cmplwi)
 		c = 2;
 	/*  SO bit, copied from XER  */
 	c |= ((cpu->cd.ppc.spr[SPR_XER] >> 31) & 1);
+	PPC_CR0_SYNC(cpu);
 	cpu->cd.ppc.cr &= ~(0xf << bf_shift);
 	cpu->cd.ppc.cr |= (c << bf_shift);
 }
@@ -950,6 +1001,7 @@ X(fcmpu)
 			c = 2;
 	}
 	/*  TODO: Signaling vs Quiet NaN  */
+	PPC_CR0_SYNC(cpu);
 	cpu->cd.ppc.cr &= ~(0xf << bf_shift);
 	cpu->cd.ppc.cr |= ((c&0xe) << bf_shift);
 	cpu->cd.ppc.fpscr &= ~(PPC_FPSCR_FPCC | PPC_FPSCR_VXNAN);
@@ -975,7 +1027,9 @@ X(frsp)
 	if (frb.nan) {
 		c = 1;
 	} else {
+		ppc_fenv_begin(cpu);
 		fl = frb.f;
+		ppc_fenv_end(cpu);
 		if (fl < 0.0)
 			c = 8;
 		else if (fl > 0.0)
@@ -1038,8 +1092,11 @@ X(fmul)
 	ieee_interpret_float_value(*(uint64_t *)ic->arg[2], &frc, IEEE_FMT_D);
 	if (fra.nan || frc.nan)
 		nan = 1;
-	else
+	else {
+		ppc_fenv_begin(cpu);
 		result = fra.f * frc.f;
+		ppc_fenv_end(cpu);
+	}
 	if (nan)
 		c = 1;
 	else {
@@ -1088,8 +1145,11 @@ X(fmadd)
 	ieee_interpret_float_value(cpu->cd.ppc.fpr[c], &frc, IEEE_FMT_D);
 	if (fra.nan || frb.nan || frc.nan)
 		nan = 1;
-	else
+	else {
+		ppc_fenv_begin(cpu);
 		result = fra.f * frc.f + frb.f;
+		ppc_fenv_end(cpu);
+	}
 	if (nan)
 		cc = 1;
 	else {
@@ -1133,8 +1193,11 @@ X(fmsub)
 	ieee_interpret_float_value(cpu->cd.ppc.fpr[c], &frc, IEEE_FMT_D);
 	if (fra.nan || frb.nan || frc.nan)
 		nan = 1;
-	else
+	else {
+		ppc_fenv_begin(cpu);
 		result = fra.f * frc.f - frb.f;
+		ppc_fenv_end(cpu);
+	}
 	if (nan)
 		cc = 1;
 	else {
@@ -1174,8 +1237,11 @@ X(fadd)
 	ieee_interpret_float_value(*(uint64_t *)ic->arg[1], &frb, IEEE_FMT_D);
 	if (fra.nan || frb.nan)
 		nan = 1;
-	else
+	else {
+		ppc_fenv_begin(cpu);
 		result = fra.f + frb.f;
+		ppc_fenv_end(cpu);
+	}
 	if (nan)
 		c = 1;
 	else {
@@ -1211,8 +1277,11 @@ X(fsub)
 	ieee_interpret_float_value(*(uint64_t *)ic->arg[1], &frb, IEEE_FMT_D);
 	if (fra.nan || frb.nan)
 		nan = 1;
-	else
+	else {
+		ppc_fenv_begin(cpu);
 		result = fra.f - frb.f;
+		ppc_fenv_end(cpu);
+	}
 	if (nan)
 		c = 1;
 	else {
@@ -1246,10 +1315,17 @@ X(fdiv)
 
 	ieee_interpret_float_value(*(uint64_t *)ic->arg[0], &fra, IEEE_FMT_D);
 	ieee_interpret_float_value(*(uint64_t *)ic->arg[1], &frb, IEEE_FMT_D);
-	if (fra.nan || frb.nan || frb.f == 0)
+	if (fra.nan || frb.nan)
 		nan = 1;
-	else
+	else if (frb.f == 0) {
+		nan = 1;
+		if (fra.f != 0)
+			ppc_fpscr_exceptions(cpu, IEEE_EXC_DIVBYZERO);
+	} else {
+		ppc_fenv_begin(cpu);
 		result = fra.f / frb.f;
+		ppc_fenv_end(cpu);
+	}
 	if (nan)
 		c = 1;
 	else {
@@ -1312,7 +1388,8 @@ X(llsc)
 			exit(1);
 		}
 		if (cpu->memory_rw(cpu, cpu->mem, addr, d, len,
-		    MEM_READ, CACHE_DATA) != MEMORY_ACCESS_OK) {
+		    MEM_READ, CACHE_DATA | MEMORY_LOAD_LINKED)
+		    != MEMORY_ACCESS_OK) {
 			fatal("ll: error: TODO\n");
 			exit(1);
 		}
@@ -1327,10 +1404,9 @@ X(llsc)
 		}
 
 		cpu->cd.ppc.gpr[rt] = value;
-		cpu->cd.ppc.ll_addr = addr;
-		cpu->cd.ppc.ll_bit = 1;
 	} else {
 		uint32_t old_so = cpu->cd.ppc.spr[SPR_XER] & PPC_XER_SO;
+		int res = MEMORY_ACCESS_NO_RESERVATION;
 		if (!rc) {
 			fatal("sc: rc-bit not set?\n");
 			exit(1);
@@ -1338,18 +1414,6 @@ X(llsc)
 
 		value = cpu->cd.ppc.gpr[rt];
 
-		/*  "If the store is performed, bits 0-2 of Condition
-		    Register Field 0 are set to 0b001, otherwise, they are
-		    set to 0b000. The SO bit of the XER is copied to to bit
-		    4 of Condition Register Field 0.  */
-		if (!cpu->cd.ppc.ll_bit || cpu->cd.ppc.ll_addr != addr) {
-			cpu->cd.ppc.cr &= 0x0fffffff;
-			if (old_so)
-				cpu->cd.ppc.cr |= 0x10000000;
-			cpu->cd.ppc.ll_bit = 0;
-			return;
-		}
-
 		for (i=0; i<len; i++) {
 			if (cpu->byte_order == EMUL_BIG_ENDIAN)
 				d[len - 1 - i] = value >> (8*i);
@@ -1357,20 +1421,26 @@ X(llsc)
 				d[i] = value >> (8*i);
 		}
 
-		if (cpu->memory_rw(cpu, cpu->mem, addr, d, len,
-		    MEM_WRITE, CACHE_DATA) != MEMORY_ACCESS_OK) {
+		/*  The reservation is checked (and cleared, for all CPUs
+		    with a reservation on the same granule) by memory_rw():  */
+		if (memory_reservation_get(cpu, NULL))
+			res = cpu->memory_rw(cpu, cpu->mem, addr, d, len,
+			    MEM_WRITE, CACHE_DATA | MEMORY_STORE_CONDITIONAL);
+		if (res == MEMORY_ACCESS_FAILED) {
 			fatal("sc: error: TODO\n");
 			exit(1);
 		}
 
+		/*  "If the store is performed, bits 0-2 of Condition
+		    Register Field 0 are set to 0b001, otherwise, they are
+		    set to 0b000. The SO bit of the XER is copied to to bit
+		    4 of Condition Register Field 0.  */
+		PPC_CR0_OVERWRITE(cpu);
 		cpu->cd.ppc.cr &= 0x0fffffff;
-		cpu->cd.ppc.cr |= 0x20000000;	/*  success!  */
+		if (res == MEMORY_ACCESS_OK)
+			cpu->cd.ppc.cr |= 0x20000000;	/*  success!  */
 		if (old_so)
 			cpu->cd.ppc.cr |= 0x10000000;
-
-		/*  Clear _all_ CPUs' ll_bits:  */
-		for (i=0; i<cpu->machine->ncpus; i++)
-			cpu->machine->cpus[i]->cd.ppc.ll_bit = 0;
 	}
 }
 
@@ -1623,7 +1693,9 @@ DOT1(srawi)
 X(mcrf)
 {
 	int bf_shift = ic->arg[0], bfa_shift = ic->arg[1];
-	uint32_t tmp = (cpu->cd.ppc.cr >> bfa_shift) & 0xf;
+	uint32_t tmp;
+	PPC_CR0_SYNC(cpu);
+	tmp = (cpu->cd.ppc.cr >> bfa_shift) & 0xf;
 	cpu->cd.ppc.cr &= ~(0xf << bf_shift);
 	cpu->cd.ppc.cr |= (tmp << bf_shift);
 }
@@ -1637,6 +1709,7 @@ X(mcrf)
 X(crand) {
 	uint32_t iword = ic->arg[0]; int bt = (iword >> 21) & 31;
 	int ba = (iword >> 16) & 31, bb = (iword >> 11) & 31;
+	PPC_CR0_SYNC(cpu);
 	ba = (cpu->cd.ppc.cr >> (31-ba)) & 1;
 	bb = (cpu->cd.ppc.cr >> (31-bb)) & 1;
 	cpu->cd.ppc.cr &= ~(1 << (31-bt));
@@ -1646,6 +1719,7 @@ X(crand) {
 X(crandc) {
 	uint32_t iword = ic->arg[0]; int bt = (iword >> 21) & 31;
 	int ba = (iword >> 16) & 31, bb = (iword >> 11) & 31;
+	PPC_CR0_SYNC(cpu);
 	ba = (cpu->cd.ppc.cr >> (31-ba)) & 1;
 	bb = (cpu->cd.ppc.cr >> (31-bb)) & 1;
 	cpu->cd.ppc.cr &= ~(1 << (31-bt));
@@ -1655,6 +1729,7 @@ X(crandc) {
 X(creqv) {
 	uint32_t iword = ic->arg[0]; int bt = (iword >> 21) & 31;
 	int ba = (iword >> 16) & 31, bb = (iword >> 11) & 31;
+	PPC_CR0_SYNC(cpu);
 	ba = (cpu->cd.ppc.cr >> (31-ba)) & 1;
 	bb = (cpu->cd.ppc.cr >> (31-bb)) & 1;
 	cpu->cd.ppc.cr &= ~(1 << (31-bt));
@@ -1664,6 +1739,7 @@ X(creqv) {
 X(cror) {
 	uint32_t iword = ic->arg[0]; int bt = (iword >> 21) & 31;
 	int ba = (iword >> 16) & 31, bb = (iword >> 11) & 31;
+	PPC_CR0_SYNC(cpu);
 	ba = (cpu->cd.ppc.cr >> (31-ba)) & 1;
 	bb = (cpu->cd.ppc.cr >> (31-bb)) & 1;
 	cpu->cd.ppc.cr &= ~(1 << (31-bt));
@@ -1673,6 +1749,7 @@ X(cror) {
 X(crorc) {
 	uint32_t iword = ic->arg[0]; int bt = (iword >> 21) & 31;
 	int ba = (iword >> 16) & 31, bb = (iword >> 11) & 31;
+	PPC_CR0_SYNC(cpu);
 	ba = (cpu->cd.ppc.cr >> (31-ba)) & 1;
 	bb = (cpu->cd.ppc.cr >> (31-bb)) & 1;
 	cpu->cd.ppc.cr &= ~(1 << (31-bt));
@@ -1682,6 +1759,7 @@ X(crorc) {
 X(crnor) {
 	uint32_t iword = ic->arg[0]; int bt = (iword >> 21) & 31;
 	int ba = (iword >> 16) & 31, bb = (iword >> 11) & 31;
+	PPC_CR0_SYNC(cpu);
 	ba = (cpu->cd.ppc.cr >> (31-ba)) & 1;
 	bb = (cpu->cd.ppc.cr >> (31-bb)) & 1;
 	cpu->cd.ppc.cr &= ~(1 << (31-bt));
@@ -1691,6 +1769,7 @@ X(crnor) {
 X(crxor) {
 	uint32_t iword = ic->arg[0]; int bt = (iword >> 21) & 31;
 	int ba = (iword >> 16) & 31, bb = (iword >> 11) & 31;
+	PPC_CR0_SYNC(cpu);
 	ba = (cpu->cd.ppc.cr >> (31-ba)) & 1;
 	bb = (cpu->cd.ppc.cr >> (31-bb)) & 1;
 	cpu->cd.ppc.cr &= ~(1 << (31-bt));
@@ -1735,8 +1814,21 @@ X(mftbu) {
  *  arg[1] = pointer to the SPR
  */
 X(mtspr) {
+	/*  TODO: Check permission  */
+	/*  XER holds the SO bit of a pending CR0 update:  */
+	PPC_CR0_SYNC(cpu);
+	reg(ic->arg[1]) = reg(ic->arg[0]);
+}
+X(mtspr_bat) {
 	/*  TODO: Check permission  */
 	reg(ic->arg[1]) = reg(ic->arg[0]);
+	ppc_bat_update(cpu);
+}
+X(mtspr_sdr1) {
+	/*  TODO: Check permission  */
+	if (cpu->cd.ppc.spr[SPR_SDR1] != reg(ic->arg[0]))
+		ppc_pte_cache_invalidate(cpu, 0, 1);
+	cpu->cd.ppc.spr[SPR_SDR1] = reg(ic->arg[0]);
 }
 X(mtlr) {
 	cpu->cd.ppc.spr[SPR_LR] = reg(ic->arg[0]);
@@ -1784,6 +1876,7 @@ X(rfid)
  */
 X(mfcr)
 {
+	PPC_CR0_SYNC(cpu);
 	reg(ic->arg[0]) = cpu->cd.ppc.cr;
 }
 
@@ -1861,6 +1954,7 @@ X(wrteei)
  */
 X(mtcrf)
 {
+	PPC_CR0_SYNC(cpu);
 	cpu->cd.ppc.cr &= ~ic->arg[1];
 	cpu->cd.ppc.cr |= (reg(ic->arg[0]) & ic->arg[1]);
 }
@@ -2576,6 +2670,7 @@ X(vxor)
 X(tlbia)
 {
 	fatal("[ tlbia ]\n");
+	ppc_pte_cache_invalidate(cpu, 0, 1);
 	cpu->invalidate_translation_caches(cpu, 0, INVALIDATE_ALL);
 }
 
@@ -2586,6 +2681,7 @@ X(tlbia)
 X(tlbie)
 {
 	/*  fatal("[ tlbie ]\n");  */
+	ppc_pte_cache_invalidate(cpu, reg(ic->arg[0]), 0);
 	cpu->invalidate_translation_caches(cpu, reg(ic->arg[0]),
 	    INVALIDATE_VADDR);
 }
@@ -2629,6 +2725,7 @@ X(openfirmware)
 X(tlbsx_dot)
 {
 	/*  TODO  */
+	PPC_CR0_OVERWRITE(cpu);
 	cpu->cd.ppc.cr &= ~(0xf0000000);
 	cpu->cd.ppc.cr |= 0x20000000;
 	cpu->cd.ppc.cr |= ((cpu->cd.ppc.spr[SPR_XER] >> 3) & 0x10000000);
@@ -2661,6 +2758,184 @@ X(tlbld)
 /*****************************************************************************/
 
 
+/*
+ *  dcbz_loop:
+ *
+ *  s:	dcbz	rA,rB		(rA or rB is rX)
+ *	addi	rX,rX,n		(n = the data cache line size)
+ *	bdnz	s
+ *
+ *  All of the cache lines up to the end of the loop, or up to the end of the
+ *  page, are cleared at once. (Pages with translated code never have
+ *  host_store pointers, so there is nothing to invalidate.)
+ */
+X(dcbz_loop)
+{
+	MODE_uint_t addr = reg(ic->arg[0]) + reg(ic->arg[1]);
+	MODE_uint_t ctr = cpu->cd.ppc.spr[SPR_CTR], n;
+	size_t linesize = 1 << cpu->cd.ppc.cpu_type.dlinesize;
+	unsigned char *page = DYNTRANS_NATIVE_HOST_PAGE(cpu, addr, 1);
+	int partial = 1;
+
+	if (page == NULL || (addr & (linesize - 1)) != 0) {
+		instr(dcbz)(cpu, ic);
+		return;
+	}
+
+	n = (0x1000 - (addr & 0xfff)) / linesize;
+	if (ctr != 0 && ctr <= n) {
+		n = ctr;
+		partial = 0;
+	}
+
+	memset(page + (addr & 0xfff), 0, n * linesize);
+	reg(ic[1].arg[2]) += n * linesize;
+	cpu->cd.ppc.spr[SPR_CTR] -= n;
+
+	cpu->n_translated_instrs += n * 3 - 1;
+	cpu->cd.ppc.next_ic = partial? ic : &ic[3];
+	cpu->native_routine_hits[NATIVE_ROUTINE_FILL_LOOP] ++;
+}
+
+
+/*
+ *  stwu_loop:
+ *
+ *  s:	stwu	rS,4(rA)
+ *	bdnz	s
+ */
+X(stwu_loop)
+{
+	MODE_uint_t addr = reg(ic->arg[1]) + 4;
+	MODE_uint_t ctr = cpu->cd.ppc.spr[SPR_CTR], n;
+	unsigned char *page = DYNTRANS_NATIVE_HOST_PAGE(cpu, addr, 1);
+	int partial = 1;
+
+	if (page == NULL || (addr & 3) != 0 ||
+	    cpu->byte_order != EMUL_BIG_ENDIAN) {
+		instr(stwu)(cpu, ic);
+		return;
+	}
+
+	n = (0x1000 - (addr & 0xfff)) / sizeof(uint32_t);
+	if (ctr != 0 && ctr <= n) {
+		n = ctr;
+		partial = 0;
+	}
+
+	native_fill_pattern(page + (addr & 0xfff), reg(ic->arg[0]),
+	    sizeof(uint32_t), 0, n * sizeof(uint32_t));
+	reg(ic->arg[1]) = addr + (n - 1) * sizeof(uint32_t);
+	cpu->cd.ppc.spr[SPR_CTR] -= n;
+
+	cpu->n_translated_instrs += n * 2 - 1;
+	cpu->cd.ppc.next_ic = partial? ic : &ic[2];
+	cpu->native_routine_hits[NATIVE_ROUTINE_FILL_LOOP] ++;
+}
+
+
+/*
+ *  lwzu_stwu_loop:
+ *
+ *  s:	lwzu	rT,4(rS)
+ *	stwu	rT,4(rD)
+ *	bdnz	s
+ *
+ *  When the destination overlaps the source from above, the loop replicates
+ *  data instead of copying it; that case is left to the individual
+ *  instructions.
+ */
+X(lwzu_stwu_loop)
+{
+	MODE_uint_t src = reg(ic[0].arg[1]) + 4, dst = reg(ic[1].arg[1]) + 4;
+	MODE_uint_t ctr = cpu->cd.ppc.spr[SPR_CTR], n;
+	unsigned char *src_page = DYNTRANS_NATIVE_HOST_PAGE(cpu, src, 0);
+	unsigned char *dst_page = DYNTRANS_NATIVE_HOST_PAGE(cpu, dst, 1);
+	unsigned char *last;
+	int partial = 1;
+
+	n = (0x1000 - ((src & 0xfff) > (dst & 0xfff)?
+	    (src & 0xfff) : (dst & 0xfff))) / sizeof(uint32_t);
+	if (ctr != 0 && ctr <= n) {
+		n = ctr;
+		partial = 0;
+	}
+
+	if (src_page == NULL || dst_page == NULL || ((src | dst) & 3) != 0 ||
+	    (MODE_uint_t)(dst - src) < n * sizeof(uint32_t) ||
+	    cpu->byte_order != EMUL_BIG_ENDIAN) {
+		instr(lwzu)(cpu, ic);
+		return;
+	}
+
+	memmove(dst_page + (dst & 0xfff), src_page + (src & 0xfff),
+	    n * sizeof(uint32_t));
+
+	/*  rT is left with the last word that was copied:  */
+	last = dst_page + (dst & 0xfff) + (n - 1) * sizeof(uint32_t);
+	reg(ic[0].arg[0]) = (uint32_t) ((last[0] << 24) + (last[1] << 16) +
+	    (last[2] << 8) + last[3]);
+	reg(ic[0].arg[1]) = src + (n - 1) * sizeof(uint32_t);
+	reg(ic[1].arg[1]) = dst + (n - 1) * sizeof(uint32_t);
+	cpu->cd.ppc.spr[SPR_CTR] -= n;
+
+	cpu->n_translated_instrs += n * 3 - 1;
+	cpu->cd.ppc.next_ic = partial? ic : &ic[3];
+	cpu->native_routine_hits[NATIVE_ROUTINE_COPY_LOOP] ++;
+}
+
+
+/*****************************************************************************/
+
+
+/*
+ *  Combine: Memory fill and copy loops, ending with a bdnz
+ *
+ *  See dcbz_loop, stwu_loop, and lwzu_stwu_loop above.
+ */
+void COMBINE(bdnz)(struct cpu *cpu, struct ppc_instr_call *ic, int low_addr)
+{
+	int n_back = (low_addr >> PPC_INSTR_ALIGNMENT_SHIFT)
+	    & (PPC_IC_ENTRIES_PER_PAGE - 1);
+	size_t linesize = 1 << cpu->cd.ppc.cpu_type.dlinesize;
+
+	if (!cpu->machine->allow_native_routines)
+		return;
+
+	if (n_back >= 1 && ic[0].arg[0] == (size_t) &ic[-1] &&
+	    ic[-1].f == instr(stwu) && (int32_t)ic[-1].arg[2] == 4 &&
+	    ic[-1].arg[0] != ic[-1].arg[1]) {
+		ic[-1].f = instr(stwu_loop);
+		return;
+	}
+
+	if (n_back < 2 || ic[0].arg[0] != (size_t) &ic[-2])
+		return;
+
+	if (ic[-2].f == instr(lwzu) && ic[-1].f == instr(stwu) &&
+	    (int32_t)ic[-2].arg[2] == 4 && (int32_t)ic[-1].arg[2] == 4 &&
+	    ic[-2].arg[0] == ic[-1].arg[0] &&
+	    ic[-2].arg[0] != ic[-2].arg[1] &&
+	    ic[-1].arg[0] != ic[-1].arg[1] &&
+	    ic[-2].arg[1] != ic[-1].arg[1]) {
+		ic[-2].f = instr(lwzu_stwu_loop);
+		return;
+	}
+
+	if (ic[-2].f == instr(dcbz) && ic[-1].f == instr(addi) &&
+	    ic[-1].arg[0] == ic[-1].arg[2] &&
+	    (ic[-2].arg[0] == ic[-1].arg[2]) !=
+	    (ic[-2].arg[1] == ic[-1].arg[2]) &&
+	    (int32_t)ic[-1].arg[1] == (int32_t)linesize) {
+		ic[-2].f = instr(dcbz_loop);
+		return;
+	}
+}
+
+
+/*****************************************************************************/
+
+
 X(end_of_page)
 {
 	/*  Update the PC:  (offset 0, but on the next page)  */
@@ -2694,7 +2969,7 @@ X(to_be_translated)
 	unsigned char ib[4];
 	int main_opcode, rt, rs, ra, rb, rc, aa_bit, l_bit, lk_bit, spr, sh,
 	    xo, imm, load, size, update, zero, bf, bo, bi, bh, oe_bit, n64=0,
-	    bfa, fp, byterev, nb, mb, me;
+	    bfa, fp, byterev, nb, mb, me, native;
 	void (*samepage_function)(struct cpu *, struct ppc_instr_call *);
 	void (*rc_f)(struct cpu *, struct ppc_instr_call *);
 
@@ -2998,6 +3273,10 @@ X(to_be_translated)
 				    ((new_pc & mask_within_page) >> 2));
 			}
 		}
+
+		/*  bdnz, at the end of a memory fill or copy loop?  */
+		if (ic->f == instr(bc_samepage) && (bo & 0x16) == 0x10)
+			cpu->cd.ppc.combination_check = COMBINE(bdnz);
 		break;
 
 	case PPC_HI6_SC:
@@ -3029,6 +3308,14 @@ X(to_be_translated)
 		}
 		ic->arg[0] = (ssize_t)(tmp_addr + (addr & 0xffc));
 		ic->arg[1] = (addr & 0xffc) + 4;
+		/*  Calls to routines which can be run natively:  */
+		if (lk_bit && !aa_bit && (native = native_routine_lookup(
+		    cpu->machine, (MODE_uint_t)(addr + tmp_addr))) !=
+		    NATIVE_ROUTINE_NONE) {
+			ic->f = instr(bl_native);
+			ic->arg[2] = native;
+			break;
+		}
 		/*  Branches are calculated as cur PC + offset.  */
 		/*  Special case: branch within the same page:  */
 		{
@@ -3285,7 +3572,13 @@ X(to_be_translated)
 			case SPR_CTR:
 				ic->f = instr(mtctr);
 				break;
-			default:ic->f = instr(mtspr);
+			case SPR_SDR1:
+				ic->f = instr(mtspr_sdr1);
+				break;
+			default:if (spr >= SPR_IBAT0U && spr <= SPR_DBAT3L)
+					ic->f = instr(mtspr_bat);
+				else
+					ic->f = instr(mtspr);
 			}
 			break;
 
@@ -3882,7 +4175,7 @@ X(to_be_translated)
 				ic->arg[0] = (size_t)(&cpu->cd.ppc.fpr[rb]);
 				ic->arg[1] = 0;
 				for (bi=7; bi>=0; bi--) {
-					ic->arg[1] <<= 8;
+					ic->arg[1] <<= 4;
 					if (iword & (1 << (17+bi)))
 						ic->arg[1] |= 0xf;
 				}
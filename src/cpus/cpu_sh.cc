@@ -172,6 +172,14 @@ int sh_cpu_new(struct cpu *cpu, struct memory *mem, struct machine *machine,
 		CPU_SETTINGS_ADD_REGISTER32(tmpstr, cpu->cd.sh.utlb_lo[i]);
 	}
 
+	sh_utlb_index_init(cpu);
+	settings_add(cpu->settings, "utlb_index_hits", 0,
+	    SETTINGS_TYPE_UINT64, SETTINGS_FORMAT_DECIMAL,
+	    (void *) &cpu->cd.sh.utlb_index_hits);
+	settings_add(cpu->settings, "utlb_index_misses", 0,
+	    SETTINGS_TYPE_UINT64, SETTINGS_FORMAT_DECIMAL,
+	    (void *) &cpu->cd.sh.utlb_index_misses);
+
 	/*  Register the CPU's interrupts:  */
 	if (cpu->cd.sh.cpu_type.arch == 4) {
 		for (i=SH_INTEVT_NMI; i<0x1000; i+=0x20) {
@@ -594,6 +602,21 @@ void sh_update_sr(struct cpu *cpu, uint32_t new_sr)
 }
 
 
+/*
+ *  sh_settings_written():
+ *
+ *  Called by the debugger after registers have been written through the
+ *  settings. The UTLB hash index is derived from utlb_hi_N and utlb_lo_N,
+ *  so it is rebuilt here, and translations which may have been made from
+ *  the old TLB contents are thrown away.
+ */
+void sh_settings_written(struct cpu *cpu)
+{
+	sh_utlb_index_init(cpu);
+	cpu->invalidate_translation_caches(cpu, 0, INVALIDATE_ALL);
+}
+
+
 /*
  *  sh_update_fpscr():
  *
@@ -2113,6 +2113,7 @@ X(ldtlb)
 
 	cpu->cd.sh.utlb_hi[urc] = cpu->cd.sh.pteh;
 	cpu->cd.sh.utlb_lo[urc] = cpu->cd.sh.ptel;
+	sh_utlb_index_update(cpu, urc);
 
 	/*  Invalidate the old mapping, if it belonged to the same ASID:  */
 	if ((old_hi & SH4_PTEH_ASID_MASK) ==
@@ -2794,22 +2795,36 @@ X(tas_b_rn)
 {
 	uint32_t addr = reg(ic->arg[1]);
 	uint8_t byte, newbyte;
+	int res, flags;
 
 	SYNCH_PC;
 
-	if (!cpu->memory_rw(cpu, cpu->mem, addr, &byte, 1, MEM_READ,
-	   CACHE_DATA)) {
-		/*  Exception.  */
-		return;
-	}
+	/*
+	 *  The read and the write are done as a load-linked/store-conditional
+	 *  pair, and retried if someone else wrote to the byte in between.
+	 *  (If no reservation could be set, e.g. outside of RAM, then a plain
+	 *  write is done.)
+	 */
+	do {
+		if (!cpu->memory_rw(cpu, cpu->mem, addr, &byte, 1, MEM_READ,
+		   CACHE_DATA | MEMORY_LOAD_LINKED)) {
+			/*  Exception.  */
+			return;
+		}
 
-	newbyte = byte | 0x80;
+		newbyte = byte | 0x80;
 
-	if (!cpu->memory_rw(cpu, cpu->mem, addr, &newbyte, 1, MEM_WRITE,
-	   CACHE_DATA)) {
-		/*  Exception.  */
-		return;
-	}
+		flags = CACHE_DATA;
+		if (memory_reservation_get(cpu, NULL))
+			flags |= MEMORY_STORE_CONDITIONAL;
+
+		res = cpu->memory_rw(cpu, cpu->mem, addr, &newbyte, 1,
+		    MEM_WRITE, flags);
+		if (res == MEMORY_ACCESS_FAILED) {
+			/*  Exception.  */
+			return;
+		}
+	} while (res == MEMORY_ACCESS_NO_RESERVATION);
 
 	if (byte == 0)
 		cpu->cd.sh.sr |= SH_SR_T;
@@ -2852,6 +2867,113 @@ X(prom_emul)
 /*****************************************************************************/
 
 
+/*
+ *  mov_l_predec_loop:  Memory fill loop, storing downwards.
+ *
+ *  s:	mov.l	Rm,@-Rn		or	s:	dt	Rk
+ *	dt	Rk				bf/s	s
+ *	bf	s				mov.l	Rm,@-Rn
+ *
+ *  In both cases, Rk words are stored. All of the words down to the end of
+ *  the loop, or down to the start of the page, are stored at once. (Pages
+ *  with translated code never have host_store pointers, so there is nothing
+ *  to invalidate.)
+ */
+X(mov_l_predec_loop)
+{
+	struct sh_instr_call *store_ic, *dt_ic;
+	uint32_t rn, rk, n;
+	unsigned char *page;
+	int partial = 1;
+
+	if (ic[1].f == instr(dt_rn)) {
+		store_ic = ic; dt_ic = ic + 1;
+	} else {
+		dt_ic = ic; store_ic = ic + 2;
+	}
+
+	rn = reg(store_ic->arg[1]);
+	rk = reg(dt_ic->arg[1]);
+	page = cpu->cd.sh.host_store[(rn - sizeof(uint32_t)) >> 12];
+
+	/*  Fallback:  */
+	if (cpu->delay_slot || page == NULL || (rn & 3) != 0) {
+		if (ic == store_ic)
+			instr(mov_l_rm_predec_rn)(cpu, ic);
+		else
+			instr(dt_rn)(cpu, ic);
+		return;
+	}
+
+	/*  The number of words left on the page, below rn:  */
+	n = (((rn - sizeof(uint32_t)) & 0xfff) >> 2) + 1;
+	if (rk != 0 && rk <= n) {
+		n = rk;
+		partial = 0;
+	}
+
+	rn -= n * sizeof(uint32_t);
+	native_fill_pattern(page + (rn & 0xfff), reg(store_ic->arg[0]),
+	    sizeof(uint32_t), cpu->byte_order == EMUL_LITTLE_ENDIAN,
+	    n * sizeof(uint32_t));
+	reg(store_ic->arg[1]) = rn;
+	reg(dt_ic->arg[1]) = rk - n;
+
+	if (rk - n == 0)
+		cpu->cd.sh.sr |= SH_SR_T;
+	else
+		cpu->cd.sh.sr &= ~SH_SR_T;
+
+	cpu->n_translated_instrs += n * 3 - 1;
+	cpu->cd.sh.next_ic = partial? ic : &ic[3];
+	cpu->native_routine_hits[NATIVE_ROUTINE_FILL_LOOP] ++;
+}
+
+
+/*****************************************************************************/
+
+
+/*
+ *  Combine: Memory fill loops (see mov_l_predec_loop above)
+ *
+ *  COMBINE(bf_loop) is checked after a bf, and COMBINE(bfs_loop) after the
+ *  instruction in the delay slot of a bf/s.
+ */
+void COMBINE(bf_loop)(struct cpu *cpu, struct sh_instr_call *ic, int low_addr)
+{
+	int n_back = (low_addr >> SH_INSTR_ALIGNMENT_SHIFT)
+	    & (SH_IC_ENTRIES_PER_PAGE - 1);
+
+	if (n_back < 2 || !cpu->machine->allow_native_routines)
+		return;
+
+	if (ic[-2].f == instr(mov_l_rm_predec_rn) && ic[-1].f == instr(dt_rn)
+	    && ic[0].arg[1] == (size_t) &ic[-2] &&
+	    ic[-2].arg[0] != ic[-2].arg[1] &&
+	    ic[-2].arg[0] != ic[-1].arg[1] &&
+	    ic[-2].arg[1] != ic[-1].arg[1])
+		ic[-2].f = instr(mov_l_predec_loop);
+}
+void COMBINE(bfs_loop)(struct cpu *cpu, struct sh_instr_call *ic, int low_addr)
+{
+	int n_back = (low_addr >> SH_INSTR_ALIGNMENT_SHIFT)
+	    & (SH_IC_ENTRIES_PER_PAGE - 1);
+
+	if (n_back < 2 || !cpu->machine->allow_native_routines)
+		return;
+
+	if (ic[-2].f == instr(dt_rn) && ic[-1].f == instr(bf_s_samepage) &&
+	    ic[-1].arg[1] == (size_t) &ic[-2] &&
+	    ic[0].arg[0] != ic[0].arg[1] &&
+	    ic[0].arg[0] != ic[-2].arg[1] &&
+	    ic[0].arg[1] != ic[-2].arg[1])
+		ic[-2].f = instr(mov_l_predec_loop);
+}
+
+
+/*****************************************************************************/
+
+
 X(end_of_page)
 {
 	/*  Update the PC:  (offset 0, but on the next page)  */
@@ -3199,6 +3321,7 @@ X(to_be_translated)
 			break;
 		case 0x6:	/*  MOV.L Rm,@-Rn  */
 			ic->f = instr(mov_l_rm_predec_rn);
+			cpu->cd.sh.combination_check = COMBINE(bfs_loop);
 			break;
 		case 0x7:	/*  DIV0S Rm,Rn  */
 			ic->f = instr(div0s_rm_rn);
@@ -3658,6 +3781,8 @@ X(to_be_translated)
 			ic->f = samepage_function;
 		}
 
+		if (ic->f == instr(bf_samepage))
+			cpu->cd.sh.combination_check = COMBINE(bf_loop);
 		break;
 
 	case 0x9:	/*  MOV.W @(disp,PC),Rn  */
@@ -35,8 +35,21 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <ctype.h>
 #include <inttypes.h>
 
+
+/*  Max nr of opcodes to take from each instruction-frequency profile:  */
+#define	MAX_FROM_PROFILE	256
+
+struct profile_entry {
+	uint32_t	opcode;
+	long long	count;
+};
+
+static uint32_t *opcodes = NULL;
+static int n_opcodes = 0;
+
 /*
  *  generate_opcode():
  *
@@ -205,6 +218,134 @@ void generate_opcode(uint32_t opcode)
 }
 
 
+/*
+ *  add_opcode():
+ *
+ *  Adds an opcode to the list of opcodes to generate code for, unless it is
+ *  already in the list. Returns 1 if it was added, 0 otherwise.
+ */
+int add_opcode(uint32_t opcode)
+{
+	int i;
+
+	for (i=0; i<n_opcodes; i++)
+		if (opcodes[i] == opcode)
+			return 0;
+
+	opcodes = (uint32_t *) realloc(opcodes, sizeof(uint32_t) *
+	    (n_opcodes + 1));
+	if (opcodes == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+
+	opcodes[n_opcodes ++] = opcode;
+	return 1;
+}
+
+
+static int profile_entry_cmp(const void *a, const void *b)
+{
+	const struct profile_entry *pa = (const struct profile_entry *) a;
+	const struct profile_entry *pb = (const struct profile_entry *) b;
+
+	if (pa->count > pb->count)
+		return -1;
+	if (pa->count < pb->count)
+		return 1;
+	return pa->opcode < pb->opcode? -1 : (pa->opcode > pb->opcode);
+}
+
+
+/*
+ *  add_profile():
+ *
+ *  Reads an instruction-frequency profile, and adds the (at most
+ *  MAX_FROM_PROFILE) most frequently used load/store multiple opcodes to the
+ *  list of opcodes. Each line in the file is either just an opcode, or a
+ *  count followed by an opcode (as written by GATHER_BDT_STATISTICS in
+ *  cpu_arm_instr.cc, or by "uniq -c"). Lines for the same opcode are summed.
+ *
+ *  Unlike opcodes given on the command line, opcodes which cannot be handled
+ *  (s-bit set, r15 as the base register, or no registers) are silently
+ *  skipped, as are the condition bits.
+ */
+void add_profile(const char *filename)
+{
+	struct profile_entry *entries = NULL;
+	int n_entries = 0, n_added = 0, i;
+	char line[200];
+	FILE *f = fopen(filename, "r");
+
+	if (f == NULL) {
+		perror(filename);
+		exit(1);
+	}
+
+	while (fgets(line, sizeof(line), f) != NULL) {
+		long long a, b, count = 1;
+		uint32_t opcode;
+		int n = sscanf(line, "%lli %lli", &a, &b);
+
+		if (n == 2) {
+			count = a;
+			opcode = b;
+		} else if (n == 1)
+			opcode = a;
+		else
+			continue;
+
+		opcode &= 0x0fffffff;
+		if ((opcode & 0x0e000000) != 0x08000000 ||
+		    (opcode & 0x00400000) || ((opcode >> 16) & 15) == 15 ||
+		    (opcode & 0xffff) == 0)
+			continue;
+
+		for (i=0; i<n_entries; i++)
+			if (entries[i].opcode == opcode)
+				break;
+		if (i == n_entries) {
+			entries = (struct profile_entry *) realloc(entries,
+			    sizeof(struct profile_entry) * (n_entries + 1));
+			if (entries == NULL) {
+				fprintf(stderr, "out of memory\n");
+				exit(1);
+			}
+			entries[i].opcode = opcode;
+			entries[i].count = 0;
+			n_entries ++;
+		}
+		entries[i].count += count;
+	}
+
+	fclose(f);
+
+	qsort(entries, n_entries, sizeof(struct profile_entry),
+	    profile_entry_cmp);
+
+	for (i=0; i<n_entries && n_added<MAX_FROM_PROFILE; i++)
+		n_added += add_opcode(entries[i].opcode);
+
+	fprintf(stderr, "%s: %i load/store multiple opcodes, %i new\n",
+	    filename, n_entries, n_added);
+
+	free(entries);
+}
+
+
+static int table_index(uint32_t zz)
+{
+	return ((zz & 0x00800000) >> 16)
+	    |((zz & 0x00100000) >> 14)
+	    |((zz & 0x00040000) >> 13)
+	    |((zz & 0x00010000) >> 12)
+	    |((zz & 0x00000100) >>  5)
+	    |((zz & 0x00000040) >>  4)
+	    |((zz & 0x00000010) >>  3)
+	    |((zz & 0x00000004) >>  2);
+}
+
+
 /*
  *  main():
  *
@@ -226,10 +367,18 @@ int main(int argc, char *argv[])
 	int n_used[256];
 
 	if (argc < 2) {
-		fprintf(stderr, "usage: %s opcode [..]\n", argv[0]);
+		fprintf(stderr, "usage: %s opcode|profile [..]\n", argv[0]);
 		exit(1);
 	}
 
+	/*  Arguments are either opcodes, or names of profile files:  */
+	for (i=1; i<argc; i++) {
+		if (isdigit((unsigned char) argv[i][0]))
+			add_opcode(strtol(argv[i], NULL, 0));
+		else
+			add_profile(argv[i]);
+	}
+
 	printf("\n/*  AUTOMATICALLY GENERATED! Do not edit.  */\n\n"
 	    "#include <stdio.h>\n"
 	    "#include <stdlib.h>\n"
@@ -249,74 +398,36 @@ int main(int argc, char *argv[])
 	printf("\n\n");
 
 	/*  Generate the opcode functions:  */
-	for (i=1; i<argc; i++)
-		generate_opcode(strtol(argv[i], NULL, 0));
+	for (i=0; i<n_opcodes; i++)
+		generate_opcode(opcodes[i]);
 
 	/*  Generate 256 small lookup tables:  */
 	for (j=0; j<256; j++) {
-		int n = 0, zz, zz0;
-		for (i=1; i<argc; i++) {
-			zz = strtol(argv[i], NULL, 0);
-			zz = ((zz & 0x00800000) >> 16)
-			    |((zz & 0x00100000) >> 14)
-			    |((zz & 0x00040000) >> 13)
-			    |((zz & 0x00010000) >> 12)
-			    |((zz & 0x00000100) >>  5)
-			    |((zz & 0x00000040) >>  4)
-			    |((zz & 0x00000010) >>  3)
-			    |((zz & 0x00000004) >>  2);
-			if (zz == j)
+		int n = 0;
+		for (i=0; i<n_opcodes; i++)
+			if (table_index(opcodes[i]) == j)
 				n++;
-		}
 		printf("\nuint32_t multi_opcode_%i[%i] = {\n", j, n+1);
-		for (i=1; i<argc; i++) {
-			zz = zz0 = strtol(argv[i], NULL, 0);
-			zz = ((zz & 0x00800000) >> 16)
-			    |((zz & 0x00100000) >> 14)
-			    |((zz & 0x00040000) >> 13)
-			    |((zz & 0x00010000) >> 12)
-			    |((zz & 0x00000100) >>  5)
-			    |((zz & 0x00000040) >>  4)
-			    |((zz & 0x00000010) >>  3)
-			    |((zz & 0x00000004) >>  2);
-			if (zz == j)
-				printf("\t0x%08x,\n", zz0);
-		}
+		for (i=0; i<n_opcodes; i++)
+			if (table_index(opcodes[i]) == j)
+				printf("\t0x%08x,\n", opcodes[i]);
 		printf("0 };\n");
 	}
 
 	/*  Generate 256 tables with function pointers:  */
 	for (j=0; j<256; j++) {
-		int n = 0, zz, zz0;
-		for (i=1; i<argc; i++) {
-			zz = strtol(argv[i], NULL, 0);
-			zz = ((zz & 0x00800000) >> 16)
-			    |((zz & 0x00100000) >> 14)
-			    |((zz & 0x00040000) >> 13)
-			    |((zz & 0x00010000) >> 12)
-			    |((zz & 0x00000100) >>  5)
-			    |((zz & 0x00000040) >>  4)
-			    |((zz & 0x00000010) >>  3)
-			    |((zz & 0x00000004) >>  2);
-			if (zz == j)
+		int n = 0, zz0;
+		for (i=0; i<n_opcodes; i++)
+			if (table_index(opcodes[i]) == j)
 				n++;
-		}
 		n_used[j] = n;
 		if (n == 0)
 			continue;
 		printf("void (*multi_opcode_f_%i[%i])(struct cpu *,"
 		    " struct arm_instr_call *) = {\n", j, n*16);
-		for (i=1; i<argc; i++) {
-			zz = zz0 = strtol(argv[i], NULL, 0);
-			zz = ((zz & 0x00800000) >> 16)
-			    |((zz & 0x00100000) >> 14)
-			    |((zz & 0x00040000) >> 13)
-			    |((zz & 0x00010000) >> 12)
-			    |((zz & 0x00000100) >>  5)
-			    |((zz & 0x00000040) >>  4)
-			    |((zz & 0x00000010) >>  3)
-			    |((zz & 0x00000004) >>  2);
-			if (zz == j) {
+		for (i=0; i<n_opcodes; i++) {
+			zz0 = opcodes[i];
+			if (table_index(zz0) == j) {
 				printf("\tarm_instr_multi_0x%08x__eq,\n", zz0);
 				printf("\tarm_instr_multi_0x%08x__ne,\n", zz0);
 				printf("\tarm_instr_multi_0x%08x__cs,\n", zz0);
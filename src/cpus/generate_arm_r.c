@@ -62,6 +62,11 @@ void f(int s, int func, int only_name)
 	if (pc)
 		sync_pc();
 
+	/*  The flags may be modified (or read, by rrx), so they must be up
+	    to date before the shift:  */
+	if (s || (t == 6 && c == 0))
+		printf("\tARM_FLAGS_SYNC(cpu);\n");
+
 	switch (t) {
 
 	case 0:	/*  lsl c  (Logical Shift Left by constant)  */
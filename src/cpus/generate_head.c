@@ -73,6 +73,8 @@ int main(int argc, char *argv[])
 
 	printf("#define DYNTRANS_MAX_VPH_TLB_ENTRIES "
 	    "%s_MAX_VPH_TLB_ENTRIES\n", uppercase(a));
+	printf("#define DYNTRANS_DEFAULT_VPH_TLB_ENTRIES "
+	    "%s_DEFAULT_VPH_TLB_ENTRIES\n", uppercase(a));
 	printf("#define DYNTRANS_ARCH %s\n", a);
 	printf("#define DYNTRANS_%s\n", uppercase(a));
 
@@ -107,6 +109,9 @@ int main(int argc, char *argv[])
 	    uppercase(a));
 	printf("#define DYNTRANS_TC_ALLOCATE "
 	    "%s_tc_allocate_default_page\n", a);
+	printf("#define DYNTRANS_VPH_PADDR_LINK %s_vph_paddr_link\n", a);
+	printf("#define DYNTRANS_VPH_PADDR_UNLINK %s_vph_paddr_unlink\n", a);
+	printf("#define DYNTRANS_VPH_PARK %s_vph_park\n", a);
 	printf("#define DYNTRANS_TC_PHYSPAGE %s_tc_physpage\n", a);
 	printf("#define DYNTRANS_PC_TO_POINTERS %s_pc_to_pointers\n", a);
 	printf("#define DYNTRANS_PC_TO_POINTERS_GENERIC "
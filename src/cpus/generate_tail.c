@@ -64,6 +64,7 @@ int main(int argc, char *argv[])
 	printf("\n/*\n *  AUTOMATICALLY GENERATED! Do not edit.\n */\n\n");
 
 	printf("extern size_t dyntrans_cache_size;\n");
+	printf("extern int dyntrans_vph_tlb_entries;\n");
 
 	printf("#ifdef DYNTRANS_32\n");
 	printf("#define MODE32\n");
@@ -79,9 +80,17 @@ int main(int argc, char *argv[])
 	printf("#include \"cpu_dyntrans.cc\"\n");
 	printf("#undef DYNTRANS_INIT_TABLES\n\n");
 
+	printf("#define DYNTRANS_VPH_PADDR_INDEX_DEF\n");
+	printf("#include \"cpu_dyntrans.cc\"\n");
+	printf("#undef DYNTRANS_VPH_PADDR_INDEX_DEF\n\n");
+
 	printf("#define DYNTRANS_TC_ALLOCATE_DEFAULT_PAGE_DEF "
 	    "%s_tc_allocate_default_page\n", a);
+	printf("#define DYNTRANS_TC_UNMAP_PAGE %s_tc_unmap_page\n", a);
+	printf("#define DYNTRANS_TC_EVICT_PAGE %s_tc_evict_page\n", a);
 	printf("#include \"cpu_dyntrans.cc\"\n");
+	printf("#undef DYNTRANS_TC_EVICT_PAGE\n");
+	printf("#undef DYNTRANS_TC_UNMAP_PAGE\n");
 	printf("#undef DYNTRANS_TC_ALLOCATE_DEFAULT_PAGE_DEF\n\n");
 
 	printf("#define DYNTRANS_INVAL_ENTRY\n");
@@ -95,14 +104,27 @@ int main(int argc, char *argv[])
 
 	printf("#define DYNTRANS_INVALIDATE_TC_CODE "
 	    "%s_invalidate_code_translation\n", a);
+	printf("#define DYNTRANS_INVALIDATE_TC_PHYSPAGE "
+	    "%s_invalidate_tc_physpage\n", a);
 	printf("#include \"cpu_dyntrans.cc\"\n");
+	printf("#undef DYNTRANS_INVALIDATE_TC_PHYSPAGE\n");
 	printf("#undef DYNTRANS_INVALIDATE_TC_CODE\n\n");
 
 	printf("#define DYNTRANS_UPDATE_TRANSLATION_TABLE "
 	    "%s_update_translation_table\n", a);
+	printf("#define DYNTRANS_PHYSPAGE_HAS_TRANSLATIONS "
+	    "%s_physpage_has_translations\n", a);
 	printf("#include \"cpu_dyntrans.cc\"\n");
+	printf("#undef DYNTRANS_PHYSPAGE_HAS_TRANSLATIONS\n");
 	printf("#undef DYNTRANS_UPDATE_TRANSLATION_TABLE\n\n");
 
+	printf("#define DYNTRANS_STOP_TRANSLATED_RUN_DEF "
+	    "%s_stop_translated_run\n", a);
+	printf("#include \"cpu_dyntrans.cc\"\n");
+	printf("#undef DYNTRANS_STOP_TRANSLATED_RUN_DEF\n");
+	printf("#define DYNTRANS_STOP_TRANSLATED_RUN "
+	    "%s_stop_translated_run\n\n", a);
+
 	printf("#define MEMORY_RW %s_memory_rw\n", a);
 	printf("#define MEM_%s\n", uppercase(a));
 	printf("#include \"memory_rw.cc\"\n");
@@ -116,6 +138,19 @@ int main(int argc, char *argv[])
 	printf("#undef DYNTRANS_PC_TO_POINTERS_FUNC\n\n");
 	printf("#undef DYNTRANS_PC_TO_POINTERS_GENERIC\n\n");
 
+	printf("#define DYNTRANS_NATIVE_HOST_PAGE_DEF "
+	    "%s_native_host_page\n", a);
+	printf("#include \"cpu_dyntrans.cc\"\n");
+	printf("#undef DYNTRANS_NATIVE_HOST_PAGE_DEF\n");
+	printf("#define DYNTRANS_NATIVE_HOST_PAGE %s_native_host_page\n\n", a);
+
+	printf("#define DYNTRANS_TRANSLATE_READAHEAD_DEF "
+	    "%s_translate_readahead\n", a);
+	printf("#include \"cpu_dyntrans.cc\"\n");
+	printf("#undef DYNTRANS_TRANSLATE_READAHEAD_DEF\n");
+	printf("#define DYNTRANS_TRANSLATE_READAHEAD %s_translate_readahead\n\n",
+	    a);
+
 
 	printf("#define COMBINE_INSTRUCTIONS %s_combine_instructions\n", a);
 	printf("#ifndef DYNTRANS_32\n");
@@ -165,11 +200,17 @@ int main(int argc, char *argv[])
 	printf("#undef DYNTRANS_INVALIDATE_TC\n\n");
 	printf("#define DYNTRANS_INVALIDATE_TC_CODE "
 	    "%s32_invalidate_code_translation\n", a);
+	printf("#define DYNTRANS_INVALIDATE_TC_PHYSPAGE "
+	    "%s32_invalidate_tc_physpage\n", a);
 	printf("#include \"cpu_dyntrans.cc\"\n");
+	printf("#undef DYNTRANS_INVALIDATE_TC_PHYSPAGE\n");
 	printf("#undef DYNTRANS_INVALIDATE_TC_CODE\n\n");
 	printf("#define DYNTRANS_UPDATE_TRANSLATION_TABLE "
 	    "%s32_update_translation_table\n", a);
+	printf("#define DYNTRANS_PHYSPAGE_HAS_TRANSLATIONS "
+	    "%s32_physpage_has_translations\n", a);
 	printf("#include \"cpu_dyntrans.cc\"\n");
+	printf("#undef DYNTRANS_PHYSPAGE_HAS_TRANSLATIONS\n");
 	printf("#undef DYNTRANS_UPDATE_TRANSLATION_TABLE\n\n");
 	printf("#define DYNTRANS_PC_TO_POINTERS_FUNC %s32_pc_to_pointers\n", a);
 	printf("#define DYNTRANS_PC_TO_POINTERS_GENERIC "
@@ -179,6 +220,18 @@ int main(int argc, char *argv[])
 	printf("#include \"cpu_dyntrans.cc\"\n");
 	printf("#undef DYNTRANS_PC_TO_POINTERS_FUNC\n\n");
 	printf("#undef DYNTRANS_PC_TO_POINTERS_GENERIC\n\n");
+	printf("#define DYNTRANS_NATIVE_HOST_PAGE_DEF "
+	    "%s32_native_host_page\n", a);
+	printf("#include \"cpu_dyntrans.cc\"\n");
+	printf("#undef DYNTRANS_NATIVE_HOST_PAGE_DEF\n");
+	printf("#undef DYNTRANS_NATIVE_HOST_PAGE\n"
+	    "#define DYNTRANS_NATIVE_HOST_PAGE %s32_native_host_page\n\n", a);
+	printf("#define DYNTRANS_TRANSLATE_READAHEAD_DEF "
+	    "%s32_translate_readahead\n", a);
+	printf("#include \"cpu_dyntrans.cc\"\n");
+	printf("#undef DYNTRANS_TRANSLATE_READAHEAD_DEF\n");
+	printf("#undef DYNTRANS_TRANSLATE_READAHEAD\n#define "
+	    "DYNTRANS_TRANSLATE_READAHEAD %s32_translate_readahead\n\n", a);
 	printf("#undef COMBINE\n");
 	printf("#define COMBINE(n) %s32_combine_ ## n\n", a);
 	printf("#include \"quick_pc_to_pointers.h\"\n");
@@ -98,6 +98,23 @@ static int arm_check_access(struct cpu *cpu, int ap, int dav, int user)
 }
 
 
+/*
+ *  arm_walk_cache_invalidate():
+ *
+ *  Forget cached L2 descriptors for the page at vaddr, or all of them if
+ *  "all" is non-zero. Called on TLB flush operations and TTB changes.
+ */
+void arm_walk_cache_invalidate(struct cpu *cpu, uint32_t vaddr, int all)
+{
+	if (all)
+		memset(cpu->cd.arm.l2_walk_cache, 0,
+		    sizeof(cpu->cd.arm.l2_walk_cache));
+	else
+		cpu->cd.arm.l2_walk_cache[(vaddr >> 12) &
+		    (ARM_N_L2_WALK_CACHE - 1)].vpage = 0;
+}
+
+
 /*
  *  arm_translate_v2p_mmu():
  *
@@ -114,6 +131,7 @@ static int arm_check_access(struct cpu *cpu, int ap, int dav, int user)
 int arm_translate_v2p_mmu(struct cpu *cpu, uint64_t vaddr64,
 	uint64_t *return_paddr, int flags)
 {
+	struct arm_l2_walk_cache_entry *wc;
 	unsigned char *q;
 	uint32_t addr, d=0, d2 = (uint32_t)(int32_t)-1, ptba, vaddr = vaddr64;
 	int instr = flags & FLAG_INSTR;
@@ -164,21 +182,46 @@ int arm_translate_v2p_mmu(struct cpu *cpu, uint64_t vaddr64,
 			goto exception_return;
 		}
 		ptba = d & 0xfffffc00;
-		addr = ptba + ((vaddr & 0x000ff000) >> 10);
+		wc = &cpu->cd.arm.l2_walk_cache[(vaddr >> 12) &
+		    (ARM_N_L2_WALK_CACHE - 1)];
 
-		q = memory_paddr_to_hostaddr(cpu->mem, addr & 0x0fffffff, 0);
-		if (q == NULL) {
-			printf("arm memory blah blah adfh asfg asdgasdg\n");
-			exit(1);
-		}
-		d2 = *(uint32_t *)(q);
+		if (wc->vpage == ((vaddr & 0xfffff000) | 1) &&
+		    wc->ptba == ptba) {
+			d2 = wc->d2;
+		} else {
+			addr = ptba + ((vaddr & 0x000ff000) >> 10);
+
+			q = memory_paddr_to_hostaddr(cpu->mem,
+			    addr & 0x0fffffff, 0);
+			if (q == NULL) {
+				printf("arm memory blah blah adfh asfg "
+				    "asdgasdg\n");
+				exit(1);
+			}
+			d2 = *(uint32_t *)(q);
 #ifdef HOST_LITTLE_ENDIAN
-		if (cpu->byte_order == EMUL_BIG_ENDIAN)
+			if (cpu->byte_order == EMUL_BIG_ENDIAN)
 #else
-		if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
+			if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
 #endif
-			d2 = ((d2 & 0xff) << 24) | ((d2 & 0xff00) << 8) |
-			     ((d2 & 0xff0000) >> 8) | ((d2 & 0xff000000) >> 24);
+				d2 = ((d2 & 0xff) << 24) |
+				    ((d2 & 0xff00) << 8) |
+				    ((d2 & 0xff0000) >> 8) |
+				    ((d2 & 0xff000000) >> 24);
+
+			/*
+			 *  Only valid small (4KB, or 1KB/XScale extended)
+			 *  page descriptors are cached. A 64KB large page
+			 *  may be flushed from the TLB using any address
+			 *  within it, and invalid descriptors may become
+			 *  valid without any TLB flush at all.
+			 */
+			if ((d2 & 3) >= 2) {
+				wc->vpage = (vaddr & 0xfffff000) | 1;
+				wc->ptba = ptba;
+				wc->d2 = d2;
+			}
+		}
 
 		switch (d2 & 3) {
 		case 0:	fs = FAULT_TRANS_P;
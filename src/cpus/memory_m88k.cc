@@ -50,6 +50,67 @@
 /*  #define M8820X_TABLE_SEARCH_DEBUG  */
 
 
+/*
+ *  patc_index_remove(), patc_index_insert():
+ *
+ *  Helper functions which keep the PATC hash index in sync with the valid
+ *  PATC entries. Chains are kept sorted by entry number, so that a lookup
+ *  finds the same entry as a linear scan of the PATC would.
+ */
+static void patc_index_remove(struct m8820x_cmmu *cmmu, int i)
+{
+	int8_t *p = &cmmu->patc_hash[M8820X_PATC_HASH(
+	    cmmu->patc_v_and_control[i])];
+
+	while (*p != i)
+		p = &cmmu->patc_hash_next[(int) *p];
+	*p = cmmu->patc_hash_next[i];
+}
+
+static void patc_index_insert(struct m8820x_cmmu *cmmu, int i)
+{
+	int8_t *p = &cmmu->patc_hash[M8820X_PATC_HASH(
+	    cmmu->patc_v_and_control[i])];
+
+	while (*p >= 0 && *p < i)
+		p = &cmmu->patc_hash_next[(int) *p];
+	cmmu->patc_hash_next[i] = *p;
+	*p = i;
+}
+
+
+/*
+ *  m8820x_patc_index_init():
+ *
+ *  Initialize the PATC hash index of a (newly created) CMMU.
+ */
+void m8820x_patc_index_init(struct m8820x_cmmu *cmmu)
+{
+	int i;
+
+	memset(cmmu->patc_hash, -1, sizeof(cmmu->patc_hash));
+
+	for (i=0; i<N_M88200_PATC_ENTRIES; i++)
+		if (cmmu->patc_v_and_control[i] & PG_V)
+			patc_index_insert(cmmu, i);
+}
+
+
+/*
+ *  m8820x_patc_invalidate_entry():
+ *
+ *  Clear the valid bit of a PATC entry, and remove it from the index.
+ */
+void m8820x_patc_invalidate_entry(struct m8820x_cmmu *cmmu, int i)
+{
+	if (!(cmmu->patc_v_and_control[i] & PG_V))
+		return;
+
+	patc_index_remove(cmmu, i);
+	cmmu->patc_v_and_control[i] &= ~PG_V;
+}
+
+
 /*
  *  m8820x_mark_page_as_modified():
  *
@@ -82,6 +143,10 @@ void m8820x_mark_page_as_modified(struct cpu *cpu,
 	else
 		page_descriptor = BE32_TO_HOST(page_descriptor);
 
+	/*  Already marked? Then there is no need to write it back.  */
+	if ((page_descriptor & (PG_M | PG_U)) == (PG_M | PG_U))
+		return;
+
 	/*  ... set the Modified and Used bits:  */
 	page_descriptor |= PG_M | PG_U;
 
@@ -186,16 +251,16 @@ int m88k_translate_v2p(struct cpu *cpu, uint64_t vaddr64,
 	 *  4 KB pages. If writeflag is set, and a PATC entry is found without
 	 *  the Modified bit set, a page table search must be performed to
 	 *  set the Modified bit in emulated memory.
+	 *
+	 *  Only the valid entries on the hash chain for this virtual page
+	 *  need to be checked.
 	 */
-	for (i=0; i<N_M88200_PATC_ENTRIES; i++) {
+	for (i = cmmu->patc_hash[M8820X_PATC_HASH(vaddr)]; i >= 0;
+	    i = cmmu->patc_hash_next[i]) {
 		uint32_t vaddr_and_control = cmmu->patc_v_and_control[i];
 		uint32_t paddr_and_sbit = cmmu->patc_p_and_supervisorbit[i];
 
-		/*  Skip this entry if the valid bit isn't set:  */
-		if (!(vaddr_and_control & PG_V))
-			continue;
-
-		/*  ... or the virtual addresses don't match:  */
+		/*  Skip this entry if the virtual addresses don't match:  */
 		if ((vaddr & 0xfffff000) != (vaddr_and_control & 0xfffff000))
 			continue;
 
@@ -320,10 +385,12 @@ int m88k_translate_v2p(struct cpu *cpu, uint64_t vaddr64,
 		i = cmmu->patc_update_index;
 
 		/*  Invalidate the current entry, if it is valid:  */
-		if (cmmu->patc_v_and_control[i] & PG_V)
+		if (cmmu->patc_v_and_control[i] & PG_V) {
 			cpu->invalidate_translation_caches(cpu,
 			    cmmu->patc_v_and_control[i] & 0xfffff000,
 			    INVALIDATE_VADDR);
+			m8820x_patc_invalidate_entry(cmmu, i);
+		}
 
 		/*  ... and write the new one:  */
 		cmmu->patc_update_index ++;
@@ -333,6 +400,7 @@ int m88k_translate_v2p(struct cpu *cpu, uint64_t vaddr64,
 		cmmu->patc_p_and_supervisorbit[i] =
 		    (page_descriptor & 0xfffff000) |
 		    (supervisor? M8820X_PATC_SUPERVISOR_BIT : 0);
+		patc_index_insert(cmmu, i);
 	}
 
 	/*  Check for writes to read-only pages:  */
@@ -351,18 +419,21 @@ int m88k_translate_v2p(struct cpu *cpu, uint64_t vaddr64,
 
 		/*
 		 *  Write back the U bit (and possibly the M bit) to the page
-		 *  descriptor in emulated memory:
+		 *  descriptor in emulated memory, unless they were already
+		 *  set:
 		 */
 		tmp = page_descriptor | PG_U;
 		if (writeflag)
 			tmp |= PG_M;
 
-		if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
-			tmp = LE32_TO_HOST(tmp);
-		else
-			tmp = BE32_TO_HOST(tmp);
+		if (tmp != page_descriptor) {
+			if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
+				tmp = LE32_TO_HOST(tmp);
+			else
+				tmp = BE32_TO_HOST(tmp);
 
-		page_base[page_nr] = tmp;
+			page_base[page_nr] = tmp;
+		}
 	}
 
 	/*  Now finally return with the translated page address:  */
@@ -66,7 +66,6 @@ int TRANSLATE_ADDRESS(struct cpu *cpu, uint64_t vaddr,
 
 #ifdef V2P_MMU3K
 	const int x_64 = 0;
-	const int n_tlbs = 64;
 	const uint32_t pmask = 0xfff;
 	uint64_t xuseg_top;		/*  Well, useg actually.  */
 #else
@@ -82,7 +81,7 @@ int TRANSLATE_ADDRESS(struct cpu *cpu, uint64_t vaddr,
 	uint64_t xuseg_top = ENTRYHI_VPN2_MASK | 0x1fffULL;
 #endif
 	int x_64;	/*  non-zero for 64-bit address space accesses  */
-	int pageshift, n_tlbs;
+	int pageshift;
 	uint32_t pmask;
 #ifdef V2P_MMU4100
 	const int pagemask_mask = PAGEMASK_MASK_R4100;
@@ -183,8 +182,6 @@ int TRANSLATE_ADDRESS(struct cpu *cpu, uint64_t vaddr,
 		exit(1);
 	}
 
-	n_tlbs = cpu->cd.mips.cpu_type.nr_of_tlb_entries;
-
 	/*  Having this here suppresses a compiler warning:  */
 	pageshift = 12;
 
@@ -249,13 +246,37 @@ int TRANSLATE_ADDRESS(struct cpu *cpu, uint64_t vaddr,
 		int g_bit, v_bit, d_bit;
 		uint64_t cached_hi, cached_lo0;
 		uint64_t entry_vpn2 = 0, entry_asid, pfn;
-		int i_end;
+		uint32_t vpn, hash, global_hash;
+		uint16_t chains[3];
+		int chain = 0;
+
+		/*
+		 *  Only the TLB entries which may match need to be checked:
+		 *  the hash chain for this ASID, the hash chain for global
+		 *  entries, and the chain of entries with larger pages.
+		 *  (See the TLB lookup index comment in cpu_mips.h.)
+		 */
+#ifdef V2P_MMU3K
+		vpn = MIPS_TLB_VPN(1, vaddr);
+		hash = MIPS_TLB_HASH(vpn,
+		    vaddr_asid >> R2K3K_ENTRYHI_ASID_SHIFT);
+#else
+		vpn = MIPS_TLB_VPN(0, vaddr);
+		hash = MIPS_TLB_HASH(vpn, vaddr_asid);
+#endif
+		global_hash = MIPS_TLB_HASH(vpn, MIPS_TLB_GLOBAL_ASID);
 
-		i = cpu->cd.mips.last_written_tlb_index;
-		i_end = i == 0? n_tlbs-1 : i - 1;
+		chains[0] = cp0->tlb_hash[hash];
+		chains[1] = global_hash == hash? 0 : cp0->tlb_hash[global_hash];
+		chains[2] = cp0->tlb_large;
 
-		/*  Scan all TLB entries:  */
+		i = chains[0] - 1;
 		for (;;) {
+			while (i < 0 && chain < 2)
+				i = chains[++chain] - 1;
+			if (i < 0)
+				break;
+
 #ifdef V2P_MMU3K
 			/*  R3000 or similar:  */
 			cached_hi = cp0->tlbs[i].hi;
@@ -399,13 +420,8 @@ int TRANSLATE_ADDRESS(struct cpu *cpu, uint64_t vaddr,
 				}
 			}
 
-			if (i == i_end)
-				break;
-
-			/*  Go to the next TLB entry:  */
-			i ++;
-			if (i == n_tlbs)
-				i = 0;
+			/*  Go to the next TLB entry in the chain:  */
+			i = cp0->tlbs[i].hash_next - 1;
 		}
 	}
 
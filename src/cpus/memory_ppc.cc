@@ -29,6 +29,44 @@
  */
 
 
+/*
+ *  ppc_bat_update():
+ *
+ *  Decode the BAT registers into cpu->cd.ppc.bat[], and recalculate which
+ *  BATs may match within each 256 MB segment. This must be called whenever
+ *  any of the IBAT/DBAT SPRs are changed.
+ */
+void ppc_bat_update(struct cpu *cpu)
+{
+	int i, instr, user;
+
+	memset(cpu->cd.ppc.bat_segment_mask, 0,
+	    sizeof(cpu->cd.ppc.bat_segment_mask));
+
+	for (i=0; i<8; i++) {
+		int regnr = SPR_IBAT0U + i * 2;
+		uint32_t upper = cpu->cd.ppc.spr[regnr];
+		uint32_t lower = cpu->cd.ppc.spr[regnr + 1];
+		uint32_t mask = ((upper & BAT_BL) << 15) | 0x1ffff;
+		struct ppc_bat *bat = &cpu->cd.ppc.bat[i];
+		int segment;
+
+		bat->vaddr = upper & BAT_EPI & ~mask;
+		bat->mask  = mask;
+		bat->paddr = lower & BAT_RPN & ~mask;
+		bat->pp    = lower & BAT_PP;
+
+		/*  A block is at most 256 MB, and aligned to its size.  */
+		segment = bat->vaddr >> 28;
+		instr = i < 4;
+		for (user=0; user<2; user++)
+			if (upper & (user? BAT_Vu : BAT_Vs))
+				cpu->cd.ppc.bat_segment_mask[instr][user]
+				    [segment] |= 1 << (i & 3);
+	}
+}
+
+
 /*
  *  ppc_bat():
  *
@@ -38,12 +76,9 @@
 int ppc_bat(struct cpu *cpu, uint64_t vaddr, uint64_t *return_paddr, int flags,
 	int user)
 {
-	int i, istart = 0, iend = 8, pp;
-
-	if (flags & FLAG_INSTR)
-		iend = 4;
-	else
-		istart = 4;
+	int instr = flags & FLAG_INSTR? 1 : 0, i;
+	int candidates = cpu->cd.ppc.bat_segment_mask[instr][user][
+	    (vaddr >> 28) & 15];
 
 	if (cpu->cd.ppc.bits != 32) {
 		fatal("TODO: ppc_bat() for non-32-bit\n");
@@ -54,28 +89,23 @@ int ppc_bat(struct cpu *cpu, uint64_t vaddr, uint64_t *return_paddr, int flags,
 		exit(1);
 	}
 
-	/*  Scan either the 4 instruction BATs or the 4 data BATs:  */
-	for (i=istart; i<iend; i++) {
-		int regnr = SPR_IBAT0U + i * 2;
-		uint32_t upper = cpu->cd.ppc.spr[regnr];
-		uint32_t lower = cpu->cd.ppc.spr[regnr + 1];
-		uint32_t phys = lower & BAT_RPN, ebs = upper & BAT_EPI;
-		uint32_t mask = ((upper & BAT_BL) << 15) | 0x1ffff;
+	/*  Only the BATs which may map something in this segment are
+	    checked, in the same order as the hardware would do it:  */
+	for (i=0; candidates != 0; i++, candidates >>= 1) {
+		struct ppc_bat *bat;
 
-		/*  Not valid in either supervisor or user mode?  */
-		if (user && !(upper & BAT_Vu))
-			continue;
-		if (!user && !(upper & BAT_Vs))
+		if (!(candidates & 1))
 			continue;
 
+		bat = &cpu->cd.ppc.bat[instr? i : i + 4];
+
 		/*  Virtual address mismatch? Then skip.  */
-		if ((vaddr & ~mask) != (ebs & ~mask))
+		if ((vaddr & ~bat->mask) != bat->vaddr)
 			continue;
 
-		*return_paddr = (vaddr & mask) | (phys & ~mask);
+		*return_paddr = (vaddr & bat->mask) | bat->paddr;
 
-		pp = lower & BAT_PP;
-		switch (pp) {
+		switch (bat->pp) {
 		case BAT_PP_NONE:
 			return 0;
 		case BAT_PP_RO_S:
@@ -90,6 +120,23 @@ int ppc_bat(struct cpu *cpu, uint64_t vaddr, uint64_t *return_paddr, int flags,
 }
 
 
+/*
+ *  ppc_pte_cache_invalidate():
+ *
+ *  Invalidate cached page table entries for the page at vaddr (for any VSID),
+ *  or all entries if "all" is non-zero. Called on tlbie, tlbia, and when SDR1
+ *  is written to.
+ */
+void ppc_pte_cache_invalidate(struct cpu *cpu, uint64_t vaddr, int all)
+{
+	if (all)
+		memset(cpu->cd.ppc.pte_cache, 0, sizeof(cpu->cd.ppc.pte_cache));
+	else
+		cpu->cd.ppc.pte_cache[(vaddr >> 12) & (PPC_N_PTE_CACHE - 1)]
+		    .key = 0;
+}
+
+
 /*
  *  get_pte_low():
  *
@@ -141,6 +188,10 @@ static int ppc_vtp32(struct cpu *cpu, uint32_t vaddr, uint64_t *return_paddr,
 	uint64_t sdr1 = cpu->cd.ppc.spr[SPR_SDR1], htaborg;
 	uint32_t hash1, hash2, pteg_select, tmp;
 	uint32_t lower_pte = 0, cmp;
+	struct ppc_pte_cache_entry *cached = &cpu->cd.ppc.pte_cache[
+	    (vaddr >> 12) & (PPC_N_PTE_CACHE - 1)];
+	uint64_t pte_key = PPC_PTE_CACHE_VALID | ((uint64_t) vsid << 16) |
+	    ((vaddr >> 12) & 0xffff);
 
 	htaborg = sdr1 & 0xffff0000UL;
 
@@ -153,7 +204,14 @@ static int ppc_vtp32(struct cpu *cpu, uint32_t vaddr, uint64_t *return_paddr,
 	cpu->cd.ppc.spr[SPR_HASH1] = pteg_select;
 	cmp = cpu->cd.ppc.spr[instr? SPR_ICMP : SPR_DCMP] =
 	    PTE_VALID | api | (vsid << PTE_VSID_SHFT);
-	match = get_pte_low(cpu, pteg_select, &lower_pte, cmp);
+
+	/*  The HASH and CMP SPRs above are still set, but the page table
+	    is only scanned if the PTE isn't already cached:  */
+	if (cached->key == pte_key) {
+		lower_pte = cached->lower_pte;
+		match = 2;
+	} else
+		match = get_pte_low(cpu, pteg_select, &lower_pte, cmp);
 
 	/*  Secondary hash:  */
 	hash2 = hash1 ^ 0x7ffff;
@@ -172,6 +230,11 @@ static int ppc_vtp32(struct cpu *cpu, uint32_t vaddr, uint64_t *return_paddr,
 	if (!match)
 		return 0;
 
+	if (match == 1) {
+		cached->key = pte_key;
+		cached->lower_pte = lower_pte;
+	}
+
 	/*  Non-executable, or Guarded page?  */
 	if (instr && cpu->cd.ppc.sr[srn] & SR_NOEXEC)
 		return 1;
@@ -59,6 +59,7 @@
  *  Returns one of the following:
  *	MEMORY_ACCESS_FAILED
  *	MEMORY_ACCESS_OK
+ *	MEMORY_ACCESS_NO_RESERVATION	(only for MEMORY_STORE_CONDITIONAL)
  *
  *  (MEMORY_ACCESS_FAILED is 0.)
  */
@@ -100,6 +101,24 @@ int MEMORY_RW(struct cpu *cpu, struct memory *mem, uint64_t vaddr,
 	}
 
 
+	/*
+	 *  Watchpoints: Pages which contain watched addresses are never
+	 *  mapped as writable by update_translation_table(), so all stores
+	 *  to such pages end up here, where the exact range is checked. The
+	 *  store is carried out, and the current run of translated
+	 *  instructions ends right after it.
+	 */
+	if (writeflag == MEM_WRITE && cpu->machine->watchpoints.n > 0 &&
+	    !no_exceptions && !(misc_flags & PHYSICAL)) {
+		int w = machine_watchpoint_lookup(cpu->machine, vaddr, len,
+		    cpu->is_32bit? 0xffffffffULL : (uint64_t) -1);
+		if (w >= 0) {
+			cpu_watchpoint_hit(cpu, w, vaddr, data, len);
+			DYNTRANS_STOP_TRANSLATED_RUN(cpu);
+		}
+	}
+
+
 	/*
 	 *  Memory mapped device?
 	 *
@@ -205,6 +224,17 @@ not just the device in question.
 					    wf, orig_paddr & ~offset_mask);
 				}
 
+				/*  Reservations work on devices too, but
+				    without comparing the data:  */
+				if (misc_flags & MEMORY_STORE_CONDITIONAL &&
+				    !memory_reservation_store(cpu, mem,
+				    orig_paddr, NULL, data, len))
+					return MEMORY_ACCESS_NO_RESERVATION;
+				if (writeflag == MEM_WRITE &&
+				    mem->reservations != NULL)
+					memory_reservation_invalidate(mem,
+					    orig_paddr, len);
+
 				res = 0;
 				if (!no_exceptions || (mem->devices[i].flags &
 				    DM_READS_HAVE_NO_SIDE_EFFECTS))
@@ -212,6 +242,10 @@ not just the device in question.
 					    data, len, writeflag,
 					    mem->devices[i].extra);
 
+				if (res > 0 && misc_flags & MEMORY_LOAD_LINKED)
+					memory_reservation_set(cpu, mem,
+					    orig_paddr, data, len);
+
 				if (res == 0)
 					res = -1;
 
@@ -345,7 +379,7 @@ not just the device in question.
 	 *      in that page.
 	 */
 	memblock = memory_paddr_to_hostaddr(mem, paddr & ~offset_mask,
-	    writeflag);
+	    misc_flags & MEMORY_LOAD_LINKED? MEM_WRITE : writeflag);
 	if (memblock == NULL) {
 		if (writeflag == MEM_READ)
 			memset(data, 0, len);
@@ -369,25 +403,40 @@ not just the device in question.
 		    paddr & ~offset_mask);
 
 	/*
-	 *  If writing, or if mapping a page where writing is ok later on,
-	 *  then invalidate code translations for the (physical) page address:
+	 *  If writing, then invalidate code translations for the written
+	 *  part of the (physical) page. (Pages with code translations are
+	 *  never mapped as writable by update_translation_table(), so all
+	 *  writes to such pages end up here.) Large writes invalidate the
+	 *  entire page.
 	 */
 
-	if ((writeflag == MEM_WRITE
-	    || (ok == 2 && cache == CACHE_DATA)
-	    ) && cpu->invalidate_code_translation != NULL)
-		cpu->invalidate_code_translation(cpu, paddr, INVALIDATE_PADDR);
+	if (writeflag == MEM_WRITE && cpu->invalidate_code_translation != NULL)
+		cpu->invalidate_code_translation(cpu, paddr, INVALIDATE_PADDR
+		    | (len <= 8? INVALIDATE_SUBPAGE : 0));
 
 	if ((paddr&((1<<BITS_PER_MEMBLOCK)-1)) + len > (1<<BITS_PER_MEMBLOCK)) {
 		printf("Write over memblock boundary?\n");
 		exit(1);
 	}
 
-	/*  And finally, read or write the data:  */
-	if (writeflag == MEM_WRITE)
+	/*
+	 *  And finally, read or write the data. A store conditional is done
+	 *  as a compare-and-swap against the data which was loaded, and other
+	 *  writes break any reservations on the same granule.
+	 */
+	if (misc_flags & MEMORY_STORE_CONDITIONAL) {
+		if (!memory_reservation_store(cpu, mem, paddr,
+		    memblock + offset, data, len))
+			return MEMORY_ACCESS_NO_RESERVATION;
+	} else if (writeflag == MEM_WRITE) {
+		if (mem->reservations != NULL)
+			memory_reservation_invalidate(mem, paddr, len);
 		memcpy(memblock + offset, data, len);
-	else
+	} else {
 		memcpy(data, memblock + offset, len);
+		if (misc_flags & MEMORY_LOAD_LINKED)
+			memory_reservation_set(cpu, mem, paddr, data, len);
+	}
 
 do_return_ok:
 	return MEMORY_ACCESS_OK;
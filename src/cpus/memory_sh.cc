@@ -38,12 +38,119 @@
 #include "thirdparty/sh4_mmu.h"
 
 
+/*  Page size shift for each page size index (1K, 4K, 64K, 1M):  */
+static const int utlb_pagesize_shift[SH_UTLB_N_PAGESIZES] = { 10, 12, 16, 20 };
+
+/*  The SZ field is bits 4 and 7 of PTEL; this gives 0..3 for 1K..1M:  */
+#define	UTLB_PAGESIZE(lo)	((((lo) >> 4) & 1) | (((lo) >> 6) & 2))
+
+static inline int utlb_hash(uint32_t vaddr, int pagesize)
+{
+	uint32_t vpn = vaddr >> utlb_pagesize_shift[pagesize];
+	return (vpn ^ (vpn >> 6)) & (SH_UTLB_HASH_SIZE - 1);
+}
+
+
+/*
+ *  sh_utlb_index_update():
+ *
+ *  Remove UTLB entry e from the hash index, and re-insert it if it is valid.
+ *  This must be called whenever utlb_hi[e] or utlb_lo[e] is modified.
+ */
+void sh_utlb_index_update(struct cpu *cpu, int e)
+{
+	int old = cpu->cd.sh.utlb_hash_bucket[e], pagesize;
+	uint32_t hi = cpu->cd.sh.utlb_hi[e], lo = cpu->cd.sh.utlb_lo[e];
+	int8_t *p;
+
+	if (old >= 0) {
+		p = &cpu->cd.sh.utlb_hash[old / SH_UTLB_HASH_SIZE]
+		    [old % SH_UTLB_HASH_SIZE];
+		while (*p != e)
+			p = &cpu->cd.sh.utlb_hash_next[(int) *p];
+		*p = cpu->cd.sh.utlb_hash_next[e];
+
+		cpu->cd.sh.utlb_n_per_pagesize[old / SH_UTLB_HASH_SIZE] --;
+		cpu->cd.sh.utlb_hash_bucket[e] = -1;
+	}
+
+	if (!(lo & SH4_PTEL_V))
+		return;
+
+	/*  Insert the entry, keeping the chain sorted by entry number:  */
+	pagesize = UTLB_PAGESIZE(lo);
+	old = utlb_hash(hi, pagesize);
+	p = &cpu->cd.sh.utlb_hash[pagesize][old];
+	while (*p >= 0 && *p < e)
+		p = &cpu->cd.sh.utlb_hash_next[(int) *p];
+	cpu->cd.sh.utlb_hash_next[e] = *p;
+	*p = e;
+
+	cpu->cd.sh.utlb_n_per_pagesize[pagesize] ++;
+	cpu->cd.sh.utlb_hash_bucket[e] = pagesize * SH_UTLB_HASH_SIZE + old;
+}
+
+
+/*
+ *  sh_utlb_index_init():
+ *
+ *  Build the UTLB hash index from scratch.
+ */
+void sh_utlb_index_init(struct cpu *cpu)
+{
+	int e;
+
+	memset(cpu->cd.sh.utlb_hash, -1, sizeof(cpu->cd.sh.utlb_hash));
+	memset(cpu->cd.sh.utlb_n_per_pagesize, 0,
+	    sizeof(cpu->cd.sh.utlb_n_per_pagesize));
+
+	for (e=0; e<SH_N_UTLB_ENTRIES; e++) {
+		cpu->cd.sh.utlb_hash_bucket[e] = -1;
+		sh_utlb_index_update(cpu, e);
+	}
+}
+
+
+/*
+ *  tlb_entry_matches():
+ *
+ *  Returns 1 if the ITLB or UTLB entry hi/lo is valid and maps vaddr for the
+ *  current ASID (or is shared), 0 otherwise. *maskp is set to the page mask.
+ */
+static int tlb_entry_matches(uint32_t hi, uint32_t lo, uint32_t vaddr,
+	int require_asid_match, int cur_asid, uint32_t *maskp)
+{
+	uint32_t mask = 0xfff00000;
+
+	if (!(lo & SH4_PTEL_V))
+		return 0;
+
+	switch (lo & SH4_PTEL_SZ_MASK) {
+	case SH4_PTEL_SZ_1K:  mask = 0xfffffc00; break;
+	case SH4_PTEL_SZ_4K:  mask = 0xfffff000; break;
+	case SH4_PTEL_SZ_64K: mask = 0xffff0000; break;
+	/*  case SH4_PTEL_SZ_1M:  mask = 0xfff00000; break;  */
+	}
+
+	*maskp = mask;
+
+	if ((hi & mask) != (vaddr & mask))
+		return 0;
+
+	if (!(lo & SH4_PTEL_SH) && require_asid_match &&
+	    (int) (hi & SH4_PTEH_ASID_MASK) != cur_asid)
+		return 0;
+
+	return 1;
+}
+
+
 /*
  *  translate_via_mmu():
  *
- *  Scan the UTLB for a matching virtual address. If a match was found, then
- *  check permission bits etc. If everything was ok, then return the physical
- *  page address, otherwise cause an exception.
+ *  Look up the virtual address in the UTLB (via the hash index, see above).
+ *  If a match was found, then check permission bits etc. If everything was
+ *  ok, then return the physical page address, otherwise cause an exception.
  *
  *  The implementation should (hopefully) be quite complete, except for lack
  *  of "Multiple matching entries" detection. (On a real CPU, these would
@@ -57,11 +164,9 @@ static int translate_via_mmu(struct cpu *cpu, uint32_t vaddr,
 	int wf = flags & FLAG_WRITEFLAG;
 	int i, urb, urc, require_asid_match, cur_asid, expevt = 0;
 	uint32_t hi, lo = 0, mask = 0;
-	int sh;		/*  Shared  */
 	int d;		/*  Dirty bit  */
-	int v;		/*  Valid bit  */
 	int pr;		/*  Protection  */
-	int i_start;
+	int found = 0, itlb_hit = 0, pagesize;
 
 	cur_asid = cpu->cd.sh.pteh & SH4_PTEH_ASID_MASK;
 	require_asid_match = !(cpu->cd.sh.mmucr & SH4_MMUCR_SV)
@@ -90,55 +195,46 @@ static int translate_via_mmu(struct cpu *cpu, uint32_t vaddr,
 		cpu->cd.sh.mmucr |= (urc << SH4_MMUCR_URC_SHIFT);
 	}
 
-	/*
-	 *  When doing Instruction lookups, the ITLB should be scanned first.
-	 *  This is done by using negative i. (Ugly hack, but works.)
-	 */
-	if (flags & FLAG_INSTR)
-		i_start = -SH_N_ITLB_ENTRIES;
-	else
-		i_start = 0;
-
-	for (i=i_start; i<SH_N_UTLB_ENTRIES; i++) {
-		if (i<0) {
-			hi = cpu->cd.sh.itlb_hi[i + SH_N_ITLB_ENTRIES];
-			lo = cpu->cd.sh.itlb_lo[i + SH_N_ITLB_ENTRIES];
-		} else {
-			hi = cpu->cd.sh.utlb_hi[i];
-			lo = cpu->cd.sh.utlb_lo[i];
-		}
-		mask = 0xfff00000;
-
-		v = lo & SH4_PTEL_V;
-		if (!v)
-			continue;
-
-		switch (lo & SH4_PTEL_SZ_MASK) {
-		case SH4_PTEL_SZ_1K:  mask = 0xfffffc00; break;
-		case SH4_PTEL_SZ_4K:  mask = 0xfffff000; break;
-		case SH4_PTEL_SZ_64K: mask = 0xffff0000; break;
-		/*  case SH4_PTEL_SZ_1M:  mask = 0xfff00000; break;  */
+	/*  When doing Instruction lookups, the ITLB is scanned first:  */
+	if (flags & FLAG_INSTR) {
+		for (i=0; i<SH_N_ITLB_ENTRIES; i++) {
+			hi = cpu->cd.sh.itlb_hi[i];
+			lo = cpu->cd.sh.itlb_lo[i];
+			if (tlb_entry_matches(hi, lo, vaddr,
+			    require_asid_match, cur_asid, &mask)) {
+				found = itlb_hit = 1;
+				break;
+			}
 		}
+	}
 
-		if ((hi & mask) != (vaddr & mask))
+	/*
+	 *  Then the UTLB, one hash chain per page size that is in use.
+	 *  Note/TODO: Check for multiple matches is not implemented.
+	 */
+	for (pagesize=0; pagesize<SH_UTLB_N_PAGESIZES && !found; pagesize++) {
+		if (cpu->cd.sh.utlb_n_per_pagesize[pagesize] == 0)
 			continue;
 
-		sh = lo & SH4_PTEL_SH;
-
-		if (!sh && require_asid_match) {
-			int asid = hi & SH4_PTEH_ASID_MASK;
-			if (asid != cur_asid)
-				continue;
+		for (i = cpu->cd.sh.utlb_hash[pagesize]
+		    [utlb_hash(vaddr, pagesize)]; i >= 0;
+		    i = cpu->cd.sh.utlb_hash_next[i]) {
+			hi = cpu->cd.sh.utlb_hi[i];
+			lo = cpu->cd.sh.utlb_lo[i];
+			if (tlb_entry_matches(hi, lo, vaddr,
+			    require_asid_match, cur_asid, &mask)) {
+				found = 1;
+				cpu->cd.sh.utlb_index_hits ++;
+				break;
+			}
 		}
-
-		/*  Note/TODO: Check for multiple matches is not implemented. */
-
-		break;
 	}
 
 	/*  Virtual address not found? Then it's a TLB miss.  */
-	if (i == SH_N_UTLB_ENTRIES)
+	if (!found) {
+		cpu->cd.sh.utlb_index_misses ++;
 		goto tlb_miss;
+	}
 
 	/*  Matching address found! Let's see whether it is
 	    readable/writable, etc.:  */
@@ -158,7 +254,7 @@ static int translate_via_mmu(struct cpu *cpu, uint32_t vaddr,
 		 *  If a matching entry wasn't found in the ITLB, but in the
 		 *  UTLB, then copy it to a random place in the ITLB.
 		 */
-		if (i >= 0 && !(flags & FLAG_NOEXCEPTIONS)) {
+		if (!itlb_hit && !(flags & FLAG_NOEXCEPTIONS)) {
 			int r = random() % SH_N_ITLB_ENTRIES;
 
 			/*  NOTE: Make sure that the old mapping for
@@ -0,0 +1,433 @@
+/*
+ *  Copyright (C) 2010  Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ *
+ *
+ *  Guest routines which are run natively on the host.
+ *
+ *  Some guest routines, such as memset, memcpy and strlen, are called so
+ *  often that emulating them instruction by instruction is a large part of
+ *  the total running time. There are two ways such routines are recognized:
+ *
+ *	o)  By symbol name: when a call instruction (ARM bl, MIPS jal, or
+ *	    PowerPC bl) is translated, the target address is looked up in the
+ *	    machine's symbol context. If it is the start of one of the routines
+ *	    in native_routine_names[], the call is translated into an
+ *	    instruction call which runs native_routine_run() instead.
+ *
+ *	o)  By instruction pattern: instruction combinations in the cpu
+ *	    specific code (e.g. netbsd_memset in cpu_arm_instr.cc) recognize
+ *	    the inner loops of such routines. The most common ones are the
+ *	    tight store loops which kernels use to zero or copy whole pages
+ *	    (fill_loop and copy_loop); these are run one host page at a time.
+ *
+ *  Both kinds are counted per cpu (see native_routine_hits in cpu.h), and
+ *  both can be turned off with the machine's allow_native_routines setting.
+ *
+ *  Guest memory is only accessed through the host pages of the fast lookup
+ *  tables (host_load and host_store). If any page which a routine needs
+ *  is not there, nothing is done, and the guest's own code is run instead.
+ *  This means that exceptions and device accesses are always handled by
+ *  the guest code, and that pages which contain translated code are never
+ *  written to. (Such pages do not have host_store pointers.)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu.h"
+#include "machine.h"
+#include "native_routines.h"
+#include "symbol.h"
+
+
+#define	NATIVE_PAGE_SHIFT	12
+#define	NATIVE_PAGE_SIZE	(1 << NATIVE_PAGE_SHIFT)
+#define	NATIVE_PAGE_MASK	(NATIVE_PAGE_SIZE - 1)
+
+
+static const char *native_routine_names[N_NATIVE_ROUTINES] = {
+	"none", "memset", "bzero", "memcpy", "memmove", "bcopy", "strlen",
+	"fill_loop", "copy_loop", "copyin", "copyout", "scanc", "cache_inv",
+	"memcpy_loop", "strlen_loop"
+};
+
+
+/*
+ *  native_routine_name():
+ *
+ *  Returns the name of a native routine, e.g. "memcpy".
+ */
+const char *native_routine_name(int id)
+{
+	if (id < 0 || id >= N_NATIVE_ROUTINES)
+		return "unknown";
+
+	return native_routine_names[id];
+}
+
+
+/*
+ *  native_fill_pattern():
+ *
+ *  Fills len bytes at host address p with copies of a 4 or 8 byte guest
+ *  word, stored in the guest's byte order. len should be a multiple of the
+ *  word size. (Used by the fill loop instruction combinations.)
+ */
+void native_fill_pattern(unsigned char *p, uint64_t value, int wordsize,
+	int little_endian, size_t len)
+{
+	unsigned char pattern[8];
+	size_t filled, n;
+	int i;
+
+	for (i=0; i<wordsize; i++)
+		pattern[little_endian? i : wordsize-1-i] = value >> (8*i);
+
+	for (i=1; i<wordsize; i++)
+		if (pattern[i] != pattern[0])
+			break;
+
+	if (i == wordsize) {
+		memset(p, pattern[0], len);
+		return;
+	}
+
+	/*  Store the first word, and then double the filled area:  */
+	filled = len < (size_t)wordsize? len : wordsize;
+	memcpy(p, pattern, filled);
+	while (filled < len) {
+		n = len - filled < filled? len - filled : filled;
+		memcpy(p + filled, p, n);
+		filled += n;
+	}
+}
+
+
+/*
+ *  native_routine_by_symbol():
+ *
+ *  Returns the native routine whose symbol starts at a specific (virtual)
+ *  address, or NATIVE_ROUTINE_NONE. Only exact name matches count. (E.g.
+ *  NetBSD's _memcpy is not called the same way as memcpy.)
+ */
+static int native_routine_by_symbol(struct machine *machine, uint64_t addr)
+{
+	uint64_t offset;
+	char *name;
+	int id;
+
+	name = get_symbol_name(&machine->symbol_context, addr, &offset);
+	if (name == NULL || offset != 0)
+		return NATIVE_ROUTINE_NONE;
+
+	for (id = NATIVE_ROUTINE_NONE + 1; id < N_NATIVE_SYMBOL_ROUTINES; id++)
+		if (strcmp(name, native_routine_names[id]) == 0)
+			return id;
+
+	return NATIVE_ROUTINE_NONE;
+}
+
+
+/*
+ *  native_routine_has_breakpoint():
+ *
+ *  Returns 1 if there is a breakpoint anywhere within the symbol which
+ *  starts at addr, 0 otherwise. (The routine's own instructions are never
+ *  executed when it is run natively, so a breakpoint in the middle of it
+ *  would never be hit.)
+ */
+static int native_routine_has_breakpoint(struct machine *machine,
+	uint64_t addr)
+{
+	struct breakpoints *bp = &machine->breakpoints;
+	uint64_t offset;
+	int i;
+
+	for (i=0; i<bp->n; i++) {
+		if (get_symbol_name(&machine->symbol_context, bp->addr[i],
+		    &offset) == NULL)
+			continue;
+
+		/*  (32-bit compare, since breakpoint addresses may or may
+		    not be sign-extended.)  */
+		if (((bp->addr[i] - offset) & 0xffffffffULL) ==
+		    (addr & 0xffffffffULL))
+			return 1;
+	}
+
+	return 0;
+}
+
+
+/*
+ *  native_routine_lookup():
+ *
+ *  Returns the native routine which starts at a specific (virtual) address,
+ *  or NATIVE_ROUTINE_NONE if there is no such routine, or if native routines
+ *  are not allowed for this machine. Just like instruction combinations,
+ *  they are not used while single-stepping or tracing, since the routine's
+ *  instructions would then not be seen, nor when there is a breakpoint
+ *  anywhere in the routine.
+ */
+int native_routine_lookup(struct machine *machine, uint64_t addr)
+{
+	extern int single_step;
+
+	if (!machine->allow_native_routines || single_step ||
+	    machine->instruction_trace || machine->show_trace_tree)
+		return NATIVE_ROUTINE_NONE;
+
+	if (machine->breakpoints.n > 0 &&
+	    native_routine_has_breakpoint(machine, addr))
+		return NATIVE_ROUTINE_NONE;
+
+	return native_routine_by_symbol(machine, addr);
+}
+
+
+/*
+ *  native_pages_present():
+ *
+ *  Returns 1 if all pages in the range [addr, addr+len) have host pages,
+ *  0 otherwise.
+ */
+static int native_pages_present(struct cpu *cpu, uint64_t addr, uint64_t len,
+	int writeflag, native_host_page_fn host_page)
+{
+	uint64_t page, last;
+
+	if (len == 0)
+		return 1;
+
+	page = addr & ~(uint64_t)NATIVE_PAGE_MASK;
+	last = (addr + len - 1) & ~(uint64_t)NATIVE_PAGE_MASK;
+
+	for (;;) {
+		if (host_page(cpu, page, writeflag) == NULL)
+			return 0;
+		if (page == last)
+			return 1;
+		page += NATIVE_PAGE_SIZE;
+	}
+}
+
+
+/*
+ *  native_fill():
+ *
+ *  Fills len bytes at guest address dst with the byte c. All pages must
+ *  already have been checked with native_pages_present().
+ */
+static void native_fill(struct cpu *cpu, uint64_t dst, int c, uint64_t len,
+	native_host_page_fn host_page)
+{
+	while (len > 0) {
+		uint32_t ofs = dst & NATIVE_PAGE_MASK;
+		uint64_t n = NATIVE_PAGE_SIZE - ofs;
+		if (n > len)
+			n = len;
+
+		memset(host_page(cpu, dst, 1) + ofs, c, n);
+		dst += n;
+		len -= n;
+	}
+}
+
+
+/*
+ *  native_copy():
+ *
+ *  Copies len bytes from guest address src to guest address dst. If the
+ *  areas overlap, the copy is done backwards when necessary, so that the
+ *  result is the same as for memmove. All pages must already have been
+ *  checked with native_pages_present().
+ */
+static void native_copy(struct cpu *cpu, uint64_t dst, uint64_t src,
+	uint64_t len, native_host_page_fn host_page)
+{
+	uint32_t dst_ofs, src_ofs;
+	uint64_t n;
+
+	if (dst - src >= len) {
+		/*  Forward:  */
+		while (len > 0) {
+			dst_ofs = dst & NATIVE_PAGE_MASK;
+			src_ofs = src & NATIVE_PAGE_MASK;
+			n = NATIVE_PAGE_SIZE - (dst_ofs > src_ofs?
+			    dst_ofs : src_ofs);
+			if (n > len)
+				n = len;
+
+			memmove(host_page(cpu, dst, 1) + dst_ofs,
+			    host_page(cpu, src, 0) + src_ofs, n);
+			dst += n;
+			src += n;
+			len -= n;
+		}
+	} else {
+		/*  Backwards, from the end:  */
+		dst += len;
+		src += len;
+		while (len > 0) {
+			/*  Bytes left on the pages before dst and src:  */
+			dst_ofs = ((dst - 1) & NATIVE_PAGE_MASK) + 1;
+			src_ofs = ((src - 1) & NATIVE_PAGE_MASK) + 1;
+			n = dst_ofs < src_ofs? dst_ofs : src_ofs;
+			if (n > len)
+				n = len;
+
+			dst -= n;
+			src -= n;
+			memmove(host_page(cpu, dst, 1) + (dst_ofs - n),
+			    host_page(cpu, src, 0) + (src_ofs - n), n);
+			len -= n;
+		}
+	}
+}
+
+
+/*
+ *  native_strlen():
+ *
+ *  Returns the length of the string at guest address s, or -1 if the string
+ *  runs into a page which is not present, or is longer than
+ *  NATIVE_ROUTINE_MAX_LEN.
+ */
+static int64_t native_strlen(struct cpu *cpu, uint64_t s,
+	native_host_page_fn host_page)
+{
+	int64_t len = 0;
+
+	while (len < NATIVE_ROUTINE_MAX_LEN) {
+		unsigned char *page = host_page(cpu, s, 0), *p, *end;
+		uint64_t n = NATIVE_PAGE_SIZE - (s & NATIVE_PAGE_MASK);
+
+		if (page == NULL)
+			return -1;
+
+		p = page + (s & NATIVE_PAGE_MASK);
+		end = (unsigned char *) memchr(p, '\0', n);
+		if (end != NULL)
+			return len + (end - p);
+
+		len += n;
+		s += n;
+	}
+
+	return -1;
+}
+
+
+/*
+ *  native_routine_run():
+ *
+ *  Runs a guest routine natively. args[] contains the routine's first three
+ *  arguments, in the order of the C prototype (e.g. dst, c, len for memset),
+ *  and *retvalp is set to the routine's return value.
+ *
+ *  Returns 1 if the routine was run, or 0 if the guest code should be run
+ *  instead (because the length was too large, or because a page was not
+ *  present in the fast lookup tables). Nothing has been modified in the
+ *  latter case.
+ */
+int native_routine_run(struct cpu *cpu, int id, uint64_t *args,
+	uint64_t *retvalp, native_host_page_fn host_page)
+{
+	uint64_t dst, src, len;
+	int64_t slen;
+	int c = 0;
+
+	if (cpu->is_32bit) {
+		args[0] = (uint32_t) args[0];
+		args[1] = (uint32_t) args[1];
+		args[2] = (uint32_t) args[2];
+	}
+
+	switch (id) {
+
+	case NATIVE_ROUTINE_MEMSET:
+	case NATIVE_ROUTINE_BZERO:
+		dst = args[0];
+		if (id == NATIVE_ROUTINE_MEMSET) {
+			c = args[1];
+			len = args[2];
+		} else
+			len = args[1];
+
+		if (len > NATIVE_ROUTINE_MAX_LEN ||
+		    !native_pages_present(cpu, dst, len, 1, host_page))
+			return 0;
+
+		native_fill(cpu, dst, c, len, host_page);
+		*retvalp = dst;
+
+		/*  Roughly one store per word:  */
+		cpu->n_translated_instrs += len / sizeof(uint32_t);
+		break;
+
+	case NATIVE_ROUTINE_MEMCPY:
+	case NATIVE_ROUTINE_MEMMOVE:
+	case NATIVE_ROUTINE_BCOPY:
+		if (id == NATIVE_ROUTINE_BCOPY) {
+			src = args[0];
+			dst = args[1];
+		} else {
+			dst = args[0];
+			src = args[1];
+		}
+		len = args[2];
+
+		if (len > NATIVE_ROUTINE_MAX_LEN ||
+		    !native_pages_present(cpu, src, len, 0, host_page) ||
+		    !native_pages_present(cpu, dst, len, 1, host_page))
+			return 0;
+
+		native_copy(cpu, dst, src, len, host_page);
+		*retvalp = dst;
+
+		/*  Roughly one load and one store per word:  */
+		cpu->n_translated_instrs += len / sizeof(uint32_t) * 2;
+		break;
+
+	case NATIVE_ROUTINE_STRLEN:
+		slen = native_strlen(cpu, args[0], host_page);
+		if (slen < 0)
+			return 0;
+
+		*retvalp = slen;
+
+		/*  Roughly a load, a compare and a branch per byte:  */
+		cpu->n_translated_instrs += slen * 3;
+		break;
+
+	default:
+		return 0;
+	}
+
+	cpu->native_routine_hits[id] ++;
+	return 1;
+}
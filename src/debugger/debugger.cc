@@ -174,6 +174,21 @@ static void show_breakpoint(struct machine *m, int i)
 }
 
 
+/*
+ *  show_watchpoint():
+ */
+static void show_watchpoint(struct machine *m, int i)
+{
+	printf("%3i: 0x", i);
+	if (m->cpus[0]->is_32bit)
+		printf("%08"PRIx32, (uint32_t) m->watchpoints.addr[i]);
+	else
+		printf("%016"PRIx64, (uint64_t) m->watchpoints.addr[i]);
+	printf(", %i byte%s\n", m->watchpoints.len[i],
+	    m->watchpoints.len[i] == 1? "" : "s");
+}
+
+
 /****************************************************************************/
 
 
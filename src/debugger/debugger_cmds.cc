@@ -88,10 +88,9 @@ static void debugger_cmd_breakpoint(struct machine *m, char *cmd_line)
 		}
 		m->breakpoints.n --;
 
-		/*  Clear translations:  */
-		for (i=0; i<m->ncpus; i++)
-			if (m->cpus[i]->translation_cache != NULL)
-				cpu_create_or_reset_tc(m->cpus[i]);
+		/*  (The instruction at the address was never kept translated,
+		    so there are no translations to clear.)  */
+		machine_breakpoints_rehash(m);
 		return;
 	}
 
@@ -123,12 +122,12 @@ static void debugger_cmd_breakpoint(struct machine *m, char *cmd_line)
 		m->breakpoints.addr[i] = tmp;
 
 		m->breakpoints.n ++;
+		machine_breakpoints_rehash(m);
 		show_breakpoint(m, i);
 
-		/*  Clear translations:  */
+		/*  Clear translations of the code at the new breakpoint:  */
 		for (i=0; i<m->ncpus; i++)
-			if (m->cpus[i]->translation_cache != NULL)
-				cpu_create_or_reset_tc(m->cpus[i]);
+			cpu_invalidate_breakpoint(m->cpus[i], tmp);
 		return;
 	}
 
@@ -1163,6 +1162,114 @@ static void debugger_cmd_unassemble(struct machine *m, char *cmd_line)
 }
 
 
+/*
+ *  debugger_cmd_watchpoint():
+ *
+ *  Watchpoints stop when the guest stores to any of the watched bytes.
+ *  The pages containing them are kept non-writable in the fast lookup
+ *  tables, so that only stores to those pages are checked.
+ */
+static void debugger_cmd_watchpoint(struct machine *m, char *cmd_line)
+{
+	int i, res;
+
+	while (cmd_line[0] != '\0' && cmd_line[0] == ' ')
+		cmd_line ++;
+
+	if (cmd_line[0] == '\0') {
+		printf("syntax: watchpoint subcmd [args...]\n");
+		printf("Available subcmds (and args) are:\n");
+		printf("  add addr [len]  add a watchpoint for len bytes "
+		    "(default 4) at addr\n");
+		printf("  delete x        delete watchpoint nr x\n");
+		printf("  show            show current watchpoints\n");
+		return;
+	}
+
+	if (strcmp(cmd_line, "show") == 0) {
+		if (m->watchpoints.n == 0)
+			printf("No watchpoints set.\n");
+		for (i=0; i<m->watchpoints.n; i++)
+			show_watchpoint(m, i);
+		return;
+	}
+
+	if (strncmp(cmd_line, "delete ", 7) == 0) {
+		int x = atoi(cmd_line + 7);
+
+		if (m->watchpoints.n == 0) {
+			printf("No watchpoints set.\n");
+			return;
+		}
+		if (x < 0 || x >= m->watchpoints.n) {
+			printf("Invalid watchpoint nr %i. Use 'watchpoint "
+			    "show' to see the current watchpoints.\n", x);
+			return;
+		}
+
+		for (i=x; i<m->watchpoints.n-1; i++) {
+			m->watchpoints.addr[i] = m->watchpoints.addr[i+1];
+			m->watchpoints.len[i]  = m->watchpoints.len[i+1];
+		}
+		m->watchpoints.n --;
+
+		/*  (Pages which are still marked as non-writable become
+		    writable again when they are next mapped.)  */
+		return;
+	}
+
+	if (strncmp(cmd_line, "add ", 4) == 0) {
+		uint64_t addr, len = 4;
+		char *p = cmd_line + 4, *lenstr;
+
+		while (*p == ' ')
+			p ++;
+		lenstr = strchr(p, ' ');
+		if (lenstr != NULL) {
+			*lenstr++ = '\0';
+			res = debugger_parse_expression(m, lenstr, 0, &len);
+			if (!res || len == 0 || len > 0x10000) {
+				printf("Invalid length '%s'\n", lenstr);
+				return;
+			}
+		}
+
+		res = debugger_parse_expression(m, p, 0, &addr);
+		if (!res) {
+			printf("Couldn't parse '%s'\n", p);
+			return;
+		}
+
+		if (m->arch == ARCH_MIPS) {
+			if ((addr >> 32) == 0 && ((addr >> 31) & 1))
+				addr |= 0xffffffff00000000ULL;
+		}
+
+		i = m->watchpoints.n;
+
+		CHECK_ALLOCATION(m->watchpoints.addr = (uint64_t *) realloc(
+		    m->watchpoints.addr, sizeof(uint64_t) *
+		    (m->watchpoints.n + 1)));
+		CHECK_ALLOCATION(m->watchpoints.len = (int *) realloc(
+		    m->watchpoints.len, sizeof(int) *
+		    (m->watchpoints.n + 1)));
+
+		m->watchpoints.addr[i] = addr;
+		m->watchpoints.len[i] = len;
+
+		m->watchpoints.n ++;
+		show_watchpoint(m, i);
+
+		/*  Make the watched pages non-writable:  */
+		for (i=0; i<m->ncpus; i++)
+			cpu_invalidate_watchpoint(m->cpus[i], addr, len);
+		return;
+	}
+
+	printf("Unknown watchpoint subcommand.\n");
+}
+
+
 /*
  *  debugger_cmd_version():
  */
@@ -1267,6 +1374,9 @@ static struct cmd cmds[] = {
 	{ "version", "", 0, debugger_cmd_version,
 		"print version information" },
 
+	{ "watchpoint", "...", 0, debugger_cmd_watchpoint,
+		"manipulate watchpoints (stores only)" },
+
 	/*  Note: NULL handler.  */
 	{ "x = expr", "", 0, NULL, "generic assignment" },
 
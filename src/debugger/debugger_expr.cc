@@ -192,6 +192,22 @@ int debugger_parse_name(struct machine *m, char *name, int writeflag,
 		}
 	}
 
+	/*
+	 *  Some registers are also decoded into other structures, which
+	 *  must be rebuilt when the register is written to via the settings
+	 *  (e.g. the PowerPC BATs, or the SuperH UTLB hash index):
+	 */
+	if (writeflag && match_settings && m->arch == ARCH_PPC) {
+		int i;
+		for (i=0; i<m->ncpus; i++)
+			ppc_settings_written(m->cpus[i]);
+	}
+	if (writeflag && match_settings && m->arch == ARCH_SH) {
+		int i;
+		for (i=0; i<m->ncpus; i++)
+			sh_settings_written(m->cpus[i]);
+	}
+
 	if (match_settings + match_symbol + match_numeric > 1)
 		return PARSE_MULTIPLE;
 
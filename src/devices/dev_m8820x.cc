@@ -55,7 +55,8 @@ struct m8820x_data {
  */
 static void m8820x_command(struct cpu *cpu, struct m8820x_data *d)
 {
-	uint32_t *regs = cpu->cd.m88k.cmmu[d->cmmu_nr]->reg;
+	struct m8820x_cmmu *cmmu = cpu->cd.m88k.cmmu[d->cmmu_nr];
+	uint32_t *regs = cmmu->reg;
 	int cmd = regs[CMMU_SCR];
 	uint32_t sar = regs[CMMU_SAR];
 	size_t i;
@@ -89,14 +90,19 @@ static void m8820x_command(struct cpu *cpu, struct m8820x_data *d)
 		    cmd == CMMU_FLUSH_SUPER_PAGE)
 			super = M8820X_PATC_SUPERVISOR_BIT;
 
-		/*  TODO: Don't invalidate EVERYTHING like this!  */
-		cpu->invalidate_translation_caches(cpu, 0, INVALIDATE_ALL);
+		/*  Translations for evicted PATC entries are invalidated
+		    when the entries are replaced, so flushing a single page
+		    only needs to invalidate that page:  */
+		if (all)
+			cpu->invalidate_translation_caches(cpu, 0,
+			    INVALIDATE_ALL);
+		else
+			cpu->invalidate_translation_caches(cpu,
+			    sar & 0xfffff000, INVALIDATE_VADDR);
 
 		for (i=0; i<N_M88200_PATC_ENTRIES; i++) {
-			uint32_t v = cpu->cd.m88k.cmmu[d->cmmu_nr]
-			    ->patc_v_and_control[i];
-			uint32_t p = cpu->cd.m88k.cmmu[d->cmmu_nr]
-			    ->patc_p_and_supervisorbit[i];
+			uint32_t v = cmmu->patc_v_and_control[i];
+			uint32_t p = cmmu->patc_p_and_supervisorbit[i];
 
 			/*  Already invalid? Then skip this entry.  */
 			if (!(v & PG_V))
@@ -112,8 +118,7 @@ static void m8820x_command(struct cpu *cpu, struct m8820x_data *d)
 				continue;
 
 			/*  Finally, invalidate the entry:  */
-			cpu->cd.m88k.cmmu[d->cmmu_nr]->patc_v_and_control[i]
-			    = v & ~PG_V;
+			m8820x_patc_invalidate_entry(cmmu, i);
 		}
 
 		break;
@@ -169,14 +174,22 @@ DEVICE_ACCESS(m8820x)
 	case CMMU_PFAR:
 	case CMMU_SAR:
 	case CMMU_SCTR:
-	case CMMU_SAPR:		/*  TODO: Invalidate something for  */
-	case CMMU_UAPR:		/*  SAPR and UAPR writes?  */
-		/*  TODO: Don't invalidate everything.  */
-		cpu->invalidate_translation_caches(cpu, 0, INVALIDATE_ALL);
 		if (writeflag == MEM_WRITE)
 			regs[relative_addr / sizeof(uint32_t)] = idata;
 		break;
 
+	case CMMU_SAPR:
+	case CMMU_UAPR:
+		/*  Only a changed area pointer affects translations. The
+		    PATC is not tagged with the APR, so it is left alone.  */
+		if (writeflag == MEM_WRITE &&
+		    regs[relative_addr / sizeof(uint32_t)] != idata) {
+			cpu->invalidate_translation_caches(cpu, 0,
+			    INVALIDATE_ALL);
+			regs[relative_addr / sizeof(uint32_t)] = idata;
+		}
+		break;
+
 	case CMMU_BWP0:
 	case CMMU_BWP1:
 	case CMMU_BWP2:
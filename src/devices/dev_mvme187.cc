@@ -130,6 +130,7 @@ DEVINIT(mvme187)
 	/*  Instruction CMMU:  */
 	CHECK_ALLOCATION(cmmu = (struct m8820x_cmmu *) malloc(sizeof(struct m8820x_cmmu)));
 	memset(cmmu, 0, sizeof(struct m8820x_cmmu));
+	m8820x_patc_index_init(cmmu);
 
 	devinit->machine->cpus[devinit->machine->bootstrap_cpu]->
 	    cd.m88k.cmmu[0] = cmmu;
@@ -142,6 +143,7 @@ DEVINIT(mvme187)
 	/*  ... and data CMMU:  */
 	CHECK_ALLOCATION(cmmu = (struct m8820x_cmmu *) malloc(sizeof(struct m8820x_cmmu)));
 	memset(cmmu, 0, sizeof(struct m8820x_cmmu));
+	m8820x_patc_index_init(cmmu);
 
 	devinit->machine->cpus[devinit->machine->bootstrap_cpu]->
 	    cd.m88k.cmmu[1] = cmmu;
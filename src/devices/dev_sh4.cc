@@ -679,6 +679,7 @@ DEVICE_ACCESS(sh4_utlb_aa)
 					if (idata & SH4_UTLB_AA_V)
 						cpu->cd.sh.utlb_lo[i] |=
 						    SH4_PTEL_V;
+					sh_utlb_index_update(cpu, i);
 				}
 
 				if (i >= 0)
@@ -706,6 +707,7 @@ DEVICE_ACCESS(sh4_utlb_aa)
 				cpu->cd.sh.utlb_lo[e] |= SH4_PTEL_D;
 			if (idata & SH4_UTLB_AA_V)
 				cpu->cd.sh.utlb_lo[e] |= SH4_PTEL_V;
+			sh_utlb_index_update(cpu, e);
 		}
 
 		if (safe_to_invalidate)
@@ -749,6 +751,7 @@ DEVICE_ACCESS(sh4_utlb_da1)
 		idata = memory_readmax64(cpu, data, len);
 		cpu->cd.sh.utlb_lo[e] &= ~mask;
 		cpu->cd.sh.utlb_lo[e] |= (idata & mask);
+		sh_utlb_index_update(cpu, e);
 
 		/*  Invalidate if this UTLB entry belongs to the
 		    currently running process, or if it was shared:  */
@@ -1043,9 +1046,11 @@ DEVICE_ACCESS(sh4)
 					cpu->cd.sh.itlb_lo[i] &=
 					    ~SH4_PTEL_V;
 
-				for (i = 0; i < SH_N_UTLB_ENTRIES; i++)
+				for (i = 0; i < SH_N_UTLB_ENTRIES; i++) {
 					cpu->cd.sh.utlb_lo[i] &=
 					    ~SH4_PTEL_V;
+					sh_utlb_index_update(cpu, i);
+				}
 
 				cpu->invalidate_translation_caches(cpu,
 				    0, INVALIDATE_ALL);
@@ -139,6 +139,36 @@ public:
 	 *	because of a timeout).
 	 */
 	virtual bool WriteData(const uint64_t& data, Endianness endianness) = 0;
+
+	/**
+	 * \brief Looks up host memory which directly backs a page of the
+	 *	address space.
+	 *
+	 * Components which simply store data in host memory (e.g. RAM) may
+	 * implement this function, to allow callers such as CPUs to access
+	 * the memory directly, instead of going through AddressSelect()
+	 * followed by ReadData() or WriteData() for every access.
+	 *
+	 * The returned pointer is only valid until the component's state is
+	 * changed in some other way than by reads and writes, e.g. when it is
+	 * reset or deserialized. Callers must therefore not keep the pointer
+	 * for longer than e.g. one call to Component::Execute().
+	 *
+	 * The default implementation returns NULL, i.e. direct access is not
+	 * possible.
+	 *
+	 * \param address An address within the page.
+	 * \param pageSize The size of the page, in bytes. Must be a power
+	 *	of two.
+	 * \param forWriting True if the caller intends to write to the page.
+	 * \return A pointer to the host memory of the first byte of the page,
+	 *	or NULL if the page cannot be accessed directly.
+	 */
+	virtual uint8_t* LookupHostPage(uint64_t address, uint64_t pageSize,
+		bool forWriting)
+	{
+		return NULL;
+	}
 };
 
 
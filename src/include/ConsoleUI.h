@@ -64,25 +64,6 @@ public:
 	 */
 	virtual void ShowStartupBanner();
 
-	/**
-	 * \brief Shows a debug message, by printing it to stdout.
-	 *
-	 * @param msg The message to show.
-	 */
-	virtual void ShowDebugMessage(const string& msg);
-	
-	/**
-	 * \brief Shows a debug message for a Component, by printing it to
-	 * stdout.
-	 *
-	 * See UI::ShowDebugMessage(Component*,const string&) for
-	 * a longer comment.
-	 *
-	 * @param component A pointer to the Component.
-	 * @param msg The message to show.
-	 */
-	virtual void ShowDebugMessage(Component* component, const string& msg);
-
 	/**
 	 * \brief Does nothing for the %ConsoleUI.
 	 *
@@ -134,6 +115,27 @@ public:
 
 	virtual void Shutdown();
 
+protected:
+	/**
+	 * \brief Shows a debug message, by printing it to stdout.
+	 *
+	 * @param msg The message to show.
+	 */
+	virtual void DisplayDebugMessage(const string& msg);
+
+	/**
+	 * \brief Shows a debug message for a Component, by printing it to
+	 * stdout.
+	 *
+	 * See UI::ShowDebugMessage(Component*,const string&) for
+	 * a longer comment.
+	 *
+	 * @param component A pointer to the Component.
+	 * @param msg The message to show.
+	 */
+	virtual void DisplayDebugMessage(Component* component,
+	    const string& msg);
+
 private:
 	/**
 	 * \brief Shows the %GXemul&gt; prompt, reads characters from stdin
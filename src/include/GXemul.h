@@ -34,6 +34,7 @@
 
 #include "CommandInterpreter.h"
 #include "Component.h"
+#include "QuantumScheduler.h"
 #include "UI.h"
 
 
@@ -223,6 +224,24 @@ public:
 	 */
 	void SetSnapshottingEnabled(bool enabled);
 
+	/**
+	 * \brief Checks whether profiling is enabled or not.
+	 *
+	 * @return True if CPU profiling is enabled, false otherwise.
+	 */
+	bool GetProfilingEnabled() const;
+
+	/**
+	 * \brief Sets whether or not to profile CPUs.
+	 *
+	 * If enabled, Run() sets the <tt>profiling</tt> variable of all
+	 * components that have one (i.e. dyntrans CPUs), and shows a
+	 * profile report for each of them when the emulation ends.
+	 *
+	 * @param enabled true to enable profiling, false to disable it.
+	 */
+	void SetProfilingEnabled(bool enabled);
+
 	/**
 	 * \brief Gets the current quiet mode setting.
 	 *
@@ -268,6 +287,11 @@ public:
 	 * special cases), when this function returns, the run state will not
 	 * have been affected.
 	 *
+	 * If <tt>root.accuracy</tt> is "sloppy", components are not
+	 * interleaved cycle by cycle. Instead, each component runs
+	 * <tt>root.quantum</tt> steps at a time, and CPUs run in parallel
+	 * using a QuantumScheduler.
+	 *
 	 * @param longestTotalRun Maximum number of steps to execute.
 	 */
 	void Execute(const int longestTotalRun = 100000);
@@ -330,6 +354,7 @@ private:
 	RunState		m_runState;
 	bool			m_interrupting;
 	uint64_t		m_nrOfSingleStepsLeft;
+	QuantumScheduler	m_quantumScheduler;
 
 	// Performance measurement:
 	struct timeval		m_lastOutputTime;
@@ -342,6 +367,9 @@ private:
 	// Snapshotting:   TODO: Multiple snapshots!
 	bool			m_snapshottingEnabled;
 	refcount_ptr<Component>	m_snapshot;
+
+	// Profiling:
+	bool			m_profilingEnabled;
 };
 
 #endif	// GXEMUL_H
@@ -62,21 +62,6 @@ public:
 	 */
 	virtual void ShowStartupBanner();
 
-	/**
-	 * \brief Does nothing, for the dummy UI.
-	 *
-	 * @param msg The message to show. (Ignored.)
-	 */
-	virtual void ShowDebugMessage(const string& msg);
-
-	/**
-	 * \brief Does nothing, for the dummy UI.
-	 *
-	 * @param component A pointer to the Component. (Ignored.)
-	 * @param msg The message to show. (Ignored.)
-	 */
-	virtual void ShowDebugMessage(Component* component, const string& msg);
-
 	/**
 	 * \brief Does nothing, for the dummy UI.
 	 *
@@ -117,6 +102,23 @@ public:
 	virtual int MainLoop();
 
 	virtual void Shutdown();
+
+protected:
+	/**
+	 * \brief Does nothing, for the dummy UI.
+	 *
+	 * @param msg The message to show. (Ignored.)
+	 */
+	virtual void DisplayDebugMessage(const string& msg);
+
+	/**
+	 * \brief Does nothing, for the dummy UI.
+	 *
+	 * @param component A pointer to the Component. (Ignored.)
+	 * @param msg The message to show. (Ignored.)
+	 */
+	virtual void DisplayDebugMessage(Component* component,
+	    const string& msg);
 };
 
 
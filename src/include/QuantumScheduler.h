@@ -0,0 +1,235 @@
+#ifndef QUANTUMSCHEDULER_H
+#define	QUANTUMSCHEDULER_H
+
+/*
+ *  Copyright (C) 2010  Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+#include "misc.h"
+
+#include "UnitTest.h"
+
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+class Component;
+class GXemul;
+class UI;
+
+
+/**
+ * \brief Runs a set of components for one quantum, possibly in parallel.
+ *
+ * When <tt>root.accuracy</tt> is "sloppy", GXemul::Execute does not
+ * interleave components cycle by cycle. Instead, each executable component
+ * is asked to run a whole quantum (<tt>root.quantum</tt> steps, scaled by
+ * its frequency) at a time. Jobs that are marked as parallel (CPUs) are run
+ * on worker threads, one job per host thread, and the remaining jobs are
+ * run on the calling thread once all parallel jobs have finished. In other
+ * words, there is a barrier at the end of each quantum.
+ *
+ * Worker threads are started lazily, the first time they are needed, and
+ * are kept alive until the %QuantumScheduler is destroyed.
+ *
+ * While parallel jobs are running, accesses to address/data busses
+ * must be serialized, since AddressSelect() followed by ReadData()
+ * or WriteData() is not an atomic operation. Code which uses a bus on
+ * behalf of a parallel job should therefore use a BusLock.
+ *
+ * Debug messages shown by parallel jobs (through UI::ShowDebugMessage)
+ * are not passed on to the %UI right away. Instead, each job has its own
+ * queue of messages, and the queues are flushed in job order by the
+ * calling thread after the barrier. The output is thus the same
+ * regardless of how the host threads were scheduled.
+ *
+ * If %GXemul was built without pthreads support, all jobs are simply
+ * run one after another on the calling thread.
+ */
+class QuantumScheduler
+	: public UnitTestable
+{
+public:
+	/**
+	 * \brief A debug message which is held back until the end of
+	 *	the quantum.
+	 */
+	struct DebugMessage
+	{
+		UI*		ui;
+		Component*	component;	// NULL for plain messages
+		string		msg;
+	};
+
+	/**
+	 * \brief A component, and the number of cycles it should run
+	 *	during the quantum.
+	 */
+	struct Job
+	{
+		Component*	component;
+		int		nrOfCycles;	// in
+		bool		parallel;	// in
+		int		executed;	// out
+
+		// Held back by DeferDebugMessage, flushed by RunQuantum:
+		vector<DebugMessage>	debugMessages;
+	};
+
+	/**
+	 * \brief Serializes bus accesses while parallel jobs are running.
+	 *
+	 * Construct a %BusLock on the stack around each AddressSelect() +
+	 * ReadData()/WriteData() pair. When no parallel jobs are running,
+	 * this is just a test of a boolean.
+	 */
+	class BusLock
+	{
+	public:
+		BusLock()
+			: m_locked(s_busLockingEnabled)
+		{
+#ifdef HAVE_PTHREADS
+			if (m_locked)
+				pthread_mutex_lock(&s_busMutex);
+#endif
+		}
+
+		~BusLock()
+		{
+#ifdef HAVE_PTHREADS
+			if (m_locked)
+				pthread_mutex_unlock(&s_busMutex);
+#endif
+		}
+
+	private:
+		bool	m_locked;
+	};
+
+public:
+	/**
+	 * \brief Constructs a %QuantumScheduler, without any worker threads.
+	 */
+	QuantumScheduler();
+
+	~QuantumScheduler();
+
+	/**
+	 * \brief Runs all jobs for one quantum.
+	 *
+	 * When this function returns, all jobs have completed, and the
+	 * <tt>executed</tt> field of each job has been filled in.
+	 *
+	 * If any of the jobs threw an exception, a std::exception is thrown
+	 * after all other jobs have completed.
+	 *
+	 * @param gxemul A pointer to the GXemul instance.
+	 * @param jobs The jobs to run.
+	 */
+	void RunQuantum(GXemul* gxemul, vector<Job>& jobs);
+
+	/**
+	 * \brief Gets the number of worker threads started so far.
+	 *
+	 * The calling thread of RunQuantum() is not counted.
+	 *
+	 * @return The number of worker threads.
+	 */
+	size_t GetNrOfWorkerThreads() const;
+
+	/**
+	 * \brief Holds back a debug message, if called from a parallel job.
+	 *
+	 * Called by UI::ShowDebugMessage. If the calling thread is running
+	 * a parallel job, the message is appended to that job's queue, and
+	 * shown by RunQuantum() once all parallel jobs have finished.
+	 *
+	 * @param ui The %UI to show the message in.
+	 * @param component A pointer to the Component, or NULL.
+	 * @param msg The message.
+	 * @return true if the message was queued, false if the caller
+	 *	should show it right away.
+	 */
+	static bool DeferDebugMessage(UI* ui, Component* component,
+	    const string& msg);
+
+
+	/********************************************************************/
+
+	static void RunUnitTests(int& nSucceeded, int& nFailures);
+
+private:
+	static void RunJob(GXemul* gxemul, Job& job, bool deferMessages,
+	    bool& failed);
+	static void FlushDebugMessages(Job& job);
+
+#ifdef HAVE_PTHREADS
+	static void CreateCurrentJobKey();
+
+	struct Worker
+	{
+		QuantumScheduler*	scheduler;
+		size_t			index;
+		uint64_t		startGeneration;
+		pthread_t		thread;
+	};
+
+	static void* WorkerThreadMain(void* arg);
+	void WorkerLoop(Worker* worker);
+	void StartWorkers(size_t n);
+	void StopWorkers();
+#endif
+
+private:
+#ifdef HAVE_PTHREADS
+	// Protects everything below, and is used with the two conditions:
+	pthread_mutex_t		m_mutex;
+	pthread_cond_t		m_startCondition;
+	pthread_cond_t		m_doneCondition;
+
+	list<Worker>		m_workers;
+	uint64_t		m_generation;
+	size_t			m_nrOfJobsLeft;
+	bool			m_quitting;
+	bool			m_failed;
+
+	// Jobs for the current quantum. Worker i runs m_workerJobs[i].
+	GXemul*			m_gxemul;
+	vector<Job*>		m_workerJobs;
+
+	static pthread_mutex_t	s_busMutex;
+
+	// The parallel job run by the current thread, if any:
+	static pthread_once_t	s_currentJobKeyOnce;
+	static pthread_key_t	s_currentJobKey;
+#endif
+
+	static bool		s_busLockingEnabled;
+};
+
+
+#endif	// QUANTUMSCHEDULER_H
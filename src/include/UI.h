@@ -30,6 +30,8 @@
 
 #include "misc.h"
 
+#include "QuantumScheduler.h"
+
 class Component;
 class GXemul;
 
@@ -126,9 +128,18 @@ public:
 	/**
 	 * \brief Shows a debug message.
 	 *
+	 * If called from a CPU which is running in parallel with other
+	 * CPUs, the message is held back until the end of the quantum (see
+	 * QuantumScheduler::DeferDebugMessage), and then shown on the
+	 * scheduler's thread.
+	 *
 	 * @param msg The message to show.
 	 */
-	virtual void ShowDebugMessage(const string& msg) = 0;
+	void ShowDebugMessage(const string& msg)
+	{
+		if (!QuantumScheduler::DeferDebugMessage(this, NULL, msg))
+			DisplayDebugMessage(msg);
+	}
 
 	/**
 	 * \brief Shows a debug message for a Component.
@@ -140,10 +151,17 @@ public:
 	 * is encapsulated by "[ ]" brackets, making the debug message very
 	 * similar to pre-0.6.0 debug output style.
 	 *
+	 * Messages from parallel CPUs are held back in the same way as for
+	 * ShowDebugMessage(const string&).
+	 *
 	 * @param component A pointer to the Component.
 	 * @param msg The message to show.
 	 */
-	virtual void ShowDebugMessage(Component* component, const string& msg) = 0;
+	void ShowDebugMessage(Component* component, const string& msg)
+	{
+		if (!QuantumScheduler::DeferDebugMessage(this, component, msg))
+			DisplayDebugMessage(component, msg);
+	}
 
 	/**
 	 * \brief Shows a command being executed.
@@ -204,6 +222,28 @@ public:
 	 */
 	virtual void Shutdown() = 0;
 
+protected:
+	/**
+	 * \brief Displays a debug message.
+	 *
+	 * Only called from the thread which runs the %UI.
+	 *
+	 * @param msg The message to show.
+	 */
+	virtual void DisplayDebugMessage(const string& msg) = 0;
+
+	/**
+	 * \brief Displays a debug message for a Component.
+	 *
+	 * Only called from the thread which runs the %UI. See
+	 * ShowDebugMessage(Component*,const string&) for details.
+	 *
+	 * @param component A pointer to the Component.
+	 * @param msg The message to show.
+	 */
+	virtual void DisplayDebugMessage(Component* component,
+	    const string& msg) = 0;
+
 protected:
 	GXemul*		m_gxemul;
 	string		m_indentationMsg;
@@ -32,6 +32,7 @@
 
 
 #include "CPUComponent.h"
+#include "RAMComponent.h"
 #include "UnitTest.h"
 
 #include <assert.h>
@@ -57,6 +58,8 @@ struct DyntransIC
 	} arg[N_DYNTRANS_IC_ARGS];
 };
 
+typedef void (*DyntransICFunction)(CPUDyntransComponent*, DyntransIC*);
+
 /*
  * A dyntrans page contains DyntransIC calls for each instruction slot, followed
  * by some special entries, which handle execution going over the end of a page
@@ -64,6 +67,20 @@ struct DyntransIC
  */
 #define	DYNTRANS_PAGE_NSPECIALENTRIES	2
 
+/*
+ * Approximate number of instruction calls between profiling samples.
+ * (See CPUDyntransComponent::DyntransProfileSample.)
+ */
+#define	DYNTRANS_PROFILE_INTERVAL	1000
+
+/*
+ * Number of entries in the host page cache, i.e. the number of virtual pages
+ * which may be accessed directly in host memory by load/store instruction
+ * calls without a lookup. (See CPUDyntransComponent::DyntransReadData.)
+ * Must be a power of two.
+ */
+#define	N_DYNTRANS_HOST_PAGES		64
+
 
 /*
  * Some helpers for implementing dyntrans instructions.
@@ -95,13 +112,64 @@ public:
 	 */
 	CPUDyntransComponent(const string& className, const string& cpuKind);
 
+	virtual void ResetState();
+
 	virtual int Execute(GXemul* gxemul, int nrOfCycles);
 
+	virtual void GetMethodNames(vector<string>& names) const;
+
+	virtual void ExecuteMethod(GXemul* gxemul,
+		const string& methodName,
+		const vector<string>& arguments);
+
+	/**
+	 * \brief Gets the total number of profiling samples taken.
+	 *
+	 * @return The number of samples since the profile was last cleared.
+	 */
+	uint64_t GetNrOfProfileSamples() const;
+
+	/**
+	 * \brief Gets the number of profiling samples taken at a guest
+	 *	address.
+	 *
+	 * @param pc The guest address of an instruction.
+	 * @return The number of samples at pc, or 0 if pc was never sampled.
+	 */
+	uint64_t GetNrOfProfileSamples(uint64_t pc) const;
+
 
 	/********************************************************************/
 
 	static void RunUnitTests(int& nSucceeded, int& nFailures);
 
+#ifdef WITHUNITTESTS
+	/**
+	 * \brief Runs a test program for instruction combinations.
+	 *
+	 * Used by the unit tests of specific CPU families. The big-endian
+	 * program is run in two separate emulations of the same machine:
+	 * in gxemulA in one go (which allows instruction combinations), and
+	 * in gxemulB one instruction at a time (which does not). The
+	 * variables in variablesToCompare must then be the same in both
+	 * CPUs.
+	 *
+	 * @param gxemulA The emulation in which the program runs in one go.
+	 * @param gxemulB The emulation in which the program is single-stepped.
+	 * @param machine The machine to add, e.g. "testmips".
+	 * @param addr The address at which the program is placed and started.
+	 * @param program The program's instruction words.
+	 * @param nWords The number of words in program.
+	 * @param nrOfSteps The number of steps to run.
+	 * @param variablesToCompare A NULL-terminated array of variable names.
+	 * @return The CPU of gxemulA.
+	 */
+	static refcount_ptr<Component> RunCombinationsTestProgram(
+	    GXemul& gxemulA, GXemul& gxemulB, const string& machine,
+	    uint64_t addr, const uint32_t* program, size_t nWords,
+	    int nrOfSteps, const char** variablesToCompare);
+#endif
+
 protected:
 	// Implemented by specific CPU families:
 	virtual int GetDyntransICshift() const = 0;
@@ -126,11 +194,132 @@ protected:
 	 */
 	void DyntransPCtoPointers();
 
+	/**
+	 * \brief Combines the instruction call before ic with ic, if they
+	 *	are f1 and f2.
+	 *
+	 * Called by Translate implementations, after the instruction at ic
+	 * has been translated. If the previous instruction call on the same
+	 * page is f1, and ic is f2, then the previous instruction call is
+	 * replaced by instr_combined<f1, f2, maxCycles>, which executes both
+	 * instructions in one call. ic itself is left as it is, so that
+	 * branches directly to ic still work.
+	 *
+	 * f1 must not be an instruction with a delay slot.
+	 *
+	 * @param ic The instruction call which was just translated.
+	 * @return true if the instruction calls were combined, false otherwise.
+	 */
+	template<DyntransICFunction f1, DyntransICFunction f2, int maxCycles>
+	bool DyntransCombine(struct DyntransIC* ic)
+	{
+		if (ic->f != f2 || ic <= m_firstIConPage ||
+		    ic >= m_firstIConPage + m_dyntransICentriesPerPage ||
+		    ic[-1].f != f1)
+			return false;
+
+		// Never combine when running a single instruction, since
+		// the single-stepping variants of instructions are
+		// different from the ordinary ones.
+		if (m_executedCycles == m_nrOfCyclesToExecute - 1)
+			return false;
+
+		ic[-1].f = instr_combined<f1, f2, maxCycles>;
+		return true;
+	}
+
+	/**
+	 * \brief Reads data from emulated memory, on behalf of a load
+	 *	instruction call.
+	 *
+	 * The width and endianness of the access are template parameters,
+	 * so that load instruction calls can be specialized for them at
+	 * translation time. If the virtual page is backed by host memory
+	 * (see AddressDataBus::LookupHostPage), the data is read directly
+	 * from host memory, without any virtual function calls. Otherwise,
+	 * the access goes through AddressSelect() and ReadData().
+	 *
+	 * @param vaddr The virtual address. Must be aligned to sizeof(T).
+	 * @param data A reference to a variable which will receive the data.
+	 * @return true if the access was successful, false otherwise.
+	 */
+	template<typename T, Endianness endianness>
+	bool DyntransReadData(uint64_t vaddr, T& data)
+	{
+		uint64_t pageAddr = vaddr & ~(uint64_t)(m_pageSize - 1);
+		struct DyntransHostPage& hostPage = m_hostPages[
+		    (vaddr >> m_dyntransPageShift) & (N_DYNTRANS_HOST_PAGES - 1)];
+
+		uint8_t* host = hostPage.m_vaddr == pageAddr? hostPage.m_host
+		    : DyntransLookupHostPage(vaddr, false);
+
+		if (host != NULL) {
+			data = RAMComponent::ReadHostMemory<T, endianness>(
+			    host + (vaddr - pageAddr));
+			return true;
+		}
+
+		AddressSelect(vaddr);
+		return ReadData(data, endianness);
+	}
+
+	/**
+	 * \brief Writes data to emulated memory, on behalf of a store
+	 *	instruction call.
+	 *
+	 * See DyntransReadData() for details.
+	 *
+	 * @param vaddr The virtual address. Must be aligned to sizeof(T).
+	 * @param data The data to write.
+	 * @return true if the access was successful, false otherwise.
+	 */
+	template<typename T, Endianness endianness>
+	bool DyntransWriteData(uint64_t vaddr, T data)
+	{
+		uint64_t pageAddr = vaddr & ~(uint64_t)(m_pageSize - 1);
+		struct DyntransHostPage& hostPage = m_hostPages[
+		    (vaddr >> m_dyntransPageShift) & (N_DYNTRANS_HOST_PAGES - 1)];
+
+		uint8_t* host = (hostPage.m_vaddr == pageAddr &&
+		    hostPage.m_writable)? hostPage.m_host
+		    : DyntransLookupHostPage(vaddr, true);
+
+		if (host != NULL) {
+			RAMComponent::WriteHostMemory<T, endianness>(
+			    host + (vaddr - pageAddr), data);
+			return true;
+		}
+
+		AddressSelect(vaddr);
+		return WriteData(data, endianness);
+	}
+
+	/**
+	 * \brief Invalidates all entries in the host page cache.
+	 *
+	 * Must be called whenever a virtual to physical mapping is changed,
+	 * or when memory components may have been reset. This is done
+	 * automatically at the start of each Execute() call.
+	 */
+	void DyntransInvalidateHostPages();
+
 private:
 	void DyntransInit();
+	uint8_t* DyntransLookupHostPage(uint64_t vaddr, bool forWriting);
 	struct DyntransIC* DyntransGetICPage(uint64_t addr);
 	void DyntransClearICPage(struct DyntransIC* icpage);
 
+	/**
+	 * \brief Takes one profiling sample of the currently executing
+	 *	instruction call.
+	 *
+	 * Called from the main execution loop, if profiling is enabled.
+	 */
+	void DyntransProfileSample();
+
+	void ClearProfile();
+	void ShowProfile(GXemul* gxemul, size_t nrOfEntries);
+
 protected:
 	/*
 	 * Generic dyntrans instruction implementations, that may be used by
@@ -173,18 +362,43 @@ protected:
 	DECLARE_DYNTRANS_INSTR(shift_left_u64_u64_imm5_truncS32);
 	DECLARE_DYNTRANS_INSTR(shift_right_u64_u64asu32_imm5_truncS32);
 
+	/*
+	 * Combined instruction call: Executes f1 for ic, and then f2 for the
+	 * following instruction call (ic+1), counting as up to maxCycles
+	 * cycles in total. (maxCycles is 3 if f2 has a delay slot, otherwise
+	 * 2.)
+	 *
+	 * If the combined call is executed in a delay slot, if fewer than
+	 * maxCycles cycles are left to execute, if f1 caused an exception,
+	 * or if ic+1 is no longer translated as f2, then only f1 is executed.
+	 * Execution then continues normally after f1.
+	 */
+	template<DyntransICFunction f1, DyntransICFunction f2, int maxCycles>
+	static void instr_combined(CPUDyntransComponent* cpubase, DyntransIC* ic)
+	{
+		f1(cpubase, ic);
+
+		if (cpubase->m_inDelaySlot || ic[1].f != f2 ||
+		    cpubase->m_nextIC != ic + 1 ||
+		    cpubase->m_executedCycles + maxCycles > cpubase->m_nrOfCyclesToExecute)
+			return;
+
+		cpubase->m_nextIC = ic + 2;
+		cpubase->m_executedCycles ++;
+		f2(cpubase, ic + 1);
+	}
+
 private:
 	class DyntransTranslationPage
 	{
 	public:
-		DyntransTranslationPage(int nICentriesPerpage)
+		DyntransTranslationPage()
 			: m_prev(-1)
 			, m_next(-1)
 			, m_nextCacheEntryForAddr(-1)
 			, m_addr(0)
 			, m_showFunctionTraceCall(false)
 		{
-			m_ic.resize(nICentriesPerpage);
 		}
 
 	public:
@@ -202,8 +416,8 @@ private:
 		// or other mode switches.
 		bool				m_showFunctionTraceCall;
 
-		// Translated instructions:
-		vector< struct DyntransIC >	m_ic;
+		// Note: The translated instructions themselves are not stored
+		// here, but in the DyntransTranslationCache's IC arena.
 	};
 
 	class DyntransTranslationCache
@@ -212,13 +426,26 @@ private:
 		DyntransTranslationCache()
 			: m_nICentriesPerpage(0)
 			, m_pageShift(0)
+			, m_hashShift(0)
 			, m_firstFree(-1)
 			, m_lastFree(-1)
 			, m_firstMRU(-1)
 			, m_lastMRU(-1)
+			, m_nrOfHits(0)
+			, m_nrOfMisses(0)
+			, m_nrOfEvictions(0)
 		{
 		}
 
+		uint64_t GetNrOfHits() const { return m_nrOfHits; }
+		uint64_t GetNrOfMisses() const { return m_nrOfMisses; }
+		uint64_t GetNrOfEvictions() const { return m_nrOfEvictions; }
+
+		void ClearStatistics()
+		{
+			m_nrOfHits = m_nrOfMisses = m_nrOfEvictions = 0;
+		}
+
 		void Reinit(size_t approximateSize, int nICentriesPerpage, int pageShift)
 		{
 			size_t approximateSizePerPage = sizeof(struct DyntransIC) * nICentriesPerpage + 64;
@@ -237,9 +464,13 @@ private:
 			m_nICentriesPerpage = nICentriesPerpage;
 			m_pageShift = pageShift;
 
-			// Generate empty pages:
+			// Generate empty pages. The ICs of all pages are allocated
+			// as one contiguous arena; page i uses the entries starting
+			// at i * m_nICentriesPerpage.
 			m_pageCache.clear();
-			m_pageCache.resize(nrOfPages, DyntransTranslationPage(nICentriesPerpage));
+			m_pageCache.resize(nrOfPages);
+			m_icArena.clear();
+			m_icArena.resize(nrOfPages * nICentriesPerpage);
 
 			// Set up the free-list to connect all pages:
 			m_firstFree = 0;
@@ -257,13 +488,17 @@ private:
 			// No pages in use yet, so nothing on the MRU list:
 			m_firstMRU = m_lastMRU = -1;
 
-			// Reset the quick lookup table:
-			// (Currently hardcoded to allow the first 1 GB of emulated physical memory
-			// to be looked up with 1 call, if more than 1 GB of RAM is used, the
-			// m_nextCacheEntryForAddr chain must be traversed...)
-			m_addrToFirstPageIndex.resize(1024 * 1048576 >> m_pageShift);
-			for (size_t i=0; i<m_addrToFirstPageIndex.size(); ++i)
-				m_addrToFirstPageIndex[i] = -1;
+			// Reset the quick lookup table. This is a hash table indexed
+			// by (a hash of) the full 64-bit page number, with at least
+			// twice as many buckets as there are pages, so that the
+			// m_nextCacheEntryForAddr chains are usually very short.
+			int bucketBits = 1;
+			while (((size_t)1 << bucketBits) < nrOfPages * 2)
+				bucketBits ++;
+
+			m_hashShift = 64 - bucketBits;
+			m_addrToFirstPageIndex.clear();
+			m_addrToFirstPageIndex.resize((size_t)1 << bucketBits, -1);
 
 			ValidateConsistency();
 		}
@@ -366,8 +601,7 @@ private:
 					continue;
 
 				uint64_t addr = m_pageCache[k].m_addr;
-				uint64_t physPageNumber = addr >> m_pageShift;
-				int quickLookupIndex = physPageNumber & (m_addrToFirstPageIndex.size() - 1);
+				size_t quickLookupIndex = QuickLookupIndex(addr);
 				int pageIndex = m_addrToFirstPageIndex[quickLookupIndex];
 
 				while (pageIndex >= 0) {
@@ -397,6 +631,7 @@ private:
 
 			// This is the one we will free.
 			int index = m_lastMRU;
+			++ m_nrOfEvictions;
 			assert(m_pageCache[index].m_prev >= 0);
 			assert(m_pageCache[index].m_next < 0);
 
@@ -418,8 +653,7 @@ private:
 			}
 
 			// Remove from the quick lookup chain:
-			uint64_t physPageNumber = m_pageCache[index].m_addr >> m_pageShift;
-			int quickLookupIndex = physPageNumber & (m_addrToFirstPageIndex.size() - 1);
+			size_t quickLookupIndex = QuickLookupIndex(m_pageCache[index].m_addr);
 			int pageIndex = m_addrToFirstPageIndex[quickLookupIndex];
 			if (pageIndex == index) {
 				// Direct hit? Then remove from the base quick look up table...
@@ -479,8 +713,7 @@ private:
 			m_pageCache[index].m_showFunctionTraceCall = showFunctionTraceCall;
 
 			// Insert into quick lookup table:
-			uint64_t physPageNumber = addr >> m_pageShift;
-			int quickLookupIndex = physPageNumber & (m_addrToFirstPageIndex.size() - 1);
+			size_t quickLookupIndex = QuickLookupIndex(addr);
 
 			// Are we the only one? (I.e. the first page for this quick lookup index.)
 			if (m_addrToFirstPageIndex[quickLookupIndex] < 0) {
@@ -494,7 +727,7 @@ private:
 
 			ValidateConsistency();
 
-			return &(m_pageCache[index].m_ic[0]);
+			return &m_icArena[index * m_nICentriesPerpage];
 		}
 
 		struct DyntransIC *GetICPage(uint64_t addr, bool showFunctionTraceCall, bool& clear)
@@ -503,13 +736,11 @@ private:
 
 			// Strip of the low bits:
 			addr >>= m_pageShift;
-			uint64_t physPageNumber = addr;
 			addr <<= m_pageShift;
 
-			int quickLookupIndex = physPageNumber & (m_addrToFirstPageIndex.size() - 1);
+			size_t quickLookupIndex = QuickLookupIndex(addr);
 			int pageIndex = m_addrToFirstPageIndex[quickLookupIndex];
-
-			// std::cerr << "addr " << addr << ", physPageNumber " << physPageNumber << ", quickLookupIndex " << quickLookupIndex << ", pageIndex " << pageIndex << "\n";
+			int prevInChain = -1;
 
 			// If pageIndex >= 0, then pageIndex points to a page which _may_ be for this addr.
 			while (pageIndex >= 0) {
@@ -518,6 +749,7 @@ private:
 
 				// If the page for pageIndex was for some other address, then
 				// let's continue searching the chain...
+				prevInChain = pageIndex;
 				pageIndex = m_pageCache[pageIndex].m_nextCacheEntryForAddr;
 			}
 
@@ -545,17 +777,20 @@ private:
 					m_firstMRU = pageIndex;
 				}
 
-				// TODO: Hm... also move to front of the Quick Lookup chain?
-				// Only necessary if more memory is used/emulated than the
-				// size of the quick lookup table, e.g. if 2 GB ram are used,
-				// and the size of the lookup table is 1 GB, and pages
-				// at exactly 0 GB and 1 GB are used in this order:
-				// 1 0 1 1 1 1 1 1 1 1 1 1 1
-				// then 1 would first be placed in the chain, then 0 (which
-				// would insert it first in the chain). But all lookups after
-				// that would have to search the whole chain (0, 1) to find 1.
+				// Also move the page to the front of its quick lookup
+				// chain, so that the next lookup of the same page (which
+				// is likely) finds it directly.
+				if (prevInChain >= 0) {
+					m_pageCache[prevInChain].m_nextCacheEntryForAddr = m_pageCache[pageIndex].m_nextCacheEntryForAddr;
+					m_pageCache[pageIndex].m_nextCacheEntryForAddr = m_addrToFirstPageIndex[quickLookupIndex];
+					m_addrToFirstPageIndex[quickLookupIndex] = pageIndex;
+				}
+
+				// Note: ValidateConsistency() is not called here, since
+				// this is the common (fast) path. Pages are only moved
+				// within the lists above, never added or removed.
 
-				ValidateConsistency();
+				++ m_nrOfHits;
 
 				// If flags are not the same, then let's clear the page:
 				if (m_pageCache[pageIndex].m_showFunctionTraceCall != showFunctionTraceCall) {
@@ -563,11 +798,12 @@ private:
 					clear = true;
 				}
 
-				return &(m_pageCache[pageIndex].m_ic[0]);
+				return &m_icArena[pageIndex * m_nICentriesPerpage];
 			}
 
 			// The address was NOT in the translation cache at all. So we have
 			// to create a new page.
+			++ m_nrOfMisses;
 
 			// If the free-list is all used up, that means we have to free something
 			// before we can allocate a new page...
@@ -579,12 +815,32 @@ private:
 			return AllocateNewPage(addr, showFunctionTraceCall);
 		}
 
+	private:
+		/*
+		 * Returns the quick lookup table index for a page address.
+		 *
+		 * All 64 bits of the page number are hashed (using Fibonacci
+		 * hashing, i.e. multiplying by 2^64 / golden ratio and keeping
+		 * the top bits), so that pages at high physical or virtual
+		 * addresses are spread out over the table just as well as
+		 * pages in the lowest part of the address space.
+		 */
+		size_t QuickLookupIndex(uint64_t addr) const
+		{
+			uint64_t pageNumber = addr >> m_pageShift;
+			return (size_t) ((pageNumber * 0x9e3779b97f4a7c15ULL) >> m_hashShift);
+		}
+
 	private:
 		// Number of translated instructions per page, and number of bits
 		// to shift to convert address to page number:
 		int				m_nICentriesPerpage;
 		int				m_pageShift;
 
+		// Number of bits to shift a hashed page number right, to get
+		// a quick lookup table index:
+		int				m_hashShift;
+
 		// Free-list of pages:
 		int				m_firstFree;
 		int				m_lastFree;
@@ -593,11 +849,36 @@ private:
 		int				m_firstMRU;
 		int				m_lastMRU;
 
-		// "Usually" quick lookup table, address to page index:
+		// Quick lookup (hash) table, address to page index:
 		vector<int>			m_addrToFirstPageIndex;
 
-		// The actual pages:
+		// The actual pages, and their translated instructions:
 		vector<DyntransTranslationPage>	m_pageCache;
+		vector<struct DyntransIC>	m_icArena;
+
+		// Statistics:
+		uint64_t			m_nrOfHits;
+		uint64_t			m_nrOfMisses;
+		uint64_t			m_nrOfEvictions;
+	};
+
+	struct DyntransHostPage
+	{
+		uint64_t	m_vaddr;	// page address, or 1 if unused
+		uint8_t*	m_host;
+		bool		m_writable;
+	};
+
+	struct DyntransProfileEntry
+	{
+		DyntransProfileEntry()
+			: m_nrOfSamples(0)
+			, m_examplePC(0)
+		{
+		}
+
+		uint64_t	m_nrOfSamples;
+		uint64_t	m_examplePC;	// only used for IC functions
 	};
 
 protected:
@@ -609,6 +890,7 @@ protected:
 	int			m_dyntransPageMask;
 	int			m_dyntransICentriesPerPage;
 	int			m_dyntransICshift;
+	int			m_dyntransPageShift;
 	int			m_executedCycles;
 	int			m_nrOfCyclesToExecute;
 
@@ -617,6 +899,22 @@ protected:
 	 */
 	DyntransTranslationCache	m_translationCache;
 
+	/*
+	 * Host page cache, direct-mapped by the low bits of the virtual
+	 * page number:
+	 */
+	struct DyntransHostPage	m_hostPages[N_DYNTRANS_HOST_PAGES];
+
+	/*
+	 * Profiling: One sample is taken every DYNTRANS_PROFILE_INTERVAL
+	 * instruction calls (approximately), when m_profiling is true.
+	 */
+	bool					m_profiling;
+	int					m_profileCountdown;
+	uint64_t				m_nrOfProfileSamples;
+	map<uint64_t, DyntransProfileEntry>	m_profilePCs;
+	map<DyntransICFunction, DyntransProfileEntry> m_profileICFunctions;
+
 	/*
 	 * Special always present DyntransIC structs, for aborting emulation:
 	 */
@@ -418,10 +418,13 @@ private:
 	DECLARE_DYNTRANS_INSTR(ldcr);
 	DECLARE_DYNTRANS_INSTR(stcr);
 	template<bool one> static void instr_tb(CPUDyntransComponent* cpubase, DyntransIC* ic);
-	template<bool store, typename T, bool doubleword, bool regofs, bool scaled, bool signedLoad> static void instr_loadstore(CPUDyntransComponent* cpubase, DyntransIC* ic);
+	template<bool store, typename T, bool doubleword, bool regofs, bool scaled, bool signedLoad, Endianness endianness> static void instr_loadstore(CPUDyntransComponent* cpubase, DyntransIC* ic);
 	template<int scaleFactor> static void instr_lda(CPUDyntransComponent* cpubase, DyntransIC* ic);
 
 	void Translate(uint32_t iword, struct DyntransIC* ic);
+	void TranslateCombinations(struct DyntransIC* ic);
+	template<Endianness endianness>
+	bool TranslateLoadStoreCombinations(struct DyntransIC* ic);
 	DECLARE_DYNTRANS_INSTR(ToBeTranslated);
 
 	// For unit tests:
@@ -215,9 +215,12 @@ private:
 	DECLARE_DYNTRANS_INSTR(slt);
 	DECLARE_DYNTRANS_INSTR(sltu);
 
-	template<bool store, typename addressType, typename T, bool signedLoad> static void instr_loadstore(CPUDyntransComponent* cpubase, DyntransIC* ic);
+	template<bool store, typename addressType, typename T, bool signedLoad, Endianness endianness> static void instr_loadstore(CPUDyntransComponent* cpubase, DyntransIC* ic);
 
 	void Translate(uint32_t iword, struct DyntransIC* ic);
+	void TranslateCombinations(struct DyntransIC* ic);
+	template<typename addressType, Endianness endianness>
+	bool TranslateLoadStoreCombinations(struct DyntransIC* ic);
 	DECLARE_DYNTRANS_INSTR(ToBeTranslated);
 	DECLARE_DYNTRANS_INSTR(ToBeTranslated_MIPS16);
 
@@ -87,6 +87,8 @@ public:
 	virtual bool WriteData(const uint16_t& data, Endianness endianness);
 	virtual bool WriteData(const uint32_t& data, Endianness endianness);
 	virtual bool WriteData(const uint64_t& data, Endianness endianness);
+	virtual uint8_t* LookupHostPage(uint64_t address, uint64_t pageSize,
+		bool forWriting);
 
 
 	/********************************************************************/
@@ -127,6 +127,73 @@ public:
 	virtual bool WriteData(const uint16_t& data, Endianness endianness);
 	virtual bool WriteData(const uint32_t& data, Endianness endianness);
 	virtual bool WriteData(const uint64_t& data, Endianness endianness);
+	virtual uint8_t* LookupHostPage(uint64_t address, uint64_t pageSize,
+		bool forWriting);
+
+	/**
+	 * \brief Converts data between host endianness and the given
+	 *	emulated endianness.
+	 *
+	 * Since the conversion is a byte swap (or nothing), the same function
+	 * is used in both directions.
+	 *
+	 * @param data The data to convert.
+	 * @return The converted data.
+	 */
+	template<typename T, Endianness endianness>
+	static inline T ConvertEndianness(T data)
+	{
+		switch (sizeof(T)) {
+		case sizeof(uint16_t):
+			if (endianness == BigEndian)
+				return (T) BE16_TO_HOST((uint16_t)data);
+			else
+				return (T) LE16_TO_HOST((uint16_t)data);
+		case sizeof(uint32_t):
+			if (endianness == BigEndian)
+				return (T) BE32_TO_HOST((uint32_t)data);
+			else
+				return (T) LE32_TO_HOST((uint32_t)data);
+		case sizeof(uint64_t):
+			if (endianness == BigEndian)
+				return (T) BE64_TO_HOST((uint64_t)data);
+			else
+				return (T) LE64_TO_HOST((uint64_t)data);
+		default:
+			return data;
+		}
+	}
+
+	/**
+	 * \brief Reads data directly from host memory.
+	 *
+	 * This is a compile-time specialized alternative to ReadData(),
+	 * meant to be used together with LookupHostPage(). The width and
+	 * endianness of the access are template parameters, so there is
+	 * neither a virtual function call nor a run-time endianness test.
+	 *
+	 * @param p A pointer to host memory, aligned to sizeof(T).
+	 * @return The data, converted to host endianness.
+	 */
+	template<typename T, Endianness endianness>
+	static inline T ReadHostMemory(const uint8_t* p)
+	{
+		return ConvertEndianness<T, endianness>(*(const T*)p);
+	}
+
+	/**
+	 * \brief Writes data directly to host memory.
+	 *
+	 * This is the write counterpart of ReadHostMemory().
+	 *
+	 * @param p A pointer to host memory, aligned to sizeof(T).
+	 * @param data The data to write, in host endianness.
+	 */
+	template<typename T, Endianness endianness>
+	static inline void WriteHostMemory(uint8_t* p, T data)
+	{
+		*(T*)p = ConvertEndianness<T, endianness>(data);
+	}
 
 
 	/********************************************************************/
@@ -136,7 +203,7 @@ public:
 private:
 	void ReleaseAllBlocks();
 
-	void* AllocateBlock();
+	void* AllocateBlock(uint64_t blockNr);
 
 	class RAMDataHandler : public CustomStateVariableHandler
 	{
@@ -49,6 +49,8 @@ class GXemul;
  *
  * <ul>
  *	<li>accuracy ("cycle" or "sloppy")
+ *	<li>quantum (the number of steps that each component runs at a time,
+ *		when accuracy is "sloppy")
  * </ul>
  *
  * NOTE: A RootComponent is not registered in the component registry, and
@@ -92,6 +94,7 @@ private:
 
 	// Model:
 	string		m_accuracy;
+	uint64_t	m_quantum;
 };
 
 
@@ -39,6 +39,7 @@
 /*  This is needed for undefining 'mips', 'ppc' etc. on weird systems:  */
 #include "../../config.h"
 
+#include "native_routines.h"
 #include "timer.h"
 
 
@@ -68,6 +69,10 @@
  *  length; to extend the list, the list should be made to point to another
  *  list, and so forth. (Bad, O(n) find/insert complexity. Should be fixed some
  *  day. TODO)  See definition of physpage_ranges below.
+ *
+ *  referenced is set whenever the page is looked up via the slow path, and
+ *  cleared by the translation cache's CLOCK hand. (See
+ *  XXX_tc_allocate_default_page() in cpu_dyntrans.cc.)
  */
 #define DYNTRANS_MISC_DECLARATIONS(arch,ARCH,addrtype)  struct \
 	arch ## _instr_call {					\
@@ -81,12 +86,18 @@
 		uint32_t	next_ofs;	/*  (0 for end of chain)  */ \
 		uint32_t	translations_bitmap;			\
 		uint32_t	translation_ranges_ofs;			\
+		uint32_t	referenced;				\
 		addrtype	physaddr;				\
 	};								\
 									\
 	struct arch ## _vpg_tlb_entry {					\
 		uint8_t		valid;					\
 		uint8_t		writeflag;				\
+		uint8_t		referenced;				\
+		uint8_t		parked;					\
+		uint16_t	paddr_next;				\
+		uint16_t	parked_next;				\
+		uint16_t	asid;					\
 		addrtype	vaddr_page;				\
 		addrtype	paddr_page;				\
 		unsigned char	*host_page;				\
@@ -153,10 +164,44 @@ struct physpage_ranges {
  *
  *  Regardless of whether 32-bit or 64-bit address translation is used, the
  *  same TLB entry structure is used.
+ *
+ *  vph_paddr_hash is a reverse index, from physical page to the valid TLB
+ *  entries which map that page, so that invalidations of a physical page do
+ *  not need to scan all entries. Each hash bucket is a chain of TLB entries,
+ *  linked via paddr_next. The values are the tlb index plus 1, with 0
+ *  meaning end of chain (like vaddr_to_tlbindex below).
+ *
+ *  Only the first n_vph_tlb_entries entries are used. (This defaults to
+ *  ARCH_DEFAULT_VPH_TLB_ENTRIES, but can be changed with the -l command
+ *  line option, up to ARCH_MAX_VPH_TLB_ENTRIES.) When a new entry is
+ *  needed, a victim is chosen using a CLOCK (second chance) algorithm:
+ *  vph_tlb_clock is the clock hand, and entries which have been referenced
+ *  since the hand last passed them are given a second chance. Such
+ *  entries are soft-unmapped from the fast lookup tables, so that a
+ *  subsequent access to the page goes via update_translation_table again
+ *  and marks the entry as referenced.
+ *
+ *  Each entry is tagged with the guest address space (vph_asid) which was
+ *  active when it was created. When the guest switches address spaces, the
+ *  entries which depend on the address space are parked: they are removed
+ *  from the fast lookup tables, but stay valid, and are linked into
+ *  vph_parked_hash (on their virtual page) via parked_next. When switching
+ *  back, they are put back into the fast lookup tables. Parked entries are
+ *  eventually reused by the CLOCK algorithm, like any other entries, so
+ *  only the recently used address spaces stay resident.
  */
+#define	N_VPH_PADDR_HASH		256
+#define	VPH_PADDR_HASH(paddr_page)	\
+	((uint32_t)((paddr_page) >> 12) & (N_VPH_PADDR_HASH - 1))
 #define	VPH_TLBS(arch,ARCH)						\
 	struct arch ## _vpg_tlb_entry					\
-	    vph_tlb_entry[ARCH ## _MAX_VPH_TLB_ENTRIES];
+	    vph_tlb_entry[ARCH ## _MAX_VPH_TLB_ENTRIES];		\
+	uint16_t		vph_paddr_hash[N_VPH_PADDR_HASH];	\
+	int			n_vph_tlb_entries;			\
+	int			vph_tlb_clock;				\
+	uint16_t		vph_parked_hash[N_VPH_PADDR_HASH];	\
+	int			n_vph_parked;				\
+	int			vph_asid;
 
 /*
  *  32-bit dyntrans emulated Virtual -> physical -> host address translation:
@@ -187,12 +232,6 @@ struct physpage_ranges {
  */
 #define	N_VPH32_ENTRIES		1048576
 #define	VPH32(arch,ARCH)						\
-	unsigned char		*host_load[N_VPH32_ENTRIES];		\
-	unsigned char		*host_store[N_VPH32_ENTRIES];		\
-	uint32_t		phys_addr[N_VPH32_ENTRIES];		\
-	struct arch ## _tc_physpage  *phys_page[N_VPH32_ENTRIES];	\
-	uint8_t			vaddr_to_tlbindex[N_VPH32_ENTRIES];
-#define	VPH32_16BITVPHENTRIES(arch,ARCH)				\
 	unsigned char		*host_load[N_VPH32_ENTRIES];		\
 	unsigned char		*host_store[N_VPH32_ENTRIES];		\
 	uint32_t		phys_addr[N_VPH32_ENTRIES];		\
@@ -203,7 +242,7 @@ struct physpage_ranges {
 	unsigned char		*host_store_ ## ex[N_VPH32_ENTRIES];	\
 	uint32_t		phys_addr_ ## ex[N_VPH32_ENTRIES];	\
 	struct arch ## _tc_physpage  *phys_page_ ## ex[N_VPH32_ENTRIES];\
-	uint8_t			vaddr_to_tlbindex_ ## ex[N_VPH32_ENTRIES];
+	uint16_t		vaddr_to_tlbindex_ ## ex[N_VPH32_ENTRIES];
 
 
 /*
@@ -310,6 +349,10 @@ struct cpu_family {
 #define	N_SAFE_DYNTRANS_LIMIT	((1 << (N_SAFE_DYNTRANS_LIMIT_SHIFT - 1)) - 1)
 
 #define	MAX_DYNTRANS_READAHEAD		128
+#define	MAX_DYNTRANS_READAHEAD_TARGETS	32
+
+/*  Instruction combinations cover at most this many instructions:  */
+#define	MAX_COMBINATION_LENGTH		18
 
 #define	DEFAULT_DYNTRANS_CACHE_SIZE	(48*1048576)
 #define	DYNTRANS_CACHE_MARGIN		200000
@@ -413,11 +456,19 @@ struct cpu {
 	 *  "nothing" instructions.
 	 *
 	 *  The translation cache is a relative large chunk of memory (say,
-	 *  32 MB) which is used for translations. When it has been used up,
-	 *  everything restarts from scratch.
+	 *  32 MB) which is used for translations. Physpages are allocated
+	 *  from it linearly. When it has been used up, cold physpages are
+	 *  evicted one at a time, using a CLOCK algorithm. The clock hand is
+	 *  translation_cache_clock_ofs. translation_cache_evictions counts
+	 *  evicted physpages, and translation_cache_flushes counts the number
+	 *  of times the whole cache has been reset.
 	 *
 	 *  translation_readahead is non-zero when translating instructions
-	 *  ahead of the current (emulated) instruction pointer.
+	 *  ahead of the current (emulated) instruction pointer. Read-ahead
+	 *  follows branch targets within the same page, so that a whole
+	 *  function is usually translated the first time it is entered.
+	 *  translation_cache_traps counts the number of times an instruction
+	 *  had to be translated because it was about to be executed.
 	 */
 
 	int		translation_readahead;
@@ -426,6 +477,27 @@ struct cpu {
 	int		n_translated_instrs;
 	unsigned char	*translation_cache;
 	size_t		translation_cache_cur_ofs;
+	size_t		translation_cache_clock_ofs;
+	uint64_t	translation_cache_evictions;
+	uint64_t	translation_cache_flushes;
+	uint64_t	translation_cache_traps;
+
+	/*
+	 *  Virtual -> physical -> host TLB statistics: hits and misses are
+	 *  counted when update_translation_table is called, i.e. accesses
+	 *  which are handled directly by the fast lookup tables are not
+	 *  counted. vph_tlb_evictions counts the number of valid entries
+	 *  which have been replaced.
+	 */
+	uint64_t	vph_tlb_hits;
+	uint64_t	vph_tlb_misses;
+	uint64_t	vph_tlb_evictions;
+
+	/*
+	 *  Number of times each guest routine has been run natively (see
+	 *  native_routines.h), indexed by NATIVE_ROUTINE_xxx.
+	 */
+	uint64_t	native_routine_hits[N_NATIVE_ROUTINES];
 
 
 	/*
@@ -460,6 +532,10 @@ void cpu_functioncall_trace(struct cpu *cpu, uint64_t f);
 void cpu_functioncall_trace_return(struct cpu *cpu);
 
 void cpu_create_or_reset_tc(struct cpu *cpu);
+void cpu_invalidate_breakpoint(struct cpu *cpu, uint64_t vaddr);
+void cpu_invalidate_watchpoint(struct cpu *cpu, uint64_t vaddr, int len);
+void cpu_watchpoint_hit(struct cpu *cpu, int w, uint64_t vaddr,
+	unsigned char *data, size_t len);
 
 void cpu_run_init(struct machine *machine);
 void cpu_run_deinit(struct machine *machine);
@@ -477,6 +553,8 @@ void cpu_init(void);
 #define	INVALIDATE_PADDR		4
 #define	INVALIDATE_VADDR		8
 #define	INVALIDATE_VADDR_UPPER4		16	/*  useful for PPC emulation  */
+#define	INVALIDATE_SUBPAGE		32	/*  with PADDR: just a write  */
+#define	INVALIDATE_ASID			64	/*  address space switch  */
 
 
 /*  Note: 64-bit processors running in 32-bit mode use a 32-bit
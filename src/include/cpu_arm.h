@@ -69,6 +69,20 @@ struct arm_cpu_type_def {
 	"and", "eor", "sub", "rsb", "add", "adc", "sbc", "rsc",	\
 	"tst", "teq", "cmp", "cmn", "orr", "mov", "bic", "mvn" }
 
+/*
+ *  Cache of recently used second-level (coarse page table) descriptors, see
+ *  memory_arm.c. vpage is the virtual page address, with bit 0 set if the
+ *  entry is valid. ptba is the physical address of the page table that the
+ *  descriptor was read from, i.e. the first-level descriptor at that time.
+ */
+#define	ARM_N_L2_WALK_CACHE		256
+
+struct arm_l2_walk_cache_entry {
+	uint32_t	vpage;
+	uint32_t	ptba;
+	uint32_t	d2;
+};
+
 #define	ARM_IC_ENTRIES_SHIFT		10
 
 #define	ARM_N_IC_ARGS			3
@@ -79,11 +93,59 @@ struct arm_cpu_type_def {
 #define	ARM_ADDR_TO_PAGENR(a)		((a) >> (ARM_IC_ENTRIES_SHIFT \
 					+ ARM_INSTR_ALIGNMENT_SHIFT))
 
+/*
+ *  Thumb code is translated into separate translation pages, each covering
+ *  half of a 4 KB page (ARM_IC_ENTRIES_PER_PAGE 16-bit instructions). They
+ *  live in the same translation cache as the ARM pages, but with the tag
+ *  (1 for the low half, 2 for the high half) added to the physical address,
+ *  so that an ARM page and its Thumb pages never match each other.
+ */
+#define	ARM_THUMB_INSTR_ALIGNMENT_SHIFT	1
+#define	ARM_THUMB_PAGE_SIZE		(ARM_IC_ENTRIES_PER_PAGE << \
+					ARM_THUMB_INSTR_ALIGNMENT_SHIFT)
+#define	ARM_THUMB_PC_TO_IC_ENTRY(a)	(((a)>>ARM_THUMB_INSTR_ALIGNMENT_SHIFT)\
+					& (ARM_IC_ENTRIES_PER_PAGE-1))
+#define	ARM_THUMB_PHYSPAGE_TAG(a)	((a) & ARM_THUMB_PAGE_SIZE? 2 : 1)
+
 #define	ARM_F_N		8	/*  Same as ARM_FLAG_*, but        */
 #define	ARM_F_Z		4	/*  for the 'flags' field instead  */
 #define	ARM_F_C		2	/*  of cpsr.                       */
 #define	ARM_F_V		1
 
+/*
+ *  Lazy flags:
+ *
+ *  Flag-setting additions and subtractions (adds, subs, rsbs, cmp, cmn)
+ *  don't update 'flags' directly. They only record the kind of operation
+ *  and its operands, and the N, Z, C, and V bits are calculated by
+ *  arm_flags_materialize() when something actually needs them.
+ *
+ *  ARM_FLAGS_SYNC() must be used before 'flags' is read or partially
+ *  modified, and ARM_FLAGS_SET() when 'flags' is overwritten completely.
+ *  Outside of arm_run_instr(), 'flags' is always up to date.
+ *
+ *  If lazy_lockstep is set (the "lazy_lockstep" cpu setting), then
+ *  arm_lazy_lockstep_check() is called after each instruction, and compares
+ *  the lazily evaluated flags with the flags the eager code would have set.
+ */
+#define	ARM_FLAGS_LAZY_NONE	0
+#define	ARM_FLAGS_LAZY_ADD	1
+#define	ARM_FLAGS_LAZY_SUB	2
+#define	ARM_FLAGS_LAZY_CHECKED	0x100	/*  or:ed in by the lockstep check  */
+
+#define	ARM_FLAGS_SYNC(cpu)	{					\
+	if ((cpu)->cd.arm.flags_lazy_op != ARM_FLAGS_LAZY_NONE)		\
+		arm_flags_materialize(cpu);				}
+
+#define	ARM_FLAGS_SET(cpu,f)	{					\
+	(cpu)->cd.arm.flags_lazy_op = ARM_FLAGS_LAZY_NONE;		\
+	(cpu)->cd.arm.flags = (f);					}
+
+#define	ARM_FLAGS_LAZY(cpu,op,a,b)	{				\
+	(cpu)->cd.arm.flags_lazy_op = (op);				\
+	(cpu)->cd.arm.flags_lazy_a = (a);				\
+	(cpu)->cd.arm.flags_lazy_b = (b);				}
+
 #define	ARM_FLAG_N	0x80000000	/*  Negative flag  */
 #define	ARM_FLAG_Z	0x40000000	/*  Zero flag  */
 #define	ARM_FLAG_C	0x20000000	/*  Carry flag  */
@@ -123,7 +185,8 @@ struct arm_cpu_type_def {
 
 DYNTRANS_MISC_DECLARATIONS(arm,ARM,uint32_t)
 
-#define	ARM_MAX_VPH_TLB_ENTRIES		384
+#define	ARM_DEFAULT_VPH_TLB_ENTRIES	384
+#define	ARM_MAX_VPH_TLB_ENTRIES		1024
 
 
 struct arm_cpu {
@@ -171,6 +234,13 @@ struct arm_cpu {
 	uint32_t		spsr_irq;
 	uint32_t		spsr_fiq;
 
+	/*  Pending lazily evaluated flags, see ARM_FLAGS_SYNC() above:  */
+	int			flags_lazy_op;
+	uint32_t		flags_lazy_a;
+	uint32_t		flags_lazy_b;
+	int			lazy_lockstep;
+	size_t			lazy_lockstep_flags;
+
 
 	/*
 	 *  System Control Coprocessor registers:
@@ -221,6 +291,9 @@ struct arm_cpu {
 	unsigned char		*translation_table;
 	uint32_t		last_ttb;
 
+	/*  Recently used L2 descriptors:  */
+	struct arm_l2_walk_cache_entry l2_walk_cache[ARM_N_L2_WALK_CACHE];
+
 	/*
 	 *  Interrupts:
 	 */
@@ -233,7 +306,7 @@ struct arm_cpu {
 	 */
 	DYNTRANS_ITC(arm)
 	VPH_TLBS(arm,ARM)
-	VPH32_16BITVPHENTRIES(arm,ARM)
+	VPH32(arm,ARM)
 
 	/*  ARM specific: */
 	uint32_t			is_userpage[N_VPH32_ENTRIES/32];
@@ -288,6 +361,9 @@ void arm_translation_table_set_l1(struct cpu *cpu, uint32_t vaddr,
 void arm_translation_table_set_l1_b(struct cpu *cpu, uint32_t vaddr,
 	uint32_t paddr);
 void arm_exception(struct cpu *, int);
+void arm_thumb_pc_to_pointers(struct cpu *cpu);
+void arm_flags_materialize(struct cpu *cpu);
+void arm_lazy_lockstep_check(struct cpu *cpu);
 int arm_run_instr(struct cpu *cpu);
 void arm_update_translation_table(struct cpu *cpu, uint64_t vaddr_page,
 	unsigned char *host_page, int writeflag, uint64_t paddr_page);
@@ -308,6 +384,7 @@ void arm_coproc_xscale_14(struct cpu *cpu, int opcode1, int opcode2, int l_bit,
 	int crn, int crm, int rd);
 
 /*  memory_arm.c:  */
+void arm_walk_cache_invalidate(struct cpu *cpu, uint32_t vaddr, int all);
 int arm_translate_v2p(struct cpu *cpu, uint64_t vaddr,
 	uint64_t *return_addr, int flags);
 int arm_translate_v2p_mmu(struct cpu *cpu, uint64_t vaddr,
@@ -163,7 +163,8 @@ struct m88k_cpu_type_def {
 
 DYNTRANS_MISC_DECLARATIONS(m88k,M88K,uint32_t)
 
-#define	M88K_MAX_VPH_TLB_ENTRIES		128
+#define	M88K_DEFAULT_VPH_TLB_ENTRIES	128
+#define	M88K_MAX_VPH_TLB_ENTRIES	1024
 
 
 #define	N_M88K_REGS		32
@@ -213,12 +214,24 @@ DYNTRANS_MISC_DECLARATIONS(m88k,M88K,uint32_t)
 #define	N_M88200_PATC_ENTRIES		56
 #define	M8820X_PATC_SUPERVISOR_BIT	0x00000001
 
+/*
+ *  The valid PATC entries are also indexed by virtual page number. Each
+ *  bucket is a chain of PATC entry numbers in ascending order, linked via
+ *  patc_hash_next[] and terminated by -1. See memory_m88k.c.
+ */
+#define	M8820X_PATC_HASH_SIZE		64
+#define	M8820X_PATC_HASH(vaddr)		(((vaddr) >> 12) & \
+					(M8820X_PATC_HASH_SIZE - 1))
+
 struct m8820x_cmmu {
 	uint32_t	reg[M8820X_LENGTH / sizeof(uint32_t)];
 	uint32_t	batc[N_M88200_BATC_REGS];
 	uint32_t	patc_v_and_control[N_M88200_PATC_ENTRIES];
 	uint32_t	patc_p_and_supervisorbit[N_M88200_PATC_ENTRIES];
 	int		patc_update_index;
+
+	int8_t		patc_hash[M8820X_PATC_HASH_SIZE];
+	int8_t		patc_hash_next[N_M88200_PATC_ENTRIES];
 };
 
 
@@ -287,6 +300,8 @@ void m88k_fstcr(struct cpu *cpu, uint32_t value, int fcr);
 void m88k_exception(struct cpu *cpu, int vector, int is_trap);
 
 /*  memory_m88k.c:  */
+void m8820x_patc_index_init(struct m8820x_cmmu *cmmu);
+void m8820x_patc_invalidate_entry(struct m8820x_cmmu *cmmu, int i);
 int m88k_translate_v2p(struct cpu *cpu, uint64_t vaddr,
 	uint64_t *return_addr, int flags);
 
@@ -81,8 +81,37 @@ struct mips_tlb {
 	uint64_t	lo0;
 	uint64_t	lo1;
 	uint64_t	mask;
+
+	uint16_t	hash_next;	/*  TLB lookup index, see below  */
+	uint16_t	asid_next;
 };
 
+/*
+ *  TLB lookup index:
+ *
+ *  Entries which use the smallest page size are kept in hash chains, keyed
+ *  on the virtual page number and the ASID (or MIPS_TLB_GLOBAL_ASID, for
+ *  global entries). All other entries (and all entries on the R4100) are
+ *  kept in the tlb_large chain. A virtual to physical translation only has
+ *  to look at the two hash chains which may contain a match, and at the
+ *  tlb_large chain, instead of at every entry in the TLB.
+ *
+ *  Non-global entries are also kept in per-ASID lists, so that only the
+ *  entries which are actually affected need to be looked at when the ASID
+ *  changes.
+ *
+ *  Chains are linked via hash_next and asid_next. The values are the TLB
+ *  entry index plus 1, with 0 meaning end of chain.
+ */
+#define	MIPS_TLB_HASH_SIZE		128
+#define	MIPS_TLB_N_ASIDS		256
+#define	MIPS_TLB_GLOBAL_ASID		MIPS_TLB_N_ASIDS
+#define	MIPS_TLB_VPN(mmu3k,addr)	((mmu3k)?			\
+	(uint32_t)((addr) >> 12) & 0xfffff :				\
+	(uint32_t)((addr) >> 13) & 0x7ffffff)
+#define	MIPS_TLB_HASH(vpn,asid)						\
+	(((vpn) ^ ((vpn) >> 7) ^ ((asid) * 13)) & (MIPS_TLB_HASH_SIZE - 1))
+
 
 /*
  *  Coproc 1:
@@ -92,6 +121,10 @@ struct mips_tlb {
 #define	MIPS_FPU_FCIR			0
 #define	MIPS_FPU_FCCR			25
 #define	MIPS_FPU_FCSR			31
+#define	   MIPS_FCSR_RM			   0x00000003
+#define	   MIPS_FCSR_FLAGS_SHIFT	   2
+#define	   MIPS_FCSR_CAUSE		   0x0003f000
+#define	   MIPS_FCSR_CAUSE_SHIFT	   12
 #define	   MIPS_FCSR_FCC0_SHIFT		   23
 #define	   MIPS_FCSR_FCC1_SHIFT		   25
 
@@ -104,6 +137,9 @@ struct mips_coproc {
 	/*  Only for COP0:  */
 	struct mips_tlb	*tlbs;
 	int		nr_of_tlbs;
+	uint16_t	tlb_hash[MIPS_TLB_HASH_SIZE];
+	uint16_t	tlb_large;
+	uint16_t	tlb_asid[MIPS_TLB_N_ASIDS];
 
 	/*  Only for COP1:  floating point control registers  */
 	/*  (Maybe also for COP0?)  */
@@ -193,13 +229,28 @@ struct r3000_cache_line {
 #define	MIPS_ADDR_TO_PAGENR(a)		((a) >> (MIPS_IC_ENTRIES_SHIFT \
 					+ MIPS_INSTR_ALIGNMENT_SHIFT))
 
+/*
+ *  MIPS16 code is translated into separate translation pages, each covering
+ *  half of a 4 KB page (MIPS_IC_ENTRIES_PER_PAGE 16-bit instructions). Just
+ *  like ARM Thumb pages, they live in the same translation cache as the
+ *  normal pages, but with a tag (1 for the low half, 2 for the high half)
+ *  added to the physical address.
+ */
+#define	MIPS16_INSTR_ALIGNMENT_SHIFT	1
+#define	MIPS16_PAGE_SIZE		(MIPS_IC_ENTRIES_PER_PAGE << \
+					MIPS16_INSTR_ALIGNMENT_SHIFT)
+#define	MIPS16_PC_TO_IC_ENTRY(a)	(((a)>>MIPS16_INSTR_ALIGNMENT_SHIFT) \
+					& (MIPS_IC_ENTRIES_PER_PAGE-1))
+#define	MIPS16_PHYSPAGE_TAG(a)		((a) & MIPS16_PAGE_SIZE? 2 : 1)
+
 #define	MIPS_L2N		17
 #define	MIPS_L3N		18
 
-#define	MIPS_MAX_VPH_TLB_ENTRIES	192
+#define	MIPS_DEFAULT_VPH_TLB_ENTRIES	192
+#define	MIPS_MAX_VPH_TLB_ENTRIES	1024
 
 DYNTRANS_MISC_DECLARATIONS(mips,MIPS,uint64_t)
-DYNTRANS_MISC64_DECLARATIONS(mips,MIPS,uint8_t)
+DYNTRANS_MISC64_DECLARATIONS(mips,MIPS,uint16_t)
 
 
 struct mips_cpu {
@@ -219,7 +270,15 @@ struct mips_cpu {
 	struct mips_coproc *coproc[N_MIPS_COPROCS];
 	uint64_t	cop0_config_select1;
 
-	int		last_written_tlb_index;
+	/*
+	 *  MIPS16: mips16_available is set if the CPU implements the MIPS16
+	 *  ASE. mips16 is set while running 16-bit code (the ISA mode bit,
+	 *  i.e. bit 0 of jump targets and of the EPC). mips16_jump_len is the
+	 *  length of the jump whose delay slot is being executed, for EPC.
+	 */
+	uint8_t		mips16_available;
+	uint8_t		mips16;
+	uint8_t		mips16_jump_len;
 
 	/*  Count/compare timer:  */
 	int		compare_register_set;
@@ -227,10 +286,6 @@ struct mips_cpu {
 	struct interrupt irq_compare;
 	struct timer	*timer;
 
-	int		rmw;		/*  Read-Modify-Write  */
-	uint64_t	rmw_len;	/*  Length of rmw modification  */
-	uint64_t	rmw_addr;	/*  Address of rmw modification  */
-
 	/*
 	 *  NOTE:  The R5900 has 128-bit registers. I'm not really sure
 	 *  whether they are used a lot or not, at least with code produced
@@ -353,5 +408,9 @@ void mips32_update_translation_table(struct cpu *cpu, uint64_t vaddr_page,
 void mips32_invalidate_translation_caches(struct cpu *cpu, uint64_t, int);
 void mips32_invalidate_code_translation(struct cpu *cpu, uint64_t, int);
 
+/*  cpu_mips_instr_mips16.cc:  */
+void mips_mips16_pc_to_pointers(struct cpu *cpu);
+void mips32_mips16_pc_to_pointers(struct cpu *cpu);
+
 
 #endif	/*  CPU_MIPS_H  */
@@ -102,9 +102,60 @@ struct ppc_cpu_type_def {
 #define	PPC_L3N			18
 
 DYNTRANS_MISC_DECLARATIONS(ppc,PPC,uint64_t)
-DYNTRANS_MISC64_DECLARATIONS(ppc,PPC,uint8_t)
+DYNTRANS_MISC64_DECLARATIONS(ppc,PPC,uint16_t)
 
-#define	PPC_MAX_VPH_TLB_ENTRIES		128
+#define	PPC_DEFAULT_VPH_TLB_ENTRIES	128
+#define	PPC_MAX_VPH_TLB_ENTRIES		1024
+
+/*
+ *  Decoded BAT register pair. bat_segment_mask[instr][user][segment] in
+ *  struct ppc_cpu has bit i set if BAT i (0..3 of the instruction or data
+ *  BATs) is valid in that mode and maps something within the 256 MB segment.
+ */
+struct ppc_bat {
+	uint32_t	vaddr;		/*  Effective address, & ~mask  */
+	uint32_t	mask;		/*  Offset mask within the block  */
+	uint32_t	paddr;		/*  Physical address, & ~mask  */
+	int		pp;		/*  BAT_PP_xxx  */
+};
+
+/*
+ *  Host-side cache of page table entries found by the hashed page table
+ *  walk, indexed by the low bits of the page index. key is PPC_PTE_CACHE_VALID
+ *  | (vsid << 16) | page index. Only hits are cached, so entries need to be
+ *  invalidated only on tlbie, tlbia, and when SDR1 changes.
+ */
+#define	PPC_N_PTE_CACHE		1024
+#define	PPC_PTE_CACHE_VALID	0x80000000000ULL
+
+struct ppc_pte_cache_entry {
+	uint64_t	key;
+	uint32_t	lower_pte;
+};
+
+/*
+ *  Lazy CR0:
+ *
+ *  Record-form ("dot") instructions don't update CR field 0 directly;
+ *  update_cr0() only stores the result value, and the LT, GT, EQ, and SO
+ *  bits are calculated by ppc_cr0_materialize() when something actually
+ *  needs them.
+ *
+ *  PPC_CR0_SYNC() must be used before 'cr' is read or partially modified,
+ *  and before XER (which holds the SO bit) is written. PPC_CR0_OVERWRITE()
+ *  is enough when all of CR0 is about to be overwritten. Outside of
+ *  ppc_run_instr(), 'cr' is always up to date.
+ *
+ *  If lazy_lockstep is set (the "lazy_lockstep" cpu setting), then
+ *  update_cr0() also calculates the CR0 bits the eager way, and
+ *  ppc_lazy_lockstep_check() is called after each instruction to compare
+ *  them with the lazily evaluated bits.
+ */
+#define	PPC_CR0_SYNC(cpu)	{					\
+	if ((cpu)->cd.ppc.cr0_lazy)					\
+		ppc_cr0_materialize(cpu);				}
+
+#define	PPC_CR0_OVERWRITE(cpu)	{ (cpu)->cd.ppc.cr0_lazy = 0; }
 
 
 struct ppc_cpu {
@@ -120,6 +171,11 @@ struct ppc_cpu {
 	uint64_t	zero;		/*  A zero register  */
 
 	uint32_t	cr;		/*  Condition Register  */
+	int		cr0_lazy;	/*  Pending CR0 update, see  */
+	uint64_t	cr0_lazy_value;	/*  PPC_CR0_SYNC() above  */
+	int		lazy_lockstep;
+	uint32_t	lazy_lockstep_eager;
+	uint32_t	lazy_lockstep_cr0;
 	uint32_t	fpscr;		/*  FP Status and Control Register  */
 	uint64_t	gpr[PPC_NGPRS];	/*  General Purpose Registers  */
 	uint64_t	fpr[PPC_NFPRS];	/*  Floating-Point Registers  */
@@ -133,9 +189,10 @@ struct ppc_cpu {
 	uint32_t	sr[16];		/*  Segment registers.  */
 	uint64_t	spr[1024];
 
-	uint64_t	ll_addr;	/*  Load-linked / store-conditional  */
-	int		ll_bit;
-
+	/*  Derived from the BAT SPRs and the page table; see memory_ppc.c:  */
+	struct ppc_bat	bat[8];
+	uint8_t		bat_segment_mask[2][2][16];
+	struct ppc_pte_cache_entry pte_cache[PPC_N_PTE_CACHE];
 
 	/*
 	 *  Instruction translation cache and Virtual->Physical->Host
@@ -175,7 +232,10 @@ struct ppc_cpu {
 #define	PPC_FPSCR_FX	(1 << 31)	/*  Exception summary  */
 #define	PPC_FPSCR_FEX	(1 << 30)	/*  Enabled Exception summary  */
 #define	PPC_FPSCR_VX	(1 << 29)	/*  Invalid Operation summary  */
-/*  .. TODO  */
+#define	PPC_FPSCR_OX	(1 << 28)	/*  Overflow  */
+#define	PPC_FPSCR_UX	(1 << 27)	/*  Underflow  */
+#define	PPC_FPSCR_ZX	(1 << 26)	/*  Zero Divide  */
+#define	PPC_FPSCR_XX	(1 << 25)	/*  Inexact  */
 #define	PPC_FPSCR_VXNAN	(1 << 24)
 /*  .. TODO  */
 #define	PPC_FPSCR_FPCC	0x0000f000
@@ -184,6 +244,8 @@ struct ppc_cpu {
 #define	PPC_FPSCR_FG	(1 << 14)	/*  Greater than  */
 #define	PPC_FPSCR_FE	(1 << 13)	/*  Equal or Zero  */
 #define	PPC_FPSCR_FU	(1 << 12)	/*  Unordered or NaN  */
+/*  .. TODO  */
+#define	PPC_FPSCR_RN	0x00000003	/*  Rounding Control  */
 
 /*  Exceptions:  */
 #define	PPC_EXCEPTION_DSI	0x3	/*  Data Storage Interrupt  */
@@ -203,6 +265,12 @@ struct ppc_cpu {
 int ppc_run_instr(struct cpu *cpu);
 int ppc32_run_instr(struct cpu *cpu);
 void ppc_exception(struct cpu *cpu, int exception_nr);
+void ppc_cr0_materialize(struct cpu *cpu);
+void ppc_lazy_lockstep_check(struct cpu *cpu);
+void ppc_settings_written(struct cpu *cpu);
+void ppc_fpscr_exceptions(struct cpu *cpu, int exc);
+void ppc_fenv_begin(struct cpu *cpu);
+void ppc_fenv_end(struct cpu *cpu);
 void ppc_update_translation_table(struct cpu *cpu, uint64_t vaddr_page,
 	unsigned char *host_page, int writeflag, uint64_t paddr_page);
 void ppc32_update_translation_table(struct cpu *cpu, uint64_t vaddr_page,
@@ -217,6 +285,8 @@ int ppc_memory_rw(struct cpu *cpu, struct memory *mem, uint64_t vaddr,
 int ppc_cpu_family_init(struct cpu_family *);
 
 /*  memory_ppc.c:  */
+void ppc_bat_update(struct cpu *cpu);
+void ppc_pte_cache_invalidate(struct cpu *cpu, uint64_t vaddr, int all);
 int ppc_translate_v2p(struct cpu *cpu, uint64_t vaddr,
 	uint64_t *return_addr, int flags);
 
@@ -77,7 +77,8 @@ struct sh_cpu_type_def {
 
 DYNTRANS_MISC_DECLARATIONS(sh,SH,uint32_t)
 
-#define	SH_MAX_VPH_TLB_ENTRIES		128
+#define	SH_DEFAULT_VPH_TLB_ENTRIES	128
+#define	SH_MAX_VPH_TLB_ENTRIES		1024
 
 
 #define	SH_N_GPRS		16
@@ -87,6 +88,15 @@ DYNTRANS_MISC_DECLARATIONS(sh,SH,uint32_t)
 #define	SH_N_ITLB_ENTRIES	4
 #define	SH_N_UTLB_ENTRIES	64
 
+/*
+ *  Hash index over the valid UTLB entries, one hash table per page size
+ *  (1K, 4K, 64K, 1M). Each bucket is a chain of UTLB entry numbers in
+ *  ascending order, linked via utlb_hash_next[], so that lookups find the
+ *  same entry as a linear scan would. -1 terminates a chain.
+ */
+#define	SH_UTLB_HASH_SIZE	64
+#define	SH_UTLB_N_PAGESIZES	4
+
 /*  An instruction with an invalid encoding; used for software
     emulation of PROM calls within GXemul:  */
 #define	SH_INVALID_INSTR	0x00fb
@@ -133,6 +143,14 @@ struct sh_cpu {
 	uint32_t	utlb_hi[SH_N_UTLB_ENTRIES];
 	uint32_t	utlb_lo[SH_N_UTLB_ENTRIES];
 
+	/*  UTLB hash index; see memory_sh.c:  */
+	int8_t		utlb_hash[SH_UTLB_N_PAGESIZES][SH_UTLB_HASH_SIZE];
+	int8_t		utlb_hash_next[SH_N_UTLB_ENTRIES];
+	int16_t		utlb_hash_bucket[SH_N_UTLB_ENTRIES];
+	int		utlb_n_per_pagesize[SH_UTLB_N_PAGESIZES];
+	uint64_t	utlb_index_hits;
+	uint64_t	utlb_index_misses;
+
 	/*  Exception handling:  */
 	uint32_t	tra;		/*  TRAPA Exception Register  */
 	uint32_t	expevt;		/*  Exception Event Register  */
@@ -237,9 +255,12 @@ int sh_cpu_family_init(struct cpu_family *);
 
 void sh_update_interrupt_priorities(struct cpu *cpu);
 void sh_update_sr(struct cpu *cpu, uint32_t new_sr);
+void sh_settings_written(struct cpu *cpu);
 void sh_exception(struct cpu *cpu, int expevt, int intevt, uint32_t vaddr);
 
 /*  memory_sh.c:  */
+void sh_utlb_index_init(struct cpu *cpu);
+void sh_utlb_index_update(struct cpu *cpu, int e);
 int sh_translate_v2p(struct cpu *cpu, uint64_t vaddr,
 	uint64_t *return_addr, int flags);
 
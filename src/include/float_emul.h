@@ -45,8 +45,28 @@ struct ieee_float_value {
 #define	IEEE_FMT_W		3	/*  word, 32-bit integer  */
 #define	IEEE_FMT_L		4	/*  long, 64-bit integer  */
 
+/*  Rounding modes (the same encoding as MIPS FCSR RM and PowerPC FPSCR RN):  */
+#define	IEEE_ROUND_NEAREST	0
+#define	IEEE_ROUND_ZERO		1
+#define	IEEE_ROUND_UP		2	/*  towards +Inf  */
+#define	IEEE_ROUND_DOWN		3	/*  towards -Inf  */
+
+/*  Exception flags, returned by ieee_fenv_end():  */
+#define	IEEE_EXC_INEXACT	1
+#define	IEEE_EXC_UNDERFLOW	2
+#define	IEEE_EXC_OVERFLOW	4
+#define	IEEE_EXC_DIVBYZERO	8
+#define	IEEE_EXC_INVALID	16
+
 void ieee_interpret_float_value(uint64_t x, struct ieee_float_value *fvp,
 	int fmt);
 uint64_t ieee_store_float_value(double nf, int fmt, int nan);
 
+void ieee_interpret_float_value_slow(uint64_t x,
+	struct ieee_float_value *fvp, int fmt);
+uint64_t ieee_store_float_value_slow(double nf, int fmt, int nan);
+
+void ieee_fenv_begin(int rounding_mode);
+int ieee_fenv_end(int rounding_mode);
+
 #endif	/*  FLOAT_EMUL_H  */
@@ -52,12 +52,30 @@ struct isa_pic_data {
 	int			last_int;
 };
 
+#define	BREAKPOINT_HASH_SIZE	256
+
 struct breakpoints {
 	int		n;
 
 	/*  Arrays, with one element for each entry:  */
 	char		**string;
 	uint64_t	*addr;
+	int		*hash_next;
+
+	/*
+	 *  Hash chains of breakpoint addresses, built by
+	 *  machine_breakpoints_rehash(). hash_first[] and hash_next[] hold
+	 *  entry index + 1, or 0 for the end of a chain.
+	 */
+	int		hash_first[BREAKPOINT_HASH_SIZE];
+};
+
+struct watchpoints {
+	int		n;
+
+	/*  Arrays, with one element for each entry:  */
+	uint64_t	*addr;
+	int		*len;
 };
 
 struct statistics {
@@ -158,12 +176,16 @@ struct machine {
 	/*  Breakpoints:  */
 	struct breakpoints breakpoints;
 
+	/*  Data watchpoints (on stores):  */
+	struct watchpoints watchpoints;
+
 	int	halt_on_nonexistant_memaccess;
 	int	instruction_trace;
 	int	show_nr_of_instructions;
 	int	show_trace_tree;
 	int	emulated_hz;
 	int	allow_instruction_combinations;
+	int	allow_native_routines;
 	int	force_netboot;
 	int	slow_serial_interrupts_hack_for_linux;
 	uint64_t file_loaded_end_addr;
@@ -368,6 +390,11 @@ void machine_destroy(struct machine *machine);
 int machine_name_to_type(char *stype, char *ssubtype,
 	int *type, int *subtype, int *arch);
 void machine_add_breakpoint_string(struct machine *machine, char *str);
+void machine_breakpoints_rehash(struct machine *machine);
+int machine_breakpoint_lookup(struct machine *machine, uint64_t addr,
+	uint64_t mask);
+int machine_watchpoint_lookup(struct machine *machine, uint64_t addr,
+	uint64_t len, uint64_t mask);
 void machine_add_tickfunction(struct machine *machine,
 	void (*func)(struct cpu *, void *), void *extra, int clockshift);
 void machine_statistics_init(struct machine *, char *fname);
@@ -36,6 +36,10 @@
 
 #include "misc.h"
 
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
 
 #define	DEFAULT_RAM_IN_MB		32
 
@@ -64,6 +68,24 @@ struct memory_device {
 };
 
 
+/*
+ *  Load-linked/store-conditional reservation. There is one per cpu, indexed
+ *  by cpu_id. data[] holds the bytes as they were loaded, so that a store
+ *  conditional can be done as a compare-and-swap on the host memory. (This
+ *  also catches writes which do not go through memory_rw(), e.g. dyntrans
+ *  fast path stores or DMA directly into host memory.)
+ */
+struct memory_reservation {
+	int		valid;
+	int		len;
+	uint64_t	paddr;
+	unsigned char	data[8];
+};
+
+/*  Writes within the same granule break a reservation:  */
+#define	MEMORY_RESERVATION_GRANULE	32
+
+
 /*
  *  Memory
  *  ------
@@ -86,6 +108,13 @@ struct memory {
 	uint64_t	mmap_dev_maxaddr;
 
 	struct memory_device *devices;
+
+	/*  Load-linked/store-conditional reservations, see memory.cc:  */
+	int		n_reservations;
+	struct memory_reservation *reservations;
+#ifdef HAVE_PTHREADS
+	pthread_mutex_t	reservation_mutex;
+#endif
 };
 
 #define	BITS_PER_PAGETABLE	20
@@ -111,6 +140,16 @@ char *memory_conv_to_string(struct cpu *cpu, struct memory *mem,
 unsigned char *memory_paddr_to_hostaddr(struct memory *mem,
 	uint64_t paddr, int writeflag);
 
+void memory_reservation_set(struct cpu *cpu, struct memory *mem,
+	uint64_t paddr, unsigned char *data, size_t len);
+int memory_reservation_store(struct cpu *cpu, struct memory *mem,
+	uint64_t paddr, unsigned char *hostptr, unsigned char *data,
+	size_t len);
+void memory_reservation_invalidate(struct memory *mem, uint64_t paddr,
+	size_t len);
+void memory_reservation_clear(struct cpu *cpu);
+int memory_reservation_get(struct cpu *cpu, uint64_t *paddrp);
+
 
 /*  Writeflag:  */
 #define	MEM_READ			0
@@ -125,6 +164,8 @@ unsigned char *memory_paddr_to_hostaddr(struct memory *mem,
 #define	NO_EXCEPTIONS			16
 #define	PHYSICAL			32
 #define	MEMORY_USER_ACCESS		64	/*  for ARM and M88K  */
+#define	MEMORY_LOAD_LINKED		512	/*  sets a reservation  */
+#define	MEMORY_STORE_CONDITIONAL	1024	/*  only if still reserved  */
 
 /*  Dyntrans Memory flags:  */
 #define	DM_DEFAULT				0
@@ -140,6 +181,7 @@ unsigned char *memory_paddr_to_hostaddr(struct memory *mem,
 #define	MEMORY_ACCESS_FAILED		0
 #define	MEMORY_ACCESS_OK		1
 #define	MEMORY_ACCESS_OK_WRITE		2
+#define	MEMORY_ACCESS_NO_RESERVATION	3	/*  store conditional failed  */
 #define	MEMORY_NOT_FULL_PAGE		256
 
 void memory_device_dyntrans_access(struct cpu *, struct memory *mem,
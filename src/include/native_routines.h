@@ -0,0 +1,90 @@
+#ifndef	NATIVE_ROUTINES_H
+#define	NATIVE_ROUTINES_H
+
+/*
+ *  Copyright (C) 2010  Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ *
+ *
+ *  Guest routines which are run natively on the host. See native_routines.cc.
+ */
+
+#include <inttypes.h>
+#include <stddef.h>
+
+struct cpu;
+struct machine;
+
+
+/*
+ *  Routines which are recognized by symbol name, i.e. when a call is
+ *  translated to an address which has one of these names in the machine's
+ *  symbol context:
+ */
+#define	NATIVE_ROUTINE_NONE		0
+#define	NATIVE_ROUTINE_MEMSET		1
+#define	NATIVE_ROUTINE_BZERO		2
+#define	NATIVE_ROUTINE_MEMCPY		3
+#define	NATIVE_ROUTINE_MEMMOVE		4
+#define	NATIVE_ROUTINE_BCOPY		5
+#define	NATIVE_ROUTINE_STRLEN		6
+#define	N_NATIVE_SYMBOL_ROUTINES	7
+
+/*
+ *  Routines (or the inner loops of routines) which are only recognized by
+ *  their instruction pattern, using instruction combinations:
+ */
+#define	NATIVE_ROUTINE_FILL_LOOP	7
+#define	NATIVE_ROUTINE_COPY_LOOP	8
+#define	NATIVE_ROUTINE_COPYIN		9
+#define	NATIVE_ROUTINE_COPYOUT		10
+#define	NATIVE_ROUTINE_SCANC		11
+#define	NATIVE_ROUTINE_CACHE_INV	12
+#define	NATIVE_ROUTINE_MEMCPY_LOOP	13
+#define	NATIVE_ROUTINE_STRLEN_LOOP	14
+#define	N_NATIVE_ROUTINES		15
+
+/*  Calls with larger lengths than this are left to the guest code.  */
+#define	NATIVE_ROUTINE_MAX_LEN		(1 << 20)
+
+/*
+ *  Returns the host page for a virtual address, or NULL if it is not mapped
+ *  in the fast lookup tables (host_store if writeflag is non-zero, otherwise
+ *  host_load). Implemented for each arch in cpu_dyntrans.cc.
+ */
+typedef unsigned char *(*native_host_page_fn)(struct cpu *,
+	uint64_t vaddr, int writeflag);
+
+
+/*  native_routines.cc:  */
+const char *native_routine_name(int id);
+void native_fill_pattern(unsigned char *p, uint64_t value, int wordsize,
+	int little_endian, size_t len);
+int native_routine_lookup(struct machine *machine, uint64_t addr);
+int native_routine_run(struct cpu *cpu, int id, uint64_t *args,
+	uint64_t *retvalp, native_host_page_fn host_page);
+
+
+#endif	/*  NATIVE_ROUTINES_H  */
@@ -2,12 +2,16 @@
 #undef quick_pc_to_pointers
 #endif
 
+/*
+ *  Note: An odd pc (e.g. a switch into ARM Thumb mode) always takes the slow
+ *  path, since phys_page[] only points to pages in the normal geometry.
+ */
 #ifdef MODE32
 #define	quick_pc_to_pointers(cpu) {					\
 	uint32_t pc = cpu->pc;						\
 	struct DYNTRANS_TC_PHYSPAGE *ppp;				\
 	ppp = cpu->cd.DYNTRANS_ARCH.phys_page[pc >> 12];		\
-	if (ppp != NULL) {						\
+	if (ppp != NULL && !(pc & 1)) {					\
 		cpu->cd.DYNTRANS_ARCH.cur_ic_page = &ppp->ics[0];	\
 		cpu->cd.DYNTRANS_ARCH.next_ic =				\
 		    cpu->cd.DYNTRANS_ARCH.cur_ic_page +			\
@@ -80,6 +80,7 @@ struct machine *machine_new(char *name, struct emul *emul, int id)
 					    emul.c for other pagesizes.  */
 	m->prom_emulation = 1;
 	m->allow_instruction_combinations = 1;
+	m->allow_native_routines = 1;
 	m->byte_order_override = NO_BYTE_ORDER_OVERRIDE;
 	m->boot_kernel_filename = strdup("");
 	m->boot_string_argument = NULL;
@@ -105,6 +106,9 @@ struct machine *machine_new(char *name, struct emul *emul, int id)
 	settings_add(m->settings, "allow_instruction_combinations", 0,
 	    SETTINGS_TYPE_INT, SETTINGS_FORMAT_YESNO,
 	    (void *) &m->allow_instruction_combinations);
+	settings_add(m->settings, "allow_native_routines", 0,
+	    SETTINGS_TYPE_INT, SETTINGS_FORMAT_YESNO,
+	    (void *) &m->allow_native_routines);
 	settings_add(m->settings, "n_gfx_cards", 0,
 	    SETTINGS_TYPE_INT, SETTINGS_FORMAT_DECIMAL,
 	    (void *) &m->n_gfx_cards);
@@ -263,6 +267,89 @@ void machine_add_breakpoint_string(struct machine *machine, char *str)
 }
 
 
+/*  Hash function for breakpoint addresses. Only the low 32 bits are used,
+    so that lookups of truncated 32-bit addresses end up in the same chain.  */
+#define	BREAKPOINT_HASH(a)	((((uint32_t)(a) >> 1) ^ ((uint32_t)(a) >> 9) \
+				^ ((uint32_t)(a) >> 17)) & (BREAKPOINT_HASH_SIZE - 1))
+
+
+/*
+ *  machine_breakpoints_rehash():
+ *
+ *  Rebuilds the breakpoint hash chains. Should be called whenever
+ *  breakpoints are added or removed, or when their addresses change.
+ */
+void machine_breakpoints_rehash(struct machine *machine)
+{
+	struct breakpoints *bp = &machine->breakpoints;
+	int i, h;
+
+	memset(bp->hash_first, 0, sizeof(bp->hash_first));
+
+	if (bp->n == 0)
+		return;
+
+	CHECK_ALLOCATION(bp->hash_next = (int *)
+	    realloc(bp->hash_next, bp->n * sizeof(int)));
+
+	for (i=bp->n-1; i>=0; i--) {
+		h = BREAKPOINT_HASH(bp->addr[i]);
+		bp->hash_next[i] = bp->hash_first[h];
+		bp->hash_first[h] = i + 1;
+	}
+}
+
+
+/*
+ *  machine_breakpoint_lookup():
+ *
+ *  Returns the index of the breakpoint at addr, or -1 if there is none.
+ *  Breakpoint addresses are masked with mask before they are compared to
+ *  addr, e.g. 0xffffffff when the emulated CPU uses 32-bit addresses.
+ */
+int machine_breakpoint_lookup(struct machine *machine, uint64_t addr,
+	uint64_t mask)
+{
+	struct breakpoints *bp = &machine->breakpoints;
+	int i = bp->hash_first[BREAKPOINT_HASH(addr)];
+
+	while (i != 0) {
+		if ((bp->addr[i-1] & mask) == addr)
+			return i-1;
+		i = bp->hash_next[i-1];
+	}
+
+	return -1;
+}
+
+
+/*
+ *  machine_watchpoint_lookup():
+ *
+ *  Returns the index of the first watchpoint which overlaps the len bytes
+ *  at addr, or -1 if there is none. Both addresses are masked with mask
+ *  before they are compared. (There are usually only a few watchpoints,
+ *  and this is only called for stores which take the slow path.)
+ */
+int machine_watchpoint_lookup(struct machine *machine, uint64_t addr,
+	uint64_t len, uint64_t mask)
+{
+	struct watchpoints *wp = &machine->watchpoints;
+	uint64_t waddr;
+	int i;
+
+	addr &= mask;
+
+	for (i=0; i<wp->n; i++) {
+		waddr = wp->addr[i] & mask;
+		if (waddr < addr + len && addr < waddr + wp->len[i])
+			return i;
+	}
+
+	return -1;
+}
+
+
 /*
  *  machine_add_tickfunction():
  *
@@ -325,6 +412,7 @@ void machine_statistics_init(struct machine *machine, char *fname)
 	const char *mode = "a";	/*  Append by default  */
 
 	machine->allow_instruction_combinations = 0;
+	machine->allow_native_routines = 0;
 
 	if (machine->statistics.fields != NULL) {
 		fprintf(stderr, "Only one -s option is allowed.\n");
@@ -173,6 +173,7 @@ GXemul::GXemul()
 	, m_nrOfSingleStepsLeft(1)
 	, m_rootComponent(new RootComponent(this))
 	, m_snapshottingEnabled(false)
+	, m_profilingEnabled(false)
 {
 	gettimeofday(&m_lastOutputTime, NULL);
 	m_lastOutputStep = 0;
@@ -548,6 +549,30 @@ void GXemul::InitUI()
 }
 
 
+// Enables profiling in all components that support it.
+static void EnableProfiling(refcount_ptr<Component> component)
+{
+	if (component->GetVariable("profiling") != NULL)
+		component->SetVariableValue("profiling", "true");
+
+	Components children = component->GetChildren();
+	for (size_t i=0; i<children.size(); ++i)
+		EnableProfiling(children[i]);
+}
+
+
+// Shows a profile report for all components that support profiling.
+static void ShowProfiles(GXemul* gxemul, refcount_ptr<Component> component)
+{
+	if (component->GetVariable("profiling") != NULL)
+		component->ExecuteMethod(gxemul, "profile", vector<string>());
+
+	Components children = component->GetChildren();
+	for (size_t i=0; i<children.size(); ++i)
+		ShowProfiles(gxemul, children[i]);
+}
+
+
 int GXemul::Run()
 {
 	// Not really running yet:
@@ -587,6 +612,8 @@ int GXemul::Run()
 
 	SetRunState(savedRunState);
 
+	if (GetProfilingEnabled())
+		EnableProfiling(GetRootComponent());
 
 	try {
 		GetUI()->MainLoop();
@@ -604,6 +631,9 @@ int GXemul::Run()
 		return 1;
 	}
 
+	if (GetProfilingEnabled())
+		ShowProfiles(this, GetRootComponent());
+
 	return 0;
 }
 
@@ -779,6 +809,18 @@ void GXemul::SetSnapshottingEnabled(bool enabled)
 }
 
 
+bool GXemul::GetProfilingEnabled() const
+{
+	return m_profilingEnabled;
+}
+
+
+void GXemul::SetProfilingEnabled(bool enabled)
+{
+	m_profilingEnabled = enabled;
+}
+
+
 bool GXemul::GetQuietMode() const
 {
 	return m_quietMode;
@@ -885,6 +927,99 @@ static void GetComponentsAndFrequencies(refcount_ptr<Component> component,
 }
 
 
+/*
+ * Sloppy execution: Instead of interleaving components cycle by cycle, each
+ * component runs a whole quantum at a time. CPUs may run in parallel, on
+ * separate host threads (see QuantumScheduler), and other components run
+ * after them. Returns the new step count.
+ */
+static uint64_t ExecuteInQuanta(GXemul* gxemul, QuantumScheduler& scheduler,
+	vector<ComponentAndFrequency>& componentsAndFrequencies,
+	size_t fastestComponentIndex, uint64_t step, uint64_t lastStep)
+{
+	uint64_t quantum = gxemul->GetRootComponent()->GetVariable("quantum")->ToInteger();
+	double fastestFrequency = componentsAndFrequencies[fastestComponentIndex].frequency;
+
+	vector<QuantumScheduler::Job> jobs;
+	vector<size_t> jobComponentIndex;
+
+	while (step < lastStep) {
+		if (gxemul->IsInterrupting() || gxemul->GetRunState() != GXemul::Running)
+			break;
+
+		uint64_t toExecute = quantum;
+		if (step + toExecute > lastStep)
+			toExecute = lastStep - step;
+
+		// Component k, using frequency fk, should have executed
+		// nstepsk = targetStep * fk / fastestFrequency  nr of steps
+		// at the end of this quantum.
+		uint64_t targetStep = step + toExecute;
+
+		jobs.clear();
+		jobComponentIndex.clear();
+
+		for (size_t k=0; k<componentsAndFrequencies.size(); ++k) {
+			uint64_t nsteps = (k == fastestComponentIndex ? targetStep
+			    : (uint64_t) (targetStep * componentsAndFrequencies[k].frequency / fastestFrequency));
+
+			uint64_t stepsExecutedSoFar = componentsAndFrequencies[k].step->ToInteger();
+			if (stepsExecutedSoFar >= nsteps)
+				continue;
+
+			QuantumScheduler::Job job;
+			job.component = componentsAndFrequencies[k].component;
+			job.nrOfCycles = nsteps - stepsExecutedSoFar;
+			job.parallel = componentsAndFrequencies[k].component->AsCPUComponent() != NULL;
+			job.executed = 0;
+
+			jobs.push_back(job);
+			jobComponentIndex.push_back(k);
+		}
+
+		scheduler.RunQuantum(gxemul, jobs);
+
+		// Write back the number of executed steps:
+		uint64_t executedByFastest = toExecute;
+		bool abort = false;
+		for (size_t j=0; j<jobs.size(); ++j) {
+			size_t k = jobComponentIndex[j];
+			int n = jobs[j].executed;
+
+			if (n > jobs[j].nrOfCycles) {
+				std::cerr << "Internal error: " << n <<
+				    " steps executed, nrOfCycles = " << jobs[j].nrOfCycles << "\n";
+				throw std::exception();
+			}
+
+			componentsAndFrequencies[k].step->SetValue(
+			    componentsAndFrequencies[k].step->ToInteger() + n);
+
+			if (k == fastestComponentIndex)
+				executedByFastest = n;
+
+			if (n != jobs[j].nrOfCycles) {
+				abort = true;
+
+				stringstream ss;
+				ss << "only " << n << " steps of " << jobs[j].nrOfCycles << " executed.";
+				gxemul->GetUI()->ShowDebugMessage(componentsAndFrequencies[k].component, ss.str());
+			}
+		}
+
+		step += executedByFastest;
+
+		if (abort) {
+			gxemul->GetUI()->ShowDebugMessage("Continuous execution aborted.\n");
+			gxemul->SetRunState(GXemul::Paused);
+			break;
+		}
+	}
+
+	return step;
+}
+
+
 void GXemul::Execute(const int longestTotalRun)
 {
 	vector<ComponentAndFrequency> componentsAndFrequencies;
@@ -992,13 +1127,7 @@ void GXemul::Execute(const int longestTotalRun)
 			uint64_t step = GetStep();
 			uint64_t startingStep = step;
 
-			// TODO: sloppy vs cycle accuracy.
-			if (GetRootComponent()->GetVariable("accuracy")->ToString() != "cycle") {
-				std::cerr << "GXemul::Execute(): TODO: Only "
-				    "root.accuracy=\"cycle\" is currently supported\n";
-				SetRunState(Paused);
-				return;
-			}
+			bool sloppy = GetRootComponent()->GetVariable("accuracy")->ToString() == "sloppy";
 
 			// The following code is for cycle accurate emulation:
 
@@ -1006,6 +1135,15 @@ void GXemul::Execute(const int longestTotalRun)
 				if (m_interrupting || GetRunState() != Running)
 					break;
 
+				// Sloppy accuracy: run whole quanta at a time instead.
+				if (sloppy) {
+					step = ExecuteInQuanta(this, m_quantumScheduler,
+					    componentsAndFrequencies, fastestComponentIndex,
+					    step, startingStep + longestTotalRun);
+					SetStep(step);
+					continue;
+				}
+
 				int toExecute = -1;
 				
 				if (componentsAndFrequencies.size() == 1) {
@@ -0,0 +1,544 @@
+/*
+ *  Copyright (C) 2010  Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+#include "QuantumScheduler.h"
+#include "Component.h"
+#include "GXemul.h"
+#include "UI.h"
+
+
+bool QuantumScheduler::s_busLockingEnabled = false;
+
+#ifdef HAVE_PTHREADS
+pthread_mutex_t QuantumScheduler::s_busMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_once_t QuantumScheduler::s_currentJobKeyOnce = PTHREAD_ONCE_INIT;
+pthread_key_t QuantumScheduler::s_currentJobKey;
+#endif
+
+
+QuantumScheduler::QuantumScheduler()
+#ifdef HAVE_PTHREADS
+	: m_generation(0)
+	, m_nrOfJobsLeft(0)
+	, m_quitting(false)
+	, m_failed(false)
+	, m_gxemul(NULL)
+#endif
+{
+#ifdef HAVE_PTHREADS
+	pthread_mutex_init(&m_mutex, NULL);
+	pthread_cond_init(&m_startCondition, NULL);
+	pthread_cond_init(&m_doneCondition, NULL);
+	pthread_once(&s_currentJobKeyOnce, CreateCurrentJobKey);
+#endif
+}
+
+
+QuantumScheduler::~QuantumScheduler()
+{
+#ifdef HAVE_PTHREADS
+	StopWorkers();
+
+	pthread_cond_destroy(&m_doneCondition);
+	pthread_cond_destroy(&m_startCondition);
+	pthread_mutex_destroy(&m_mutex);
+#endif
+}
+
+
+size_t QuantumScheduler::GetNrOfWorkerThreads() const
+{
+#ifdef HAVE_PTHREADS
+	return m_workers.size();
+#else
+	return 0;
+#endif
+}
+
+
+bool QuantumScheduler::DeferDebugMessage(UI* ui, Component* component,
+	const string& msg)
+{
+	// Only set while parallel jobs are running, and then the key
+	// has been created:
+	if (!s_busLockingEnabled)
+		return false;
+
+#ifdef HAVE_PTHREADS
+	Job* job = (Job*) pthread_getspecific(s_currentJobKey);
+	if (job == NULL)
+		return false;
+
+	DebugMessage debugMessage;
+	debugMessage.ui = ui;
+	debugMessage.component = component;
+	debugMessage.msg = msg;
+	job->debugMessages.push_back(debugMessage);
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+void QuantumScheduler::FlushDebugMessages(Job& job)
+{
+	for (size_t i=0; i<job.debugMessages.size(); ++i) {
+		DebugMessage& m = job.debugMessages[i];
+		if (m.component == NULL)
+			m.ui->ShowDebugMessage(m.msg);
+		else
+			m.ui->ShowDebugMessage(m.component, m.msg);
+	}
+
+	job.debugMessages.clear();
+}
+
+
+void QuantumScheduler::RunJob(GXemul* gxemul, Job& job, bool deferMessages,
+	bool& failed)
+{
+	job.executed = 0;
+
+#ifdef HAVE_PTHREADS
+	if (deferMessages)
+		pthread_setspecific(s_currentJobKey, &job);
+#endif
+
+	try {
+		job.executed = job.component->Execute(gxemul, job.nrOfCycles);
+	} catch (...) {
+		// Exceptions must not escape from a worker thread. The
+		// failure is instead re-thrown on the calling thread, once
+		// all jobs have finished.
+		failed = true;
+	}
+
+#ifdef HAVE_PTHREADS
+	if (deferMessages)
+		pthread_setspecific(s_currentJobKey, NULL);
+#endif
+}
+
+
+void QuantumScheduler::RunQuantum(GXemul* gxemul, vector<Job>& jobs)
+{
+	vector<Job*> parallelJobs;
+	for (size_t i=0; i<jobs.size(); ++i)
+		if (jobs[i].parallel)
+			parallelJobs.push_back(&jobs[i]);
+
+	bool failed = false;
+
+#ifdef HAVE_PTHREADS
+	// The first parallel job is run by the calling thread, the others
+	// by worker threads.
+	if (parallelJobs.size() > 1) {
+		StartWorkers(parallelJobs.size() - 1);
+
+		pthread_mutex_lock(&m_mutex);
+
+		s_busLockingEnabled = true;
+		m_gxemul = gxemul;
+		m_failed = false;
+		m_workerJobs.assign(parallelJobs.begin() + 1, parallelJobs.end());
+		m_nrOfJobsLeft = m_workerJobs.size();
+		++ m_generation;
+
+		pthread_cond_broadcast(&m_startCondition);
+		pthread_mutex_unlock(&m_mutex);
+
+		RunJob(gxemul, *parallelJobs[0], true, failed);
+
+		// Barrier: wait for all worker threads to finish the quantum.
+		pthread_mutex_lock(&m_mutex);
+		while (m_nrOfJobsLeft > 0)
+			pthread_cond_wait(&m_doneCondition, &m_mutex);
+
+		s_busLockingEnabled = false;
+		m_workerJobs.clear();
+		failed |= m_failed;
+
+		pthread_mutex_unlock(&m_mutex);
+
+		for (size_t i=0; i<parallelJobs.size(); ++i)
+			FlushDebugMessages(*parallelJobs[i]);
+
+		parallelJobs.clear();
+	}
+#endif
+
+	// Without threads (or with just a single parallel job), the parallel
+	// jobs are run on the calling thread:
+	for (size_t i=0; i<parallelJobs.size(); ++i)
+		RunJob(gxemul, *parallelJobs[i], false, failed);
+
+	// Then the serial jobs, after all parallel jobs have finished:
+	for (size_t i=0; i<jobs.size(); ++i)
+		if (!jobs[i].parallel)
+			RunJob(gxemul, jobs[i], false, failed);
+
+	if (failed) {
+		std::cerr << "QuantumScheduler: a component failed during"
+		    " execution of a quantum.\n";
+		throw std::exception();
+	}
+}
+
+
+#ifdef HAVE_PTHREADS
+
+void QuantumScheduler::CreateCurrentJobKey()
+{
+	pthread_key_create(&s_currentJobKey, NULL);
+}
+
+
+void* QuantumScheduler::WorkerThreadMain(void* arg)
+{
+	Worker* worker = (Worker*) arg;
+	worker->scheduler->WorkerLoop(worker);
+	return NULL;
+}
+
+
+void QuantumScheduler::WorkerLoop(Worker* worker)
+{
+	pthread_mutex_lock(&m_mutex);
+
+	size_t index = worker->index;
+	uint64_t lastGeneration = worker->startGeneration;
+
+	for (;;) {
+		while (m_generation == lastGeneration && !m_quitting)
+			pthread_cond_wait(&m_startCondition, &m_mutex);
+
+		if (m_quitting)
+			break;
+
+		lastGeneration = m_generation;
+
+		// Fewer jobs than workers this quantum? Then just wait
+		// for the next one.
+		if (index >= m_workerJobs.size())
+			continue;
+
+		Job* job = m_workerJobs[index];
+		GXemul* gxemul = m_gxemul;
+		bool failed = false;
+
+		pthread_mutex_unlock(&m_mutex);
+		RunJob(gxemul, *job, true, failed);
+		pthread_mutex_lock(&m_mutex);
+
+		m_failed |= failed;
+		if (-- m_nrOfJobsLeft == 0)
+			pthread_cond_signal(&m_doneCondition);
+	}
+
+	pthread_mutex_unlock(&m_mutex);
+}
+
+
+void QuantumScheduler::StartWorkers(size_t n)
+{
+	while (m_workers.size() < n) {
+		// Note: m_workers is a list, so the address of a Worker
+		// (which is passed to the thread) stays valid.
+		m_workers.push_back(Worker());
+		Worker& worker = m_workers.back();
+		worker.scheduler = this;
+		worker.index = m_workers.size() - 1;
+
+		// The new thread should wait for the _next_ quantum, not
+		// run the previous one.
+		pthread_mutex_lock(&m_mutex);
+		worker.startGeneration = m_generation;
+		int res = pthread_create(&worker.thread, NULL,
+		    WorkerThreadMain, &worker);
+		pthread_mutex_unlock(&m_mutex);
+
+		if (res != 0) {
+			std::cerr << "QuantumScheduler: could not create"
+			    " worker thread.\n";
+			m_workers.pop_back();
+			throw std::exception();
+		}
+	}
+}
+
+
+void QuantumScheduler::StopWorkers()
+{
+	pthread_mutex_lock(&m_mutex);
+	m_quitting = true;
+	pthread_cond_broadcast(&m_startCondition);
+	pthread_mutex_unlock(&m_mutex);
+
+	for (list<Worker>::iterator it = m_workers.begin();
+	    it != m_workers.end(); ++it)
+		pthread_join(it->thread, NULL);
+
+	m_workers.clear();
+}
+
+#endif	// HAVE_PTHREADS
+
+
+/*****************************************************************************/
+
+
+#ifdef WITHUNITTESTS
+
+#include "components/DummyComponent.h"
+#include "NullUI.h"
+
+/*
+ * A component which simply counts executed cycles. Each instance only
+ * touches its own state, so several of them may run in parallel.
+ */
+class QuantumSchedulerTestCounter
+	: public DummyComponent
+{
+public:
+	QuantumSchedulerTestCounter()
+		: DummyComponent("quantumschedulertestcounter")
+		, m_counter(0)
+		, m_maxCyclesPerCall(-1)
+	{
+	}
+
+	virtual int Execute(GXemul* gxemul, int nrOfCycles)
+	{
+		int n = nrOfCycles;
+		if (m_maxCyclesPerCall >= 0 && n > m_maxCyclesPerCall)
+			n = m_maxCyclesPerCall;
+
+		for (int i=0; i<n; ++i)
+			++ m_counter;
+
+		return n;
+	}
+
+	uint64_t	m_counter;
+	int		m_maxCyclesPerCall;
+};
+
+/*
+ * A UI which remembers all debug messages it was asked to display.
+ */
+class QuantumSchedulerTestUI
+	: public NullUI
+{
+public:
+	QuantumSchedulerTestUI(GXemul* gxemul)
+		: NullUI(gxemul)
+	{
+	}
+
+	vector<string>	m_messages;
+
+protected:
+	virtual void DisplayDebugMessage(const string& msg)
+	{
+		m_messages.push_back(msg);
+	}
+
+	virtual void DisplayDebugMessage(Component* component,
+	    const string& msg)
+	{
+		m_messages.push_back(component->GetVariable("name")->ToString()
+		    + ": " + msg);
+	}
+};
+
+/*
+ * A component which shows a few debug messages each time it executes.
+ */
+class QuantumSchedulerTestMessenger
+	: public DummyComponent
+{
+public:
+	QuantumSchedulerTestMessenger(UI* ui, const string& name)
+		: DummyComponent("quantumschedulertestmessenger")
+		, m_ui(ui)
+	{
+		SetVariableValue("name", "\"" + name + "\"");
+	}
+
+	virtual int Execute(GXemul* gxemul, int nrOfCycles)
+	{
+		string name = GetVariable("name")->ToString();
+
+		for (int i=0; i<3; ++i) {
+			stringstream ss;
+			ss << "message " << i;
+			m_ui->ShowDebugMessage(this, ss.str());
+		}
+
+		m_ui->ShowDebugMessage(name + " done");
+
+		return nrOfCycles;
+	}
+
+	UI*	m_ui;
+};
+
+static void Test_QuantumScheduler_NoWorkersInitially()
+{
+	QuantumScheduler scheduler;
+
+	UnitTest::Assert("there should be no worker threads initially",
+	    scheduler.GetNrOfWorkerThreads(), 0);
+}
+
+static void Test_QuantumScheduler_RunsAllJobs()
+{
+	GXemul gxemul;
+	QuantumScheduler scheduler;
+
+	const size_t nJobs = 5;
+	vector< refcount_ptr<Component> > components;
+	vector<QuantumScheduler::Job> jobs;
+
+	for (size_t i=0; i<nJobs; ++i) {
+		QuantumSchedulerTestCounter* counter = new QuantumSchedulerTestCounter;
+		components.push_back(counter);
+
+		QuantumScheduler::Job job;
+		job.component = counter;
+		job.nrOfCycles = 1000 * (i+1);
+		job.parallel = (i != 2);
+		job.executed = -1;
+		jobs.push_back(job);
+	}
+
+	// Run several quanta, to make sure that the worker threads
+	// are reused:
+	for (int quantum=0; quantum<10; ++quantum)
+		scheduler.RunQuantum(&gxemul, jobs);
+
+	for (size_t i=0; i<nJobs; ++i) {
+		QuantumSchedulerTestCounter* counter =
+		    (QuantumSchedulerTestCounter*) jobs[i].component;
+
+		UnitTest::Assert("executed mismatch",
+		    jobs[i].executed, 1000 * (i+1));
+		UnitTest::Assert("counter mismatch",
+		    counter->m_counter, 10 * 1000 * (i+1));
+	}
+
+#ifdef HAVE_PTHREADS
+	UnitTest::Assert("4 parallel jobs should use 3 worker threads",
+	    scheduler.GetNrOfWorkerThreads(), 3);
+#endif
+}
+
+static void Test_QuantumScheduler_PartialExecution()
+{
+	GXemul gxemul;
+	QuantumScheduler scheduler;
+
+	QuantumSchedulerTestCounter* counterA = new QuantumSchedulerTestCounter;
+	QuantumSchedulerTestCounter* counterB = new QuantumSchedulerTestCounter;
+	refcount_ptr<Component> a = counterA;
+	refcount_ptr<Component> b = counterB;
+
+	counterB->m_maxCyclesPerCall = 17;
+
+	vector<QuantumScheduler::Job> jobs(2);
+	jobs[0].component = counterA;
+	jobs[0].nrOfCycles = 100;
+	jobs[0].parallel = true;
+	jobs[1].component = counterB;
+	jobs[1].nrOfCycles = 100;
+	jobs[1].parallel = true;
+
+	scheduler.RunQuantum(&gxemul, jobs);
+
+	UnitTest::Assert("A should have run the whole quantum",
+	    jobs[0].executed, 100);
+	UnitTest::Assert("B should have stopped early",
+	    jobs[1].executed, 17);
+}
+
+static void Test_QuantumScheduler_DebugMessagesFromParallelJobs()
+{
+	GXemul gxemul;
+	QuantumScheduler scheduler;
+
+	QuantumSchedulerTestUI* testUI = new QuantumSchedulerTestUI(&gxemul);
+	refcount_ptr<UI> ui = testUI;
+
+	refcount_ptr<Component> a = new QuantumSchedulerTestMessenger(ui, "a");
+	refcount_ptr<Component> b = new QuantumSchedulerTestMessenger(ui, "b");
+
+	vector<QuantumScheduler::Job> jobs(2);
+	jobs[0].component = a;
+	jobs[0].nrOfCycles = 10;
+	jobs[0].parallel = true;
+	jobs[1].component = b;
+	jobs[1].nrOfCycles = 10;
+	jobs[1].parallel = true;
+
+	// Whichever thread happens to run first, the messages should come
+	// out whole, and grouped in job order:
+	for (int quantum=0; quantum<20; ++quantum) {
+		testUI->m_messages.clear();
+		scheduler.RunQuantum(&gxemul, jobs);
+
+		UnitTest::Assert("wrong number of messages",
+		    testUI->m_messages.size(), 8);
+		UnitTest::Assert("message 0", testUI->m_messages[0], "a: message 0");
+		UnitTest::Assert("message 1", testUI->m_messages[1], "a: message 1");
+		UnitTest::Assert("message 2", testUI->m_messages[2], "a: message 2");
+		UnitTest::Assert("message 3", testUI->m_messages[3], "a done");
+		UnitTest::Assert("message 4", testUI->m_messages[4], "b: message 0");
+		UnitTest::Assert("message 5", testUI->m_messages[5], "b: message 1");
+		UnitTest::Assert("message 6", testUI->m_messages[6], "b: message 2");
+		UnitTest::Assert("message 7", testUI->m_messages[7], "b done");
+	}
+
+	UnitTest::Assert("queues should be empty after the quantum",
+	    jobs[0].debugMessages.size() + jobs[1].debugMessages.size(), 0);
+
+	// Outside of a quantum, messages are displayed right away:
+	testUI->m_messages.clear();
+	ui->ShowDebugMessage("direct");
+	UnitTest::Assert("direct message", testUI->m_messages.size(), 1);
+}
+
+UNITTESTS(QuantumScheduler)
+{
+	UNITTEST(Test_QuantumScheduler_NoWorkersInitially);
+	UNITTEST(Test_QuantumScheduler_RunsAllJobs);
+	UNITTEST(Test_QuantumScheduler_PartialExecution);
+	UNITTEST(Test_QuantumScheduler_DebugMessagesFromParallelJobs);
+}
+
+#endif
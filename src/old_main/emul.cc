@@ -123,6 +123,8 @@ static void add_breakpoints(struct machine *m)
 			debug(" (%s)", m->breakpoints.string[i]);
 		debug("\n");
 	}
+
+	machine_breakpoints_rehash(m);
 }
 
 
@@ -32,6 +32,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <fenv.h>
 
 #include "float_emul.h"
 #include "misc.h"
@@ -41,16 +42,17 @@
 
 
 /*
- *  ieee_interpret_float_value():
+ *  ieee_interpret_float_value_slow():
  *
  *  Interprets a float value from binary IEEE format into an ieee_float_value
- *  struct.
+ *  struct, one bit at a time. This is the reference implementation, used for
+ *  the corner cases which ieee_interpret_float_value() doesn't handle itself.
  */
-void ieee_interpret_float_value(uint64_t x, struct ieee_float_value *fvp,
+void ieee_interpret_float_value_slow(uint64_t x, struct ieee_float_value *fvp,
 	int fmt)
 {
 	int n_frac = 0, n_exp = 0;
-	int i, nan, sign = 0, exponent;
+	int i, nan, sign = 0, exponent, denormal = 0;
 	double fraction;
 
 	memset(fvp, 0, sizeof(struct ieee_float_value));
@@ -76,6 +78,7 @@ void ieee_interpret_float_value(uint64_t x, struct ieee_float_value *fvp,
 		x &= 0xffffffffULL;
 	case IEEE_FMT_D:
 		exponent = (x >> n_frac) & ((1 << n_exp) - 1);
+		denormal = exponent == 0;
 		exponent -= (1 << (n_exp-1)) - 1;
 		break;
 	default:fatal("ieee_interpret_float_value(): unimplemented "
@@ -131,8 +134,13 @@ void ieee_interpret_float_value(uint64_t x, struct ieee_float_value *fvp,
 			if (bit)
 				fraction += 1.0;
 		}
-		/*  Add implicit bit 0:  */
-		fraction = (fraction / 2.0) + 1.0;
+		/*  Add implicit bit 0 (zeroes and denormals have none, and
+		    use the smallest normal exponent):  */
+		fraction = fraction / 2.0;
+		if (denormal)
+			exponent ++;
+		else
+			fraction += 1.0;
 		break;
 	default:fatal("ieee_interpret_float_value(): "
 		    "unimplemented format %i\n", fmt);
@@ -179,11 +187,13 @@ no_reasonable_result:
 
 
 /*
- *  ieee_store_float_value():
+ *  ieee_store_float_value_slow():
  *
- *  Generates a 64-bit IEEE-formated value in a specific format.
+ *  Generates a 64-bit IEEE-formated value in a specific format, one bit at a
+ *  time. This is the reference implementation, used for the corner cases
+ *  which ieee_store_float_value() doesn't handle itself.
  */
-uint64_t ieee_store_float_value(double nf, int fmt, int nan)
+uint64_t ieee_store_float_value_slow(double nf, int fmt, int nan)
 {
 	int n_frac = 0, n_exp = 0, signofs=0;
 	int i, exponent;
@@ -299,3 +309,163 @@ store_nan:
 	return r;
 }
 
+
+/*
+ *  ieee_interpret_float_value():
+ *
+ *  Interprets a float value from binary IEEE format into an ieee_float_value
+ *  struct.
+ *
+ *  Normal single and double precision values are converted by the host
+ *  directly (this assumes that the host's float and double are IEEE 754
+ *  values with the same byte order as its integers), and so are zeroes and
+ *  denormals. Infinities and NaNs, and the integer formats, are passed on to
+ *  ieee_interpret_float_value_slow(). The result is always the same as the
+ *  slow path's.
+ */
+void ieee_interpret_float_value(uint64_t x, struct ieee_float_value *fvp,
+	int fmt)
+{
+	uint32_t x32;
+	float f32;
+	int exponent;
+
+	switch (fmt) {
+	case IEEE_FMT_S:
+		x32 = x;
+		exponent = (x32 >> 23) & 0xff;
+		if (exponent == 0xff)
+			break;
+
+		memcpy(&f32, &x32, sizeof(f32));
+		fvp->f = f32;
+
+		fvp->nan = 0;
+		return;
+
+	case IEEE_FMT_D:
+		exponent = (x >> 52) & 0x7ff;
+		if (exponent == 0x7ff)
+			break;
+
+		memcpy(&fvp->f, &x, sizeof(fvp->f));
+
+		fvp->nan = 0;
+		return;
+	}
+
+	ieee_interpret_float_value_slow(x, fvp, fmt);
+}
+
+
+/*
+ *  ieee_store_float_value():
+ *
+ *  Generates a 64-bit IEEE-formated value in a specific format.
+ *
+ *  Normal values are converted directly from the host's double. Like the
+ *  slow path, single precision values are truncated (not rounded), and
+ *  zeroes, denormals and values too small for the format are stored as +0.0.
+ *  Infinities, NaNs, values too large for single precision, and the integer
+ *  formats are passed on to ieee_store_float_value_slow().
+ */
+uint64_t ieee_store_float_value(double nf, int fmt, int nan)
+{
+	uint64_t x;
+	int exponent;
+
+	if (nan || (fmt != IEEE_FMT_S && fmt != IEEE_FMT_D))
+		return ieee_store_float_value_slow(nf, fmt, nan);
+
+	memcpy(&x, &nf, sizeof(x));
+	exponent = (x >> 52) & 0x7ff;
+
+	if (exponent == 0)
+		return 0;
+	if (exponent == 0x7ff)
+		return ieee_store_float_value_slow(nf, fmt, nan);
+
+	if (fmt == IEEE_FMT_D)
+		return x;
+
+	exponent += 127 - 1023;
+	if (exponent <= 0)
+		return 0;
+	if (exponent >= 0xff)
+		return ieee_store_float_value_slow(nf, fmt, nan);
+
+	return ((x >> 32) & 0x80000000) | ((uint64_t)exponent << 23) |
+	    ((x >> 29) & 0x7fffff);
+}
+
+
+/*
+ *  ieee_fenv_begin():
+ *
+ *  Clears the host's floating point exception flags, and switches the host
+ *  to the guest's rounding mode (one of the IEEE_ROUND_* values). The guest
+ *  operation is then done with host arithmetic, followed by a call to
+ *  ieee_fenv_end() with the same rounding mode.
+ */
+void ieee_fenv_begin(int rounding_mode)
+{
+	feclearexcept(FE_ALL_EXCEPT);
+
+	switch (rounding_mode) {
+	case IEEE_ROUND_NEAREST:
+		break;
+#ifdef FE_TOWARDZERO
+	case IEEE_ROUND_ZERO:
+		fesetround(FE_TOWARDZERO);
+		break;
+#endif
+#ifdef FE_UPWARD
+	case IEEE_ROUND_UP:
+		fesetround(FE_UPWARD);
+		break;
+#endif
+#ifdef FE_DOWNWARD
+	case IEEE_ROUND_DOWN:
+		fesetround(FE_DOWNWARD);
+		break;
+#endif
+	}
+}
+
+
+/*
+ *  ieee_fenv_end():
+ *
+ *  Returns the exceptions raised by the host since ieee_fenv_begin(), as
+ *  IEEE_EXC_* flags, and switches the host back to round-to-nearest.
+ */
+int ieee_fenv_end(int rounding_mode)
+{
+	int raised = fetestexcept(FE_ALL_EXCEPT), exc = 0;
+
+#ifdef FE_INEXACT
+	if (raised & FE_INEXACT)
+		exc |= IEEE_EXC_INEXACT;
+#endif
+#ifdef FE_UNDERFLOW
+	if (raised & FE_UNDERFLOW)
+		exc |= IEEE_EXC_UNDERFLOW;
+#endif
+#ifdef FE_OVERFLOW
+	if (raised & FE_OVERFLOW)
+		exc |= IEEE_EXC_OVERFLOW;
+#endif
+#ifdef FE_DIVBYZERO
+	if (raised & FE_DIVBYZERO)
+		exc |= IEEE_EXC_DIVBYZERO;
+#endif
+#ifdef FE_INVALID
+	if (raised & FE_INVALID)
+		exc |= IEEE_EXC_INVALID;
+#endif
+
+	if (rounding_mode != IEEE_ROUND_NEAREST)
+		fesetround(FE_TONEAREST);
+
+	return exc;
+}
@@ -63,6 +63,7 @@ char **extra_argv;
 char *progname;
 
 size_t dyntrans_cache_size = DEFAULT_DYNTRANS_CACHE_SIZE;
+int dyntrans_vph_tlb_entries = 0;
 static int skip_srandom_call = 0;
 
 
@@ -225,6 +226,7 @@ static void usage(int longusage)
 		printf("\nOptions:\n");
 		printf("  -B           Enable snapshotting (reverse stepping support).\n");
 		printf("  -H           Display a list of available machine templates.\n");
+		printf("  -P           Profile CPU execution, and show a report at exit.\n");
 		printf("  -e name      Start with a machine based on template 'name'.\n");
 		printf("  -q           Quiet mode (suppress debug messages).\n");
 		printf("  -V           Start up in interactive mode, paused.\n");
@@ -250,6 +252,8 @@ static void usage(int longusage)
 	    "with -E.)\n");
 
 	printf("\nOther options:\n");
+	printf("  -A        disable native execution of guest routines "
+	    "(memcpy etc.)\n");
 	printf("  -C x      try to emulate a specific CPU. (Use -H to get a "
 	    "list of types.)\n");
 	printf("  -d fname  add fname as a disk image. You can add \"xxx:\""
@@ -340,6 +344,8 @@ static void usage(int longusage)
 	    " size is %i MB)\n", DEFAULT_DYNTRANS_CACHE_SIZE / 1048576);
 	printf("  -K        force the debugger to be entered at the end "
 	    "of a simulation\n");
+	printf("  -l n      use n dyntrans virtual to host TLB entries per "
+	    "CPU (the default\n            depends on the CPU family)\n");
 	printf("  -q        quiet mode (don't print startup messages)\n");
 	printf("  -V        start up in the single-step debugger, paused\n");
 	printf("  -v        verbose debug messages\n");
@@ -373,13 +379,14 @@ int get_cmd_args(int argc, char *argv[], struct emul *emul,
 	int ch, res, using_switch_d = 0, using_switch_Z = 0;
 	int using_switch_e = 0, using_switch_E = 0;
 	bool using_switch_B = false;
+	bool using_switch_P = false;
 	char *type = NULL, *subtype = NULL;
 	int n_cpus_set = 0;
 	int msopts = 0;		/*  Machine-specific options used  */
 	struct machine *m = emul_add_machine(emul, NULL);
 
 	const char *opts =
-	    "BC:c:Dd:E:e:HhI:iJj:k:KM:Nn:Oo:p:QqRrSs:TtUuVvW:"
+	    "ABC:c:Dd:E:e:HhI:iJj:k:Kl:M:Nn:Oo:Pp:QqRrSs:TtUuVvW:"
 #ifdef WITH_X11
 	    "XxY:"
 #endif
@@ -387,6 +394,10 @@ int get_cmd_args(int argc, char *argv[], struct emul *emul,
 
 	while ((ch = getopt(argc, argv, opts)) != -1) {
 		switch (ch) {
+		case 'A':
+			m->allow_native_routines = 0;
+			msopts = 1;
+			break;
 		case 'B':
 			using_switch_B = true;
 			break;
@@ -469,6 +480,14 @@ int get_cmd_args(int argc, char *argv[], struct emul *emul,
 		case 'K':
 			force_debugger_at_exit = 1;
 			break;
+		case 'l':
+			dyntrans_vph_tlb_entries = atoi(optarg);
+			if (dyntrans_vph_tlb_entries < 1) {
+				fprintf(stderr, "The number of dyntrans TLB "
+				    "entries must be at least 1.\n");
+				exit(1);
+			}
+			break;
 		case 'M':
 			m->physical_ram_in_mb = atoi(optarg);
 			msopts = 1;
@@ -491,6 +510,9 @@ int get_cmd_args(int argc, char *argv[], struct emul *emul,
 			    strdup(optarg));
 			msopts = 1;
 			break;
+		case 'P':
+			using_switch_P = true;
+			break;
 		case 'p':
 			machine_add_breakpoint_string(m, optarg);
 			msopts = 1;
@@ -605,6 +627,7 @@ int get_cmd_args(int argc, char *argv[], struct emul *emul,
 				gxemul.SetRunState(GXemul::Running);
 
 			gxemul.SetSnapshottingEnabled(using_switch_B);
+			gxemul.SetProfilingEnabled(using_switch_P);
 
 			if (quiet_mode)
 				gxemul.SetQuietMode(true);
@@ -640,6 +663,7 @@ int get_cmd_args(int argc, char *argv[], struct emul *emul,
 					gxemul.SetRunState(GXemul::Running);
 
 				gxemul.SetSnapshottingEnabled(using_switch_B);
+				gxemul.SetProfilingEnabled(using_switch_P);
 
 				if (quiet_mode)
 					gxemul.SetQuietMode(true);
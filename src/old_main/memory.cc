@@ -177,6 +177,10 @@ struct memory *memory_new(uint64_t physical_max, int arch)
 	mem->mmap_dev_minaddr = 0xffffffffffffffffULL;
 	mem->mmap_dev_maxaddr = 0;
 
+#ifdef HAVE_PTHREADS
+	pthread_mutex_init(&mem->reservation_mutex, NULL);
+#endif
+
 	return mem;
 }
 
@@ -544,6 +548,229 @@ unsigned char *memory_paddr_to_hostaddr(struct memory *mem,
 }
 
 
+/*
+ *  memory_compare_and_swap():
+ *
+ *  Stores newdata at p, but only if p still contains olddata. Naturally
+ *  aligned 1, 2, 4 and 8 byte words are swapped using host atomics, so that
+ *  this works even if guest cpus are run in parallel on several host
+ *  threads. Returns 1 if the data was stored, 0 otherwise.
+ */
+static int memory_compare_and_swap(unsigned char *p, unsigned char *olddata,
+	unsigned char *newdata, size_t len)
+{
+#ifdef __GNUC__
+	if (((size_t)p & (len - 1)) == 0) {
+		uint64_t o = 0, n = 0;
+		memcpy(&o, olddata, len);
+		memcpy(&n, newdata, len);
+
+		switch (len) {
+		case sizeof(uint8_t):
+			return __sync_bool_compare_and_swap(p,
+			    (uint8_t)o, (uint8_t)n);
+		case sizeof(uint16_t):
+			return __sync_bool_compare_and_swap((uint16_t *)p,
+			    (uint16_t)o, (uint16_t)n);
+		case sizeof(uint32_t):
+			return __sync_bool_compare_and_swap((uint32_t *)p,
+			    (uint32_t)o, (uint32_t)n);
+		case sizeof(uint64_t):
+			return __sync_bool_compare_and_swap((uint64_t *)p,
+			    o, n);
+		}
+	}
+#endif
+
+	if (memcmp(p, olddata, len) != 0)
+		return 0;
+
+	memcpy(p, newdata, len);
+	return 1;
+}
+
+
+/*
+ *  The reservation table is protected by reservation_mutex. It is held while
+ *  the table is grown, and while a store conditional checks its reservation,
+ *  does the compare-and-swap, and breaks the other reservations, so that
+ *  these steps are one atomic operation as seen by other cpus. Plain writes
+ *  only need the lock while breaking reservations: a plain write which is
+ *  done after that is still caught by the compare-and-swap.
+ */
+#ifdef HAVE_PTHREADS
+#define	RESERVATION_LOCK(mem)	pthread_mutex_lock(&(mem)->reservation_mutex)
+#define	RESERVATION_UNLOCK(mem)	pthread_mutex_unlock(			\
+				    &(mem)->reservation_mutex)
+#else
+#define	RESERVATION_LOCK(mem)	{ }
+#define	RESERVATION_UNLOCK(mem)	{ }
+#endif
+
+
+/*
+ *  reservation_invalidate():
+ *
+ *  Clears all reservations within the granule(s) covered by a write of len
+ *  bytes to paddr. Must be called with reservation_mutex held.
+ */
+static void reservation_invalidate(struct memory *mem, uint64_t paddr,
+	size_t len)
+{
+	uint64_t low = paddr & ~(MEMORY_RESERVATION_GRANULE - 1);
+	uint64_t high = (paddr + len - 1) | (MEMORY_RESERVATION_GRANULE - 1);
+	int i;
+
+	for (i=0; i<mem->n_reservations; i++) {
+		struct memory_reservation *r = &mem->reservations[i];
+
+		if (r->valid && r->paddr + r->len > low && r->paddr <= high)
+			r->valid = 0;
+	}
+}
+
+
+/*
+ *  memory_reservation_set():
+ *
+ *  Called by memory_rw() for a MEMORY_LOAD_LINKED read. Sets the cpu's
+ *  reservation to the physical address paddr, and remembers the loaded data.
+ */
+void memory_reservation_set(struct cpu *cpu, struct memory *mem,
+	uint64_t paddr, unsigned char *data, size_t len)
+{
+	struct memory_reservation *r;
+
+	if (len > sizeof(r->data)) {
+		fatal("memory_reservation_set(): len = %i\n", (int)len);
+		exit(1);
+	}
+
+	RESERVATION_LOCK(mem);
+
+	if (cpu->cpu_id >= mem->n_reservations) {
+		int old_n = mem->n_reservations;
+
+		mem->n_reservations = cpu->cpu_id + 1;
+		CHECK_ALLOCATION(mem->reservations = (struct memory_reservation *)
+		    realloc(mem->reservations, mem->n_reservations *
+		    sizeof(struct memory_reservation)));
+		memset(&mem->reservations[old_n], 0, (mem->n_reservations
+		    - old_n) * sizeof(struct memory_reservation));
+	}
+
+	r = &mem->reservations[cpu->cpu_id];
+	r->paddr = paddr;
+	r->len = len;
+	memcpy(r->data, data, len);
+	r->valid = 1;
+
+	RESERVATION_UNLOCK(mem);
+}
+
+
+/*
+ *  memory_reservation_store():
+ *
+ *  Called by memory_rw() for a MEMORY_STORE_CONDITIONAL write. If the cpu
+ *  still holds a reservation for paddr, and (for RAM, i.e. when hostptr is
+ *  non-NULL) the memory still contains what was loaded, then data is stored
+ *  and 1 is returned. For devices, the caller does the actual write.
+ *
+ *  The cpu's own reservation is always cleared. On success, all other
+ *  reservations within the same granule are cleared too.
+ */
+int memory_reservation_store(struct cpu *cpu, struct memory *mem,
+	uint64_t paddr, unsigned char *hostptr, unsigned char *data,
+	size_t len)
+{
+	struct memory_reservation *r;
+	int success = 0;
+
+	RESERVATION_LOCK(mem);
+
+	if (cpu->cpu_id >= mem->n_reservations)
+		goto done;
+
+	r = &mem->reservations[cpu->cpu_id];
+	if (!r->valid || r->paddr != paddr || r->len != (int) len) {
+		r->valid = 0;
+		goto done;
+	}
+
+	r->valid = 0;
+
+	if (hostptr != NULL &&
+	    !memory_compare_and_swap(hostptr, r->data, data, len))
+		goto done;
+
+	reservation_invalidate(mem, paddr, len);
+	success = 1;
+
+done:
+	RESERVATION_UNLOCK(mem);
+	return success;
+}
+
+
+/*
+ *  memory_reservation_invalidate():
+ *
+ *  Clears all reservations within the granule(s) covered by a write of len
+ *  bytes to paddr. memory_rw() calls this for all writes (by cpus, or by
+ *  devices doing DMA through memory_rw()) while there are reservations.
+ */
+void memory_reservation_invalidate(struct memory *mem, uint64_t paddr,
+	size_t len)
+{
+	RESERVATION_LOCK(mem);
+	reservation_invalidate(mem, paddr, len);
+	RESERVATION_UNLOCK(mem);
+}
+
+
+/*
+ *  memory_reservation_clear():
+ *
+ *  Clears the cpu's own reservation, e.g. on exception return.
+ */
+void memory_reservation_clear(struct cpu *cpu)
+{
+	struct memory *mem = cpu->mem;
+
+	RESERVATION_LOCK(mem);
+	if (cpu->cpu_id < mem->n_reservations)
+		mem->reservations[cpu->cpu_id].valid = 0;
+	RESERVATION_UNLOCK(mem);
+}
+
+
+/*
+ *  memory_reservation_get():
+ *
+ *  Returns 1 (and the reserved physical address in *paddrp) if the cpu holds
+ *  a reservation, 0 otherwise.
+ */
+int memory_reservation_get(struct cpu *cpu, uint64_t *paddrp)
+{
+	struct memory *mem = cpu->mem;
+	struct memory_reservation *r;
+	int valid = 0;
+
+	RESERVATION_LOCK(mem);
+
+	if (cpu->cpu_id < mem->n_reservations) {
+		r = &mem->reservations[cpu->cpu_id];
+		valid = r->valid;
+		if (valid && paddrp != NULL)
+			*paddrp = r->paddr;
+	}
+
+	RESERVATION_UNLOCK(mem);
+	return valid;
+}
+
+
 #define	UPDATE_CHECKSUM(value) {					\
 		internal_state -= 0x118c7771c0c0a77fULL;		\
 		internal_state = ((internal_state + (value)) << 7) ^	\
@@ -158,7 +158,7 @@ static vector<string> SplitIntoRows(const string &msg, bool addEmptyLines)
 }
 
 
-void ConsoleUI::ShowDebugMessage(const string& msg)
+void ConsoleUI::DisplayDebugMessage(const string& msg)
 {
 	vector<string> lines = SplitIntoRows(msg, true);
 
@@ -178,7 +178,7 @@ void ConsoleUI::ShowDebugMessage(const string& msg)
 }
 
 
-void ConsoleUI::ShowDebugMessage(Component* component, const string& msg)
+void ConsoleUI::DisplayDebugMessage(Component* component, const string& msg)
 {
 	if (m_gxemul->GetQuietMode())
 		return;
@@ -200,7 +200,7 @@ void ConsoleUI::ShowDebugMessage(Component* component, const string& msg)
 	for (i=1; i<lines.size(); ++i)
 		ss << spaces << lines[i] << "\n";
 
-	ShowDebugMessage(ss.str());
+	DisplayDebugMessage(ss.str());
 }
 
 
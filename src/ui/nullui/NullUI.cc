@@ -55,12 +55,12 @@ void NullUI::UpdateUI()
 }
 
 
-void NullUI::ShowDebugMessage(const string& msg)
+void NullUI::DisplayDebugMessage(const string& msg)
 {
 }
 
 
-void NullUI::ShowDebugMessage(Component* component, const string& msg)
+void NullUI::DisplayDebugMessage(Component* component, const string& msg)
 {
 }
 
@@ -0,0 +1,111 @@
+@
+@  Test program for the lazy flags lockstep check, for -E testarm.
+@  See test_lazy_lockstep.sh.
+@
+@  All flag-setting additions and subtractions which are evaluated lazily
+@  are run on all pairs of some interesting values. The flags are then read
+@  by conditional instructions, by mrs, and by adcs/sbcs, and are summed up
+@  into a checksum, which is printed in hex.
+@
+@  (Calls are done with mov lr,pc + b, so that the program can be turned
+@  into a raw binary without a linker.)
+@
+@  Built with:
+@
+@	llvm-mc -triple=armv5-none-eabi -filetype=obj lazy_lockstep_arm.s -o lazy_lockstep_arm.o
+@	llvm-objcopy -O binary -j .text lazy_lockstep_arm.o lazy_lockstep_arm.bin
+@
+
+	.text
+	.globl	_start
+_start:
+	mov	r8, #0x10000000		@  console
+	adr	r10, values
+	mov	r11, #0			@  checksum
+	mov	r4, #0
+
+outer:	ldr	r1, [r10, r4, lsl #2]
+	mov	r5, #0
+
+inner:	ldr	r2, [r10, r5, lsl #2]
+
+	cmp	r1, r2
+	mov	lr, pc
+	b	accum
+	cmn	r1, r2
+	mov	lr, pc
+	b	accum
+	adds	r3, r1, r2
+	mov	lr, pc
+	b	accum
+	subs	r3, r1, r2
+	mov	lr, pc
+	b	accum
+	rsbs	r3, r1, r2
+	mov	lr, pc
+	b	accum
+	adds	r3, r1, r2
+	adcs	r3, r1, r2
+	mov	lr, pc
+	b	accum
+	subs	r3, r1, r2
+	sbcs	r3, r1, r2
+	mov	lr, pc
+	b	accum
+
+	@  cmp followed by a conditional branch:
+	cmp	r1, r2
+	bne	1f
+	add	r11, r11, #7
+1:	cmp	r1, r2
+	blt	2f
+	add	r11, r11, #11
+2:	cmp	r1, r2
+	bhi	3f
+	eor	r11, r11, #13
+3:
+	add	r5, r5, #1
+	cmp	r5, #8
+	bne	inner
+	add	r4, r4, #1
+	cmp	r4, #8
+	bne	outer
+
+	@  Print the checksum:
+	mov	r4, #8
+4:	mov	r3, r11, lsr #28
+	cmp	r3, #10
+	addlt	r3, r3, #0x30
+	addge	r3, r3, #0x37
+	strb	r3, [r8]
+	mov	r11, r11, lsl #4
+	subs	r4, r4, #1
+	bne	4b
+	mov	r3, #10
+	strb	r3, [r8]
+
+	strb	r3, [r8, #0x10]		@  halt
+5:	b	5b
+
+accum:	mov	r6, #0
+	orreq	r6, r6, #0x1
+	orrne	r6, r6, #0x2
+	orrcs	r6, r6, #0x4
+	orrcc	r6, r6, #0x8
+	orrmi	r6, r6, #0x10
+	orrpl	r6, r6, #0x20
+	orrvs	r6, r6, #0x40
+	orrvc	r6, r6, #0x80
+	orrhi	r6, r6, #0x100
+	orrls	r6, r6, #0x200
+	orrge	r6, r6, #0x400
+	orrlt	r6, r6, #0x800
+	orrgt	r6, r6, #0x1000
+	orrle	r6, r6, #0x2000
+	mrs	r7, cpsr
+	eor	r6, r6, r7, lsr #28
+	add	r11, r6, r11, ror #27
+	mov	pc, lr
+
+values:	.word	0, 1, 5, 0x7fffffff, 0x80000000, 0x80000001, 0xfffffffe
+	.word	0xffffffff
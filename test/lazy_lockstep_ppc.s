@@ -0,0 +1,110 @@
+#
+#  Test program for the lazy CR0 lockstep check, for -E testppc.
+#  See test_lazy_lockstep.sh.
+#
+#  Record-form instructions, whose CR0 updates are evaluated lazily, are
+#  run on all pairs of some interesting values, with XER[SO] both clear
+#  and set. CR0 is then read by conditional branches and by mfcr, also
+#  after XER[SO] has been changed by mtxer, and is summed up into a
+#  checksum, which is printed in hex.
+#
+#  Built with:
+#
+#	llvm-mc -triple=powerpc-unknown-elf -filetype=obj lazy_lockstep_ppc.s -o lazy_lockstep_ppc.o
+#	llvm-objcopy -O binary -j .text lazy_lockstep_ppc.o lazy_lockstep_ppc.bin
+#
+
+	.text
+	.globl	_start
+_start:
+	lis	8, 0x1000		# console
+	bl	values_end
+values:	.long	0, 1, 5, 0x7fffffff, 0x80000000, 0x80000001, 0xfffffffe
+	.long	0xffffffff
+values_end:
+	mflr	10
+	li	11, 0			# checksum
+	li	20, 0
+
+so_loop:
+	slwi	21, 20, 31
+	mtxer	21
+	li	4, 0
+
+outer:	slwi	12, 4, 2
+	lwzx	1, 10, 12
+	li	5, 0
+
+inner:	slwi	12, 5, 2
+	lwzx	2, 10, 12
+
+	add.	3, 1, 2
+	bl	accum
+	subf.	3, 2, 1
+	bl	accum
+	and.	3, 1, 2
+	bl	accum
+	or.	3, 1, 2
+	bl	accum
+	addic.	3, 1, 1
+	bl	accum
+	cmpw	1, 2
+	bl	accum
+	cmplw	1, 2
+	bl	accum
+
+	# Change XER[SO] while a CR0 update is pending:
+	add.	3, 1, 2
+	xoris	22, 21, 0x8000
+	mtxer	22
+	bl	accum
+	mtxer	21
+
+	# Modify other CR fields while a CR0 update is pending:
+	subf.	3, 2, 1
+	cmpw	1, 1, 2
+	crxor	6, 0, 1
+	bl	accum
+
+	addi	5, 5, 1
+	cmpwi	5, 8
+	bne	inner
+	addi	4, 4, 1
+	cmpwi	4, 8
+	bne	outer
+	addi	20, 20, 1
+	cmpwi	20, 2
+	bne	so_loop
+
+	# Print the checksum:
+	li	4, 8
+1:	srwi	3, 11, 28
+	cmpwi	3, 10
+	blt	2f
+	addi	3, 3, 7
+2:	addi	3, 3, 0x30
+	stb	3, 0(8)
+	slwi	11, 11, 4
+	addi	4, 4, -1
+	cmpwi	4, 0
+	bne	1b
+	li	3, 10
+	stb	3, 0(8)
+
+	stb	3, 0x10(8)		# halt
+3:	b	3b
+
+accum:	li	6, 0
+	bne	1f
+	ori	6, 6, 0x1
+1:	bge	1f
+	ori	6, 6, 0x2
+1:	ble	1f
+	ori	6, 6, 0x4
+1:	bns	1f
+	ori	6, 6, 0x8
+1:	mfcr	7
+	xor	6, 6, 7
+	rotlwi	11, 11, 5
+	add	11, 11, 6
+	blr
@@ -0,0 +1,138 @@
+#
+#  Multi-processor ll/sc test program for -E oldtestmips with several
+#  CPUs (e.g. -n 4). See test_llsc_spinlock.sh.
+#
+#  CPU 0 starts all other CPUs, using the testmachine mp device. Then each
+#  CPU runs 20000 iterations of:
+#
+#	o)  take a spinlock (ll/sc), do a non-atomic increment of a shared
+#	    counter while holding it, and release the lock
+#	o)  an atomic add (ll/sc retry loop) to a second counter
+#
+#  When all CPUs are done, CPU 0 prints both counters in hex. Both should
+#  be 20000 times the number of CPUs, e.g. "00013880 00013880" for 4 CPUs.
+#  A lost update in either counter means that ll/sc is not atomic.
+#
+#  Built with:
+#
+#	llvm-mc -triple=mips-unknown-elf -mcpu=mips32 -filetype=obj llsc_spinlock.s -o llsc_spinlock.o
+#	llvm-objcopy -O binary -j .text llsc_spinlock.o llsc_spinlock.bin
+#
+
+	.set	noreorder
+	.set	noat
+	.text
+
+	.equ	LOADADDR, 0x80010000
+	.equ	NITERATIONS, 20000
+
+	.equ	CONS, 0xb0000000	#  testmachine console
+	.equ	MP, 0xb1000000		#  testmachine mp device
+	.equ	SHARED, 0x80400000	#  lock, counters, and done count
+
+	#  Offsets into the shared area (one cache line apart):
+	.equ	LOCK, 0x00
+	.equ	LOCKED_COUNTER, 0x40
+	.equ	ATOMIC_COUNTER, 0x80
+	.equ	DONE, 0xc0
+
+_start:
+	li	$s6, MP
+	lw	$s1, 0x10($s6)		#  number of CPUs
+
+	#  Start address and stack for the other CPUs:
+	lui	$t0, %hi(worker - _start + LOADADDR)
+	addiu	$t0, $t0, %lo(worker - _start + LOADADDR)
+	sw	$t0, 0x30($s6)
+	li	$t0, 0x80380000
+	sw	$t0, 0x70($s6)
+
+	li	$t1, 1
+1:	beq	$t1, $s1, worker
+	nop
+	sw	$t1, 0x20($s6)		#  start CPU t1
+	b	1b
+	addiu	$t1, $t1, 1
+
+worker:
+	li	$s7, CONS
+	li	$s6, MP
+	li	$s0, SHARED
+	lw	$s1, 0x10($s6)		#  number of CPUs
+	lw	$s2, 0($s6)		#  this CPU's id
+	li	$s3, NITERATIONS
+
+loop:
+	#  Take the spinlock:
+1:	ll	$t0, LOCK($s0)
+	bne	$t0, $zero, 1b
+	li	$t1, 1
+	sc	$t1, LOCK($s0)
+	beq	$t1, $zero, 1b
+	nop
+
+	#  Critical section: a non-atomic increment, with a short delay
+	#  (which depends on the CPU id) between the load and the store:
+	lw	$t2, LOCKED_COUNTER($s0)
+	addiu	$t3, $s2, 3
+2:	addiu	$t3, $t3, -1
+	bne	$t3, $zero, 2b
+	nop
+	addiu	$t2, $t2, 1
+	sw	$t2, LOCKED_COUNTER($s0)
+
+	#  Release the spinlock:
+	sw	$zero, LOCK($s0)
+
+	#  Atomic add:
+3:	ll	$t4, ATOMIC_COUNTER($s0)
+	addiu	$t4, $t4, 1
+	sc	$t4, ATOMIC_COUNTER($s0)
+	beq	$t4, $zero, 3b
+	nop
+
+	addiu	$s3, $s3, -1
+	bne	$s3, $zero, loop
+	nop
+
+	#  This CPU is done:
+4:	ll	$t4, DONE($s0)
+	addiu	$t4, $t4, 1
+	sc	$t4, DONE($s0)
+	beq	$t4, $zero, 4b
+	nop
+
+	bne	$s2, $zero, hang
+	nop
+
+	#  CPU 0 waits for the others, prints both counters, and halts:
+5:	lw	$t4, DONE($s0)
+	bne	$t4, $s1, 5b
+	nop
+	lw	$a0, LOCKED_COUNTER($s0)
+	bal	hex
+	nop
+	lw	$a0, ATOMIC_COUNTER($s0)
+	bal	hex
+	nop
+	li	$t0, 10
+	sb	$t0, 0($s7)
+	sb	$zero, 0x10($s7)	#  halt the machine
+hang:	b	hang
+	nop
+
+	#  Print a0 as 8 hex digits followed by a space:
+hex:	li	$t5, 8
+6:	srl	$t6, $a0, 28
+	sltiu	$t7, $t6, 10
+	bne	$t7, $zero, 7f
+	addiu	$t6, $t6, 48
+	addiu	$t6, $t6, 7
+7:	sb	$t6, 0($s7)
+	sll	$a0, $a0, 4
+	addiu	$t5, $t5, -1
+	bne	$t5, $zero, 6b
+	nop
+	li	$t6, 32
+	jr	$ra
+	sb	$t6, 0($s7)
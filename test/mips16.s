@@ -0,0 +1,207 @@
+#
+#  Test program for MIPS16 execution, and switching between 32-bit and
+#  MIPS16 mode, for -E oldtestmips with a CPU which has the MIPS16 ASE
+#  (e.g. -C 4Kc). See test_mips16.sh.
+#
+#  Each step prints one letter, so the expected output is "ABCDEFGHIJK":
+#
+#	A	32-bit jalx to MIPS16, save, and jal to a MIPS16 subroutine
+#	B	EXTENDed addiu, and zeb
+#	C	lw pc-relative
+#	D	bnez loop within the same translation page
+#	E	EXTENDed li across a 2 KB MIPS16 translation page boundary
+#	F	jal with its delay slot on the next page
+#	G	jal across a 2 KB MIPS16 translation page boundary
+#	H	jalr to 32-bit code, and 32-bit jr back to MIPS16
+#	I	jalx to 32-bit code
+#	J	break, and eret back to MIPS16 (EPC with bit 0 set)
+#	K	EXTENDed save and restore of s2
+#
+#  The binary is loaded at 0x80010000. Since llvm-mc cannot assemble MIPS16
+#  code, the MIPS16 instructions are written out by hand, using the MIPS16
+#  register numbers (s0=0, s1=1, v0=2, v1=3, a0=4, a1=5, a2=6, a3=7).
+#
+#  Built with:
+#
+#	llvm-mc -triple=mips-unknown-elf -mcpu=mips32 -filetype=obj mips16.s -o mips16.o
+#	llvm-objcopy -O binary -j .text mips16.o mips16.bin
+#
+
+	.set	noreorder
+	.set	noat
+	.text
+
+	.equ	LOADADDR, 0x80010000
+
+	#  32-bit jalx, to MIPS16 code:
+	.macro	jalx32 target
+	.word	0x74000000 | (((\target - _start + LOADADDR) >> 2) & 0x3ffffff)
+	.endm
+
+	#  MIPS16 jal (x=0) or jalx (x=1):
+	.macro	jal16 target, x=0
+	.set	t\@, ((\target - _start + LOADADDR) >> 2) & 0x3ffffff
+	.short	0x1800 | (\x << 10) | ((t\@ >> 16) & 0x1f) << 5 | (t\@ >> 21)
+	.short	t\@ & 0xffff
+	.endm
+
+	#  MIPS16 bnez rx,target:
+	.macro	bnez16 rx, target
+	.short	0x2800 | (\rx << 8) | (((\target - . - 2) >> 1) & 0xff)
+	.endm
+
+	#  EXTENDed MIPS16 b target:
+	.macro	b16ext target
+	.set	o\@, (\target - . - 4) >> 1
+	.short	0xf000 | (o\@ & 0x7e0) | ((o\@ >> 11) & 0x1f)
+	.short	0x1000 | (o\@ & 0x1f)
+	.endm
+
+	#  MIPS16 lw rx,target(pc):
+	.macro	lwpc16 rx, target
+	.short	0xb000 | (\rx << 8) | ((\target - _start - ((. - _start) & ~3)) >> 2)
+	.endm
+
+	#  Other MIPS16 instructions:
+	.macro	li16 rx, imm
+	.short	0x6800 | (\rx << 8) | \imm
+	.endm
+	.macro	addiu16 rx, imm
+	.short	0x4800 | (\rx << 8) | ((\imm) & 0xff)
+	.endm
+	.macro	nop16
+	.short	0x6500
+	.endm
+
+
+	.globl	_start
+_start:
+	lui	$17, 0xb000		#  s1 = console
+	lui	$sp, 0x8003
+
+	#  Copy the exception handler (7 words) to 0x80000180:
+	bal	2f
+	nop
+
+	#  Exception handler (for break): skip the 16-bit break instruction.
+handler:
+	mfc0	$26, $14
+	addiu	$26, $26, 2
+	mtc0	$26, $14
+	nop
+	nop
+	eret
+	nop
+
+2:	addiu	$10, $31, 7 * 4
+	lui	$9, 0x8000
+	ori	$9, $9, 0x180
+1:	lw	$11, 0($31)
+	addiu	$31, $31, 4
+	sw	$11, 0($9)
+	bne	$31, $10, 1b
+	addiu	$9, $9, 4
+
+	jalx32	m16_main
+	nop
+
+	#  Back in 32-bit mode. Halt the machine:
+	sb	$0, 0x10($17)
+3:	b	3b
+	nop
+
+	#  32-bit putchar, for H and I:
+putc32:
+	jr	$31
+	sb	$4, 0($17)
+
+
+	#  MIPS16 putchar:
+	.p2align 2
+putc16:
+	.short	0xc180			#  sb	a0,0(s1)
+	.short	0xe820			#  jr	ra
+	nop16
+
+
+	.p2align 2
+m16_main:
+	.short	0x64c4			#  save	32,ra
+
+	li16	4, 0x41			#  li	a0,'A'
+	jal16	putc16
+	nop16
+
+	li16	4, 0
+	.short	0xf140, 0x4c02		#  addiu	a0,0x142
+	.short	0xec11			#  zeb	a0
+	jal16	putc16
+	nop16
+
+	lwpc16	4, lit_c		#  lw	a0,lit_c
+	jal16	putc16
+	nop16
+
+	li16	4, 0x41			#  li	a0,'A'
+	li16	2, 3			#  li	v0,3
+4:	addiu16	4, 1			#  addiu	a0,1
+	addiu16	2, -1			#  addiu	v0,-1
+	bnez16	2, 4b			#  bnez	v0,4b
+	jal16	putc16
+	nop16
+
+	b16ext	step_e
+
+	.p2align 2
+lit_c:	.word	0x43			#  'C'
+
+	#  E: EXTEND in the last halfword of a 2 KB page
+	.org	0x7fe
+step_e:	.short	0xf040, 0x6c05		#  li	a0,'E'
+	jal16	putc16
+	nop16
+	b16ext	step_f
+
+	#  F: jal in the last two halfwords of a page
+	.org	0xffc
+step_f:	jal16	putc16
+	li16	4, 0x46			#  li	a0,'F'  (delay slot)
+
+	b16ext	step_g
+
+	#  G: jal beginning in the last halfword of a 2 KB page
+	.org	0x17fe
+step_g:	jal16	putc16
+	li16	4, 0x47			#  li	a0,'G'  (delay slot)
+
+	li16	4, 0x48			#  li	a0,'H'
+	lwpc16	2, lit_putc32		#  lw	v0,lit_putc32
+	.short	0xea40			#  jalr	v0
+	nop16
+
+	li16	4, 0x49			#  li	a0,'I'
+	jal16	putc32, 1		#  jalx	putc32
+	nop16
+
+	.short	0xe805			#  break
+	li16	4, 0x4a			#  li	a0,'J'
+	jal16	putc16
+	nop16
+
+	li16	4, 0x4b			#  li	a0,'K'
+	.short	0x6554			#  move	s2,a0
+	.short	0xf100, 0x64f2		#  save	16,ra,s0,s1,s2
+	li16	2, 0
+	.short	0x6552			#  move	s2,v0
+	.short	0xf100, 0x6472		#  restore	16,ra,s0,s1,s2
+	.short	0x6792			#  move	a0,s2
+	jal16	putc16
+	nop16
+
+	.short	0x6444			#  restore	32,ra
+	.short	0xe820			#  jr	ra
+	nop16
+
+	.p2align 2
+lit_putc32:
+	.word	putc32 - _start + LOADADDR
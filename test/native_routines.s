@@ -0,0 +1,167 @@
+#
+#  Test program for guest routines which are run natively (see
+#  src/cpus/native_routines.cc), for -E oldtestmips. See
+#  test_native_routines.sh.
+#
+#  The program calls its own memset, memcpy and strlen 16 times each, with
+#  different arguments, and mixes the return values and the contents of
+#  the buffers into a checksum, which is printed in hex. The checksum must
+#  be the same whether or not the routines are run natively (-A turns
+#  native routines off). The routines are found through the symbols in
+#  native_routines.syms, so that file must be loaded too.
+#
+#  Built with:
+#
+#	llvm-mc -triple=mips-unknown-elf -mcpu=mips32 -filetype=obj native_routines.s -o native_routines.o
+#	llvm-objcopy -O binary -j .text native_routines.o native_routines.bin
+#	llvm-nm -S native_routines.o | while read a l t n; do [ $t = T ] && printf "%08x %s %s %s\n" $((0x80010000 + 0x$a)) $l $t $n; done > native_routines.syms
+#
+
+	.set	noreorder
+	.set	noat
+	.text
+
+	.equ	LOADADDR, 0x80010000
+	.equ	NLOOPS, 16
+
+	.equ	CONS, 0xb0000000	#  testmachine console
+	.equ	BUF_A, 0x80400000
+	.equ	BUF_B, 0x80410000
+
+	#  jal to an absolute address (there is no linker):
+	.macro	jalabs target
+	.word	0x0c000000 | (((\target - _start + LOADADDR) >> 2) & 0x3ffffff)
+	.endm
+
+	.globl	_start
+_start:
+	li	$sp, 0x80380000
+	li	$s7, CONS
+	li	$s0, BUF_A
+	li	$s1, BUF_B
+	li	$s2, 0			#  loop counter
+	li	$s3, 0			#  checksum
+
+main_loop:
+	#  memset(A, i + 1, 4096 + i * 3):
+	move	$a0, $s0
+	addiu	$a1, $s2, 1
+	sll	$a2, $s2, 1
+	addu	$a2, $a2, $s2
+	jalabs	memset
+	addiu	$a2, $a2, 4096
+	bal	mix
+	move	$a0, $v0
+
+	#  memcpy(B, A + 5, 3000 + i):
+	move	$a0, $s1
+	addiu	$a1, $s0, 5
+	jalabs	memcpy
+	addiu	$a2, $s2, 3000
+	bal	mix
+	move	$a0, $v0
+
+	#  B[100 + i * 7] = 0; strlen(B):
+	sll	$t0, $s2, 3
+	subu	$t0, $t0, $s2
+	addu	$t0, $t0, $s1
+	sb	$zero, 100($t0)
+	jalabs	strlen
+	move	$a0, $s1
+	bal	mix
+	move	$a0, $v0
+
+	addiu	$s2, $s2, 1
+	li	$t0, NLOOPS
+	bne	$s2, $t0, main_loop
+	nop
+
+	#  Mix in the contents of both buffers:
+	move	$s4, $s0
+	addiu	$s5, $s0, 8192
+1:	lw	$a0, 0($s4)
+	bal	mix
+	addiu	$s4, $s4, 4
+	bne	$s4, $s5, 1b
+	nop
+	move	$s4, $s1
+	addiu	$s5, $s1, 8192
+2:	lw	$a0, 0($s4)
+	bal	mix
+	addiu	$s4, $s4, 4
+	bne	$s4, $s5, 2b
+	nop
+
+	move	$a0, $s3
+	bal	hex
+	nop
+	li	$t0, 10
+	sb	$t0, 0($s7)
+
+	.globl	done
+done:	b	done
+	nop
+
+	#  s3 = rotl(s3, 5) ^ a0
+mix:	sll	$t8, $s3, 5
+	srl	$t9, $s3, 27
+	or	$s3, $t8, $t9
+	jr	$ra
+	xor	$s3, $s3, $a0
+
+	#  Print a0 as 8 hex digits:
+hex:	li	$t5, 8
+3:	srl	$t6, $a0, 28
+	sltiu	$t7, $t6, 10
+	bne	$t7, $zero, 4f
+	addiu	$t6, $t6, 48
+	addiu	$t6, $t6, 7
+4:	sb	$t6, 0($s7)
+	sll	$a0, $a0, 4
+	addiu	$t5, $t5, -1
+	bne	$t5, $zero, 3b
+	nop
+	jr	$ra
+	nop
+
+	#  The routines which may be run natively. Their symbols have sizes,
+	#  so that a breakpoint anywhere inside them can be found.
+
+	.globl	memset
+	.type	memset, @function
+memset:	move	$v0, $a0
+	beq	$a2, $zero, 2f
+	addu	$a2, $a2, $a0
+1:	sb	$a1, 0($a0)
+	addiu	$a0, $a0, 1
+	bne	$a0, $a2, 1b
+	nop
+2:	jr	$ra
+	nop
+	.size	memset, . - memset
+
+	.globl	memcpy
+	.type	memcpy, @function
+memcpy:	move	$v0, $a0
+	beq	$a2, $zero, 2f
+	addu	$a2, $a2, $a0
+1:	lbu	$t0, 0($a1)
+	addiu	$a1, $a1, 1
+	sb	$t0, 0($a0)
+	addiu	$a0, $a0, 1
+	bne	$a0, $a2, 1b
+	nop
+2:	jr	$ra
+	nop
+	.size	memcpy, . - memcpy
+
+	.globl	strlen
+	.type	strlen, @function
+strlen:	move	$v0, $a0
+1:	lb	$t0, 0($v0)
+	bne	$t0, $zero, 1b
+	addiu	$v0, $v0, 1
+	addiu	$v0, $v0, -1
+	jr	$ra
+	subu	$v0, $v0, $a0
+	.size	strlen, . - strlen
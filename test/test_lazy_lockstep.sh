@@ -0,0 +1,9 @@
+#!/bin/sh
+#
+#  Regression test: Lazily evaluated ARM flags and PowerPC CR0 bits, compared
+#  with the eagerly calculated ones after each instruction. Start with:
+#
+#	test/test_lazy_lockstep.sh
+#
+
+test/test_lazy_lockstep.expect
@@ -0,0 +1,9 @@
+#!/bin/sh
+#
+#  Regression test: ll/sc spinlocks and atomic adds on several MIPS CPUs
+#  sharing the same memory. Start with:
+#
+#	test/test_llsc_spinlock.sh
+#
+
+test/test_llsc_spinlock.expect
@@ -0,0 +1,9 @@
+#!/bin/sh
+#
+#  Regression test: MIPS16 execution, and switching between 32-bit and
+#  MIPS16 mode with jalx, jalr, jr, and eret. Start with:
+#
+#	test/test_mips16.sh
+#
+
+test/test_mips16.expect
@@ -0,0 +1,10 @@
+#!/bin/sh
+#
+#  Regression test: guest memset, memcpy and strlen which are run natively
+#  give the same results as when they are emulated, and breakpoints inside
+#  them are still hit. Start with:
+#
+#	test/test_native_routines.sh
+#
+
+test/test_native_routines.expect
@@ -0,0 +1,9 @@
+#!/bin/sh
+#
+#  Regression test: Thumb execution, and switching between ARM and Thumb
+#  mode with bx, blx, BL pairs, and loads of the pc. Start with:
+#
+#	test/test_thumb_interwork.sh
+#
+
+test/test_thumb_interwork.expect
@@ -0,0 +1,9 @@
+#!/bin/sh
+#
+#  Regression test: a debugger watchpoint should stop execution right after
+#  the store which hit it. Start with:
+#
+#	test/test_watchpoint.sh
+#
+
+test/test_watchpoint.expect
@@ -0,0 +1,135 @@
+@
+@  Test program for Thumb execution and ARM/Thumb interworking, for
+@  -E testarm. See test_thumb_interwork.sh.
+@
+@  Each step prints one letter when it has been reached in the right mode,
+@  so the expected output is "ABCDEFGHI":
+@
+@	A	ARM to Thumb with bx, Thumb BL pair to a Thumb subroutine
+@	B	Thumb BL pair to a subroutine more than one translation page away
+@	C	Thumb blx register to ARM, and bx lr back to Thumb
+@	D	Thumb blx immediate (BL/BLX pair) to ARM, and bx lr back
+@	E	Thumb push {lr} / pop {pc} within Thumb code
+@	F	Thumb pop {pc} with bit 0 clear, to ARM
+@	G	ARM ldm with the pc in the register list and bit 0 set, to Thumb
+@	H	Thumb bx to ARM, and ARM blx register to Thumb and back
+@	I	ARM ldm to ARM code, with bit 0 clear
+@
+@  (The Thumb blx immediate is written out by hand, and no ARM bl is used,
+@  so that the program can be turned into a raw binary without a linker.)
+@
+@  Built with:
+@
+@	llvm-mc -triple=armv5te-none-eabi -filetype=obj thumb_interwork.s -o thumb_interwork.o
+@	llvm-objcopy -O binary -j .text thumb_interwork.o thumb_interwork.bin
+@
+
+	.syntax unified
+	.text
+
+	@  Thumb blx to ARM code (must be at a word aligned address):
+	.macro	blx_arm target
+.Lblx\@:
+	.short	0xf000 | (((\target - .Lblx\@ - 4) >> 12) & 0x7ff)
+	.short	0xe800 | (((\target - .Lblx\@ - 4) >> 1) & 0x7ff)
+	.endm
+
+	.arm
+	.globl	_start
+_start:
+	mov	r8, #0x10000000		@  console
+	mov	sp, #0x100000
+	adr	r0, step_a + 1
+	bx	r0
+
+	.thumb
+	.thumb_func
+step_a:	movs	r0, #0x41		@  'A'
+	bl	putc
+
+	movs	r0, #0x42		@  'B'
+	bl	far_putc
+
+	adr	r2, arm_c
+	blx	r2
+	movs	r0, #0x44		@  'D'
+	.p2align 2
+	blx_arm	arm_putc
+
+	bl	sub_e
+	movs	r0, #0x45		@  'E'
+	bl	putc
+
+	adr	r1, arm_f		@  bit 0 clear: switch to ARM
+	push	{r1}
+	pop	{pc}
+
+	.thumb_func
+putc:	mov	r1, r8
+	strb	r0, [r1]
+	bx	lr
+
+	.thumb_func
+sub_e:	push	{r4, lr}
+	movs	r4, #0
+	pop	{r4, pc}
+
+	.p2align 2
+	.arm
+arm_c:	mov	r0, #0x43		@  'C'
+	strb	r0, [r8]
+	bx	lr
+
+arm_putc:
+	strb	r0, [r8]
+	bx	lr
+
+arm_f:	mov	r0, #0x46		@  'F'
+	strb	r0, [r8]
+	adr	r1, step_g + 1		@  bit 0 set: switch to Thumb
+	str	r1, [sp, #-4]!
+	ldmia	sp!, {pc}
+	mov	r0, #0x58		@  'X': not reached
+	strb	r0, [r8]
+
+	.thumb
+	.thumb_func
+step_g:	movs	r0, #0x47		@  'G'
+	bl	putc
+	adr	r1, arm_h
+	bx	r1
+
+	.p2align 2
+	.arm
+arm_h:	adr	r0, thumb_h + 1
+	blx	r0
+	adr	r1, arm_i
+	str	r1, [sp, #-4]!
+	ldmia	sp!, {pc}
+	mov	r0, #0x58		@  'X': not reached
+	strb	r0, [r8]
+
+arm_i:	mov	r0, #0x49		@  'I'
+	strb	r0, [r8]
+	mov	r0, #10
+	strb	r0, [r8]
+	strb	r0, [r8, #0x10]		@  halt
+1:	b	1b
+
+	.thumb
+	.thumb_func
+thumb_h:
+	movs	r0, #0x48		@  'H'
+	mov	r1, r8
+	strb	r0, [r1]
+	bx	lr
+
+	@  Far enough away that the BL pair has a non-zero upper half, and
+	@  that the call crosses Thumb translation pages:
+	.space	0x1800
+
+	.thumb_func
+far_putc:
+	mov	r1, r8
+	strb	r0, [r1]
+	bx	lr